@@ -0,0 +1,35 @@
+# --- This file is distributed under the MIT Open Source License, as detailed
+# in the file "LICENSE.TXT" in the root of this repository ---
+
+
+# Use an installed Google Benchmark if there is one, and otherwise use
+# FetchContent to get it.
+# https://github.com/google/benchmark
+
+
+if (NOT TARGET benchmark::benchmark)
+    find_package(benchmark CONFIG QUIET)
+endif()
+
+if (NOT TARGET benchmark::benchmark)
+    set(BUILD_SHARED_LIBS OFF)
+    set(BENCHMARK_ENABLE_TESTING OFF CACHE BOOL "" FORCE)
+    set(BENCHMARK_ENABLE_GTEST_TESTS OFF CACHE BOOL "" FORCE)
+    set(BENCHMARK_ENABLE_INSTALL OFF CACHE BOOL "" FORCE)
+
+    include(FetchContent)
+    FetchContent_Declare(
+        googlebenchmark
+        GIT_REPOSITORY https://github.com/google/benchmark.git
+        GIT_TAG        v1.8.3
+    )
+    FetchContent_MakeAvailable(googlebenchmark)
+
+    mark_as_advanced(
+    BENCHMARK_ENABLE_TESTING
+    BENCHMARK_ENABLE_GTEST_TESTS
+    BENCHMARK_ENABLE_INSTALL
+    )
+    set_target_properties(benchmark benchmark_main
+        PROPERTIES FOLDER "GoogleBenchmark")
+endif()
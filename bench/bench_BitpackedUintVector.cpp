@@ -0,0 +1,204 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+// Throughput of BitpackedUintVector for sequential read, sequential write,
+// random read, and random read-modify-write, for every element_bitlen from 1
+// to 32, and of a std::vector of the smallest uint8_t/16_t/32_t that holds
+// the same elements.  The argument of each benchmark is the size in bytes of
+// the BitpackedUintVector's data (the working set), from a size that fits in
+// L1 up to well past any last level cache; the std::vector baseline for that
+// benchmark holds the same number of elements, and so uses 8/16/32 bits per
+// element instead of element_bitlen bits.
+//
+// Example, comparing 13 bit elements against std::vector<uint16_t>:
+//   bench_hurchalla_util_bitpacked --benchmark_filter='/13/'
+// Each name is  pattern/container/element_bitlen/working_set_bytes.
+
+#include "hurchalla/util/BitpackedUintVector.h"
+#include "hurchalla/util/sized_uint.h"
+#include "benchmark/benchmark.h"
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+
+constexpr int bits_for(unsigned int element_bitlen)
+{
+    return (element_bitlen <= 8) ? 8 : (element_bitlen <= 16) ? 16 : 32;
+}
+
+
+// Adapters, so each benchmark is written once for both containers.
+template <unsigned int element_bitlen>
+struct Packed {
+    using U = typename hurchalla::sized_uint<bits_for(element_bitlen)>::type;
+    hurchalla::BitpackedUintVector<U, element_bitlen> vec;
+    explicit Packed(std::size_t n) : vec(n) {}
+    U get(std::size_t i) const { return vec.getAt(i); }
+    void set(std::size_t i, U x) { vec.setAt(i, x); }
+};
+template <unsigned int element_bitlen>
+struct Unpacked {
+    using U = typename hurchalla::sized_uint<bits_for(element_bitlen)>::type;
+    std::vector<U> vec;
+    explicit Unpacked(std::size_t n) : vec(n) {}
+    U get(std::size_t i) const { return vec[i]; }
+    void set(std::size_t i, U x) { vec[i] = x; }
+};
+
+
+template <unsigned int element_bitlen>
+std::size_t element_count(const benchmark::State& state)
+{
+    return static_cast<std::size_t>(state.range(0)) * 8 / element_bitlen;
+}
+
+template <unsigned int element_bitlen>
+constexpr uint32_t value_mask()
+{
+    return static_cast<uint32_t>((UINT64_C(1) << element_bitlen) - 1);
+}
+
+// A cheap xorshift generator, mapped onto [0, n) with a multiply and shift,
+// so that generating an index costs only a few cycles compared to a cache
+// miss.
+struct RandomIndex {
+    uint32_t x;
+    std::size_t n;
+    std::size_t next()
+    {
+        x ^= x << 13;  x ^= x >> 17;  x ^= x << 5;
+        return static_cast<std::size_t>((static_cast<uint64_t>(x) * n) >> 32);
+    }
+};
+
+template <class C, unsigned int element_bitlen>
+void BM_SeqRead(benchmark::State& state)
+{
+    std::size_t n = element_count<element_bitlen>(state);
+    C c(n);
+    for (std::size_t i = 0; i < n; ++i)
+        c.set(i, static_cast<typename C::U>(i & value_mask<element_bitlen>()));
+    for (auto _ : state) {
+        uint32_t sum = 0;
+        for (std::size_t i = 0; i < n; ++i)
+            sum += c.get(i);
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * n));
+}
+
+template <class C, unsigned int element_bitlen>
+void BM_SeqWrite(benchmark::State& state)
+{
+    using U = typename C::U;
+    std::size_t n = element_count<element_bitlen>(state);
+    C c(n);
+    uint32_t k = 0;
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < n; ++i)
+            c.set(i, static_cast<U>((i + k) & value_mask<element_bitlen>()));
+        benchmark::ClobberMemory();
+        ++k;
+    }
+    benchmark::DoNotOptimize(c.get(n - 1));
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * n));
+}
+
+template <class C, unsigned int element_bitlen>
+void BM_RandomRead(benchmark::State& state)
+{
+    std::size_t n = element_count<element_bitlen>(state);
+    C c(n);
+    for (std::size_t i = 0; i < n; ++i)
+        c.set(i, static_cast<typename C::U>(i & value_mask<element_bitlen>()));
+    RandomIndex r{ 2463534242u, n };
+    for (auto _ : state) {
+        uint32_t sum = 0;
+        for (std::size_t i = 0; i < n; ++i)
+            sum += c.get(r.next());
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * n));
+}
+
+template <class C, unsigned int element_bitlen>
+void BM_RandomReadModifyWrite(benchmark::State& state)
+{
+    using U = typename C::U;
+    std::size_t n = element_count<element_bitlen>(state);
+    C c(n);
+    RandomIndex r{ 2463534242u, n };
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < n; ++i) {
+            std::size_t j = r.next();
+            c.set(j, static_cast<U>((c.get(j) + 1u) &
+                                    value_mask<element_bitlen>()));
+        }
+        benchmark::ClobberMemory();
+    }
+    benchmark::DoNotOptimize(c.get(0));
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * n));
+}
+
+
+// Working set sizes in bytes: 16KiB (L1), 256KiB (L2), 4MiB (L2/L3),
+// 32MiB (around the size of a large L3), and 256MiB (DRAM).
+void apply_sizes(benchmark::internal::Benchmark* b)
+{
+    for (int64_t bytes : { INT64_C(16) << 10, INT64_C(256) << 10,
+                           INT64_C(4) << 20, INT64_C(32) << 20,
+                           INT64_C(256) << 20 })
+        b->Arg(bytes);
+}
+
+using BenchFunction = void (*)(benchmark::State&);
+
+void register_pair(const char* pattern, unsigned int element_bitlen,
+                   BenchFunction packed, BenchFunction unpacked)
+{
+    std::string suffix = "/" + std::to_string(element_bitlen);
+    apply_sizes(benchmark::RegisterBenchmark((std::string(pattern) +
+                   "/BitpackedUintVector" + suffix).c_str(), packed));
+    apply_sizes(benchmark::RegisterBenchmark((std::string(pattern) +
+                   "/std::vector" + suffix).c_str(), unpacked));
+}
+
+template <unsigned int B>
+void register_bitlen()
+{
+    using P = Packed<B>;
+    using V = Unpacked<B>;
+    register_pair("SeqRead", B, BM_SeqRead<P, B>, BM_SeqRead<V, B>);
+    register_pair("SeqWrite", B, BM_SeqWrite<P, B>, BM_SeqWrite<V, B>);
+    register_pair("RandomRead", B, BM_RandomRead<P, B>, BM_RandomRead<V, B>);
+    register_pair("RandomReadModifyWrite", B, BM_RandomReadModifyWrite<P, B>,
+                                              BM_RandomReadModifyWrite<V, B>);
+}
+
+template <std::size_t... I>
+void register_all(std::index_sequence<I...>)
+{
+    // register in order of element_bitlen = 1, 2, ... 32
+    int dummy[] = { (register_bitlen<static_cast<unsigned int>(I + 1)>(), 0)... };
+    (void)dummy;
+}
+
+
+} // end unnamed namespace
+
+
+int main(int argc, char** argv)
+{
+    register_all(std::make_index_sequence<32>());
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,329 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+// Branchless versus branchy selection, under condition streams that a branch
+// predictor handles well and badly:
+//   Predictable - the condition is true once every 64 elements, in a fixed
+//                 pattern that predictors learn
+//   Random10    - the condition is true at random, 10% of the time
+//   Random50    - the condition is true at random, 50% of the time (the
+//                 worst case for a branch)
+//
+// conditional_select is run with CSelectStandardTag, CSelectMaskedTag and
+// CSelectDefaultTag; cselect_on_bit with its default implementation (inline
+// asm in the _asm executable, see below); and both are compared to "Branchy",
+// an if/else that the compiler is prevented from converting into a
+// conditional move, which shows what a mispredicted branch would cost.
+//
+// branchless_shift_left and branchless_shift_right are run on the widest
+// type available (__uint128_t if the compiler has it), with the condition
+// picking a shift in the lower or upper half of the type's bit width - which
+// is exactly the decision that a double-word shift must make.  They are
+// compared to the compiler's own shift operator ("Builtin"), and to a branchy
+// double-word shift.
+//
+// This file is built twice, like bench_multiply_hilo.cpp:
+// bench_hurchalla_util_branchless without inline asm, and
+// bench_hurchalla_util_branchless_asm with HURCHALLA_ALLOW_INLINE_ASM_ALL.
+// The compiler's name and version are recorded in the benchmark context, so
+// that saving the results of each compiler's build, e.g.
+//   bench_hurchalla_util_branchless --benchmark_out=gcc12.csv \
+//                                   --benchmark_out_format=csv
+// gives a table per compiler.
+//
+// Each name is  function/implementation/condition_stream/asm_mode.
+
+#include "hurchalla/util/conditional_select.h"
+#include "hurchalla/util/cselect_on_bit.h"
+#include "hurchalla/util/branchless_shift_left.h"
+#include "hurchalla/util/branchless_shift_right.h"
+#include "hurchalla/util/compiler_macros.h"
+#include "benchmark/benchmark.h"
+#include <cstdint>
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(HURCHALLA_ALLOW_INLINE_ASM_ALL)
+#  define HURCHALLA_BENCH_ASM_MODE "asm_all"
+#else
+#  define HURCHALLA_BENCH_ASM_MODE "noasm"
+#endif
+
+// An empty asm statement in one arm of an if/else stops gcc and clang from
+// if-converting it, so that the branch really is a branch.
+#if defined(__GNUC__)
+#  define HURCHALLA_BENCH_KEEP_BRANCH() __asm__ __volatile__("")
+#else
+#  define HURCHALLA_BENCH_KEEP_BRANCH() ((void)0)
+#endif
+
+namespace {
+
+
+namespace hc = ::hurchalla;
+
+#if HURCHALLA_COMPILER_HAS_UINT128_T()
+using ShiftT = __uint128_t;
+const char* const SHIFT_TYPE_NAME = "__uint128_t";
+#else
+using ShiftT = uint64_t;
+const char* const SHIFT_TYPE_NAME = "uint64_t";
+#endif
+constexpr int SHIFT_BITS = 8 * static_cast<int>(sizeof(ShiftT));
+
+
+enum class Stream { Predictable, Random10, Random50 };
+
+const char* stream_name(Stream s)
+{
+    return (s == Stream::Predictable) ? "Predictable" :
+           (s == Stream::Random10) ? "Random10" : "Random50";
+}
+
+// The condition stream needs to be long; modern branch predictors can
+// memorize a "random" pattern of a few thousand branches if it repeats.  The
+// data values are shorter arrays, indexed modulo their size, so that the
+// working set stays in L2.
+constexpr std::size_t NUM_ELEMENTS = std::size_t(1) << 18;
+constexpr std::size_t NUM_VALUES = 4096;
+
+std::vector<uint8_t> make_conditions(Stream s)
+{
+    std::mt19937_64 mt(12345);
+    std::vector<uint8_t> cond(NUM_ELEMENTS);
+    for (std::size_t i = 0; i < NUM_ELEMENTS; ++i) {
+        if (s == Stream::Predictable)
+            cond[i] = (i % 64 == 63);
+        else if (s == Stream::Random10)
+            cond[i] = (mt() % 10 == 0);
+        else
+            cond[i] = mt() & 1;
+    }
+    return cond;
+}
+
+std::vector<uint64_t> random_words(unsigned int seed)
+{
+    std::mt19937_64 mt(seed);
+    std::vector<uint64_t> v(NUM_VALUES);
+    for (auto& x : v)
+        x = mt();
+    return v;
+}
+
+
+// ---- selection ----
+
+struct SelectBranchy {
+    static const char* name() { return "Branchy"; }
+    HURCHALLA_FORCE_INLINE static uint64_t call(uint64_t c, uint64_t a,
+                                                uint64_t b)
+    {
+        if (c) {
+            HURCHALLA_BENCH_KEEP_BRANCH();
+            return a;
+        }
+        return b;
+    }
+};
+template <class Tag>
+struct SelectTag;
+template <>
+struct SelectTag<hc::CSelectStandardTag> {
+    static const char* name() { return "CSelectStandardTag"; }
+};
+template <>
+struct SelectTag<hc::CSelectMaskedTag> {
+    static const char* name() { return "CSelectMaskedTag"; }
+};
+template <>
+struct SelectTag<hc::CSelectDefaultTag> {
+    static const char* name() { return "CSelectDefaultTag"; }
+};
+template <class Tag>
+struct SelectConditional : SelectTag<Tag> {
+    HURCHALLA_FORCE_INLINE static uint64_t call(uint64_t c, uint64_t a,
+                                                uint64_t b)
+    {
+        return hc::conditional_select<uint64_t, Tag>(c != 0, a, b);
+    }
+};
+struct SelectOnBit {
+    static const char* name() { return "cselect_on_bit"; }
+    HURCHALLA_FORCE_INLINE static uint64_t call(uint64_t c, uint64_t a,
+                                                uint64_t b)
+    {
+        return hc::cselect_on_bit<0>::ne_0(c, a, b);
+    }
+};
+
+// The selected value is added into a running sum, so every select is on the
+// critical path, as it would be in a loop that uses its result.
+template <class Sel>
+void BM_Select(benchmark::State& state, Stream s)
+{
+    std::vector<uint8_t> cond = make_conditions(s);
+    std::vector<uint64_t> a = random_words(1);
+    std::vector<uint64_t> b = random_words(2);
+    for (auto _ : state) {
+        uint64_t sum = 0;
+        for (std::size_t i = 0; i < NUM_ELEMENTS; ++i) {
+            std::size_t j = i % NUM_VALUES;
+            sum += Sel::call(cond[i], a[j], b[j]) ^ sum;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(
+                                           state.iterations() * NUM_ELEMENTS));
+}
+
+
+// ---- shifts ----
+
+struct ShiftLeftBranchless {
+    static const char* name() { return "branchless_shift_left/Branchless"; }
+    HURCHALLA_FORCE_INLINE static ShiftT call(ShiftT a, int shift)
+    {
+        return hc::branchless_shift_left(a, shift);
+    }
+};
+struct ShiftLeftBuiltin {
+    static const char* name() { return "branchless_shift_left/Builtin"; }
+    HURCHALLA_FORCE_INLINE static ShiftT call(ShiftT a, int shift)
+    {
+        return static_cast<ShiftT>(a << shift);
+    }
+};
+struct ShiftLeftBranchy {
+    static const char* name() { return "branchless_shift_left/Branchy"; }
+    HURCHALLA_FORCE_INLINE static ShiftT call(ShiftT a, int shift)
+    {
+        constexpr int HALF = SHIFT_BITS / 2;
+        if (shift >= HALF) {
+            HURCHALLA_BENCH_KEEP_BRANCH();
+            return static_cast<ShiftT>(static_cast<ShiftT>(a << HALF)
+                                                          << (shift - HALF));
+        }
+        return static_cast<ShiftT>(a << shift);
+    }
+};
+struct ShiftRightBranchless {
+    static const char* name() { return "branchless_shift_right/Branchless"; }
+    HURCHALLA_FORCE_INLINE static ShiftT call(ShiftT a, int shift)
+    {
+        return hc::branchless_shift_right(a, shift);
+    }
+};
+struct ShiftRightBuiltin {
+    static const char* name() { return "branchless_shift_right/Builtin"; }
+    HURCHALLA_FORCE_INLINE static ShiftT call(ShiftT a, int shift)
+    {
+        return static_cast<ShiftT>(a >> shift);
+    }
+};
+struct ShiftRightBranchy {
+    static const char* name() { return "branchless_shift_right/Branchy"; }
+    HURCHALLA_FORCE_INLINE static ShiftT call(ShiftT a, int shift)
+    {
+        constexpr int HALF = SHIFT_BITS / 2;
+        if (shift >= HALF) {
+            HURCHALLA_BENCH_KEEP_BRANCH();
+            return static_cast<ShiftT>(static_cast<ShiftT>(a >> HALF)
+                                                          >> (shift - HALF));
+        }
+        return static_cast<ShiftT>(a >> shift);
+    }
+};
+
+// The condition stream picks a shift in [0, SHIFT_BITS/2) or in
+// [SHIFT_BITS/2, SHIFT_BITS).  As with BM_Select, each result feeds the next
+// iteration through the running value.
+template <class Sh>
+void BM_Shift(benchmark::State& state, Stream s)
+{
+    std::vector<uint8_t> cond = make_conditions(s);
+    std::mt19937_64 mt(3);
+    std::vector<uint8_t> shifts(NUM_ELEMENTS);
+    constexpr int HALF = SHIFT_BITS / 2;
+    for (std::size_t i = 0; i < NUM_ELEMENTS; ++i)
+        shifts[i] = static_cast<uint8_t>(static_cast<int>(mt() % HALF) +
+                                         (cond[i] ? HALF : 0));
+    std::vector<uint64_t> a = random_words(4);
+    for (auto _ : state) {
+        ShiftT x = 0;
+        for (std::size_t i = 0; i < NUM_ELEMENTS; ++i) {
+            ShiftT v = static_cast<ShiftT>(a[i % NUM_VALUES] ^
+                                           static_cast<uint64_t>(x));
+            x = static_cast<ShiftT>(x + Sh::call(v, shifts[i]));
+        }
+        benchmark::DoNotOptimize(x);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(
+                                           state.iterations() * NUM_ELEMENTS));
+}
+
+
+template <class Sel>
+void register_select()
+{
+    for (Stream s : { Stream::Predictable, Stream::Random10, Stream::Random50 })
+        benchmark::RegisterBenchmark((std::string("select/") + Sel::name() +
+                          "/" + stream_name(s) + "/" HURCHALLA_BENCH_ASM_MODE).c_str(),
+                          BM_Select<Sel>, s);
+}
+
+template <class Sh>
+void register_shift()
+{
+    for (Stream s : { Stream::Predictable, Stream::Random10, Stream::Random50 })
+        benchmark::RegisterBenchmark((std::string(Sh::name()) + "/" +
+                          stream_name(s) + "/" HURCHALLA_BENCH_ASM_MODE).c_str(),
+                          BM_Shift<Sh>, s);
+}
+
+
+std::string compiler_name()
+{
+#if defined(__clang__)
+    return std::string("clang ") + __clang_version__;
+#elif defined(__GNUC__)
+    return std::string("gcc ") + __VERSION__;
+#elif defined(_MSC_VER)
+    return "msvc " + std::to_string(_MSC_FULL_VER);
+#else
+    return "unknown";
+#endif
+}
+
+
+} // end unnamed namespace
+
+
+int main(int argc, char** argv)
+{
+    register_select<SelectBranchy>();
+    register_select<SelectConditional<hc::CSelectStandardTag>>();
+    register_select<SelectConditional<hc::CSelectMaskedTag>>();
+    register_select<SelectConditional<hc::CSelectDefaultTag>>();
+    register_select<SelectOnBit>();
+
+    register_shift<ShiftLeftBranchless>();
+    register_shift<ShiftLeftBuiltin>();
+    register_shift<ShiftLeftBranchy>();
+    register_shift<ShiftRightBranchless>();
+    register_shift<ShiftRightBuiltin>();
+    register_shift<ShiftRightBranchy>();
+
+    benchmark::AddCustomContext("compiler", compiler_name());
+    benchmark::AddCustomContext("asm_mode", HURCHALLA_BENCH_ASM_MODE);
+    benchmark::AddCustomContext("shift_type", SHIFT_TYPE_NAME);
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,220 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+// Latency and throughput of the double-width multiply and square functions:
+//   unsigned_multiply_to_hilo_product, unsigned_multiply_to_hi_product,
+//   unsigned_square_to_hilo_product, unsigned_multiply_add_to_hilo_product,
+//   signed_multiply_to_hilo_product, signed_square_to_hilo_product
+// for every type from 8 bits to 128 bits (when the compiler has __int128).
+//
+// "Latency" runs a dependent chain, where each call's input is the previous
+// call's result, and so measures the length of the critical path.  This is
+// what matters in a scalar loop like a modular exponentiation.  "Throughput"
+// runs independent calls over an array that fits in L1, and so measures how
+// many calls the CPU can overlap.  This is what matters in array/vectorized
+// code, e.g. the "array pow" results cited in impl_*_to_hilo_product.h.
+//
+// This file is built twice: bench_hurchalla_util_multiply_hilo uses the
+// default (no inline asm), and bench_hurchalla_util_multiply_hilo_asm defines
+// HURCHALLA_ALLOW_INLINE_ASM_ALL.  Each benchmark name ends in /noasm or
+// /asm_all accordingly.  To compare the two, run both with the same filter,
+// or use Google Benchmark's tools/compare.py:
+//   compare.py benchmarks ./bench_hurchalla_util_multiply_hilo \
+//                         ./bench_hurchalla_util_multiply_hilo_asm
+
+#include "hurchalla/util/unsigned_multiply_to_hilo_product.h"
+#include "hurchalla/util/unsigned_multiply_to_hi_product.h"
+#include "hurchalla/util/unsigned_square_to_hilo_product.h"
+#include "hurchalla/util/unsigned_multiply_add_to_hilo_product.h"
+#include "hurchalla/util/signed_multiply_to_hilo_product.h"
+#include "hurchalla/util/signed_square_to_hilo_product.h"
+#include "hurchalla/util/traits/extensible_make_unsigned.h"
+#include "hurchalla/util/compiler_macros.h"
+#include "benchmark/benchmark.h"
+#include <cstdint>
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(HURCHALLA_ALLOW_INLINE_ASM_ALL)
+#  define HURCHALLA_BENCH_ASM_MODE "asm_all"
+#else
+#  define HURCHALLA_BENCH_ASM_MODE "noasm"
+#endif
+
+namespace {
+
+
+namespace hc = ::hurchalla;
+
+// Each operation takes (a, b) and returns a T that depends on every bit of
+// the result, so that the latency chain x = op(x, b) goes through the whole
+// product.  The square operations add b so that the chain can't get stuck at
+// zero.
+struct UMulHilo {
+    static const char* name() { return "unsigned_multiply_to_hilo_product"; }
+    template <typename T>
+    HURCHALLA_FORCE_INLINE static T call(T a, T b)
+    {
+        T lo;
+        T hi = hc::unsigned_multiply_to_hilo_product(lo, a, b);
+        return static_cast<T>(hi ^ lo);
+    }
+};
+struct UMulHi {
+    static const char* name() { return "unsigned_multiply_to_hi_product"; }
+    template <typename T>
+    HURCHALLA_FORCE_INLINE static T call(T a, T b)
+    {
+        return hc::unsigned_multiply_to_hi_product(a, b);
+    }
+};
+struct USquareHilo {
+    static const char* name() { return "unsigned_square_to_hilo_product"; }
+    template <typename T>
+    HURCHALLA_FORCE_INLINE static T call(T a, T b)
+    {
+        T lo;
+        T hi = hc::unsigned_square_to_hilo_product(lo, a);
+        return static_cast<T>((hi ^ lo) + b);
+    }
+};
+// the two-addend form, as used in a multiprecision multiply's inner loop
+struct UMulAddHilo {
+    static const char* name() { return "unsigned_multiply_add_to_hilo_product"; }
+    template <typename T>
+    HURCHALLA_FORCE_INLINE static T call(T a, T b)
+    {
+        T lo;
+        T hi = hc::unsigned_multiply_add_to_hilo_product(lo, a, b, b, a);
+        return static_cast<T>(hi ^ lo);
+    }
+};
+struct SMulHilo {
+    static const char* name() { return "signed_multiply_to_hilo_product"; }
+    template <typename T>
+    HURCHALLA_FORCE_INLINE static T call(T a, T b)
+    {
+        typename hc::extensible_make_unsigned<T>::type lo;
+        T hi = hc::signed_multiply_to_hilo_product(lo, a, b);
+        return static_cast<T>(hi ^ static_cast<T>(lo));
+    }
+};
+struct SSquareHilo {
+    static const char* name() { return "signed_square_to_hilo_product"; }
+    template <typename T>
+    HURCHALLA_FORCE_INLINE static T call(T a, T b)
+    {
+        using UT = typename hc::extensible_make_unsigned<T>::type;
+        UT lo;
+        T hi = hc::signed_square_to_hilo_product(lo, a);
+        return static_cast<T>(static_cast<UT>(static_cast<UT>(hi) ^ lo) +
+                              static_cast<UT>(b));
+    }
+};
+
+
+template <typename T>
+std::vector<T> random_values(std::size_t n, unsigned int seed)
+{
+    using UT = typename hc::extensible_make_unsigned<T>::type;
+    std::mt19937_64 mt(seed);
+    std::vector<T> v(n);
+    for (auto& x : v) {
+        UT u = 0;
+        for (std::size_t i = 0; i < sizeof(UT); ++i)
+            u = static_cast<UT>(static_cast<UT>(u << 8) | (mt() & 0xFF));
+        x = static_cast<T>(u);
+    }
+    return v;
+}
+
+constexpr std::size_t OPS_PER_ITERATION = 1024;
+
+template <class Op, typename T>
+void BM_Latency(benchmark::State& state)
+{
+    std::vector<T> b = random_values<T>(OPS_PER_ITERATION, 1);
+    T x = random_values<T>(1, 2)[0];
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < OPS_PER_ITERATION; ++i)
+            x = Op::template call<T>(x, b[i]);
+        benchmark::DoNotOptimize(x);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(
+                                      state.iterations() * OPS_PER_ITERATION));
+}
+
+template <class Op, typename T>
+void BM_Throughput(benchmark::State& state)
+{
+    std::vector<T> a = random_values<T>(OPS_PER_ITERATION, 3);
+    std::vector<T> b = random_values<T>(OPS_PER_ITERATION, 4);
+    std::vector<T> out(OPS_PER_ITERATION);
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < OPS_PER_ITERATION; ++i)
+            out[i] = Op::template call<T>(a[i], b[i]);
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(
+                                      state.iterations() * OPS_PER_ITERATION));
+}
+
+
+template <class Op, typename T>
+void register_op(const char* type_name)
+{
+    std::string suffix = std::string("/") + Op::name() + "/" + type_name +
+                         "/" HURCHALLA_BENCH_ASM_MODE;
+    benchmark::RegisterBenchmark(("Latency" + suffix).c_str(),
+                                 BM_Latency<Op, T>);
+    benchmark::RegisterBenchmark(("Throughput" + suffix).c_str(),
+                                 BM_Throughput<Op, T>);
+}
+
+template <typename T>
+void register_unsigned(const char* type_name)
+{
+    register_op<UMulHilo, T>(type_name);
+    register_op<UMulHi, T>(type_name);
+    register_op<USquareHilo, T>(type_name);
+    register_op<UMulAddHilo, T>(type_name);
+}
+
+template <typename T>
+void register_signed(const char* type_name)
+{
+    register_op<SMulHilo, T>(type_name);
+    register_op<SSquareHilo, T>(type_name);
+}
+
+
+} // end unnamed namespace
+
+
+int main(int argc, char** argv)
+{
+    register_unsigned<uint8_t>("uint8_t");
+    register_unsigned<uint16_t>("uint16_t");
+    register_unsigned<uint32_t>("uint32_t");
+    register_unsigned<uint64_t>("uint64_t");
+#if HURCHALLA_COMPILER_HAS_UINT128_T()
+    register_unsigned<__uint128_t>("__uint128_t");
+#endif
+    register_signed<int8_t>("int8_t");
+    register_signed<int16_t>("int16_t");
+    register_signed<int32_t>("int32_t");
+    register_signed<int64_t>("int64_t");
+#if HURCHALLA_COMPILER_HAS_UINT128_T()
+    register_signed<__int128_t>("__int128_t");
+#endif
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
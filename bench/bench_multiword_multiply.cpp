@@ -0,0 +1,179 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+// Latency and throughput of the multiword multiply kernels in
+// multiword_multiply.h:  mul_1, addmul_1, submul_1 and mul_n, for uint64_t
+// words and N = 4 and 8 (256 and 512 bit numbers).
+// "Latency" and "Throughput" are as in bench_multiply_hilo.cpp.  For latency,
+// each call's r is the previous call's r, with the returned word folded in.
+//
+// This file is built twice, like bench_multiply_hilo.cpp:
+// bench_hurchalla_util_multiword_multiply without inline asm, and
+// bench_hurchalla_util_multiword_multiply_asm with
+// HURCHALLA_ALLOW_INLINE_ASM_ALL.  The asm versions need BMI2 and ADX, so to
+// compare them, configure with e.g. -DCMAKE_CXX_FLAGS=-march=native.
+//
+// Each name is  Latency|Throughput/function/N/asm_mode.
+
+#include "hurchalla/util/multiword_multiply.h"
+#include "hurchalla/util/compiler_macros.h"
+#include "benchmark/benchmark.h"
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(HURCHALLA_ALLOW_INLINE_ASM_ALL)
+#  if defined(__BMI2__) && defined(__ADX__)
+#    define HURCHALLA_BENCH_ASM_MODE "asm_all"
+#  else
+#    define HURCHALLA_BENCH_ASM_MODE "asm_all_no_adx"
+#  endif
+#else
+#  define HURCHALLA_BENCH_ASM_MODE "noasm"
+#endif
+
+namespace {
+
+
+namespace hc = ::hurchalla;
+
+// Each operation updates r from a and b.  r has 2*N words so that mul_n can
+// use it; the other operations use its low N words.
+struct Mul1 {
+    static const char* name() { return "mul_1"; }
+    template <std::size_t N>
+    HURCHALLA_FORCE_INLINE static void call(std::uint64_t* r,
+                      const std::array<std::uint64_t, N>& a, std::uint64_t b)
+    {
+        r[0] ^= hc::mul_1<N>(r, a.data(), b ^ r[N-1]);
+    }
+};
+struct AddMul1 {
+    static const char* name() { return "addmul_1"; }
+    template <std::size_t N>
+    HURCHALLA_FORCE_INLINE static void call(std::uint64_t* r,
+                      const std::array<std::uint64_t, N>& a, std::uint64_t b)
+    {
+        r[0] ^= hc::addmul_1<N>(r, a.data(), b);
+    }
+};
+struct SubMul1 {
+    static const char* name() { return "submul_1"; }
+    template <std::size_t N>
+    HURCHALLA_FORCE_INLINE static void call(std::uint64_t* r,
+                      const std::array<std::uint64_t, N>& a, std::uint64_t b)
+    {
+        r[0] ^= hc::submul_1<N>(r, a.data(), b);
+    }
+};
+// mul_n's second operand is a with its low word replaced by b ^ r[2*N-1],
+// which makes the result depend on the previous one.
+struct MulN {
+    static const char* name() { return "mul_n"; }
+    template <std::size_t N>
+    HURCHALLA_FORCE_INLINE static void call(std::uint64_t* r,
+                      const std::array<std::uint64_t, N>& a, std::uint64_t b)
+    {
+        std::array<std::uint64_t, N> c = a;
+        c[0] = b ^ r[2*N-1];
+        hc::mul_n<N>(r, a.data(), c.data());
+    }
+};
+
+
+template <std::size_t N>
+std::vector<std::array<std::uint64_t, N>> random_arrays(std::size_t n,
+                                                        unsigned int seed)
+{
+    std::mt19937_64 mt(seed);
+    std::vector<std::array<std::uint64_t, N>> v(n);
+    for (auto& x : v) {
+        for (auto& w : x)
+            w = mt();
+    }
+    return v;
+}
+
+std::vector<std::uint64_t> random_words(std::size_t n, unsigned int seed)
+{
+    std::mt19937_64 mt(seed);
+    std::vector<std::uint64_t> v(n);
+    for (auto& x : v)
+        x = mt();
+    return v;
+}
+
+constexpr std::size_t OPS_PER_ITERATION = 256;
+
+template <class Op, std::size_t N>
+void BM_Latency(benchmark::State& state)
+{
+    auto a = random_arrays<N>(OPS_PER_ITERATION, 1);
+    auto b = random_words(OPS_PER_ITERATION, 2);
+    auto r = random_arrays<2*N>(1, 3)[0];
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < OPS_PER_ITERATION; ++i)
+            Op::template call<N>(r.data(), a[i], b[i]);
+        benchmark::DoNotOptimize(r.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(
+                                      state.iterations() * OPS_PER_ITERATION));
+}
+
+template <class Op, std::size_t N>
+void BM_Throughput(benchmark::State& state)
+{
+    auto a = random_arrays<N>(OPS_PER_ITERATION, 4);
+    auto b = random_words(OPS_PER_ITERATION, 5);
+    auto r = random_arrays<2*N>(OPS_PER_ITERATION, 6);
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < OPS_PER_ITERATION; ++i)
+            Op::template call<N>(r[i].data(), a[i], b[i]);
+        benchmark::DoNotOptimize(r.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(
+                                      state.iterations() * OPS_PER_ITERATION));
+}
+
+
+template <class Op, std::size_t N>
+void register_op()
+{
+    std::string suffix = std::string("/") + Op::name() + "/" +
+                         std::to_string(N) + "/" HURCHALLA_BENCH_ASM_MODE;
+    benchmark::RegisterBenchmark(("Latency" + suffix).c_str(),
+                                 BM_Latency<Op, N>);
+    benchmark::RegisterBenchmark(("Throughput" + suffix).c_str(),
+                                 BM_Throughput<Op, N>);
+}
+
+template <std::size_t N>
+void register_n()
+{
+    register_op<Mul1, N>();
+    register_op<AddMul1, N>();
+    register_op<SubMul1, N>();
+    register_op<MulN, N>();
+}
+
+
+} // end unnamed namespace
+
+
+int main(int argc, char** argv)
+{
+    register_n<4>();
+    register_n<8>();
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
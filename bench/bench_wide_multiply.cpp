@@ -0,0 +1,173 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+// unsigned_multiply_to_hilo_product for types wider than any native integer,
+// comparing the two strategies of slow_unsigned_multiply_to_hilo_product:
+//   by_halves - the schoolbook split into two halves held in T, with the
+//               cross products computed by T's own (wide) multiply.  Before
+//               by_limbs existed, this was the fallback for all wide types.
+//   by_limbs  - the split into native words, with the product computed by
+//               schoolbook multiplication of the words.  This is what
+//               unsigned_multiply_to_hilo_product now uses for these types.
+// The wide type is the test helper uint_wide<BITS> (test/uint_wide.h), whose
+// operators are simple word loops, as a user-defined type's would be.
+// They are compared to
+//   uint_fixed - unsigned_multiply_to_hilo_product on this library's
+//                uint_fixed<BITS>, which multiplies its limbs directly.
+// "Latency" and "Throughput" are as in bench_multiply_hilo.cpp.
+//
+// This file is built twice, like bench_multiply_hilo.cpp:
+// bench_hurchalla_util_wide_multiply without inline asm, and
+// bench_hurchalla_util_wide_multiply_asm with HURCHALLA_ALLOW_INLINE_ASM_ALL.
+//
+// Each name is  Latency|Throughput/strategy/bits/asm_mode.
+
+#include "hurchalla/util/unsigned_multiply_to_hilo_product.h"
+#include "hurchalla/util/uint_fixed.h"
+#include "uint_wide.h"
+#include "benchmark/benchmark.h"
+#include <cstdint>
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(HURCHALLA_ALLOW_INLINE_ASM_ALL)
+#  define HURCHALLA_BENCH_ASM_MODE "asm_all"
+#else
+#  define HURCHALLA_BENCH_ASM_MODE "noasm"
+#endif
+
+namespace {
+
+
+namespace hc = ::hurchalla;
+namespace hd = ::hurchalla::detail;
+
+struct ByHalves {
+    static const char* name() { return "by_halves"; }
+    template <typename T>
+    HURCHALLA_FORCE_INLINE static T call(T a, T b)
+    {
+        T lo;
+        T hi = hd::slow_unsigned_multiply_to_hilo_product::by_halves(lo, a, b);
+        return hi + lo;
+    }
+};
+struct ByLimbs {
+    static const char* name() { return "by_limbs"; }
+    template <typename T>
+    HURCHALLA_FORCE_INLINE static T call(T a, T b)
+    {
+        T lo;
+        T hi = hd::slow_unsigned_multiply_to_hilo_product::by_limbs(lo, a, b);
+        return hi + lo;
+    }
+};
+struct UintFixed {
+    static const char* name() { return "uint_fixed"; }
+    template <typename T>
+    HURCHALLA_FORCE_INLINE static T call(T a, T b)
+    {
+        T lo;
+        T hi = hc::unsigned_multiply_to_hilo_product(lo, a, b);
+        return hi + lo;
+    }
+};
+
+
+template <int BITS>
+void randomize(uint_wide<BITS>& x, std::mt19937_64& mt)
+{
+    for (std::size_t i = 0; i < uint_wide<BITS>::N; ++i)
+        x.w[i] = mt();
+}
+template <int BITS>
+void randomize(hc::uint_fixed<BITS>& x, std::mt19937_64& mt)
+{
+    typename hc::uint_fixed<BITS>::limb_array w;
+    for (auto& y : w)
+        y = mt();
+    x = hc::uint_fixed<BITS>(w);
+}
+
+template <typename T>
+std::vector<T> random_values(std::size_t n, unsigned int seed)
+{
+    std::mt19937_64 mt(seed);
+    std::vector<T> v(n);
+    for (auto& x : v)
+        randomize(x, mt);
+    return v;
+}
+
+constexpr std::size_t OPS_PER_ITERATION = 256;
+
+template <class Op, typename T>
+void BM_Latency(benchmark::State& state)
+{
+    std::vector<T> b = random_values<T>(OPS_PER_ITERATION, 1);
+    T x = random_values<T>(1, 2)[0];
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < OPS_PER_ITERATION; ++i)
+            x = Op::template call<T>(x, b[i]);
+        benchmark::DoNotOptimize(x);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(
+                                      state.iterations() * OPS_PER_ITERATION));
+}
+
+template <class Op, typename T>
+void BM_Throughput(benchmark::State& state)
+{
+    std::vector<T> a = random_values<T>(OPS_PER_ITERATION, 3);
+    std::vector<T> b = random_values<T>(OPS_PER_ITERATION, 4);
+    std::vector<T> out(OPS_PER_ITERATION);
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < OPS_PER_ITERATION; ++i)
+            out[i] = Op::template call<T>(a[i], b[i]);
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(
+                                      state.iterations() * OPS_PER_ITERATION));
+}
+
+
+template <class Op, typename T>
+void register_op()
+{
+    std::string suffix = std::string("/") + Op::name() + "/" +
+                         std::to_string(hc::ut_numeric_limits<T>::digits) +
+                         "/" HURCHALLA_BENCH_ASM_MODE;
+    benchmark::RegisterBenchmark(("Latency" + suffix).c_str(),
+                                 BM_Latency<Op, T>);
+    benchmark::RegisterBenchmark(("Throughput" + suffix).c_str(),
+                                 BM_Throughput<Op, T>);
+}
+
+template <int BITS>
+void register_bits()
+{
+    register_op<ByHalves, uint_wide<BITS>>();
+    register_op<ByLimbs, uint_wide<BITS>>();
+    register_op<UintFixed, hc::uint_fixed<BITS>>();
+}
+
+
+} // end unnamed namespace
+
+
+int main(int argc, char** argv)
+{
+    register_bits<128>();
+    register_bits<256>();
+    register_bits<512>();
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,46 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#ifndef HURCHALLA_UTIL_BITPACKED_HEAP_STORAGE_H_INCLUDED
+#define HURCHALLA_UTIL_BITPACKED_HEAP_STORAGE_H_INCLUDED
+
+
+#include <cstddef>
+#include <new>
+
+namespace hurchalla {
+
+
+// Storage policies for BitpackedUintVector's Storage template parameter.
+// A storage policy is a class with two static member functions:
+//
+//   static unsigned char* allocate(std::size_t bytes);
+//      Returns 'bytes' (> 0) bytes of zero-filled memory, or throws
+//      std::bad_alloc.
+//   static void deallocate(unsigned char* p, std::size_t bytes) noexcept;
+//      Frees memory from allocate(); 'bytes' is the value passed to allocate.
+//
+// You can write your own policy to place vectors in memory from your own
+// allocator.  For memory that comes directly from the OS, see
+// BitpackedPageStorage in BitpackedUintVectorStorage.h.
+
+
+// The default policy: memory from new unsigned char[bytes](), which zero-fills
+// the whole buffer up front.  This is the only policy that can adopt the
+// std::unique_ptr<unsigned char[]> given to BitpackedUintVector's
+// deserialization constructor; other policies copy from it.
+struct BitpackedHeapStorage {
+    static unsigned char* allocate(std::size_t bytes)
+    {
+        return new unsigned char[bytes]();
+    }
+    static void deallocate(unsigned char* p, std::size_t) noexcept
+    {
+        delete[] p;
+    }
+};
+
+
+} // end namespace
+
+#endif
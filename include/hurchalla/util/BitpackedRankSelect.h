@@ -0,0 +1,146 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#ifndef HURCHALLA_UTIL_BITPACKED_RANK_SELECT_H_INCLUDED
+#define HURCHALLA_UTIL_BITPACKED_RANK_SELECT_H_INCLUDED
+
+
+#include "hurchalla/util/BitpackedUintVectorView.h"
+#include "hurchalla/util/detail/ImplBitpackedRankSelect.h"
+#include "hurchalla/util/detail/util_programming_by_contract.h"
+#include "hurchalla/util/compiler_macros.h"
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace hurchalla {
+
+
+// BitpackedRankSelect adds rank and select queries to a bit vector, i.e. to
+// the packed data of a BitpackedUintVector<U, 1> (or any other vector with
+// element_bitlen == 1), which it accesses through a read only view:
+//
+//   rank1(i)   - the number of elements in [0, i) that are 1
+//   select1(k) - the index of the element that is the (k+1)th 1
+//
+// rank1() is constant time: it adds two directory entries to the popcounts of
+// at most 8 words.  select1() starts from a directory sample of every 8192nd
+// one and binary searches the 512 bit blocks up to the next sample, which
+// takes about log2(16/d) steps when the density of ones is d (e.g. 4 steps
+// if every bit is 1, 8 steps for one 1 in 16 bits), and then scans at most 8
+// words.  The directory takes about 3.2% of the size of the bit vector, plus
+// at most about 0.8% for the select samples; see directoryBytes().
+//
+// For example, over a sieve where bit i is 1 if and only if i is prime,
+// rank1(n + 1) is the number of primes <= n, and select1(k) is the (k+1)th
+// prime, without a separate prime index table.
+//
+// The directory describes the bits as they were when it was built.  If you
+// change the vector's elements, call rebuild() before using rank1() or
+// select1() again.  The vector's data must stay alive (and in place) for as
+// long as this object is used.
+
+template <typename U>
+class BitpackedRankSelect
+{
+    using Impl = detail::ImplBitpackedRankSelect;
+public:
+    using View = ConstBitpackedUintVectorView<U, 1>;
+    using size_type = typename View::size_type;
+
+    // (a non-const view, or the view() of a vector, converts to View)
+    explicit BitpackedRankSelect(View view) :
+            bits(view), super(), block(), samples(), ones(0)
+    {
+        rebuild();
+    }
+    ~BitpackedRankSelect();
+    BitpackedRankSelect(const BitpackedRankSelect&) = default;
+    BitpackedRankSelect(BitpackedRankSelect&&) = default;
+    BitpackedRankSelect& operator=(const BitpackedRankSelect&) = default;
+    BitpackedRankSelect& operator=(BitpackedRankSelect&&) = default;
+
+    // Rebuilds the directory from the current values of the elements.  This
+    // is linear time, and reads the whole vector.
+    void rebuild()
+    {
+        ones = Impl::build(super, block, samples, bits.data(),
+                       bits.dataSizeBytes(), static_cast<uint64_t>(bits.size()));
+    }
+
+    // Returns the number of 1 elements at indices [0, i).  i must be
+    // <= size().
+    HURCHALLA_FORCE_INLINE size_type rank1(size_type i) const
+    {
+        HPBC_UTIL_API_PRECONDITION(i <= size());
+        return static_cast<size_type>(Impl::rank1(super, block, bits.data(),
+                             bits.dataSizeBytes(),
+                             static_cast<uint64_t>(bits.size()),
+                             static_cast<uint64_t>(i)));
+    }
+
+    // Returns the number of 0 elements at indices [0, i).  i must be
+    // <= size().
+    HURCHALLA_FORCE_INLINE size_type rank0(size_type i) const
+    {
+        return i - rank1(i);
+    }
+
+    // Returns the index of the 1 element of rank k, i.e. the index i such
+    // that getAt(i) == 1 and rank1(i) == k.  k must be < count1().
+    HURCHALLA_FORCE_INLINE size_type select1(size_type k) const
+    {
+        HPBC_UTIL_API_PRECONDITION(k < count1());
+        size_type i = static_cast<size_type>(Impl::select1(super, block,
+                             samples, bits.data(), bits.dataSizeBytes(),
+                             static_cast<uint64_t>(bits.size()),
+                             static_cast<uint64_t>(k)));
+        HPBC_UTIL_POSTCONDITION(i < size() && bits.getAt(i) == 1);
+        return i;
+    }
+
+    // returns the total number of 1 elements
+    HURCHALLA_FORCE_INLINE size_type count1() const
+    {
+        return static_cast<size_type>(ones);
+    }
+
+    // returns the number of elements (bits)
+    HURCHALLA_FORCE_INLINE size_type size() const
+    {
+        return bits.size();
+    }
+
+    // returns the number of bytes that the directory uses
+    std::size_t directoryBytes() const
+    {
+        return super.capacity() * sizeof(super[0]) +
+               block.capacity() * sizeof(block[0]) +
+               samples.capacity() * sizeof(samples[0]);
+    }
+
+    HURCHALLA_FORCE_INLINE const View& view() const
+    {
+        return bits;
+    }
+
+private:
+    View bits;
+    // the directory (see ImplBitpackedRankSelect)
+    std::vector<uint64_t> super;
+    std::vector<uint16_t> block;
+    std::vector<uint64_t> samples;
+    uint64_t ones;
+};
+
+// The destructor is defined out of the class (and so isn't implicitly
+// inline), because destroying the directory's vectors is too much code for
+// the compiler to want to inline on the unlikely paths that call it, such as
+// unwinding.
+template <typename U>
+BitpackedRankSelect<U>::~BitpackedRankSelect() {}
+
+
+} // end namespace
+
+#endif
@@ -5,7 +5,10 @@
 #define HURCHALLA_UTIL_BITPACKED_UINT_VECTOR_H_INCLUDED
 
 
+#include "hurchalla/util/BitpackedHeapStorage.h"
+#include "hurchalla/util/BitpackedUintVectorView.h"
 #include "hurchalla/util/detail/ImplBitpackedUintVector.h"
+#include "hurchalla/util/detail/ImplBitpackedUintVectorIterators.h"
 #include "hurchalla/util/detail/util_programming_by_contract.h"
 #include <cstdint>
 #include <limits>
@@ -25,17 +28,31 @@ namespace hurchalla {
 //    Requirements 1 and 2 may acceptably cause loss in performance, though
 //    read/write speed should be extremely good (perhaps near optimal) when
 //    accesses of memory or CPU cache is a bottleneck.
+//
+// The Storage template parameter is a policy that allocates the packed data;
+// see BitpackedHeapStorage.h.  The default uses new[].  For very large
+// vectors, BitpackedPageStorage<> (from BitpackedUintVectorStorage.h) gets
+// (optionally huge page backed) memory directly from the OS, without the up
+// front memset that new[]() does.
 
 
-template <typename U, unsigned int element_bitlen>
+template <typename U, unsigned int element_bitlen,
+          class Storage = BitpackedHeapStorage>
 struct BitpackedUintVector
 {
     static_assert(std::numeric_limits<U>::is_integer, "");
     static_assert(!std::numeric_limits<U>::is_signed, "");
     static_assert(element_bitlen <= std::numeric_limits<U>::digits, "");
-    static_assert(0 < element_bitlen && element_bitlen <= 32, "");
+    static_assert(0 < element_bitlen && element_bitlen <= 64, "");
     using size_type = typename
                   detail::ImplBitpackedUintVector<U, element_bitlen>::size_type;
+    // Random access iterators.  Like std::vector<bool>, a non-const iterator
+    // dereferences to a proxy reference rather than to a U&.
+    using iterator = detail::BitpackedUintVectorIterator<U, element_bitlen>;
+    using const_iterator =
+                  detail::BitpackedUintVectorConstIterator<U, element_bitlen>;
+    using ReadCursor =
+                  detail::BitpackedUintVectorReadCursor<U, element_bitlen>;
 
     BitpackedUintVector(const BitpackedUintVector&) = delete;
     BitpackedUintVector& operator=(const BitpackedUintVector&) = delete;
@@ -46,7 +63,8 @@ struct BitpackedUintVector
     BitpackedUintVector(size_type count) : impl_buv(count) {}
 
     // constructor for deserialization.  Note: use data(), dataSizeBytes(), and
-    // size() to serialize.
+    // size() to serialize.  Unless Storage is BitpackedHeapStorage, this
+    // copies the data into memory from Storage.
     BitpackedUintVector(std::unique_ptr<unsigned char[]> data,
                         std::size_t data_bytes,
                         size_type element_count) :
@@ -68,6 +86,180 @@ struct BitpackedUintVector
         return value;
     }
 
+    // Reads the 'count' elements beginning at index 'first', into out[0] to
+    // out[count-1].  For sequential access this is much faster than calling
+    // getAt() in a loop, since it unpacks whole groups of 8 elements at once.
+    HURCHALLA_FORCE_INLINE void getRange(size_type first, size_type count,
+                                         U* out) const
+    {
+        HPBC_UTIL_API_PRECONDITION(first <= size());
+        HPBC_UTIL_API_PRECONDITION(count <= size() - first);
+        impl_buv.getRange(first, count, out);
+    }
+
+    // Writes in[0] to in[count-1] into the 'count' elements beginning at index
+    // 'first'.  Every value in 'in' must be <= max_allowed_value().  For
+    // sequential access this is much faster than calling setAt() in a loop,
+    // since it packs whole groups of 8 elements at once.
+    HURCHALLA_FORCE_INLINE void setRange(size_type first, size_type count,
+                                         const U* in)
+    {
+        HPBC_UTIL_API_PRECONDITION(first <= size());
+        HPBC_UTIL_API_PRECONDITION(count <= size() - first);
+        impl_buv.setRange(first, count, in);
+    }
+
+    // Reads the elements at indices[0] to indices[n-1], into out[0] to
+    // out[n-1].  For random indices into a vector that is much larger than
+    // the CPU caches, this is much faster than calling getAt() in a loop:
+    // it prefetches each element 'prefetch_distance' elements before it reads
+    // it, so that many cache misses can be in flight at once.  The best
+    // distance depends on the machine; the default is usually close.  It
+    // must be <= max_prefetch_distance().
+    HURCHALLA_FORCE_INLINE void gather(const size_type* indices, std::size_t n,
+                 U* out, std::size_t prefetch_distance = detail::
+                 ImplBitpackedUintVector<U, element_bitlen>::
+                 DEFAULT_PREFETCH_DISTANCE) const
+    {
+        HPBC_UTIL_API_PRECONDITION(prefetch_distance <= max_prefetch_distance());
+        for (std::size_t i = 0; i < n; ++i)
+            HPBC_UTIL_API_PRECONDITION(indices[i] < size());
+        impl_buv.gather(indices, n, out, prefetch_distance);
+    }
+
+    // Writes in[i] to the element at indices[i], for i from 0 to n-1, with
+    // prefetching as in gather().  Every value in 'in' must be
+    // <= max_allowed_value().  The writes happen in order, so if an index
+    // repeats, its last value wins.
+    HURCHALLA_FORCE_INLINE void scatter(const size_type* indices, std::size_t n,
+                 const U* in, std::size_t prefetch_distance = detail::
+                 ImplBitpackedUintVector<U, element_bitlen>::
+                 DEFAULT_PREFETCH_DISTANCE)
+    {
+        HPBC_UTIL_API_PRECONDITION(prefetch_distance <= max_prefetch_distance());
+        for (std::size_t i = 0; i < n; ++i) {
+            HPBC_UTIL_API_PRECONDITION(indices[i] < size());
+            HPBC_UTIL_API_PRECONDITION(in[i] <= max_allowed_value());
+        }
+        impl_buv.scatter(indices, n, in, prefetch_distance);
+    }
+
+    HURCHALLA_FORCE_INLINE static constexpr std::size_t max_prefetch_distance()
+    {
+        return decltype(impl_buv)::MAX_PREFETCH_DISTANCE;
+    }
+
+    // Separate threads can write to the index ranges
+    // [partitionPoint(i, num_parts), partitionPoint(i+1, num_parts)), for
+    // 0 <= i < num_parts, without any synchronization, since these ranges never
+    // share a byte.  Each boundary is close to i*size()/num_parts.  The
+    // threads can use setAt(), getAt(), setRange(), and iterators within
+    // their range (but not getRange() or readCursor(), which may read bytes
+    // beyond the elements they return).
+    HURCHALLA_FORCE_INLINE
+    size_type partitionPoint(unsigned int part, unsigned int num_parts) const
+    {
+        HPBC_UTIL_API_PRECONDITION(0 < num_parts);
+        HPBC_UTIL_API_PRECONDITION(part <= num_parts);
+        return decltype(impl_buv)::partitionPoint(size(), part, num_parts);
+    }
+
+    // The atomic functions below are safe to call concurrently with each other
+    // from multiple threads, on any indices (including the same index), and
+    // each is indivisible.  They are only available when element_bitlen
+    // divides 64 (1, 2, 4, 8, 16, 32, or 64), since then each element lies
+    // within a single aligned byte or word that one atomic operation can
+    // cover.  They use relaxed memory ordering, and they must not be mixed
+    // with concurrent non-atomic writes.  See the comments on concurrent
+    // access in ImplBitpackedUintVector.h.
+    HURCHALLA_FORCE_INLINE void atomicSetAt(size_type index, U value)
+    {
+        HPBC_UTIL_API_PRECONDITION(value <= max_allowed_value());
+        HPBC_UTIL_API_PRECONDITION(index < size());
+        impl_buv.atomicSetAt(index, value);
+    }
+    // Sets the element at 'index' to (element | bits), and returns the
+    // element's previous value.
+    HURCHALLA_FORCE_INLINE U atomicFetchOr(size_type index, U bits)
+    {
+        HPBC_UTIL_API_PRECONDITION(bits <= max_allowed_value());
+        HPBC_UTIL_API_PRECONDITION(index < size());
+        return impl_buv.atomicFetchOr(index, bits);
+    }
+    HURCHALLA_FORCE_INLINE U atomicGetAt(size_type index) const
+    {
+        HPBC_UTIL_API_PRECONDITION(index < size());
+        U value = impl_buv.atomicGetAt(index);
+        HPBC_UTIL_POSTCONDITION(value <= max_allowed_value());
+        return value;
+    }
+
+    HURCHALLA_FORCE_INLINE iterator begin()
+    {
+        return makeIterator<iterator>(0);
+    }
+    HURCHALLA_FORCE_INLINE iterator end()
+    {
+        return makeIterator<iterator>(size());
+    }
+    HURCHALLA_FORCE_INLINE const_iterator begin() const
+    {
+        return makeIterator<const_iterator>(0);
+    }
+    HURCHALLA_FORCE_INLINE const_iterator end() const
+    {
+        return makeIterator<const_iterator>(size());
+    }
+    HURCHALLA_FORCE_INLINE const_iterator cbegin() const
+    {
+        return begin();
+    }
+    HURCHALLA_FORCE_INLINE const_iterator cend() const
+    {
+        return end();
+    }
+
+    // Returns a cursor whose first call to next() gives the element at index
+    // 'first', and each following call gives the next element.  For a
+    // sequential scan this is usually faster than iterators or getAt(), since
+    // the cursor decodes 8 elements at a time.
+    HURCHALLA_FORCE_INLINE ReadCursor readCursor(size_type first) const
+    {
+        HPBC_UTIL_API_PRECONDITION(first <= size());
+        size_type group_first = first - first % 8;
+        typename detail::ImplBitpackedUintVector<U, element_bitlen>::
+                                                      NoAliasUchar* ptr;
+        std::size_t bit_offset;
+        impl_buv.getLocation(group_first, ptr, bit_offset);
+        std::size_t offset_bytes = static_cast<std::size_t>(
+                                  reinterpret_cast<const unsigned char*>(ptr) -
+                                  impl_buv.data());
+        return ReadCursor(ptr, static_cast<unsigned int>(first % 8),
+                          size() - group_first,
+                          impl_buv.dataSizeBytes() - offset_bytes);
+    }
+
+    // Returns a view of this vector's data (see BitpackedUintVectorView.h),
+    // which is valid until this vector is destroyed or moved from.  Functions
+    // that work on views, such as those in BitpackedUintVectorAlgorithms.h,
+    // can use it.
+    BitpackedUintVectorView<U, element_bitlen> view()
+    {
+        typename detail::ImplBitpackedUintVector<U, element_bitlen>::
+                                                      NoAliasUchar* ptr;
+        std::size_t bit_offset;
+        impl_buv.getLocation(0, ptr, bit_offset);
+        return BitpackedUintVectorView<U, element_bitlen>(
+                            reinterpret_cast<unsigned char*>(ptr),
+                            impl_buv.dataSizeBytes(), impl_buv.size());
+    }
+    ConstBitpackedUintVectorView<U, element_bitlen> view() const
+    {
+        return ConstBitpackedUintVectorView<U, element_bitlen>(
+                            impl_buv.data(), impl_buv.dataSizeBytes(),
+                            impl_buv.size());
+    }
+
     // returns the number of packed elements in this vector
     HURCHALLA_FORCE_INLINE size_type size() const
     {
@@ -108,7 +300,17 @@ struct BitpackedUintVector
     }
 
 private:
-    detail::ImplBitpackedUintVector<U, element_bitlen> impl_buv;
+    template <class It>
+    HURCHALLA_FORCE_INLINE It makeIterator(size_type index) const
+    {
+        typename detail::ImplBitpackedUintVector<U, element_bitlen>::
+                                                      NoAliasUchar* ptr;
+        std::size_t bit_offset;
+        impl_buv.getLocation(index, ptr, bit_offset);
+        return It(ptr, static_cast<unsigned int>(bit_offset));
+    }
+
+    detail::ImplBitpackedUintVector<U, element_bitlen, Storage> impl_buv;
 };
 
 
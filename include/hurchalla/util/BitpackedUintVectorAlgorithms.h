@@ -0,0 +1,172 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#ifndef HURCHALLA_UTIL_BITPACKED_UINT_VECTOR_ALGORITHMS_H_INCLUDED
+#define HURCHALLA_UTIL_BITPACKED_UINT_VECTOR_ALGORITHMS_H_INCLUDED
+
+
+#include "hurchalla/util/BitpackedUintVector.h"
+#include "hurchalla/util/BitpackedUintVectorView.h"
+#include "hurchalla/util/detail/ImplBitpackedUintVectorAlgorithms.h"
+#include "hurchalla/util/detail/util_programming_by_contract.h"
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace hurchalla {
+
+
+// Multithreaded bulk operations on the elements of a BitpackedUintVectorView.
+// (Use BitpackedUintVector::view() for a vector, or
+// MappedBitpackedUintVector::view() for the read only operations on a mapped
+// file.)
+//
+// Each function splits the elements into one contiguous chunk per thread,
+// with chunk boundaries on 8 element groups so that no two threads ever
+// access the same byte, and runs the chunks on std::thread workers.  You may
+// need to link with your platform's threads library.  If num_threads is 0,
+// std::thread::hardware_concurrency() threads are used.  Fewer threads are
+// used for small views (below roughly 64K elements per thread), and a view
+// that small runs entirely on the calling thread.
+//
+// While one of these functions runs, no other thread may write to the view's
+// elements.  Function objects are called concurrently from several threads,
+// on elements in an unspecified order.  If a function object throws, the
+// first exception is rethrown after all threads finish (in which case
+// parallel_transform may have changed any number of elements).
+
+
+// Sets every element to 'value'.  (The value's type is not deduced, so a
+// literal like 0 works for any U.)
+template <typename U, unsigned int element_bitlen>
+void parallel_fill(const BitpackedUintVectorView<U, element_bitlen>& view,
+                   typename std::common_type<U>::type value,
+                   unsigned int num_threads = 0)
+{
+    HPBC_UTIL_API_PRECONDITION(value <= view.max_allowed_value());
+    using Impl = detail::ImplBitpackedUintVectorAlgorithms<U, element_bitlen>;
+    using NoAliasUchar = typename
+                detail::ImplBitpackedUintVector<U, element_bitlen>::NoAliasUchar;
+    Impl::fill(reinterpret_cast<NoAliasUchar*>(view.data()), view.size(),
+               value, num_threads);
+}
+
+// Replaces every element x with f(x).  f must return values that are
+// <= max_allowed_value().
+template <typename U, unsigned int element_bitlen, class F>
+void parallel_transform(const BitpackedUintVectorView<U, element_bitlen>& view,
+                        const F& f, unsigned int num_threads = 0)
+{
+    using Impl = detail::ImplBitpackedUintVectorAlgorithms<U, element_bitlen>;
+    using NoAliasUchar = typename
+                detail::ImplBitpackedUintVector<U, element_bitlen>::NoAliasUchar;
+    Impl::transform(reinterpret_cast<NoAliasUchar*>(view.data()),
+                    view.dataSizeBytes(), view.size(), f, num_threads);
+}
+
+// Returns the number of elements x for which pred(x) is true.
+template <typename U, unsigned int element_bitlen, bool is_const, class Pred>
+typename BitpackedUintVectorView<U, element_bitlen, is_const>::size_type
+parallel_count_if(
+          const BitpackedUintVectorView<U, element_bitlen, is_const>& view,
+          const Pred& pred, unsigned int num_threads = 0)
+{
+    using Impl = detail::ImplBitpackedUintVectorAlgorithms<U, element_bitlen>;
+    using NoAliasUchar = typename
+                detail::ImplBitpackedUintVector<U, element_bitlen>::NoAliasUchar;
+    return Impl::countIf(reinterpret_cast<const NoAliasUchar*>(view.data()),
+                    view.dataSizeBytes(), view.size(), pred, num_threads);
+}
+
+// Returns the pair (smallest element, largest element).  The view must not
+// be empty.
+template <typename U, unsigned int element_bitlen, bool is_const>
+std::pair<U, U>
+parallel_minmax(
+          const BitpackedUintVectorView<U, element_bitlen, is_const>& view,
+          unsigned int num_threads = 0)
+{
+    HPBC_UTIL_API_PRECONDITION(view.size() > 0);
+    using Impl = detail::ImplBitpackedUintVectorAlgorithms<U, element_bitlen>;
+    using NoAliasUchar = typename
+                detail::ImplBitpackedUintVector<U, element_bitlen>::NoAliasUchar;
+    return Impl::minmax(reinterpret_cast<const NoAliasUchar*>(view.data()),
+                    view.dataSizeBytes(), view.size(), num_threads);
+}
+
+// Returns a histogram of the elements: bin i is the number of elements x for
+// which (x >> bucket_shift) == i, and there are (max_allowed_value() >>
+// bucket_shift) + 1 bins.  element_bitlen - bucket_shift must be at most 24
+// (for 32 bit elements, bucket_shift = 8 gives 16M bins), and by default
+// bucket_shift is the smallest value that allows.  Each thread counts into
+// its own copy of the bins, so a thread is only used for every (number of
+// bins) elements; with many bins and few elements, this runs on fewer
+// threads than num_threads.
+template <typename U, unsigned int element_bitlen, bool is_const>
+std::vector<std::uint64_t>
+parallel_histogram(
+          const BitpackedUintVectorView<U, element_bitlen, is_const>& view,
+          unsigned int bucket_shift = (element_bitlen > 24) ?
+                                      element_bitlen - 24 : 0,
+          unsigned int num_threads = 0)
+{
+    HPBC_UTIL_API_PRECONDITION(bucket_shift <= element_bitlen);
+    HPBC_UTIL_API_PRECONDITION(element_bitlen - bucket_shift <= 24);
+    using Impl = detail::ImplBitpackedUintVectorAlgorithms<U, element_bitlen>;
+    using NoAliasUchar = typename
+                detail::ImplBitpackedUintVector<U, element_bitlen>::NoAliasUchar;
+    return Impl::histogram(reinterpret_cast<const NoAliasUchar*>(view.data()),
+                    view.dataSizeBytes(), view.size(), bucket_shift,
+                    num_threads);
+}
+
+
+// Overloads for BitpackedUintVector, which use its view().
+
+template <typename U, unsigned int element_bitlen, class Storage>
+void parallel_fill(BitpackedUintVector<U, element_bitlen, Storage>& vec,
+                   typename std::common_type<U>::type value,
+                   unsigned int num_threads = 0)
+{
+    parallel_fill(vec.view(), value, num_threads);
+}
+
+template <typename U, unsigned int element_bitlen, class Storage, class F>
+void parallel_transform(BitpackedUintVector<U, element_bitlen, Storage>& vec,
+                        const F& f, unsigned int num_threads = 0)
+{
+    parallel_transform(vec.view(), f, num_threads);
+}
+
+template <typename U, unsigned int element_bitlen, class Storage, class Pred>
+typename BitpackedUintVector<U, element_bitlen, Storage>::size_type
+parallel_count_if(const BitpackedUintVector<U, element_bitlen, Storage>& vec,
+                  const Pred& pred, unsigned int num_threads = 0)
+{
+    return parallel_count_if(vec.view(), pred, num_threads);
+}
+
+template <typename U, unsigned int element_bitlen, class Storage>
+std::pair<U, U>
+parallel_minmax(const BitpackedUintVector<U, element_bitlen, Storage>& vec,
+                unsigned int num_threads = 0)
+{
+    return parallel_minmax(vec.view(), num_threads);
+}
+
+template <typename U, unsigned int element_bitlen, class Storage>
+std::vector<std::uint64_t>
+parallel_histogram(const BitpackedUintVector<U, element_bitlen, Storage>& vec,
+                   unsigned int bucket_shift = (element_bitlen > 24) ?
+                                               element_bitlen - 24 : 0,
+                   unsigned int num_threads = 0)
+{
+    return parallel_histogram(vec.view(), bucket_shift, num_threads);
+}
+
+
+} // end namespace
+
+#endif
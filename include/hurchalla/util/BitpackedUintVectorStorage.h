@@ -0,0 +1,58 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#ifndef HURCHALLA_UTIL_BITPACKED_UINT_VECTOR_STORAGE_H_INCLUDED
+#define HURCHALLA_UTIL_BITPACKED_UINT_VECTOR_STORAGE_H_INCLUDED
+
+
+#include "hurchalla/util/BitpackedHeapStorage.h"
+#include "hurchalla/util/detail/platform_specific/impl_page_allocation.h"
+#include <cstddef>
+
+namespace hurchalla {
+
+
+// A storage policy (see BitpackedHeapStorage.h) for large vectors, with
+// memory that comes directly from the OS.  The OS supplies it already zeroed
+// (lazily, a page at a time), so allocation is fast and no thread spends time
+// in a memset.
+//
+// If huge_pages is true, on Linux the memory is aligned for and advised to
+// use transparent huge pages (madvise MADV_HUGEPAGE), which greatly reduces
+// TLB misses for random access to multi-GB vectors.  It's a hint that the
+// kernel may ignore, depending on /sys/kernel/mm/transparent_hugepage.
+//
+// If first_touch_threads > 1, allocate() touches every page using that many
+// threads, each handling an equal contiguous share of the pages.  With the
+// usual first-touch NUMA policy this spreads the vector over the nodes those
+// threads run on, rather than placing it all on the node of whichever thread
+// happens to write it first.  (This uses std::thread, so you may need to link
+// with your platform's threads library.)  If first_touch_threads is 0 or 1,
+// pages are placed lazily as they're written.
+template <bool huge_pages = true, unsigned int first_touch_threads = 0>
+struct BitpackedPageStorage {
+    static unsigned char* allocate(std::size_t bytes)
+    {
+        unsigned char* p =
+                 detail::impl_page_allocation::allocate(bytes, huge_pages);
+        if (first_touch_threads > 1) {
+            try {
+                detail::impl_page_allocation::first_touch(p, bytes,
+                                                      first_touch_threads);
+            } catch (...) {
+                detail::impl_page_allocation::deallocate(p, bytes);
+                throw;
+            }
+        }
+        return p;
+    }
+    static void deallocate(unsigned char* p, std::size_t bytes) noexcept
+    {
+        detail::impl_page_allocation::deallocate(p, bytes);
+    }
+};
+
+
+} // end namespace
+
+#endif
@@ -0,0 +1,142 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#ifndef HURCHALLA_UTIL_BITPACKED_UINT_VECTOR_STREAM_H_INCLUDED
+#define HURCHALLA_UTIL_BITPACKED_UINT_VECTOR_STREAM_H_INCLUDED
+
+
+#include "hurchalla/util/BitpackedUintVector.h"
+#include "hurchalla/util/BitpackedHeapStorage.h"
+#include "hurchalla/util/BitpackedUintVectorView.h"
+#include "hurchalla/util/detail/ImplBitpackedUintVectorStream.h"
+#include "hurchalla/util/detail/util_programming_by_contract.h"
+#include <cstdint>
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+namespace hurchalla {
+
+
+// Streaming serialization of bitpacked vectors, to and from a std::ostream /
+// std::istream or a file descriptor.  Unlike serializing data() as a single
+// buffer, these move the data in fixed size chunks directly from and to the
+// vector's own memory, so checkpointing or loading even a very large vector
+// needs no second buffer.  The stream has a header with the format ID,
+// element_bitlen, element count, and chunk size, and every chunk is followed
+// by its CRC-32C, so that a corrupt or truncated stream is detected on load.
+// (The exact format is described in ImplBitpackedUintVectorStream.h.)
+//
+// The CRC uses the CPU's crc32c instruction if you compile for a CPU that has
+// it (e.g. -msse4.2 or -march=native on x86), and is otherwise several times
+// slower than reading memory; see impl_crc32c.h.
+//
+// The write functions throw std::runtime_error if the stream fails (the fd
+// versions throw std::system_error, which is a std::runtime_error).  The
+// read functions throw std::runtime_error if the stream fails or is
+// truncated, if its header doesn't match the vector type, or if a checksum
+// doesn't match.
+
+
+// Writes the view's elements to 'os', in chunks of chunk_bytes bytes.
+// chunk_bytes must be from 1 to 2^30.
+template <typename U, unsigned int element_bitlen, bool is_const>
+void write_bitpacked_stream(std::ostream& os,
+        const BitpackedUintVectorView<U, element_bitlen, is_const>& view,
+        std::size_t chunk_bytes =
+                detail::ImplBitpackedUintVectorStream::DEFAULT_CHUNK_BYTES)
+{
+    auto sink = [&os](const unsigned char* p, std::size_t n) {
+        os.write(reinterpret_cast<const char*>(p),
+                 static_cast<std::streamsize>(n));
+        if (!os)
+            throw std::runtime_error("unable to write bitpacked stream");
+    };
+    HPBC_UTIL_API_PRECONDITION(0 < chunk_bytes &&
+         chunk_bytes <= detail::ImplBitpackedUintVectorStream::MAX_CHUNK_BYTES);
+    detail::ImplBitpackedUintVectorStream::writeView(sink, view, chunk_bytes);
+}
+
+// As above, to the file descriptor 'fd'.
+template <typename U, unsigned int element_bitlen, bool is_const>
+void write_bitpacked_stream(int fd,
+        const BitpackedUintVectorView<U, element_bitlen, is_const>& view,
+        std::size_t chunk_bytes =
+                detail::ImplBitpackedUintVectorStream::DEFAULT_CHUNK_BYTES)
+{
+    auto sink = [fd](const unsigned char* p, std::size_t n) {
+        detail::impl_fd_io::writeAll(fd, p, n);
+    };
+    HPBC_UTIL_API_PRECONDITION(0 < chunk_bytes &&
+         chunk_bytes <= detail::ImplBitpackedUintVectorStream::MAX_CHUNK_BYTES);
+    detail::ImplBitpackedUintVectorStream::writeView(sink, view, chunk_bytes);
+}
+
+// Reads a stream written by write_bitpacked_stream() into the view's memory
+// (for example an arena, or a writable MappedBitpackedUintVector).  The
+// stream's element count must equal view.size().
+template <typename U, unsigned int element_bitlen>
+void read_bitpacked_stream(std::istream& is,
+                   const BitpackedUintVectorView<U, element_bitlen>& view)
+{
+    detail::ImplBitpackedUintVectorStream::IstreamSource source{is};
+    detail::ImplBitpackedUintVectorStream::readIntoView(source, view);
+}
+
+// As above, from the file descriptor 'fd'.
+template <typename U, unsigned int element_bitlen>
+void read_bitpacked_stream(int fd,
+                   const BitpackedUintVectorView<U, element_bitlen>& view)
+{
+    detail::ImplBitpackedUintVectorStream::FdSource source{fd};
+    detail::ImplBitpackedUintVectorStream::readIntoView(source, view);
+}
+
+
+// Overloads for BitpackedUintVector.
+
+template <typename U, unsigned int element_bitlen, class Storage>
+void write_bitpacked_stream(std::ostream& os,
+        const BitpackedUintVector<U, element_bitlen, Storage>& vec,
+        std::size_t chunk_bytes =
+                detail::ImplBitpackedUintVectorStream::DEFAULT_CHUNK_BYTES)
+{
+    write_bitpacked_stream(os, vec.view(), chunk_bytes);
+}
+
+template <typename U, unsigned int element_bitlen, class Storage>
+void write_bitpacked_stream(int fd,
+        const BitpackedUintVector<U, element_bitlen, Storage>& vec,
+        std::size_t chunk_bytes =
+                detail::ImplBitpackedUintVectorStream::DEFAULT_CHUNK_BYTES)
+{
+    write_bitpacked_stream(fd, vec.view(), chunk_bytes);
+}
+
+// Returns a new vector with the contents of the stream, e.g.
+//   auto vec = read_bitpacked_stream<uint32_t, 13>(is);
+template <typename U, unsigned int element_bitlen,
+          class Storage = BitpackedHeapStorage>
+BitpackedUintVector<U, element_bitlen, Storage>
+read_bitpacked_stream(std::istream& is)
+{
+    detail::ImplBitpackedUintVectorStream::IstreamSource source{is};
+    return detail::ImplBitpackedUintVectorStream::
+                         readVector<U, element_bitlen, Storage>(source);
+}
+
+template <typename U, unsigned int element_bitlen,
+          class Storage = BitpackedHeapStorage>
+BitpackedUintVector<U, element_bitlen, Storage>
+read_bitpacked_stream(int fd)
+{
+    detail::ImplBitpackedUintVectorStream::FdSource source{fd};
+    return detail::ImplBitpackedUintVectorStream::
+                         readVector<U, element_bitlen, Storage>(source);
+}
+
+
+} // end namespace
+
+#endif
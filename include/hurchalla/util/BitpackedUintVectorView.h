@@ -0,0 +1,270 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#ifndef HURCHALLA_UTIL_BITPACKED_UINT_VECTOR_VIEW_H_INCLUDED
+#define HURCHALLA_UTIL_BITPACKED_UINT_VECTOR_VIEW_H_INCLUDED
+
+
+#include "hurchalla/util/detail/ImplBitpackedUintVector.h"
+#include "hurchalla/util/detail/ImplBitpackedUintVectorIterators.h"
+#include "hurchalla/util/detail/util_programming_by_contract.h"
+#include "hurchalla/util/compiler_macros.h"
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+namespace hurchalla {
+
+
+// BitpackedUintVectorView provides the same element access as
+// BitpackedUintVector, for packed data that lives in memory the caller owns
+// (an arena, a shared memory segment, a huge page allocation, a memory mapped
+// file, etc).  It never allocates or frees anything, and it is cheap to copy;
+// the caller must keep the memory alive for as long as any view of it is
+// used.  The memory has exactly the same layout as BitpackedUintVector::data(),
+// so a view can be placed over serialized data without a copy.
+//
+// If is_const is true the view is read only, and it can be constructed from
+// a const unsigned char* (or from a non-const view).
+
+template <typename U, unsigned int element_bitlen, bool is_const = false>
+class BitpackedUintVectorView
+{
+    using Impl = detail::ImplBitpackedUintVector<U, element_bitlen>;
+    static_assert(0 < element_bitlen && element_bitlen <= 64, "");
+    using Uchar = typename std::conditional<is_const,
+                                const unsigned char, unsigned char>::type;
+    using NoAliasUchar = typename std::conditional<is_const,
+                                const typename Impl::NoAliasUchar,
+                                typename Impl::NoAliasUchar>::type;
+public:
+    using size_type = typename Impl::size_type;
+    // For a const view, iterator and const_iterator are the same type.
+    using iterator = typename std::conditional<is_const,
+            detail::BitpackedUintVectorConstIterator<U, element_bitlen>,
+            detail::BitpackedUintVectorIterator<U, element_bitlen>>::type;
+    using const_iterator =
+                  detail::BitpackedUintVectorConstIterator<U, element_bitlen>;
+    using ReadCursor =
+                  detail::BitpackedUintVectorReadCursor<U, element_bitlen>;
+
+    // 'data' must point to at least dataSizeBytes(element_count) bytes, and
+    // data_bytes is the size of that memory.  Throws std::length_error if
+    // element_count is too large or data_bytes is too small.
+    BitpackedUintVectorView(Uchar* data, std::size_t data_bytes,
+                            size_type element_count) :
+          vec8(reinterpret_cast<NoAliasUchar*>(data)),
+          vec8_bytes(dataSizeBytes(element_count)),
+          packed_count(element_count)
+    {
+        HPBC_UTIL_API_PRECONDITION(data != nullptr);
+        if (vec8_bytes == 0)
+            throw std::length_error("BitpackedUintVectorView size too large, would overflow");
+        if (data_bytes < vec8_bytes)
+            throw std::length_error("data_bytes is less than the bytes needed for element_count");
+    }
+
+    // a non-const view converts to a const view
+    template <bool C = is_const, typename = typename std::enable_if<C>::type>
+    BitpackedUintVectorView(
+                 const BitpackedUintVectorView<U, element_bitlen, false>& other) :
+          vec8(reinterpret_cast<NoAliasUchar*>(other.data())),
+          vec8_bytes(other.dataSizeBytes()),
+          packed_count(other.size())
+    {}
+
+
+    template <bool C = is_const>
+    HURCHALLA_FORCE_INLINE typename std::enable_if<!C, void>::type
+    setAt(size_type index, U value) const
+    {
+        HPBC_UTIL_API_PRECONDITION(value <= max_allowed_value());
+        HPBC_UTIL_API_PRECONDITION(index < size());
+        Impl::writeIndex(vec8, vec8_bytes, index, value);
+    }
+
+    HURCHALLA_FORCE_INLINE U getAt(size_type index) const
+    {
+        HPBC_UTIL_API_PRECONDITION(index < size());
+        U value = Impl::readIndex(vec8, vec8_bytes, index);
+        HPBC_UTIL_POSTCONDITION(value <= max_allowed_value());
+        return value;
+    }
+
+    // Reads the 'count' elements beginning at index 'first', into out[0] to
+    // out[count-1].
+    HURCHALLA_FORCE_INLINE void getRange(size_type first, size_type count,
+                                         U* out) const
+    {
+        HPBC_UTIL_API_PRECONDITION(first <= size());
+        HPBC_UTIL_API_PRECONDITION(count <= size() - first);
+        Impl::readRange(vec8, dataSizeBytes(), first, count, out);
+    }
+
+    // Writes in[0] to in[count-1] into the 'count' elements beginning at index
+    // 'first'.  Every value in 'in' must be <= max_allowed_value().
+    template <bool C = is_const>
+    HURCHALLA_FORCE_INLINE typename std::enable_if<!C, void>::type
+    setRange(size_type first, size_type count, const U* in) const
+    {
+        HPBC_UTIL_API_PRECONDITION(first <= size());
+        HPBC_UTIL_API_PRECONDITION(count <= size() - first);
+        Impl::writeRange(vec8, first, count, in);
+    }
+
+    // See BitpackedUintVector::gather() and scatter().
+    HURCHALLA_FORCE_INLINE void gather(const size_type* indices, std::size_t n,
+                 U* out, std::size_t prefetch_distance =
+                 Impl::DEFAULT_PREFETCH_DISTANCE) const
+    {
+        HPBC_UTIL_API_PRECONDITION(prefetch_distance <= max_prefetch_distance());
+        for (std::size_t i = 0; i < n; ++i)
+            HPBC_UTIL_API_PRECONDITION(indices[i] < size());
+        Impl::readGather(vec8, indices, n, out, prefetch_distance);
+    }
+    template <bool C = is_const>
+    HURCHALLA_FORCE_INLINE typename std::enable_if<!C, void>::type
+    scatter(const size_type* indices, std::size_t n, const U* in,
+            std::size_t prefetch_distance = Impl::DEFAULT_PREFETCH_DISTANCE) const
+    {
+        HPBC_UTIL_API_PRECONDITION(prefetch_distance <= max_prefetch_distance());
+        for (std::size_t i = 0; i < n; ++i) {
+            HPBC_UTIL_API_PRECONDITION(indices[i] < size());
+            HPBC_UTIL_API_PRECONDITION(in[i] <= max_allowed_value());
+        }
+        Impl::writeScatter(vec8, indices, n, in, prefetch_distance);
+    }
+    HURCHALLA_FORCE_INLINE static constexpr std::size_t max_prefetch_distance()
+    {
+        return Impl::MAX_PREFETCH_DISTANCE;
+    }
+
+    // See BitpackedUintVector::partitionPoint().
+    HURCHALLA_FORCE_INLINE
+    size_type partitionPoint(unsigned int part, unsigned int num_parts) const
+    {
+        HPBC_UTIL_API_PRECONDITION(0 < num_parts);
+        HPBC_UTIL_API_PRECONDITION(part <= num_parts);
+        return Impl::partitionPoint(size(), part, num_parts);
+    }
+
+    // See BitpackedUintVector::atomicSetAt(), atomicFetchOr(), atomicGetAt().
+    // For element_bitlen >= 16, the view's data must be aligned to
+    // element_bitlen/8 bytes to use these.
+    template <bool C = is_const>
+    HURCHALLA_FORCE_INLINE typename std::enable_if<!C, void>::type
+    atomicSetAt(size_type index, U value) const
+    {
+        HPBC_UTIL_API_PRECONDITION(value <= max_allowed_value());
+        HPBC_UTIL_API_PRECONDITION(index < size());
+        Impl::atomicWriteIndex(vec8, dataSizeBytes(), index, value);
+    }
+    template <bool C = is_const>
+    HURCHALLA_FORCE_INLINE typename std::enable_if<!C, U>::type
+    atomicFetchOr(size_type index, U bits) const
+    {
+        HPBC_UTIL_API_PRECONDITION(bits <= max_allowed_value());
+        HPBC_UTIL_API_PRECONDITION(index < size());
+        return Impl::atomicFetchOrIndex(vec8, dataSizeBytes(), index, bits);
+    }
+    HURCHALLA_FORCE_INLINE U atomicGetAt(size_type index) const
+    {
+        HPBC_UTIL_API_PRECONDITION(index < size());
+        U value = Impl::atomicReadIndex(vec8, dataSizeBytes(), index);
+        HPBC_UTIL_POSTCONDITION(value <= max_allowed_value());
+        return value;
+    }
+
+    HURCHALLA_FORCE_INLINE iterator begin() const
+    {
+        return makeIterator<iterator>(0);
+    }
+    HURCHALLA_FORCE_INLINE iterator end() const
+    {
+        return makeIterator<iterator>(size());
+    }
+    HURCHALLA_FORCE_INLINE const_iterator cbegin() const
+    {
+        return makeIterator<const_iterator>(0);
+    }
+    HURCHALLA_FORCE_INLINE const_iterator cend() const
+    {
+        return makeIterator<const_iterator>(size());
+    }
+
+    // Returns a cursor whose first call to next() gives the element at index
+    // 'first'; see BitpackedUintVector::readCursor().
+    HURCHALLA_FORCE_INLINE ReadCursor readCursor(size_type first) const
+    {
+        HPBC_UTIL_API_PRECONDITION(first <= size());
+        size_type group_first = first - first % 8;
+        std::size_t starting_byte, bit_offset;
+        Impl::locateIndex(group_first, starting_byte, bit_offset);
+        HPBC_UTIL_ASSERT(bit_offset == 0);
+        return ReadCursor(vec8 + starting_byte,
+                          static_cast<unsigned int>(first % 8),
+                          size() - group_first,
+                          dataSizeBytes() - starting_byte);
+    }
+
+    // returns the number of packed elements in this view
+    HURCHALLA_FORCE_INLINE size_type size() const
+    {
+        return packed_count;
+    }
+
+    // returns the maximum value that fits within element_bitlen bits.
+    HURCHALLA_FORCE_INLINE static constexpr U max_allowed_value()
+    {
+        return Impl::max_allowed_value();
+    }
+
+    // returns 0 if element_count is an invalid size
+    static constexpr std::size_t dataSizeBytes(size_type element_count)
+    {
+        return Impl::dataSizeBytes(element_count);
+    }
+
+    // returns the number of bytes of the caller's memory that this view uses
+    HURCHALLA_FORCE_INLINE std::size_t dataSizeBytes() const
+    {
+        return vec8_bytes;
+    }
+
+    HURCHALLA_FORCE_INLINE Uchar* data() const
+    {
+        return reinterpret_cast<Uchar*>(vec8);
+    }
+
+    // this is the same format ID as BitpackedUintVector::getFormatID()
+    HURCHALLA_FORCE_INLINE static constexpr uint32_t getFormatID()
+    {
+        return Impl::getFormatID();
+    }
+
+private:
+    template <class It>
+    HURCHALLA_FORCE_INLINE It makeIterator(size_type index) const
+    {
+        std::size_t starting_byte, bit_offset;
+        Impl::locateIndex(index, starting_byte, bit_offset);
+        return It(vec8 + starting_byte, static_cast<unsigned int>(bit_offset));
+    }
+
+    NoAliasUchar* vec8;
+    std::size_t vec8_bytes;   // dataSizeBytes(packed_count)
+    size_type packed_count;
+};
+
+
+// a read only view
+template <typename U, unsigned int element_bitlen>
+using ConstBitpackedUintVectorView =
+                          BitpackedUintVectorView<U, element_bitlen, true>;
+
+
+} // end namespace
+
+#endif
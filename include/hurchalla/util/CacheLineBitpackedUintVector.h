@@ -0,0 +1,216 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#ifndef HURCHALLA_UTIL_CACHE_LINE_BITPACKED_UINT_VECTOR_H_INCLUDED
+#define HURCHALLA_UTIL_CACHE_LINE_BITPACKED_UINT_VECTOR_H_INCLUDED
+
+
+#include "hurchalla/util/BitpackedHeapStorage.h"
+#include "hurchalla/util/detail/ImplCacheLineBitpackedUintVector.h"
+#include "hurchalla/util/detail/util_programming_by_contract.h"
+#include "hurchalla/util/compiler_macros.h"
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+namespace hurchalla {
+
+
+// CacheLineBitpackedUintVector is a bitpacked vector with a different layout
+// than BitpackedUintVector: it packs elements_per_block() ==
+// floor(512/element_bitlen) elements into each 64 byte block, leaving the
+// remaining bits of the block unused, and its blocks are 64 byte aligned.  No
+// element ever crosses a cache line, so a random getAt() or setAt() always
+// touches exactly one cache line, whereas in BitpackedUintVector's dense
+// layout an element that straddles two lines needs both.
+//
+// The price is memory: dataSizeBytes() is a whole number of blocks, and each
+// block wastes 512 % element_bitlen bits (e.g. 9 of 512 bits for 13 bit
+// elements, but 0 for any power of 2 width, where the layouts waste nothing).
+// Locating an element also takes a multiply by a reciprocal (for the division
+// by elements_per_block()), rather than just shifts.  On CPUs that fetch both
+// lines of a straddling element in parallel, or that prefetch adjacent lines,
+// the dense layout is often just as fast or faster, so measure before
+// preferring this class; it is most likely to help for random access into a
+// vector much larger than the CPU caches, on machines where each extra cache
+// line costs memory bandwidth that you need.
+//
+// The data has its own format (and getFormatID()); it is not interchangeable
+// with BitpackedUintVector's data.  Within each block, the elements are
+// packed exactly as in BitpackedUintVector, and the unused bits are zero.
+
+template <typename U, unsigned int element_bitlen,
+          class Storage = BitpackedHeapStorage>
+class CacheLineBitpackedUintVector
+{
+    static_assert(std::numeric_limits<U>::is_integer, "");
+    static_assert(!std::numeric_limits<U>::is_signed, "");
+    static_assert(element_bitlen <= std::numeric_limits<U>::digits, "");
+    static_assert(0 < element_bitlen && element_bitlen <= 64, "");
+    using Impl = detail::ImplCacheLineBitpackedUintVector<U, element_bitlen>;
+    using NoAliasUchar = typename Impl::NoAliasUchar;
+
+    struct StorageDeleter {
+        std::size_t bytes;
+        void operator()(unsigned char* p) const noexcept
+        {
+            Storage::deallocate(p, bytes);
+        }
+    };
+
+public:
+    using size_type = std::size_t;
+
+    CacheLineBitpackedUintVector(const CacheLineBitpackedUintVector&) = delete;
+    CacheLineBitpackedUintVector&
+                    operator=(const CacheLineBitpackedUintVector&) = delete;
+
+    CacheLineBitpackedUintVector(CacheLineBitpackedUintVector&& other) noexcept
+            : packed_count(other.packed_count), vec_bytes(other.vec_bytes),
+              upalloc(std::move(other.upalloc)), blocks(other.blocks) {}
+
+    // Creates 'count' zero elements.  Throws std::length_error if count is
+    // too large.
+    CacheLineBitpackedUintVector(size_type count) :
+            packed_count(count), vec_bytes(getBytesFromCount(count)),
+            upalloc(allocate(vec_bytes)), blocks(alignBlocks(upalloc.get())) {}
+
+    // Constructor for deserialization of data that you got from data(),
+    // dataSizeBytes(), and size() of this class.  This copies the data.
+    // Throws std::length_error if data_bytes isn't dataSizeBytes(element_count).
+    CacheLineBitpackedUintVector(const unsigned char* data,
+                                 std::size_t data_bytes,
+                                 size_type element_count) :
+            packed_count(element_count),
+            vec_bytes(getBytesFromCount(element_count)),
+            upalloc(allocate(vec_bytes)),
+            blocks(alignBlocks(upalloc.get()))
+    {
+        if (data_bytes != vec_bytes)
+            throw std::length_error("data_bytes doesn't match expected bytes needed for element_count");
+        std::memcpy(blocks, data, data_bytes);
+    }
+
+
+    HURCHALLA_FORCE_INLINE void setAt(size_type index, U value)
+    {
+        HPBC_UTIL_API_PRECONDITION(value <= max_allowed_value());
+        HPBC_UTIL_API_PRECONDITION(index < size());
+        Impl::writeIndex(blocks, index, value);
+    }
+
+    HURCHALLA_FORCE_INLINE U getAt(size_type index) const
+    {
+        HPBC_UTIL_API_PRECONDITION(index < size());
+        U value = Impl::readIndex(blocks, index);
+        HPBC_UTIL_POSTCONDITION(value <= max_allowed_value());
+        return value;
+    }
+
+    // Reads the 'count' elements beginning at index 'first', into out[0] to
+    // out[count-1], unpacking whole groups of 8 elements at once within each
+    // block, as BitpackedUintVector::getRange() does.
+    void getRange(size_type first, size_type count, U* out) const
+    {
+        HPBC_UTIL_API_PRECONDITION(first <= size());
+        HPBC_UTIL_API_PRECONDITION(count <= size() - first);
+        Impl::readRange(blocks, first, count, out);
+    }
+
+    // Writes in[0] to in[count-1] into the 'count' elements beginning at index
+    // 'first'.  Every value in 'in' must be <= max_allowed_value().
+    void setRange(size_type first, size_type count, const U* in)
+    {
+        HPBC_UTIL_API_PRECONDITION(first <= size());
+        HPBC_UTIL_API_PRECONDITION(count <= size() - first);
+        Impl::writeRange(blocks, first, count, in);
+    }
+
+    // returns the number of packed elements in this vector
+    HURCHALLA_FORCE_INLINE size_type size() const
+    {
+        return packed_count;
+    }
+
+    // returns the maximum value that fits within element_bitlen bits.
+    HURCHALLA_FORCE_INLINE static constexpr U max_allowed_value()
+    {
+        return Impl::Dense::max_allowed_value();
+    }
+
+    // returns the number of elements in each 64 byte block
+    HURCHALLA_FORCE_INLINE static constexpr std::size_t elements_per_block()
+    {
+        return Impl::ELEMENTS_PER_BLOCK;
+    }
+
+    // Returns the size of data() for 'element_count' elements: 64 bytes for
+    // every block that holds an element (and one block if element_count is
+    // 0).  Returns 0 if element_count is an invalid size.
+    HURCHALLA_FORCE_INLINE static constexpr
+    std::size_t dataSizeBytes(size_type element_count)
+    {
+        return Impl::dataSizeBytes(element_count);
+    }
+
+    HURCHALLA_FORCE_INLINE std::size_t dataSizeBytes() const
+    {
+        return vec_bytes;
+    }
+
+    // (always 64 byte aligned)
+    HURCHALLA_FORCE_INLINE const unsigned char* data() const
+    {
+        return reinterpret_cast<const unsigned char*>(blocks);
+    }
+
+    HURCHALLA_FORCE_INLINE static constexpr uint32_t getFormatID()
+    {
+        return Impl::getFormatID();
+    }
+
+private:
+    static constexpr std::size_t ALIGN_PAD = Impl::BLOCK_BYTES - 1;
+
+    static std::size_t getBytesFromCount(size_type count)
+    {
+        std::size_t bytes = Impl::dataSizeBytes(count);
+        if (bytes == 0 ||
+                   bytes > std::numeric_limits<std::size_t>::max() - ALIGN_PAD)
+            throw std::length_error("CacheLineBitpackedUintVector size too large, would overflow");
+        return bytes;
+    }
+
+    // Storage doesn't promise any alignment, so we allocate ALIGN_PAD more
+    // bytes than we need, and begin the blocks at the first 64 byte boundary.
+    static std::unique_ptr<unsigned char[], StorageDeleter>
+    allocate(std::size_t bytes)
+    {
+        std::size_t total = bytes + ALIGN_PAD;
+        return std::unique_ptr<unsigned char[], StorageDeleter>(
+                             Storage::allocate(total), StorageDeleter{total});
+    }
+
+    static NoAliasUchar* alignBlocks(unsigned char* p)
+    {
+        std::uintptr_t addr = reinterpret_cast<std::uintptr_t>(p);
+        std::size_t offset = static_cast<std::size_t>(
+                             (Impl::BLOCK_BYTES - addr % Impl::BLOCK_BYTES) %
+                             Impl::BLOCK_BYTES);
+        return reinterpret_cast<NoAliasUchar*>(p + offset);
+    }
+
+    const size_type packed_count;
+    const std::size_t vec_bytes;
+    std::unique_ptr<unsigned char[], StorageDeleter> upalloc;
+    NoAliasUchar* blocks;
+};
+
+
+} // end namespace
+
+#endif
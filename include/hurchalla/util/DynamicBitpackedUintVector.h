@@ -0,0 +1,244 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#ifndef HURCHALLA_UTIL_DYNAMIC_BITPACKED_UINT_VECTOR_H_INCLUDED
+#define HURCHALLA_UTIL_DYNAMIC_BITPACKED_UINT_VECTOR_H_INCLUDED
+
+
+#include "hurchalla/util/BitpackedHeapStorage.h"
+#include "hurchalla/util/BitpackedUintVectorView.h"
+#include "hurchalla/util/detail/ImplDynamicBitpackedUintVector.h"
+#include "hurchalla/util/detail/ImplBitpackedUintVector.h"
+#include "hurchalla/util/detail/util_programming_by_contract.h"
+#include "hurchalla/util/compiler_macros.h"
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+namespace hurchalla {
+
+
+// DynamicBitpackedUintVector is a BitpackedUintVector whose element_bitlen is
+// a constructor argument rather than a template argument, for when the bit
+// width is known only at run time.  It is compiled once per U (rather than
+// once per bit width), and its data has exactly the layout (and
+// getFormatID()) of BitpackedUintVector<U, element_bitlen>.
+//
+// getAt() and setAt() decode an element with one unaligned 64 bit load, a
+// shift and a mask, whatever the bit width.  This is a little faster than
+// BitpackedUintVector's getAt() and setAt(), which never access bytes beyond
+// their element's granule (see ImplBitpackedUintVector::writeIndex()).  For bulk work, visit(f) calls
+// f(view), where view is a BitpackedUintVectorView<U, element_bitlen> of this
+// vector's data, with element_bitlen as a compile time constant.  Inside f
+// you have getRange(), setRange(), iterators, readCursor(), the functions of
+// BitpackedUintVectorAlgorithms.h, and so on, all using the specialized
+// (and SIMD) code, for the cost of a single dispatch.  f must be callable
+// with a view of every width from 1 to max_bitlen(), and must return the same
+// type for all of them (a generic lambda is the easy way to do this).
+//
+// Unlike BitpackedUintVector, setAt() may rewrite (unchanged) bytes of
+// nearby elements, so separate threads must not call setAt() on nearby
+// elements without synchronization.  Use visit() if you need
+// BitpackedUintVector's partitionPoint() guarantees.
+
+template <typename U, class Storage = BitpackedHeapStorage>
+class DynamicBitpackedUintVector
+{
+    static_assert(std::numeric_limits<U>::is_integer, "");
+    static_assert(!std::numeric_limits<U>::is_signed, "");
+    using Impl = detail::ImplDynamicBitpackedUintVector<U>;
+
+    struct StorageDeleter {
+        std::size_t bytes;
+        void operator()(unsigned char* p) const noexcept
+        {
+            Storage::deallocate(p, bytes);
+        }
+    };
+
+public:
+    using size_type = std::size_t;
+
+    DynamicBitpackedUintVector(const DynamicBitpackedUintVector&) = delete;
+    DynamicBitpackedUintVector&
+                    operator=(const DynamicBitpackedUintVector&) = delete;
+
+    DynamicBitpackedUintVector(DynamicBitpackedUintVector&& other) noexcept :
+            bitlen(other.bitlen), packed_count(other.packed_count),
+            vec8_bytes(other.vec8_bytes), upvec(std::move(other.upvec)) {}
+
+    // Creates 'count' zero elements of 'element_bitlen' bits each.  Throws
+    // std::invalid_argument if element_bitlen is 0 or > max_bitlen(), or
+    // std::length_error if count is too large.
+    DynamicBitpackedUintVector(unsigned int element_bitlen, size_type count) :
+            bitlen(checkBitlen(element_bitlen)), packed_count(count),
+            vec8_bytes(getBytesFromCount(element_bitlen, count)),
+            upvec(allocate(vec8_bytes)) {}
+
+    // Constructor for deserialization of data that you got from data(),
+    // dataSizeBytes(), and size() of this class, or of a BitpackedUintVector
+    // with the same element_bitlen.  This copies the data.
+    DynamicBitpackedUintVector(unsigned int element_bitlen,
+                               const unsigned char* data,
+                               std::size_t data_bytes, size_type element_count) :
+            bitlen(checkBitlen(element_bitlen)), packed_count(element_count),
+            vec8_bytes(getBytesFromCount(element_bitlen, element_count)),
+            upvec(allocate(vec8_bytes))
+    {
+        if (data_bytes != vec8_bytes)
+            throw std::length_error("data_bytes doesn't match expected bytes needed for element_count");
+        std::memcpy(upvec.get(), data, data_bytes);
+    }
+
+
+    HURCHALLA_FORCE_INLINE void setAt(size_type index, U value)
+    {
+        HPBC_UTIL_API_PRECONDITION(value <= max_allowed_value());
+        HPBC_UTIL_API_PRECONDITION(index < size());
+        Impl::writeWindow(upvec.get(), bitlen, index, value);
+    }
+
+    HURCHALLA_FORCE_INLINE U getAt(size_type index) const
+    {
+        HPBC_UTIL_API_PRECONDITION(index < size());
+        U value = Impl::readWindow(upvec.get(), bitlen, index);
+        HPBC_UTIL_POSTCONDITION(value <= max_allowed_value());
+        return value;
+    }
+
+    // Reads the 'count' elements beginning at index 'first', into out[0] to
+    // out[count-1].
+    void getRange(size_type first, size_type count, U* out) const
+    {
+        HPBC_UTIL_API_PRECONDITION(first <= size());
+        HPBC_UTIL_API_PRECONDITION(count <= size() - first);
+        // (a view's size_type is never narrower than size_type)
+        visit([=](const auto& view) { view.getRange(first, count, out); });
+    }
+
+    // Writes in[0] to in[count-1] into the 'count' elements beginning at index
+    // 'first'.  Every value in 'in' must be <= max_allowed_value().
+    void setRange(size_type first, size_type count, const U* in)
+    {
+        HPBC_UTIL_API_PRECONDITION(first <= size());
+        HPBC_UTIL_API_PRECONDITION(count <= size() - first);
+        // (a view's size_type is never narrower than size_type)
+        visit([=](const auto& view) { view.setRange(first, count, in); });
+    }
+
+    // Returns f(view), for a BitpackedUintVectorView<U, element_bitlen()> of
+    // this vector (a ConstBitpackedUintVectorView, for the const overload).
+    // The view is valid for as long as this vector is.
+    template <class F>
+    decltype(auto) visit(F&& f)
+    {
+        using R = decltype(f(std::declval<BitpackedUintVectorView<U, 1>>()));
+        return Impl::template visit<false, R>(bitlen, upvec.get(),
+                                              vec8_bytes, packed_count, f);
+    }
+    template <class F>
+    decltype(auto) visit(F&& f) const
+    {
+        using R = decltype(f(std::declval<ConstBitpackedUintVectorView<U,1>>()));
+        return Impl::template visit<true, R>(bitlen,
+                                             static_cast<const unsigned char*>(
+                                             upvec.get()),
+                                             vec8_bytes, packed_count, f);
+    }
+
+    // returns the number of packed elements in this vector
+    HURCHALLA_FORCE_INLINE size_type size() const
+    {
+        return packed_count;
+    }
+
+    HURCHALLA_FORCE_INLINE unsigned int element_bitlen() const
+    {
+        return bitlen;
+    }
+
+    // returns the largest element_bitlen that U supports here: at most 32,
+    // since getAt() and setAt() need a single 64 bit window to cover any
+    // element.  (BitpackedUintVector supports up to 64 bits.)
+    HURCHALLA_FORCE_INLINE static constexpr unsigned int max_bitlen()
+    {
+        return Impl::MAX_BITLEN;
+    }
+
+    // returns the maximum value that fits within element_bitlen() bits.
+    HURCHALLA_FORCE_INLINE U max_allowed_value() const
+    {
+        return Impl::max_allowed_value(bitlen);
+    }
+
+    // Returns the size of data() for 'element_count' elements of
+    // 'element_bitlen' bits, the same as BitpackedUintVector::dataSizeBytes().
+    // Returns 0 if element_count is an invalid size.
+    HURCHALLA_FORCE_INLINE static
+    std::size_t dataSizeBytes(unsigned int element_bitlen,
+                              size_type element_count)
+    {
+        HPBC_UTIL_API_PRECONDITION(0 < element_bitlen &&
+                                   element_bitlen <= max_bitlen());
+        return Impl::dataSizeBytes(element_bitlen, element_count);
+    }
+
+    // (the allocation is larger than this; see the constructor)
+    HURCHALLA_FORCE_INLINE std::size_t dataSizeBytes() const
+    {
+        return vec8_bytes;
+    }
+
+    HURCHALLA_FORCE_INLINE const unsigned char* data() const
+    {
+        return upvec.get();
+    }
+
+    // this is the same format ID as BitpackedUintVector::getFormatID()
+    HURCHALLA_FORCE_INLINE static constexpr uint32_t getFormatID()
+    {
+        return detail::ImplBitpackedUintVector<U, 1>::getFormatID();
+    }
+
+private:
+    static unsigned int checkBitlen(unsigned int element_bitlen)
+    {
+        if (element_bitlen == 0 || element_bitlen > max_bitlen())
+            throw std::invalid_argument("DynamicBitpackedUintVector element_bitlen must be from 1 to max_bitlen()");
+        return element_bitlen;
+    }
+
+    static std::size_t getBytesFromCount(unsigned int element_bitlen,
+                                         size_type count)
+    {
+        std::size_t bytes = Impl::dataSizeBytes(element_bitlen, count);
+        if (bytes == 0 ||
+               bytes > std::numeric_limits<std::size_t>::max() - Impl::WINDOW_PAD)
+            throw std::length_error("DynamicBitpackedUintVector size too large, would overflow");
+        return bytes;
+    }
+
+    // getAt() and setAt() access an 8 byte window that can extend up to
+    // WINDOW_PAD bytes past dataSizeBytes(), so we allocate that much more.
+    static std::unique_ptr<unsigned char[], StorageDeleter>
+    allocate(std::size_t data_bytes)
+    {
+        std::size_t bytes = data_bytes + Impl::WINDOW_PAD;
+        return std::unique_ptr<unsigned char[], StorageDeleter>(
+                             Storage::allocate(bytes), StorageDeleter{bytes});
+    }
+
+    const unsigned int bitlen;
+    const size_type packed_count;
+    const std::size_t vec8_bytes;
+    std::unique_ptr<unsigned char[], StorageDeleter> upvec;
+};
+
+
+} // end namespace
+
+#endif
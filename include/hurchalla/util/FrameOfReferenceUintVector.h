@@ -0,0 +1,200 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#ifndef HURCHALLA_UTIL_FRAME_OF_REFERENCE_UINT_VECTOR_H_INCLUDED
+#define HURCHALLA_UTIL_FRAME_OF_REFERENCE_UINT_VECTOR_H_INCLUDED
+
+
+#include "hurchalla/util/BitpackedHeapStorage.h"
+#include "hurchalla/util/detail/ImplFrameOfReferenceUintVector.h"
+#include "hurchalla/util/detail/util_programming_by_contract.h"
+#include "hurchalla/util/compiler_macros.h"
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace hurchalla {
+
+
+// FrameOfReferenceUintVector is a read only packed vector for values that
+// cluster tightly within each stretch of the vector, such as sorted values
+// or small gaps, where a single element_bitlen for the whole vector would
+// have to cover the worst case anywhere in it.
+//
+// The constructor splits the values into blocks of block_size elements.
+// Each block stores its minimum as a base, and its values as offsets from
+// that base, packed with just enough bits for its largest offset (0 bits if
+// all of its values are equal), in the layout of BitpackedUintVector.  A block
+// header (a 64 bit word for the offset and width, plus a U for the base)
+// costs 64 + digits(U) bits, rounded up for alignment, per block.
+//
+// getAt() is constant time: it reads the block header and then the packed
+// offset.  getRange() decodes each block with the compile time specialized
+// (and SIMD) code of BitpackedUintVector for the block's width.  For bulk
+// decoding, larger blocks amortize the headers better, and smaller blocks
+// adapt better to local changes in the values; block_size must be a
+// multiple of 8.
+
+template <typename U, std::size_t block_size = 128,
+          class Storage = BitpackedHeapStorage>
+class FrameOfReferenceUintVector
+{
+    static_assert(std::numeric_limits<U>::is_integer, "");
+    static_assert(!std::numeric_limits<U>::is_signed, "");
+    static_assert(block_size > 0 && block_size % 8 == 0, "");
+    using Impl = detail::ImplFrameOfReferenceUintVector<U, block_size>;
+    using BlockHeader = typename Impl::BlockHeader;
+
+    struct StorageDeleter {
+        std::size_t bytes;
+        void operator()(unsigned char* p) const noexcept
+        {
+            Storage::deallocate(p, bytes);
+        }
+    };
+
+public:
+    using size_type = std::size_t;
+
+    FrameOfReferenceUintVector(const FrameOfReferenceUintVector&) = delete;
+    FrameOfReferenceUintVector&
+                    operator=(const FrameOfReferenceUintVector&) = delete;
+
+    FrameOfReferenceUintVector(FrameOfReferenceUintVector&& other) noexcept :
+            packed_count(other.packed_count), vec_bytes(other.vec_bytes),
+            headers(std::move(other.headers)), upvec(std::move(other.upvec)) {}
+
+    ~FrameOfReferenceUintVector();
+
+    // Packs the 'count' values in[0] to in[count-1].  This reads the values
+    // twice: once to choose each block's base and width, and once to pack.
+    // Throws std::length_error if count is too large.
+    FrameOfReferenceUintVector(const U* in, size_type count) :
+            packed_count(count), vec_bytes(0), headers(), upvec()
+    {
+        std::size_t num_blocks = count / block_size +
+                                 ((count % block_size != 0) ? 1 : 0);
+        headers.resize(num_blocks);
+
+        // choose each block's base and width, and lay out the blocks
+        // (an offset must fit below the width bits of a header's location)
+        constexpr uint64_t LOCATION_LIMIT =
+                              static_cast<uint64_t>(1) << Impl::WIDTH_SHIFT;
+        constexpr std::size_t MAX_OFFSET =
+                (std::numeric_limits<std::size_t>::max() - Impl::WINDOW_PAD <
+                 LOCATION_LIMIT) ?
+                std::numeric_limits<std::size_t>::max() - Impl::WINDOW_PAD :
+                static_cast<std::size_t>(LOCATION_LIMIT - 1);
+        std::size_t offset = 0;
+        for (std::size_t b = 0; b < num_blocks; ++b) {
+            std::size_t n = blockCount(b);
+            U base;
+            unsigned int w = Impl::chooseWidth(in + b * block_size, n, base);
+            headers[b].base = base;
+            headers[b].location = static_cast<uint64_t>(offset) |
+                       (static_cast<uint64_t>(w) << Impl::WIDTH_SHIFT);
+            if (Impl::blockBytes(w) > MAX_OFFSET - offset)
+                throw std::length_error("FrameOfReferenceUintVector size too large, would overflow");
+            offset += Impl::blockBytes(w);
+        }
+        vec_bytes = offset + Impl::WINDOW_PAD;
+        upvec = std::unique_ptr<unsigned char[], StorageDeleter>(
+                      Storage::allocate(vec_bytes), StorageDeleter{vec_bytes});
+
+        // pack each block's offsets from its base
+        std::vector<U> deltas(block_size);
+        for (std::size_t b = 0; b < num_blocks; ++b) {
+            std::size_t n = blockCount(b);
+            const U* src = in + b * block_size;
+            U base = headers[b].base;
+            std::size_t i = 0;
+            for (; i < n; ++i)
+                deltas[i] = static_cast<U>(src[i] - base);
+            for (; i < block_size; ++i)
+                deltas[i] = 0;
+            Impl::packBlock(upvec.get() + Impl::offset(headers[b]),
+                            Impl::width(headers[b]), deltas.data());
+        }
+    }
+
+    HURCHALLA_FORCE_INLINE U getAt(size_type index) const
+    {
+        HPBC_UTIL_API_PRECONDITION(index < size());
+        return Impl::readIndex(upvec.get(), headers.data(), index);
+    }
+
+    // Reads the 'count' elements beginning at index 'first', into out[0] to
+    // out[count-1].
+    void getRange(size_type first, size_type count, U* out) const
+    {
+        HPBC_UTIL_API_PRECONDITION(first <= size());
+        HPBC_UTIL_API_PRECONDITION(count <= size() - first);
+        Impl::readRange(upvec.get(), vec_bytes, headers.data(), first, count,
+                        out);
+    }
+
+    // returns the number of elements in this vector
+    HURCHALLA_FORCE_INLINE size_type size() const
+    {
+        return packed_count;
+    }
+
+    HURCHALLA_FORCE_INLINE static constexpr std::size_t elements_per_block()
+    {
+        return block_size;
+    }
+
+    HURCHALLA_FORCE_INLINE std::size_t num_blocks() const
+    {
+        return headers.size();
+    }
+
+    // returns the number of bits that block b uses for each of its elements
+    HURCHALLA_FORCE_INLINE unsigned int block_bitlen(std::size_t b) const
+    {
+        HPBC_UTIL_API_PRECONDITION(b < num_blocks());
+        return Impl::width(headers[b]);
+    }
+
+    // returns the base (minimum) value of block b
+    HURCHALLA_FORCE_INLINE U block_base(std::size_t b) const
+    {
+        HPBC_UTIL_API_PRECONDITION(b < num_blocks());
+        return headers[b].base;
+    }
+
+    // Returns the total bytes of memory that this vector uses for its packed
+    // data and its block headers.
+    HURCHALLA_FORCE_INLINE std::size_t memoryBytes() const
+    {
+        return vec_bytes + headers.capacity() * sizeof(BlockHeader);
+    }
+
+private:
+    std::size_t blockCount(std::size_t b) const
+    {
+        std::size_t rest = packed_count - b * block_size;
+        return (rest < block_size) ? rest : block_size;
+    }
+
+    const size_type packed_count;
+    std::size_t vec_bytes;
+    std::vector<BlockHeader> headers;
+    std::unique_ptr<unsigned char[], StorageDeleter> upvec;
+};
+
+// The destructor is defined out of the class (and so isn't implicitly
+// inline), since the compiler won't inline it on unlikely paths such as
+// unwinding, and -Winline would complain.
+template <typename U, std::size_t block_size, class Storage>
+FrameOfReferenceUintVector<U, block_size, Storage>::
+~FrameOfReferenceUintVector() {}
+
+
+} // end namespace
+
+#endif
@@ -0,0 +1,475 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#ifndef HURCHALLA_UTIL_GROWABLE_BITPACKED_UINT_VECTOR_H_INCLUDED
+#define HURCHALLA_UTIL_GROWABLE_BITPACKED_UINT_VECTOR_H_INCLUDED
+
+
+#include "hurchalla/util/BitpackedHeapStorage.h"
+#include "hurchalla/util/BitpackedUintVectorView.h"
+#include "hurchalla/util/detail/ImplBitpackedUintVector.h"
+#include "hurchalla/util/detail/ImplBitpackedUintVectorIterators.h"
+#include "hurchalla/util/detail/util_programming_by_contract.h"
+#include "hurchalla/util/compiler_macros.h"
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace hurchalla {
+
+
+// GrowableBitpackedUintVector is a BitpackedUintVector whose size can change,
+// in the manner of std::vector: push_back() and append() are amortized O(1)
+// per element, since the capacity grows geometrically, and reserve(),
+// resize(), and shrink_to_fit() are available.  Growing can reallocate the
+// packed data, which invalidates iterators, views, and data() pointers, the
+// same as for std::vector.
+//
+// data() and dataSizeBytes() give exactly the bytes (and getFormatID() is the
+// same ID) that a BitpackedUintVector with the same elements would give, so
+// data built up with this class can be serialized and then deserialized as a
+// BitpackedUintVector, and vice versa.
+//
+// If you know the final size in advance, BitpackedUintVector is slightly
+// simpler and never reallocates.
+
+template <typename U, unsigned int element_bitlen,
+          class Storage = BitpackedHeapStorage>
+class GrowableBitpackedUintVector
+{
+    static_assert(std::numeric_limits<U>::is_integer, "");
+    static_assert(!std::numeric_limits<U>::is_signed, "");
+    static_assert(element_bitlen <= std::numeric_limits<U>::digits, "");
+    static_assert(0 < element_bitlen && element_bitlen <= 64, "");
+    using Impl = detail::ImplBitpackedUintVector<U, element_bitlen>;
+    using NoAliasUchar = typename Impl::NoAliasUchar;
+
+    struct StorageDeleter {
+        std::size_t bytes;
+        void operator()(unsigned char* p) const noexcept
+        {
+            Storage::deallocate(p, bytes);
+        }
+    };
+    using Buffer = std::unique_ptr<unsigned char[], StorageDeleter>;
+
+public:
+    using size_type = typename Impl::size_type;
+    using iterator = detail::BitpackedUintVectorIterator<U, element_bitlen>;
+    using const_iterator =
+                  detail::BitpackedUintVectorConstIterator<U, element_bitlen>;
+    using ReadCursor =
+                  detail::BitpackedUintVectorReadCursor<U, element_bitlen>;
+
+    GrowableBitpackedUintVector(const GrowableBitpackedUintVector&) = delete;
+    GrowableBitpackedUintVector&
+                    operator=(const GrowableBitpackedUintVector&) = delete;
+
+    // the moved-from vector is left empty
+    GrowableBitpackedUintVector(GrowableBitpackedUintVector&& other) noexcept :
+            buf(std::move(other.buf)), packed_count(other.packed_count),
+            cap(other.cap)
+    {
+        other.packed_count = 0;
+        other.cap = 0;
+    }
+    GrowableBitpackedUintVector&
+    operator=(GrowableBitpackedUintVector&& other) noexcept
+    {
+        if (this != &other) {
+            buf = std::move(other.buf);
+            packed_count = other.packed_count;
+            cap = other.cap;
+            other.packed_count = 0;
+            other.cap = 0;
+        }
+        return *this;
+    }
+
+    // creates a vector of 'count' zero elements
+    explicit GrowableBitpackedUintVector(size_type count = 0) :
+            buf(allocate(count)), packed_count(count), cap(count) {}
+
+    // constructor for deserialization of data from data(), dataSizeBytes(),
+    // and size() of this class or of BitpackedUintVector.  Unless Storage is
+    // BitpackedHeapStorage, this copies the data into memory from Storage.
+    GrowableBitpackedUintVector(std::unique_ptr<unsigned char[]> data,
+                                std::size_t data_bytes,
+                                size_type element_count) :
+            buf(adopt(std::move(data), data_bytes, element_count,
+                      std::is_same<Storage, BitpackedHeapStorage>())),
+            packed_count(element_count), cap(element_count) {}
+
+
+    HURCHALLA_FORCE_INLINE void setAt(size_type index, U value)
+    {
+        HPBC_UTIL_API_PRECONDITION(value <= max_allowed_value());
+        HPBC_UTIL_API_PRECONDITION(index < size());
+        Impl::writeIndex(vec8(), capacityBytes(), index, value);
+    }
+
+    HURCHALLA_FORCE_INLINE U getAt(size_type index) const
+    {
+        HPBC_UTIL_API_PRECONDITION(index < size());
+        U value = Impl::readIndex(vec8(), capacityBytes(), index);
+        HPBC_UTIL_POSTCONDITION(value <= max_allowed_value());
+        return value;
+    }
+
+    // Reads the 'count' elements beginning at index 'first', into out[0] to
+    // out[count-1].
+    HURCHALLA_FORCE_INLINE void getRange(size_type first, size_type count,
+                                         U* out) const
+    {
+        HPBC_UTIL_API_PRECONDITION(first <= size());
+        HPBC_UTIL_API_PRECONDITION(count <= size() - first);
+        Impl::readRange(vec8(), capacityBytes(), first, count, out);
+    }
+
+    // Writes in[0] to in[count-1] into the 'count' elements beginning at index
+    // 'first'.  Every value in 'in' must be <= max_allowed_value().
+    HURCHALLA_FORCE_INLINE void setRange(size_type first, size_type count,
+                                         const U* in)
+    {
+        HPBC_UTIL_API_PRECONDITION(first <= size());
+        HPBC_UTIL_API_PRECONDITION(count <= size() - first);
+        Impl::writeRange(vec8(), first, count, in);
+    }
+
+    // See BitpackedUintVector::gather() and scatter().
+    HURCHALLA_FORCE_INLINE void gather(const size_type* indices, std::size_t n,
+                 U* out, std::size_t prefetch_distance =
+                 Impl::DEFAULT_PREFETCH_DISTANCE) const
+    {
+        HPBC_UTIL_API_PRECONDITION(prefetch_distance <= max_prefetch_distance());
+        for (std::size_t i = 0; i < n; ++i)
+            HPBC_UTIL_API_PRECONDITION(indices[i] < size());
+        Impl::readGather(vec8(), indices, n, out, prefetch_distance);
+    }
+    HURCHALLA_FORCE_INLINE void scatter(const size_type* indices, std::size_t n,
+                 const U* in, std::size_t prefetch_distance =
+                 Impl::DEFAULT_PREFETCH_DISTANCE)
+    {
+        HPBC_UTIL_API_PRECONDITION(prefetch_distance <= max_prefetch_distance());
+        for (std::size_t i = 0; i < n; ++i) {
+            HPBC_UTIL_API_PRECONDITION(indices[i] < size());
+            HPBC_UTIL_API_PRECONDITION(in[i] <= max_allowed_value());
+        }
+        Impl::writeScatter(vec8(), indices, n, in, prefetch_distance);
+    }
+    HURCHALLA_FORCE_INLINE static constexpr std::size_t max_prefetch_distance()
+    {
+        return Impl::MAX_PREFETCH_DISTANCE;
+    }
+
+    // Appends 'value' as the new last element.  Throws std::length_error if
+    // the vector would be too large, or std::bad_alloc.
+    HURCHALLA_FORCE_INLINE void push_back(U value)
+    {
+        HPBC_UTIL_API_PRECONDITION(value <= max_allowed_value());
+        if (packed_count == cap)
+            grow(1);
+        Impl::writeIndex(vec8(), packed_count, value);
+        ++packed_count;
+    }
+
+    // Appends in[0] to in[count-1].  Every value in 'in' must be
+    // <= max_allowed_value().  This is much faster per element than
+    // push_back(), since it packs whole groups of elements at once.
+    void append(const U* in, size_type count)
+    {
+        if (count > cap - packed_count)
+            grow(count);
+        Impl::writeRange(vec8(), packed_count, count, in);
+        packed_count += count;
+    }
+
+    // Removes the last element.  The vector must not be empty.
+    void pop_back()
+    {
+        HPBC_UTIL_API_PRECONDITION(size() > 0);
+        zeroTail(packed_count - 1, packed_count);
+        --packed_count;
+    }
+
+    // Changes the size to 'count', appending zero elements or removing
+    // elements from the end as needed.
+    void resize(size_type count)
+    {
+        if (count > packed_count) {
+            if (count > cap)
+                grow(count - packed_count);
+            // the bits beyond the last element are always zero, so the new
+            // elements are already zero
+        } else {
+            zeroTail(count, packed_count);
+        }
+        packed_count = count;
+    }
+
+    void clear()
+    {
+        resize(0);
+    }
+
+    // Makes capacity() at least 'count', without changing size().  Like
+    // push_back() and append(), when it reallocates it at least doubles the
+    // capacity, so that a loop of slightly increasing reserve() calls is
+    // still amortized O(1) per element.  Throws std::length_error if 'count'
+    // is too large, or std::bad_alloc.
+    void reserve(size_type count)
+    {
+        if (count > cap)
+            grow(count - packed_count);
+    }
+
+    // Reduces capacity() to size().
+    void shrink_to_fit()
+    {
+        if (cap > packed_count)
+            reallocate(packed_count);
+    }
+
+    // Returns the number of elements that the vector can hold without
+    // reallocating.
+    HURCHALLA_FORCE_INLINE size_type capacity() const
+    {
+        return cap;
+    }
+
+    HURCHALLA_FORCE_INLINE iterator begin()
+    {
+        return makeIterator<iterator>(0);
+    }
+    HURCHALLA_FORCE_INLINE iterator end()
+    {
+        return makeIterator<iterator>(size());
+    }
+    HURCHALLA_FORCE_INLINE const_iterator begin() const
+    {
+        return makeIterator<const_iterator>(0);
+    }
+    HURCHALLA_FORCE_INLINE const_iterator end() const
+    {
+        return makeIterator<const_iterator>(size());
+    }
+    HURCHALLA_FORCE_INLINE const_iterator cbegin() const
+    {
+        return begin();
+    }
+    HURCHALLA_FORCE_INLINE const_iterator cend() const
+    {
+        return end();
+    }
+
+    // Returns a cursor whose first call to next() gives the element at index
+    // 'first'; see BitpackedUintVector::readCursor().
+    HURCHALLA_FORCE_INLINE ReadCursor readCursor(size_type first) const
+    {
+        return view().readCursor(first);
+    }
+
+    // Returns a view of the elements (see BitpackedUintVectorView.h).  It is
+    // invalidated by anything that reallocates.
+    BitpackedUintVectorView<U, element_bitlen> view()
+    {
+        return BitpackedUintVectorView<U, element_bitlen>(
+                  buf.get(), capacityBytes(), packed_count);
+    }
+    ConstBitpackedUintVectorView<U, element_bitlen> view() const
+    {
+        return ConstBitpackedUintVectorView<U, element_bitlen>(
+                  buf.get(), capacityBytes(), packed_count);
+    }
+
+    // returns the number of packed elements in this vector
+    HURCHALLA_FORCE_INLINE size_type size() const
+    {
+        return packed_count;
+    }
+
+    // returns the maximum value that fits within element_bitlen bits.
+    HURCHALLA_FORCE_INLINE static constexpr U max_allowed_value()
+    {
+        return Impl::max_allowed_value();
+    }
+
+    // returns 0 if element_count is an invalid size
+    HURCHALLA_FORCE_INLINE static constexpr
+    std::size_t dataSizeBytes(size_type element_count)
+    {
+        return Impl::dataSizeBytes(element_count);
+    }
+
+    // Returns the size of the serialized data, i.e. the bytes of data() that
+    // hold size() elements.  (The allocation may be larger.)
+    HURCHALLA_FORCE_INLINE std::size_t dataSizeBytes() const
+    {
+        // this is dataSizeBytes(packed_count), which can't be the invalid
+        // size 0, since we have an allocation for at least packed_count.
+        // (The data format has one byte after the bytes that hold elements.)
+        std::size_t bytes = usedBytes(packed_count) + 1;
+        HPBC_UTIL_POSTCONDITION2(bytes == dataSizeBytes(packed_count));
+        return bytes;
+    }
+
+    // Returns nullptr only for a vector that has been moved from.
+    HURCHALLA_FORCE_INLINE const unsigned char* data() const
+    {
+        return buf.get();
+    }
+
+    // this is the same format ID as BitpackedUintVector::getFormatID()
+    HURCHALLA_FORCE_INLINE static constexpr uint32_t getFormatID()
+    {
+        return Impl::getFormatID();
+    }
+
+private:
+    HURCHALLA_FORCE_INLINE NoAliasUchar* vec8() const
+    {
+        return reinterpret_cast<NoAliasUchar*>(buf.get());
+    }
+
+    HURCHALLA_FORCE_INLINE std::size_t capacityBytes() const
+    {
+        return buf.get_deleter().bytes;
+    }
+
+    template <class It>
+    HURCHALLA_FORCE_INLINE It makeIterator(size_type index) const
+    {
+        std::size_t starting_byte, bit_offset;
+        Impl::locateIndex(index, starting_byte, bit_offset);
+        return It(vec8() + starting_byte, static_cast<unsigned int>(bit_offset));
+    }
+
+    // the largest capacity whose allocation is at most MAX_BYTES, the
+    // maximum object size.  It's a multiple of 8 elements, so its data has
+    // no partial byte: MAX_CAPACITY/8 * element_bitlen + 1 bytes.
+    static constexpr std::size_t MAX_BYTES =
+             static_cast<std::size_t>(std::numeric_limits<std::ptrdiff_t>::max());
+    static constexpr size_type MAX_CAPACITY = static_cast<size_type>(8 *
+          (((MAX_BYTES - 1) / element_bitlen <
+                       std::numeric_limits<size_type>::max() / 8) ?
+                (MAX_BYTES - 1) / element_bitlen :
+                std::numeric_limits<size_type>::max() / 8));
+
+    static std::size_t bytesFor(size_type count)
+    {
+        std::size_t bytes = dataSizeBytes(count);
+        if (bytes == 0 || bytes > MAX_BYTES)
+            throw std::length_error("GrowableBitpackedUintVector size too large, would overflow");
+        return bytes;
+    }
+
+    static Buffer allocate(size_type count)
+    {
+        std::size_t bytes = bytesFor(count);
+        return Buffer(Storage::allocate(bytes), StorageDeleter{bytes});
+    }
+
+    static Buffer adopt(std::unique_ptr<unsigned char[]> data,
+                        std::size_t data_bytes, size_type element_count,
+                        std::true_type)
+    {
+        if (data_bytes != bytesFor(element_count))
+            throw std::length_error("data_bytes doesn't match expected bytes needed for element_count");
+        return Buffer(data.release(), StorageDeleter{data_bytes});
+    }
+    static Buffer adopt(std::unique_ptr<unsigned char[]> data,
+                        std::size_t data_bytes, size_type element_count,
+                        std::false_type)
+    {
+        if (data_bytes != bytesFor(element_count))
+            throw std::length_error("data_bytes doesn't match expected bytes needed for element_count");
+        Buffer p = allocate(element_count);
+        std::memcpy(p.get(), data.get(), data_bytes);
+        return p;
+    }
+
+    // Makes room for at least 'extra' more elements, doubling the capacity
+    // so that appending is amortized O(1).  (Growing by a smaller factor
+    // measured noticeably slower, since every reallocation copies the data
+    // and faults in fresh pages.)
+    void grow(size_type extra)
+    {
+        constexpr size_type MAXCOUNT = std::numeric_limits<size_type>::max();
+        if (extra > MAXCOUNT - packed_count)
+            throw std::length_error("GrowableBitpackedUintVector size too large, would overflow");
+        size_type needed = packed_count + extra;
+        if (needed > MAX_CAPACITY)
+            throw std::length_error("GrowableBitpackedUintVector size too large, would overflow");
+        size_type target = (cap > MAX_CAPACITY / 2) ? MAX_CAPACITY : cap + cap;
+        // start with at least a few groups, so small vectors don't
+        // reallocate on every push_back
+        constexpr size_type MIN_CAPACITY = 64;
+        if (target < MIN_CAPACITY)
+            target = MIN_CAPACITY;
+        if (target < needed)
+            target = needed;
+        reallocate(target);
+    }
+
+    // Replaces the buffer with one of capacity 'new_cap' >= size().  The new
+    // memory is zeroed by Storage::allocate(), so only the bytes that hold
+    // elements need to be copied.
+    void reallocate(size_type new_cap)
+    {
+        HPBC_UTIL_PRECONDITION2(new_cap >= packed_count);
+        Buffer p = allocate(new_cap);
+        std::size_t used = usedBytes(packed_count);
+        if (used > 0)
+            std::memcpy(p.get(), buf.get(), used);
+        buf = std::move(p);
+        cap = new_cap;
+    }
+
+    // the number of bytes that the elements [0, count) occupy
+    static std::size_t usedBytes(size_type count)
+    {
+        std::size_t starting_byte, bit_offset;
+        Impl::locateIndex(count, starting_byte, bit_offset);
+        return starting_byte + (bit_offset != 0);
+    }
+
+    // Zeroes the bits of the elements [first, last).  We keep every bit
+    // beyond the last element zero, so that the serialized data is the same
+    // as BitpackedUintVector's, and so that resize() can grow for free.
+    void zeroTail(size_type first, size_type last)
+    {
+        if (first >= last)
+            return;
+        unsigned char* p = buf.get();
+        std::size_t starting_byte, bit_offset;
+        Impl::locateIndex(first, starting_byte, bit_offset);
+        if (bit_offset != 0) {
+            p[starting_byte] = static_cast<unsigned char>(p[starting_byte] &
+                                                ((1u << bit_offset) - 1));
+            ++starting_byte;
+        }
+        // (last <= cap, so end_byte is within the buffer; clamping it makes
+        // that visible to the compiler, which otherwise may warn about a
+        // wrapped length on paths where last < first)
+        std::size_t end_byte = usedBytes(last);
+        HPBC_UTIL_ASSERT2(end_byte <= capacityBytes());
+        if (end_byte > capacityBytes())
+            end_byte = capacityBytes();
+        if (end_byte > starting_byte)
+            std::memset(p + starting_byte, 0, end_byte - starting_byte);
+    }
+
+    Buffer buf;
+    size_type packed_count;
+    size_type cap;
+};
+
+
+} // end namespace
+
+#endif
@@ -0,0 +1,247 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#ifndef HURCHALLA_UTIL_MAPPED_BITPACKED_UINT_VECTOR_H_INCLUDED
+#define HURCHALLA_UTIL_MAPPED_BITPACKED_UINT_VECTOR_H_INCLUDED
+
+
+#include "hurchalla/util/BitpackedUintVector.h"
+#include "hurchalla/util/BitpackedUintVectorView.h"
+#include "hurchalla/util/detail/ImplBitpackedUintVector.h"
+#include "hurchalla/util/detail/platform_specific/impl_file_mapping.h"
+#include "hurchalla/util/detail/util_programming_by_contract.h"
+#include "hurchalla/util/compiler_macros.h"
+#include <cstdint>
+#include <cstddef>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace hurchalla {
+
+
+// MappedBitpackedUintVector provides the same element access as
+// BitpackedUintVector, but its packed data is a memory mapping of a file,
+// rather than a heap allocation.  Construction is O(1): nothing is read or
+// copied up front, and the OS pages the data in as it's accessed.  This is
+// intended for very large precomputed tables, where reading the whole file
+// into memory would double peak memory use and slow down startup.
+//
+// The file is written by writeFile(), and consists of a small header
+// followed by exactly the bytes of BitpackedUintVector::data().  The header
+// records the format ID, element_bitlen, and element count, and the
+// constructor throws std::runtime_error if any of them don't match what this
+// class expects.
+//
+// If is_writable is false (the default), the file is mapped read only, and
+// there is no setAt() - writing to a read only mapping would crash, so it's
+// a compile error rather than a runtime precondition.  If is_writable is
+// true, the file is mapped for writing, and setAt() (or the non-const view())
+// writes directly to the file.
+
+template <typename U, unsigned int element_bitlen, bool is_writable = false>
+class MappedBitpackedUintVector
+{
+    using Impl = detail::ImplBitpackedUintVector<U, element_bitlen>;
+    static_assert(0 < element_bitlen && element_bitlen <= 64, "");
+public:
+    using size_type = typename Impl::size_type;
+
+    // The header occupies 64 bytes, so that the packed data begins 64 byte
+    // aligned (mappings are page aligned).  All fields are little-endian:
+    //   bytes 0-7:    magic "HBPUVEC\0"
+    //   bytes 8-11:   getFormatID()
+    //   bytes 12-15:  element_bitlen
+    //   bytes 16-23:  element count
+    //   bytes 24-31:  data size in bytes (dataSizeBytes())
+    //   bytes 32-63:  zero
+    static constexpr std::size_t HEADER_BYTES = 64;
+
+    MappedBitpackedUintVector(const MappedBitpackedUintVector&) = delete;
+    MappedBitpackedUintVector& operator=(const MappedBitpackedUintVector&) = delete;
+
+    // (moving the mapping doesn't change the address of the mapped data, so
+    // the view stays valid)
+    MappedBitpackedUintVector(MappedBitpackedUintVector&& other) noexcept :
+            mapping(std::move(other.mapping)), buv_view(other.buv_view) {}
+
+    // Maps the file at 'path', which must have been written by writeFile().
+    // Throws std::system_error if the file can't be mapped (or if is_writable
+    // is true and the file can't be opened for writing), or
+    // std::runtime_error if its header doesn't match this class.
+    explicit MappedBitpackedUintVector(const char* path)
+          : mapping(path, is_writable), buv_view(makeView(mapping, path))
+    {}
+
+    // Writes the vector in the file format that the constructor expects,
+    // replacing any existing file at 'path'.  Throws std::runtime_error on
+    // failure.
+    template <class Storage>
+    static void writeFile(const char* path,
+                 const BitpackedUintVector<U, element_bitlen, Storage>& vec)
+    {
+        writeFile(path, vec.data(), vec.dataSizeBytes(), vec.size());
+    }
+    // As above, for data that you got from BitpackedUintVector::data(),
+    // dataSizeBytes(), and size().
+    static void writeFile(const char* path, const unsigned char* data,
+                          std::size_t data_bytes, size_type element_count)
+    {
+        HPBC_UTIL_API_PRECONDITION(data_bytes == dataSizeBytes(element_count));
+        unsigned char header[HEADER_BYTES] = {};
+        const char magic[8] = { 'H','B','P','U','V','E','C','\0' };
+        for (std::size_t i = 0; i < sizeof(magic); ++i)
+            header[i] = static_cast<unsigned char>(magic[i]);
+        writeLE(header + 8, 4, getFormatID());
+        writeLE(header + 12, 4, element_bitlen);
+        writeLE(header + 16, 8, static_cast<uint64_t>(element_count));
+        writeLE(header + 24, 8, static_cast<uint64_t>(data_bytes));
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(header), HEADER_BYTES);
+        // write in chunks, since std::streamsize may be narrower than size_t
+        constexpr std::size_t CHUNK = std::size_t(1) << 30;
+        for (std::size_t done = 0; out && done < data_bytes; ) {
+            std::size_t n = (data_bytes - done < CHUNK) ? data_bytes - done
+                                                        : CHUNK;
+            out.write(reinterpret_cast<const char*>(data + done),
+                      static_cast<std::streamsize>(n));
+            done += n;
+        }
+        out.flush();
+        if (!out)
+            throw std::runtime_error(std::string("unable to write ") + path);
+    }
+
+
+    template <bool W = is_writable>
+    HURCHALLA_FORCE_INLINE typename std::enable_if<W, void>::type
+    setAt(size_type index, U value)
+    {
+        buv_view.setAt(index, value);
+    }
+
+    HURCHALLA_FORCE_INLINE U getAt(size_type index) const
+    {
+        return buv_view.getAt(index);
+    }
+
+    // Returns a read only view of the mapped data, which provides getRange(),
+    // iterators, and readCursor().  It's valid for as long as this object is.
+    HURCHALLA_FORCE_INLINE
+    ConstBitpackedUintVectorView<U, element_bitlen> view() const
+    {
+        return buv_view;
+    }
+    // For a writable mapping, returns a view that can also write to the file
+    // (e.g. with setRange(), or read_bitpacked_stream()).
+    template <bool W = is_writable>
+    HURCHALLA_FORCE_INLINE typename std::enable_if<W,
+                          BitpackedUintVectorView<U, element_bitlen>>::type
+    view()
+    {
+        return buv_view;
+    }
+
+    // returns the number of packed elements in this vector
+    HURCHALLA_FORCE_INLINE size_type size() const
+    {
+        return buv_view.size();
+    }
+
+    // returns true if this vector is mapped as writable
+    HURCHALLA_FORCE_INLINE static constexpr bool writable()
+    {
+        return is_writable;
+    }
+
+    // returns the maximum value that fits within element_bitlen bits.
+    HURCHALLA_FORCE_INLINE static constexpr U max_allowed_value()
+    {
+        return Impl::max_allowed_value();
+    }
+
+    // returns 0 if element_count is an invalid size
+    HURCHALLA_FORCE_INLINE static constexpr
+    std::size_t dataSizeBytes(size_type element_count)
+    {
+        return Impl::dataSizeBytes(element_count);
+    }
+
+    HURCHALLA_FORCE_INLINE std::size_t dataSizeBytes() const
+    {
+        return buv_view.dataSizeBytes();
+    }
+
+    // returns the packed data (which follows the header in the mapping)
+    HURCHALLA_FORCE_INLINE const unsigned char* data() const
+    {
+        return buv_view.data();
+    }
+
+    // this is the same format ID as BitpackedUintVector::getFormatID()
+    HURCHALLA_FORCE_INLINE static constexpr uint32_t getFormatID()
+    {
+        return Impl::getFormatID();
+    }
+
+private:
+    // Validates the header, and returns a view of the data that follows it.
+    static BitpackedUintVectorView<U, element_bitlen>
+    makeView(const detail::FileMapping& fm, const char* path)
+    {
+        const unsigned char* p = fm.data();
+        if (fm.size() < HEADER_BYTES)
+            throw std::runtime_error(std::string(path) +
+                          " is too small to be a MappedBitpackedUintVector");
+        static const char magic[8] = { 'H','B','P','U','V','E','C','\0' };
+        for (std::size_t i = 0; i < sizeof(magic); ++i) {
+            if (p[i] != static_cast<unsigned char>(magic[i]))
+                throw std::runtime_error(std::string(path) +
+                          " is not a MappedBitpackedUintVector file");
+        }
+        if (readLE(p + 8, 4) != getFormatID())
+            throw std::runtime_error(std::string(path) +
+                          " has a mismatched format ID");
+        if (readLE(p + 12, 4) != element_bitlen)
+            throw std::runtime_error(std::string(path) +
+                          " has a mismatched element_bitlen");
+        uint64_t count = readLE(p + 16, 8);
+        uint64_t bytes = readLE(p + 24, 8);
+        if (count > std::numeric_limits<size_type>::max())
+            throw std::runtime_error(std::string(path) +
+                          " has an element count that is too large");
+        std::size_t expected = dataSizeBytes(static_cast<size_type>(count));
+        if (expected == 0 || bytes != expected ||
+                                       fm.size() - HEADER_BYTES < expected)
+            throw std::runtime_error(std::string(path) +
+                          " has a data size that doesn't match its count");
+        return BitpackedUintVectorView<U, element_bitlen>(
+                    fm.data() + HEADER_BYTES, expected,
+                    static_cast<size_type>(count));
+    }
+
+    static uint64_t readLE(const unsigned char* p, unsigned int num_bytes)
+    {
+        uint64_t x = 0;
+        for (unsigned int i = 0; i < num_bytes; ++i)
+            x |= static_cast<uint64_t>(p[i]) << (8 * i);
+        return x;
+    }
+    static void writeLE(unsigned char* p, unsigned int num_bytes, uint64_t x)
+    {
+        for (unsigned int i = 0; i < num_bytes; ++i)
+            p[i] = static_cast<unsigned char>(x >> (8 * i));
+    }
+
+    detail::FileMapping mapping;
+    BitpackedUintVectorView<U, element_bitlen> buv_view;
+};
+
+
+} // end namespace
+
+#endif
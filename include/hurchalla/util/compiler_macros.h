@@ -183,6 +183,38 @@
 #endif
 
 
+// The macro  HURCHALLA_TARGET_IS_LITTLE_ENDIAN()  is 1 if the target is known
+// to be little-endian, and 0 otherwise.  A result of 0 doesn't imply that the
+// target is big-endian - it may simply be unknown.  Code that uses this macro
+// should still be correct when it is 0; the macro is intended only to enable
+// optimizations, such as replacing a sequence of byte loads with one memcpy.
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__)
+#  if (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#    define HURCHALLA_TARGET_IS_LITTLE_ENDIAN() 1
+#  else
+#    define HURCHALLA_TARGET_IS_LITTLE_ENDIAN() 0
+#  endif
+#elif defined(_MSC_VER)
+   // every architecture MSVC targets (x86, x64, ARM, ARM64) is little-endian
+#  define HURCHALLA_TARGET_IS_LITTLE_ENDIAN() 1
+#else
+#  define HURCHALLA_TARGET_IS_LITTLE_ENDIAN() 0
+#endif
+
+
+// HURCHALLA_PREFETCH_FOR_READ(ptr) and HURCHALLA_PREFETCH_FOR_WRITE(ptr) hint
+// to the CPU that the cache line holding *ptr will soon be read (or written),
+// so that it can begin loading the line now.  They are only hints: they never
+// fault, and on compilers without a prefetch builtin they do nothing.
+#if defined(__GNUC__) || defined(__clang__) || defined(__INTEL_COMPILER)
+#  define HURCHALLA_PREFETCH_FOR_READ(ptr) __builtin_prefetch((ptr), 0, 3)
+#  define HURCHALLA_PREFETCH_FOR_WRITE(ptr) __builtin_prefetch((ptr), 1, 3)
+#else
+#  define HURCHALLA_PREFETCH_FOR_READ(ptr) ((void)(ptr))
+#  define HURCHALLA_PREFETCH_FOR_WRITE(ptr) ((void)(ptr))
+#endif
+
+
 #if (__cplusplus >= 201402L) || \
         (defined(_MSVC_LANG) && _MSVC_LANG >= 201402L && _MSC_VER >= 1910)
 #  define HURCHALLA_CPP14_CONSTEXPR constexpr
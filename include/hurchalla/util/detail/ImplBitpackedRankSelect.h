@@ -0,0 +1,235 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#ifndef HURCHALLA_UTIL_IMPL_BITPACKED_RANK_SELECT_H_INCLUDED
+#define HURCHALLA_UTIL_IMPL_BITPACKED_RANK_SELECT_H_INCLUDED
+
+
+#include "hurchalla/util/count_trailing_zeros.h"
+#include "hurchalla/util/detail/util_programming_by_contract.h"
+#include "hurchalla/util/compiler_macros.h"
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+namespace hurchalla { namespace detail {
+
+
+// Rank and select over the packed data of a BitpackedUintVector<U, 1>, which
+// is simply a little-endian bit stream: element i is bit i%8 of byte i/8.  We
+// treat it as a sequence of 64 bit words (word w is bytes 8w to 8w+7).
+//
+// The directory has two levels.  For every superblock of SUPERBLOCK_BITS
+// (65536) bits, 'super' holds the number of ones before the superblock, and
+// for every block of BLOCK_BITS (512) bits, 'block' holds the number of ones
+// before the block, counted from the start of its superblock (at most 65024,
+// so it fits in a uint16_t).  That's 64 bits per 65536 plus 16 bits per 512,
+// about 3.2% of the bit vector.  rank1(i) adds the two counts to the
+// popcounts of at most 8 words.
+//
+// For select, 'samples' holds the block that contains the one of rank
+// j*SELECT_SAMPLE, for every j.  select1(k) binary searches the blocks between
+// the sample before k and the sample after it, and then scans at most 8
+// words.  The samples are SELECT_SAMPLE (8192) ones apart, so there are 16
+// blocks between them if every bit is 1, and 16/d blocks for a density d of
+// ones.  The samples cost at most 64 bits per 8192 ones, i.e. at most about
+// 0.8% of the bit vector.
+struct ImplBitpackedRankSelect {
+    static constexpr std::size_t WORD_BITS = 64;
+    static constexpr std::size_t BLOCK_BITS = 512;
+    static constexpr std::size_t SUPERBLOCK_BITS = 65536;
+    static constexpr std::size_t WORDS_PER_BLOCK = BLOCK_BITS / WORD_BITS;
+    static constexpr std::size_t BLOCKS_PER_SUPERBLOCK =
+                                                SUPERBLOCK_BITS / BLOCK_BITS;
+    static constexpr uint64_t SELECT_SAMPLE = 8192;
+
+    // The caller owns the directory's vectors (BitpackedRankSelect keeps them
+    // as direct members), and passes them to each function below.
+
+    // Builds the directory for the first 'nbits' bits at 'data', and returns
+    // the total number of ones.  data_bytes is the size of the data, which
+    // must be at least (nbits+7)/8; we never read beyond it, and we ignore
+    // any bits at and beyond nbits.
+    static uint64_t build(std::vector<uint64_t>& super,
+                          std::vector<uint16_t>& block,
+                          std::vector<uint64_t>& samples,
+                          const unsigned char* data,
+                          std::size_t data_bytes, uint64_t nbits)
+    {
+        HPBC_UTIL_PRECONDITION2((nbits + 7) / 8 <= data_bytes);
+        uint64_t num_blocks = nbits / BLOCK_BITS + 1;
+        super.assign(static_cast<std::size_t>(
+                          (num_blocks - 1) / BLOCKS_PER_SUPERBLOCK + 1), 0);
+        block.assign(static_cast<std::size_t>(num_blocks), 0);
+        samples.clear();
+
+        uint64_t ones = 0;
+        uint64_t super_start = 0;
+        uint64_t num_words = (nbits + WORD_BITS - 1) / WORD_BITS;
+        for (uint64_t b = 0; b < num_blocks; ++b) {
+            if (b % BLOCKS_PER_SUPERBLOCK == 0) {
+                super[static_cast<std::size_t>(b / BLOCKS_PER_SUPERBLOCK)]
+                                                                        = ones;
+                super_start = ones;
+            }
+            block[static_cast<std::size_t>(b)] =
+                                   static_cast<uint16_t>(ones - super_start);
+            uint64_t w = b * WORDS_PER_BLOCK;
+            uint64_t wend = w + WORDS_PER_BLOCK;
+            if (wend > num_words)
+                wend = num_words;
+            for (; w < wend; ++w) {
+                uint64_t word = loadWord(data, data_bytes, nbits, w);
+                unsigned int pc = popcount(word);
+                // record a sample for every multiple of SELECT_SAMPLE in
+                // [ones, ones + pc)
+                uint64_t next = (samples.size()) * SELECT_SAMPLE;
+                if (next < ones + pc)
+                    samples.push_back(b);
+                ones += pc;
+            }
+        }
+        return ones;
+    }
+
+    // Returns the number of ones in bits [0, i), for i <= nbits.
+    static uint64_t rank1(const std::vector<uint64_t>& super,
+                          const std::vector<uint16_t>& block,
+                          const unsigned char* data,
+                          std::size_t data_bytes, uint64_t nbits, uint64_t i)
+    {
+        HPBC_UTIL_PRECONDITION2(i <= nbits);
+        uint64_t b = i / BLOCK_BITS;
+        uint64_t count = blockRank(super, block, b);
+        uint64_t w = b * WORDS_PER_BLOCK;
+        uint64_t wend = i / WORD_BITS;
+        for (; w < wend; ++w)
+            count += popcount(loadWord(data, data_bytes, nbits, w));
+        unsigned int rem = static_cast<unsigned int>(i % WORD_BITS);
+        if (rem != 0) {
+            uint64_t word = loadWord(data, data_bytes, nbits, wend);
+            count += popcount(word & ((static_cast<uint64_t>(1) << rem) - 1));
+        }
+        return count;
+    }
+
+    // Returns the position of the one of rank k (i.e. the (k+1)th one), for
+    // k < ones, where ones is the total that build() returned.
+    static uint64_t select1(const std::vector<uint64_t>& super,
+                            const std::vector<uint16_t>& block,
+                            const std::vector<uint64_t>& samples,
+                            const unsigned char* data,
+                            std::size_t data_bytes, uint64_t nbits, uint64_t k)
+    {
+        std::size_t s = static_cast<std::size_t>(k / SELECT_SAMPLE);
+        HPBC_UTIL_PRECONDITION2(s < samples.size());
+        // find the last block b in [lo, hi] with blockRank(b) <= k
+        uint64_t lo = samples[s];
+        uint64_t hi = (s + 1 < samples.size()) ? samples[s + 1] :
+                                        static_cast<uint64_t>(block.size()) - 1;
+        while (hi - lo > 8) {
+            uint64_t mid = lo + (hi - lo + 1) / 2;
+            if (blockRank(super, block, mid) <= k)
+                lo = mid;
+            else
+                hi = mid - 1;
+        }
+        while (lo < hi && blockRank(super, block, lo + 1) <= k)
+            ++lo;
+        uint64_t r = k - blockRank(super, block, lo);
+        uint64_t w = lo * WORDS_PER_BLOCK;
+        for (;; ++w) {
+            HPBC_UTIL_ASSERT2(w < lo * WORDS_PER_BLOCK + WORDS_PER_BLOCK);
+            uint64_t word = loadWord(data, data_bytes, nbits, w);
+            unsigned int pc = popcount(word);
+            if (r < pc)
+                return w * WORD_BITS + selectInWord(word,
+                                                   static_cast<unsigned int>(r));
+            r -= pc;
+        }
+    }
+
+    HURCHALLA_FORCE_INLINE static unsigned int popcount(uint64_t x)
+    {
+        // On x86 without the popcnt instruction enabled, gcc compiles
+        // __builtin_popcountll to a library call that is slower than the
+        // portable version below.
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__POPCNT__) || \
+                        !(defined(__x86_64__) || defined(__i386__)))
+        return static_cast<unsigned int>(__builtin_popcountll(x));
+#else
+        x = x - ((x >> 1) & UINT64_C(0x5555555555555555));
+        x = (x & UINT64_C(0x3333333333333333)) +
+            ((x >> 2) & UINT64_C(0x3333333333333333));
+        x = (x + (x >> 4)) & UINT64_C(0x0F0F0F0F0F0F0F0F);
+        return static_cast<unsigned int>((x * UINT64_C(0x0101010101010101)) >> 56);
+#endif
+    }
+
+    // Returns the position of the set bit of rank r in word, for
+    // r < popcount(word).
+    HURCHALLA_FORCE_INLINE static unsigned int
+    selectInWord(uint64_t word, unsigned int r)
+    {
+        HPBC_UTIL_PRECONDITION2(r < popcount(word));
+        // byte i of 'sums' is the number of ones in bytes 0 to i of word
+        uint64_t x = word - ((word >> 1) & UINT64_C(0x5555555555555555));
+        x = (x & UINT64_C(0x3333333333333333)) +
+            ((x >> 2) & UINT64_C(0x3333333333333333));
+        x = (x + (x >> 4)) & UINT64_C(0x0F0F0F0F0F0F0F0F);
+        uint64_t sums = x * UINT64_C(0x0101010101010101);
+        unsigned int shift = 0;
+        unsigned int before = 0;
+        while (((sums >> shift) & 0xFF) <= r) {
+            before = static_cast<unsigned int>((sums >> shift) & 0xFF);
+            shift += 8;
+        }
+        uint64_t bits = (word >> shift) & 0xFF;
+        for (unsigned int j = r - before; j > 0; --j)
+            bits &= bits - 1;
+        return shift + static_cast<unsigned int>(count_trailing_zeros(bits));
+    }
+
+private:
+    HURCHALLA_FORCE_INLINE static
+    uint64_t blockRank(const std::vector<uint64_t>& super,
+                       const std::vector<uint16_t>& block, uint64_t b)
+    {
+        return super[static_cast<std::size_t>(b / BLOCKS_PER_SUPERBLOCK)] +
+               block[static_cast<std::size_t>(b)];
+    }
+
+    // Returns word w of the bit stream, with any bits at or beyond nbits
+    // cleared.  w must be < (nbits + 63)/64.
+    HURCHALLA_FORCE_INLINE static
+    uint64_t loadWord(const unsigned char* data, std::size_t data_bytes,
+                      uint64_t nbits, uint64_t w)
+    {
+        HPBC_UTIL_PRECONDITION2(w * WORD_BITS < nbits);
+        std::size_t byte = static_cast<std::size_t>(w * 8);
+        uint64_t word;
+        if (data_bytes - byte >= 8) {
+#if HURCHALLA_TARGET_IS_LITTLE_ENDIAN()
+            std::memcpy(&word, data + byte, sizeof(word));
+#else
+            word = 0;
+            for (int j = 7; j >= 0; --j)
+                word = (word << 8) | data[byte + static_cast<std::size_t>(j)];
+#endif
+        } else {
+            word = 0;
+            for (std::size_t j = data_bytes - byte; j > 0; --j)
+                word = (word << 8) | data[byte + j - 1];
+        }
+        uint64_t avail = nbits - w * WORD_BITS;
+        if (avail < WORD_BITS)
+            word &= (static_cast<uint64_t>(1) << avail) - 1;
+        return word;
+    }
+};
+
+
+}} // end namespace
+
+#endif
@@ -5,11 +5,16 @@
 #define HURCHALLA_UTIL_IMPL_BITPACKED_UINT_VECTOR_H_INCLUDED
 
 
+#include "hurchalla/util/BitpackedHeapStorage.h"
+#include "hurchalla/util/detail/platform_specific/impl_atomic_bits.h"
+#include "hurchalla/util/detail/platform_specific/impl_bitpacked_group_kernels.h"
 #include "hurchalla/util/detail/util_programming_by_contract.h"
 #include "hurchalla/util/traits/safely_promote_unsigned.h"
 #include "hurchalla/util/compiler_macros.h"
+#include "hurchalla/util/Unroll.h"
 #include <limits>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <type_traits>
 #include <stdexcept>
@@ -37,10 +42,12 @@ namespace hurchalla { namespace detail {
 // This class has some similarity to an array, in that after being constructed,
 // the maximum number of elements it can hold is constant, and any element can
 // be read or written.  However, similarly to a std::vector, its storage is
-// allocated on the heap.
+// allocated dynamically, by the Storage policy (see
+// BitpackedUintVectorStorage.h).
 
 
-template <typename U, unsigned int element_bitlen>
+template <typename U, unsigned int element_bitlen,
+          class Storage = BitpackedHeapStorage>
 struct ImplBitpackedUintVector
 {
     static_assert(std::numeric_limits<U>::is_integer, "");
@@ -80,17 +87,29 @@ struct ImplBitpackedUintVector
     // Again, the acceptance of P0593R6 into C++20 is what makes using char8_t*
     // reinterpret_casts on unsigned char* (in our particular case) a defined
     // behavior.  See the paper.
+    using NoAliasUchar = char8_t;
     using NoAliasUcharPtr = char8_t*;
+    using NoAliasConstUcharPtr = const char8_t*;
 #else
+    using NoAliasUchar = unsigned char;
     using NoAliasUcharPtr = unsigned char* HURCHALLA_RESTRICT;
+    using NoAliasConstUcharPtr = const unsigned char* HURCHALLA_RESTRICT;
 #endif
 
 private:
+    struct StorageDeleter {
+        std::size_t bytes;
+        void operator()(unsigned char* p) const noexcept
+        {
+            Storage::deallocate(p, bytes);
+        }
+    };
+
     const size_type packed_count;
     const std::size_t vec8_bytes;
     static_assert(std::numeric_limits<unsigned char>::digits == 8, "");
     static constexpr uint8_t dataVersion = 1;
-    std::unique_ptr<unsigned char[]> upvec;
+    std::unique_ptr<unsigned char[], StorageDeleter> upvec;
     NoAliasUcharPtr vec8;
 
 public:
@@ -107,7 +126,7 @@ public:
     ImplBitpackedUintVector(size_type count) :
           packed_count(count),
           vec8_bytes(getBytesFromCount(count)),
-          upvec(std::unique_ptr<unsigned char[]>(new unsigned char[vec8_bytes]())),
+          upvec(Storage::allocate(vec8_bytes), StorageDeleter{vec8_bytes}),
           vec8(reinterpret_cast<NoAliasUcharPtr>(upvec.get()))
     {}
     // constructor for deserialization.  Note: use data(), dataSizeBytes(), and
@@ -116,14 +135,11 @@ public:
                         std::size_t data_bytes,
                         size_type element_count) :
           packed_count(element_count),
-          vec8_bytes(data_bytes),
-          upvec(std::move(data)),
+          vec8_bytes(checkDataBytes(data_bytes, element_count)),
+          upvec(adopt(std::move(data), vec8_bytes,
+                      std::is_same<Storage, BitpackedHeapStorage>())),
           vec8(reinterpret_cast<NoAliasUcharPtr>(upvec.get()))
-    {
-        std::size_t bytes_needed = getBytesFromCount(element_count);
-        if (data_bytes != bytes_needed)
-            throw std::length_error("data_bytes doesn't match expected bytes needed for element_count");
-    }
+    {}
 
     // returns the number of packed elements in this vector
     size_type size() const
@@ -171,8 +187,9 @@ public:
             else
                 ++bytes_needed;
         }
-        // We want to allocate one byte more than we strictly need, so that
-        // setAt() can safely write one byte beyond where it strictly should.
+        // We allocate one byte more than we strictly need.  getAt() no longer
+        // reads beyond its element, but the extra byte is part of the data
+        // format (and of getFormatID()), so it stays.
         if (bytes_needed == MAXSIZET)
             return 0;
         else
@@ -210,6 +227,34 @@ private:
         return bytes_needed;
     }
 
+    static std::size_t checkDataBytes(std::size_t data_bytes,
+                                      size_type element_count)
+    {
+        std::size_t bytes_needed = getBytesFromCount(element_count);
+        if (data_bytes != bytes_needed)
+            throw std::length_error("data_bytes doesn't match expected bytes needed for element_count");
+        return data_bytes;
+    }
+
+    // BitpackedHeapStorage uses new[] and delete[], so it can take ownership
+    // of the deserialization data.  Other storage needs a copy.
+    static std::unique_ptr<unsigned char[], StorageDeleter>
+    adopt(std::unique_ptr<unsigned char[]> data, std::size_t data_bytes,
+          std::true_type)
+    {
+        return std::unique_ptr<unsigned char[], StorageDeleter>(
+                                   data.release(), StorageDeleter{data_bytes});
+    }
+    static std::unique_ptr<unsigned char[], StorageDeleter>
+    adopt(std::unique_ptr<unsigned char[]> data, std::size_t data_bytes,
+          std::false_type)
+    {
+        std::unique_ptr<unsigned char[], StorageDeleter> p(
+                  Storage::allocate(data_bytes), StorageDeleter{data_bytes});
+        std::memcpy(p.get(), data.get(), data_bytes);
+        return p;
+    }
+
 
     // if this function returns with overflowed == false,
     // then it guarantees any value <= 'index' can be converted into
@@ -272,12 +317,11 @@ private:
 // 8 bit, 16 bit, 24, 32 etc functions
 private:
     template <int BITS = element_bitlen>
-    HURCHALLA_FORCE_INLINE typename std::enable_if<(BITS % 8 == 0), void>::type
+    HURCHALLA_FORCE_INLINE static
+    typename std::enable_if<(BITS % 8 == 0), void>::type
     getLocationFromIndex(size_type index,
-                      std::size_t& starting_byte, std::size_t& bit_offset) const
+                      std::size_t& starting_byte, std::size_t& bit_offset)
     {
-        HPBC_UTIL_PRECONDITION2(index < size());
-
         constexpr decltype(element_bitlen) element_bytes =
                       static_cast<decltype(element_bitlen)>(element_bitlen / 8);
           // The constructor established a class invariant that any
@@ -297,129 +341,378 @@ private:
     }
 
 public:
+    // The getLocationFromIndex() functions are static so that they can also
+    // serve storage that this class doesn't own.  Their callers must ensure
+    // the class invariant that they rely upon: index <= count, for some count
+    // where dataSizeBytes(count) != 0.
+    HURCHALLA_FORCE_INLINE static void locateIndex(size_type index,
+                      std::size_t& starting_byte, std::size_t& bit_offset)
+    {
+        getLocationFromIndex(index, starting_byte, bit_offset);
+    }
+
+    // Static versions of setAt() and getAt(), for packed data at 'vec' that
+    // this class doesn't own.  The same class invariant as above applies.
+    HURCHALLA_FORCE_INLINE static
+    void writeIndex(NoAliasUcharPtr vec, size_type index, U value)
+    {
+        HPBC_UTIL_PRECONDITION2(value <= max_allowed_value());
+        std::size_t starting_byte, bit_offset;
+        getLocationFromIndex(index, starting_byte, bit_offset);
+        writeAt(vec + starting_byte, bit_offset, value);
+    }
+    HURCHALLA_FORCE_INLINE static
+    U readIndex(NoAliasConstUcharPtr vec, size_type index)
+    {
+        std::size_t starting_byte, bit_offset;
+        getLocationFromIndex(index, starting_byte, bit_offset);
+        return readAt(vec + starting_byte, bit_offset);
+    }
+
+    // Versions of writeIndex() and readIndex() for random access, given the
+    // size in bytes of the packed data at 'vec'.  When it's possible, they
+    // access the element with a single 4 or 8 byte load (and store) that
+    // lies within both the data and the element's granule (see
+    // windowBytes() below), rather than byte by byte.  Random access timings
+    // in nanoseconds for 16K elements, before and after (1 core x64 VM,
+    // gcc 12, -O2):
+    //   bits      getAt()     getAt()+setAt()
+    //    13     4.1 -> 3.9      5.1 -> 4.7
+    //    21     4.8 -> 3.8      5.8 -> 4.6
+    //    27     5.0 -> 4.0      6.0 -> 4.8
+    // For 8M elements (mostly in DRAM), getAt()+setAt() at 13 and 27 bits
+    // went from 14.3 to 11.2 ns and from 35.5 to 26.9 ns.
+    // DynamicBitpackedUintVector's 8 byte window, which may access the bytes
+    // of other granules, is still a little faster (3.1 ns for an L1 getAt()),
+    // but it needs 7 bytes of padding past the data and it gives up
+    // partitionPoint()'s guarantee, neither of which this class can do.
+    HURCHALLA_FORCE_INLINE static
+    void writeIndex(NoAliasUcharPtr vec, std::size_t vec_bytes,
+                    size_type index, U value)
+    {
+        HPBC_UTIL_PRECONDITION2(value <= max_allowed_value());
+        writeIndexWindow(vec, vec_bytes, index, value,
+                   std::integral_constant<bool, (windowBytes() != 0)>());
+    }
+    HURCHALLA_FORCE_INLINE static
+    U readIndex(NoAliasConstUcharPtr vec, std::size_t vec_bytes,
+                size_type index)
+    {
+        return readIndexWindow(vec, vec_bytes, index,
+                   std::integral_constant<bool, (windowBytes() != 0)>());
+    }
+
+    void setAt(size_type index, U value)
+    {
+        HPBC_UTIL_PRECONDITION2(value <= max_allowed_value());
+        HPBC_UTIL_PRECONDITION2(index < size());
+        // mitigate the perf hit if the compiler assumes vec8 could alias *this
+        NoAliasUcharPtr ptr = vec8;
+        writeIndex(ptr, vec8_bytes, index, value);
+    }
+    U getAt(size_type index) const
+    {
+        HPBC_UTIL_PRECONDITION2(index < size());
+        return readIndex(vec8, vec8_bytes, index);
+    }
+
+    // Returns the location (the byte pointer and bit_offset) of the element
+    // at 'index'.  Requires index <= size(); index == size() gives the
+    // location one past the last element.
+    void getLocation(size_type index, NoAliasUchar*& ptr,
+                     std::size_t& bit_offset) const
+    {
+        HPBC_UTIL_PRECONDITION2(index <= size());
+        std::size_t starting_byte;
+        bool overflowed;
+        attemptGetLocationFromIndex(index, starting_byte, bit_offset, overflowed);
+        HPBC_UTIL_ASSERT2(overflowed == false);
+        ptr = vec8 + starting_byte;
+    }
+
+private:
+    // A granule is the smallest run of elements that begins and ends on a
+    // byte boundary: partitionGranularity() elements, in granuleBytes()
+    // bytes.  Index ranges that don't share a byte are always made of whole
+    // granules, so getAt() and setAt() may access any of the bytes of their
+    // element's granule without affecting what threads may do concurrently
+    // (see partitionPoint()).
+    static constexpr std::size_t granuleBytes()
+    {
+        return static_cast<std::size_t>(partitionGranularity()) *
+               element_bitlen / 8;
+    }
+    // The window getAt() and setAt() use: the smallest of 4 or 8 bytes that
+    // covers an element at its largest bit_offset, so long as the window
+    // fits within a granule.  0 means they access only the element's bytes,
+    // with readAt() and writeAt().  That's the case for widths that are a
+    // multiple or a divisor of 8 (the elements are byte aligned), for widths
+    // that are 1 more than a multiple of 8 (every element spans the same
+    // number of bytes, so readAt() is already a fixed size load), for 10
+    // bits (which has its own cheap location arithmetic), and for 3, 6, and
+    // 12 bits (their granules are only 3 bytes).
+    static constexpr std::size_t windowBytes()
+    {
+        return (element_bitlen % 8 == 0 || 8 % element_bitlen == 0 ||
+                element_bitlen % 8 == 1 || element_bitlen == 10) ? 0 :
+               (maxBitOffset() + element_bitlen <= 32) ?
+                     ((granuleBytes() >= 4) ? 4 : 0) :
+               (maxBitOffset() + element_bitlen <= 64) ?
+                     ((granuleBytes() >= 8) ? 8 : 0) : 0;
+    }
+    static constexpr std::size_t maxBitOffset()
+    {
+        return 8 - 8 / static_cast<std::size_t>(partitionGranularity());
+    }
+    // Byte j of the result is the window's first byte (relative to the
+    // granule) for element j of a granule: the element's first byte, unless
+    // the window would then extend past the granule.
+    static constexpr uint64_t windowStarts(std::size_t j)
+    {
+        return (j == partitionGranularity()) ? 0 :
+               (static_cast<uint64_t>(
+                    (j * element_bitlen / 8 < granuleBytes() - windowBytes()) ?
+                    j * element_bitlen / 8 : granuleBytes() - windowBytes())
+                   << (8 * j)) | windowStarts(j + 1);
+    }
+
+    // If the element at 'index' is in a granule that lies entirely within
+    // the data, sets 'start' to the first byte of the element's window, and
+    // 'shift' to the element's bit position within the window, and returns
+    // true.  Otherwise (only for the last granule), returns false.  The
+    // window never includes the last byte of the data (the extra byte that
+    // dataSizeBytes() counts), which holds no element bits; for a view that
+    // ends where another begins, that byte belongs to the other view.
+    HURCHALLA_FORCE_INLINE static
+    bool locateWindow(std::size_t vec_bytes, size_type index,
+                      std::size_t& start, unsigned int& shift)
+    {
+        constexpr std::size_t G = granuleBytes();
+        constexpr size_type GRAN = partitionGranularity();
+        // The granule begins at or before the element's first byte, so this
+        // can't overflow (see the class invariant for getLocationFromIndex).
+        std::size_t granule_start = static_cast<std::size_t>(index / GRAN) * G;
+        HPBC_UTIL_ASSERT2(granule_start < vec_bytes - 1);
+        if (vec_bytes - 1 - granule_start < G)
+            return false;
+        // the element's bit position within its granule
+        std::size_t j = static_cast<std::size_t>(index % GRAN);
+        std::size_t bit = j * element_bitlen;
+        // windowStarts() is a lookup table in a constant; a min() here
+        // instead would often compile to an unpredictable branch
+        std::size_t rel = static_cast<std::size_t>(
+                                 (windowStarts(0) >> (8 * j)) & 0xFF);
+        start = granule_start + rel;
+        shift = static_cast<unsigned int>(bit - 8 * rel);
+        HPBC_UTIL_ASSERT2(shift + element_bitlen <= 8 * windowBytes());
+        return true;
+    }
+
+    template <std::size_t W>
+    HURCHALLA_FORCE_INLINE static
+    typename std::enable_if<(W == 4), uint64_t>::type
+    loadWindow(NoAliasConstUcharPtr ptr)
+    {
+#if HURCHALLA_TARGET_IS_LITTLE_ENDIAN()
+        uint32_t word;
+        std::memcpy(&word, ptr, sizeof(word));
+        return word;
+#else
+        return  (static_cast<uint32_t>(ptr[0]) << 0) |
+                (static_cast<uint32_t>(ptr[1]) << 8) |
+                (static_cast<uint32_t>(ptr[2]) << 16) |
+                (static_cast<uint32_t>(ptr[3]) << 24);
+#endif
+    }
+    template <std::size_t W>
+    HURCHALLA_FORCE_INLINE static
+    typename std::enable_if<(W == 8), uint64_t>::type
+    loadWindow(NoAliasConstUcharPtr ptr)
+    {
+        return loadLE64(ptr);
+    }
+    template <std::size_t W>
+    HURCHALLA_FORCE_INLINE static
+    typename std::enable_if<(W == 4), void>::type
+    storeWindow(NoAliasUcharPtr ptr, uint64_t word)
+    {
+        storeLE32(ptr, static_cast<uint32_t>(word));
+    }
+    template <std::size_t W>
+    HURCHALLA_FORCE_INLINE static
+    typename std::enable_if<(W == 8), void>::type
+    storeWindow(NoAliasUcharPtr ptr, uint64_t word)
+    {
+        storeLE64(ptr, word);
+    }
+
+    HURCHALLA_FORCE_INLINE static
+    void writeIndexWindow(NoAliasUcharPtr vec, std::size_t vec_bytes,
+                          size_type index, U value, std::true_type)
+    {
+        constexpr std::size_t W = windowBytes();
+        std::size_t start;
+        unsigned int shift;
+        if HURCHALLA_UNLIKELY(!locateWindow(vec_bytes, index, start, shift)) {
+            writeIndex(vec, index, value);
+            return;
+        }
+        uint64_t mask = static_cast<uint64_t>(max_allowed_value()) << shift;
+        uint64_t word = loadWindow<W>(vec + start);
+        word = (word & ~mask) | (static_cast<uint64_t>(value) << shift);
+        storeWindow<W>(vec + start, word);
+    }
+    HURCHALLA_FORCE_INLINE static
+    void writeIndexWindow(NoAliasUcharPtr vec, std::size_t,
+                          size_type index, U value, std::false_type)
+    {
+        writeIndex(vec, index, value);
+    }
+    HURCHALLA_FORCE_INLINE static
+    U readIndexWindow(NoAliasConstUcharPtr vec, std::size_t vec_bytes,
+                      size_type index, std::true_type)
+    {
+        constexpr std::size_t W = windowBytes();
+        std::size_t start;
+        unsigned int shift;
+        if HURCHALLA_UNLIKELY(!locateWindow(vec_bytes, index, start, shift))
+            return readIndex(vec, index);
+        uint64_t word = loadWindow<W>(vec + start) >> shift;
+        U value = static_cast<U>(word &
+                                 static_cast<uint64_t>(max_allowed_value()));
+        HPBC_UTIL_POSTCONDITION2(value <= max_allowed_value());
+        return value;
+    }
+    HURCHALLA_FORCE_INLINE static
+    U readIndexWindow(NoAliasConstUcharPtr vec, std::size_t,
+                      size_type index, std::false_type)
+    {
+        return readIndex(vec, index);
+    }
+
+// The readAt() and writeAt() functions below read or write the element that
+// begins at bit 'bit_offset' of the byte at 'ptr'.  They work on a location
+// rather than an index, so that iterators can step from one element to the
+// next by adding element_bitlen to bit_offset, without any division.
+// They access only the bytes that the element occupies (getAt() and setAt()
+// may access more bytes of the element's granule; see windowBytes()): for
+// widths where the element may or may not extend into the last byte of its
+// fixed size window, they access the final byte at index
+// (bit_offset + element_bitlen - 1)/8, which duplicates an earlier byte of
+// the element when it doesn't (branch free, which matters for random
+// access).  This is what allows separate threads to access index ranges
+// with non-overlapping bytes; see partitionPoint().
 
 // 8 bit functions:
+public:
     template <int BITS = element_bitlen>
+    HURCHALLA_FORCE_INLINE static
     typename std::enable_if<(BITS == 8), void>::type
-    setAt(size_type index, U value)
+    writeAt(NoAliasUcharPtr ptr, std::size_t bit_offset, U value)
     {
+        HPBC_UTIL_PRECONDITION2(bit_offset == 0);
+        (void)bit_offset;
         HPBC_UTIL_PRECONDITION2(value <= max_allowed_value());
-        HPBC_UTIL_PRECONDITION2(index < size());
-        std::size_t index_st = static_cast<std::size_t>(index);
-        vec8[index_st] = static_cast<unsigned char>(value);
+        ptr[0] = static_cast<unsigned char>(value);
     }
     template <int BITS = element_bitlen>
+    HURCHALLA_FORCE_INLINE static
     typename std::enable_if<(BITS == 8), U>::type
-    getAt(size_type index) const
+    readAt(NoAliasConstUcharPtr ptr, std::size_t bit_offset)
     {
-        HPBC_UTIL_PRECONDITION2(index < size());
-        std::size_t index_st = static_cast<std::size_t>(index);
-        U value = vec8[index_st];
+        HPBC_UTIL_PRECONDITION2(bit_offset == 0);
+        (void)bit_offset;
+        U value = ptr[0];
         HPBC_UTIL_POSTCONDITION2(value <= max_allowed_value());
         return value;
     }
 
 // 16 bit functions:
     template <int BITS = element_bitlen>
+    HURCHALLA_FORCE_INLINE static
     typename std::enable_if<(BITS == 16), void>::type
-    setAt(size_type index, U value)
+    writeAt(NoAliasUcharPtr ptr, std::size_t bit_offset, U value)
     {
+        HPBC_UTIL_PRECONDITION2(bit_offset == 0);
+        (void)bit_offset;
         HPBC_UTIL_PRECONDITION2(value <= max_allowed_value());
-        HPBC_UTIL_PRECONDITION2(index < size());
-
-        std::size_t starting_byte, bit_offset;
-        getLocationFromIndex(index, starting_byte, bit_offset);
 
         static_assert(std::numeric_limits<U>::digits >= 16, "");
-        // mitigate the perf hit if the compiler assumes vec8 could alias *this
-        NoAliasUcharPtr ptr = vec8;
-        ptr[starting_byte + 0] = static_cast<unsigned char>(value);
-        ptr[starting_byte + 1] = static_cast<unsigned char>(value >> 8);
+        ptr[0] = static_cast<unsigned char>(value);
+        ptr[1] = static_cast<unsigned char>(value >> 8);
     }
     template <int BITS = element_bitlen>
+    HURCHALLA_FORCE_INLINE static
     typename std::enable_if<(BITS == 16), U>::type
-    getAt(size_type index) const
+    readAt(NoAliasConstUcharPtr ptr, std::size_t bit_offset)
     {
-        HPBC_UTIL_PRECONDITION2(index < size());
-
-        std::size_t starting_byte, bit_offset;
-        getLocationFromIndex(index, starting_byte, bit_offset);
-
+        HPBC_UTIL_PRECONDITION2(bit_offset == 0);
+        (void)bit_offset;
         static_assert(std::numeric_limits<U>::digits >= 16, "");
-        U value = static_cast<U>( vec8[starting_byte + 0] +
-                               (static_cast<U>(vec8[starting_byte + 1]) << 8) );
+        U value = static_cast<U>( ptr[0] +
+                               (static_cast<U>(ptr[1]) << 8) );
         HPBC_UTIL_POSTCONDITION2(value <= max_allowed_value());
         return value;
     }
 
 // 24 bit functions:
     template <int BITS = element_bitlen>
+    HURCHALLA_FORCE_INLINE static
     typename std::enable_if<(BITS == 24), void>::type
-    setAt(size_type index, U value)
+    writeAt(NoAliasUcharPtr ptr, std::size_t bit_offset, U value)
     {
+        HPBC_UTIL_PRECONDITION2(bit_offset == 0);
+        (void)bit_offset;
         HPBC_UTIL_PRECONDITION2(value <= max_allowed_value());
-        HPBC_UTIL_PRECONDITION2(index < size());
-
-        std::size_t starting_byte, bit_offset;
-        getLocationFromIndex(index, starting_byte, bit_offset);
 
         static_assert(std::numeric_limits<U>::digits >= 24, "");
-        // mitigate the perf hit if the compiler assumes vec8 could alias *this
-        NoAliasUcharPtr ptr = vec8;
-        ptr[starting_byte + 0] = static_cast<unsigned char>(value);
-        ptr[starting_byte + 1] = static_cast<unsigned char>(value >> 8);
-        ptr[starting_byte + 2] = static_cast<unsigned char>(value >> 16);
+        ptr[0] = static_cast<unsigned char>(value);
+        ptr[1] = static_cast<unsigned char>(value >> 8);
+        ptr[2] = static_cast<unsigned char>(value >> 16);
     }
     template <int BITS = element_bitlen>
+    HURCHALLA_FORCE_INLINE static
     typename std::enable_if<(BITS == 24), U>::type
-    getAt(size_type index) const
+    readAt(NoAliasConstUcharPtr ptr, std::size_t bit_offset)
     {
-        HPBC_UTIL_PRECONDITION2(index < size());
-
-        std::size_t starting_byte, bit_offset;
-        getLocationFromIndex(index, starting_byte, bit_offset);
-
+        HPBC_UTIL_PRECONDITION2(bit_offset == 0);
+        (void)bit_offset;
         static_assert(std::numeric_limits<U>::digits >= 24, "");
-        U value = vec8[starting_byte + 0] +
-                  (static_cast<U>(vec8[starting_byte + 1]) << 8) +
-                  (static_cast<U>(vec8[starting_byte + 2]) << 16);
+        U value = ptr[0] +
+                  (static_cast<U>(ptr[1]) << 8) +
+                  (static_cast<U>(ptr[2]) << 16);
         HPBC_UTIL_POSTCONDITION2(value <= max_allowed_value());
         return value;
     }
 
 // 32 bit functions:
     template <int BITS = element_bitlen>
+    HURCHALLA_FORCE_INLINE static
     typename std::enable_if<(BITS == 32), void>::type
-    setAt(size_type index, U value)
+    writeAt(NoAliasUcharPtr ptr, std::size_t bit_offset, U value)
     {
+        HPBC_UTIL_PRECONDITION2(bit_offset == 0);
+        (void)bit_offset;
         HPBC_UTIL_PRECONDITION2(value <= max_allowed_value());
-        HPBC_UTIL_PRECONDITION2(index < size());
-
-        std::size_t starting_byte, bit_offset;
-        getLocationFromIndex(index, starting_byte, bit_offset);
 
         static_assert(std::numeric_limits<U>::digits >= 32, "");
-        // mitigate the perf hit if the compiler assumes vec8 could alias *this
-        NoAliasUcharPtr ptr = vec8;
-        ptr[starting_byte + 0] = static_cast<unsigned char>(value);
-        ptr[starting_byte + 1] = static_cast<unsigned char>(value >> 8);
-        ptr[starting_byte + 2] = static_cast<unsigned char>(value >> 16);
-        ptr[starting_byte + 3] = static_cast<unsigned char>(value >> 24);
+        ptr[0] = static_cast<unsigned char>(value);
+        ptr[1] = static_cast<unsigned char>(value >> 8);
+        ptr[2] = static_cast<unsigned char>(value >> 16);
+        ptr[3] = static_cast<unsigned char>(value >> 24);
     }
     template <int BITS = element_bitlen>
+    HURCHALLA_FORCE_INLINE static
     typename std::enable_if<(BITS == 32), U>::type
-    getAt(size_type index) const
+    readAt(NoAliasConstUcharPtr ptr, std::size_t bit_offset)
     {
-        HPBC_UTIL_PRECONDITION2(index < size());
-
-        std::size_t starting_byte, bit_offset;
-        getLocationFromIndex(index, starting_byte, bit_offset);
-
+        HPBC_UTIL_PRECONDITION2(bit_offset == 0);
+        (void)bit_offset;
         static_assert(std::numeric_limits<U>::digits >= 32, "");
-        U value = vec8[starting_byte + 0] +
-                  (static_cast<U>(vec8[starting_byte + 1]) << 8) +
-                  (static_cast<U>(vec8[starting_byte + 2]) << 16) +
-                  (static_cast<U>(vec8[starting_byte + 3]) << 24);
+        U value = ptr[0] +
+                  (static_cast<U>(ptr[1]) << 8) +
+                  (static_cast<U>(ptr[2]) << 16) +
+                  (static_cast<U>(ptr[3]) << 24);
         HPBC_UTIL_POSTCONDITION2(value <= max_allowed_value());
         return value;
     }
@@ -429,12 +722,11 @@ public:
 // 1,2,4 bit functions:
 private:
     template <int BITS = element_bitlen>
-    HURCHALLA_FORCE_INLINE
+    HURCHALLA_FORCE_INLINE static
     typename std::enable_if<(BITS == 1)||(BITS == 2)||(BITS == 4), void>::type
     getLocationFromIndex(size_type index,
-                      std::size_t& starting_byte, std::size_t& bit_offset) const
+                      std::size_t& starting_byte, std::size_t& bit_offset)
     {
-        HPBC_UTIL_PRECONDITION2(index < size());
 
         static_assert(8 % element_bitlen == 0, "");
         constexpr decltype(element_bitlen) elements_per_byte = 8/element_bitlen;
@@ -473,18 +765,14 @@ private:
     }
 public:
     template <int BITS = element_bitlen>
+    HURCHALLA_FORCE_INLINE static
     typename std::enable_if<(BITS == 1)||(BITS == 2)||(BITS == 4), void>::type
-    setAt(size_type index, U value)
+    writeAt(NoAliasUcharPtr ptr, std::size_t bit_offset, U value)
     {
         HPBC_UTIL_PRECONDITION2(value <= max_allowed_value());
-        HPBC_UTIL_PRECONDITION2(index < size());
+        HPBC_UTIL_PRECONDITION2(element_bitlen + bit_offset <= 8);
 
-        std::size_t starting_byte, bit_offset;
-        getLocationFromIndex(index, starting_byte, bit_offset);
-          // from getLocationFromIndex() we know
-        HPBC_UTIL_ASSERT2(element_bitlen + bit_offset <= 8);
-
-        HPBC_UTIL_ASSERT2(bit_offset < 8);
+        HPBC_UTIL_PRECONDITION2(bit_offset < 8);
         static_assert(element_bitlen < 8, "");
 
         uint8_t newbits = static_cast<uint8_t>(
@@ -492,25 +780,21 @@ public:
 
         constexpr uint8_t mask = static_cast<uint8_t>((1 << element_bitlen) - 1);
         auto mask2 = ~(static_cast<unsigned int>(mask << bit_offset));
-        auto oldbits = mask2 & vec8[starting_byte];
+        auto oldbits = mask2 & ptr[0];
 
-        vec8[starting_byte] = static_cast<unsigned char>(oldbits | newbits);
+        ptr[0] = static_cast<unsigned char>(oldbits | newbits);
     }
     template <int BITS = element_bitlen>
+    HURCHALLA_FORCE_INLINE static
     typename std::enable_if<(BITS == 1) || (BITS == 2) || (BITS == 4), U>::type
-    getAt(size_type index) const
+    readAt(NoAliasConstUcharPtr ptr, std::size_t bit_offset)
     {
-        HPBC_UTIL_PRECONDITION2(index < size());
+        HPBC_UTIL_PRECONDITION2(element_bitlen + bit_offset <= 8);
 
-        std::size_t starting_byte, bit_offset;
-        getLocationFromIndex(index, starting_byte, bit_offset);
-          // from getLocationFromIndex() we know
-        HPBC_UTIL_ASSERT2(element_bitlen + bit_offset <= 8);
-
-        HPBC_UTIL_ASSERT2(bit_offset < 8);
+        HPBC_UTIL_PRECONDITION2(bit_offset < 8);
         static_assert(element_bitlen < 8, "");
 
-        uint8_t byte = static_cast<uint8_t>(vec8[starting_byte] >> bit_offset);
+        uint8_t byte = static_cast<uint8_t>(ptr[0] >> bit_offset);
         constexpr uint8_t mask = static_cast<uint8_t>((1 << element_bitlen) - 1);
         uint8_t value = mask & byte;
 
@@ -523,13 +807,12 @@ public:
 private:
     // note that this function should work for any element_bitlen < 8
     template <int BITS = element_bitlen>
-    HURCHALLA_FORCE_INLINE
+    HURCHALLA_FORCE_INLINE static
     typename std::enable_if<(BITS == 3) || (BITS == 5) ||
                             (BITS == 6) || (BITS == 7), void>::type
     getLocationFromIndex(size_type index,
-                      std::size_t& starting_byte, std::size_t& bit_offset) const
+                      std::size_t& starting_byte, std::size_t& bit_offset)
     {
-        HPBC_UTIL_PRECONDITION2(index < size());
           // The constructor established a class invariant that any
           // index < size() will convert correctly by attemptGetLocationFromIndex().
           // Thus we don't need to check overflowed below- it is always false.
@@ -542,22 +825,21 @@ private:
 public:
     // note that this function should work for any element_bitlen < 8
     template <int BITS = element_bitlen>
+    HURCHALLA_FORCE_INLINE static
     typename std::enable_if<(BITS == 3) || (BITS == 5) ||
                             (BITS == 6) || (BITS == 7), void>::type
-    setAt(size_type index, U value)
+    writeAt(NoAliasUcharPtr ptr, std::size_t bit_offset, U value)
     {
         HPBC_UTIL_PRECONDITION2(value <= max_allowed_value());
-        HPBC_UTIL_PRECONDITION2(index < size());
-
-        std::size_t starting_byte, bit_offset;
-        getLocationFromIndex(index, starting_byte, bit_offset);
-
-        HPBC_UTIL_ASSERT2(bit_offset < 8);
+        HPBC_UTIL_PRECONDITION2(bit_offset < 8);
         static_assert(element_bitlen < 8, "");
 
+        // see the comment above the 8 bit functions; ptr[last] is the last
+        // byte of the element
+        std::size_t last = (bit_offset + element_bitlen - 1) / 8;
         uint16_t oldword = static_cast<uint16_t>(
-                        vec8[starting_byte + 0] +
-                        (static_cast<uint16_t>(vec8[starting_byte + 1]) << 8) );
+                        ptr[0] |
+                        (static_cast<uint16_t>(ptr[last]) << (8 * last)) );
         uint16_t newword = static_cast<uint16_t>(
                                     static_cast<uint16_t>(value) << bit_offset);
 
@@ -566,28 +848,23 @@ public:
                                   ~(static_cast<uint16_t>(mask) << bit_offset));
         uint16_t word = static_cast<uint16_t>((mask2 & oldword) | newword);
 
-        // mitigate the perf hit if the compiler assumes vec8 could alias *this
-        NoAliasUcharPtr ptr = vec8;
-        ptr[starting_byte + 0] = static_cast<unsigned char>(word);
-        ptr[starting_byte + 1] = static_cast<unsigned char>(word >> 8);
+        ptr[0] = static_cast<unsigned char>(word);
+        ptr[last] = static_cast<unsigned char>(word >> (8 * last));
     }
     // note that this function should work for any element_bitlen < 8
     template <int BITS = element_bitlen>
+    HURCHALLA_FORCE_INLINE static
     typename std::enable_if<(BITS == 3) || (BITS == 5) ||
                             (BITS == 6) || (BITS == 7), U>::type
-    getAt(size_type index) const
+    readAt(NoAliasConstUcharPtr ptr, std::size_t bit_offset)
     {
-        HPBC_UTIL_PRECONDITION2(index < size());
-
-        std::size_t starting_byte, bit_offset;
-        getLocationFromIndex(index, starting_byte, bit_offset);
-
-        HPBC_UTIL_ASSERT2(bit_offset < 8);
+        HPBC_UTIL_PRECONDITION2(bit_offset < 8);
         static_assert(element_bitlen < 8, "");
 
+        std::size_t last = (bit_offset + element_bitlen - 1) / 8;
         uint16_t word = static_cast<uint16_t>(
-                        vec8[starting_byte + 0] +
-                        (static_cast<uint16_t>(vec8[starting_byte + 1]) << 8) );
+                        ptr[0] |
+                        (static_cast<uint16_t>(ptr[last]) << (8 * last)) );
 
         word = static_cast<uint16_t>(word >> bit_offset);
         constexpr uint8_t mask = (static_cast<uint8_t>(1) << element_bitlen) - 1;
@@ -601,12 +878,11 @@ public:
 // 9,10,12 bit functions:
 private:
     template <int BITS = element_bitlen>
-    HURCHALLA_FORCE_INLINE
+    HURCHALLA_FORCE_INLINE static
     typename std::enable_if<(BITS == 9)||(BITS == 10)||(BITS == 12), void>::type
     getLocationFromIndex(size_type index,
-                      std::size_t& starting_byte, std::size_t& bit_offset) const
+                      std::size_t& starting_byte, std::size_t& bit_offset)
     {
-        HPBC_UTIL_PRECONDITION2(index < size());
 
           // We would like to set  starting_byte = (index * element_bitlen) / 8
           // but (index * element_bitlen) might overflow.  So instead:
@@ -650,7 +926,7 @@ private:
           // thus     bit_offset + k*8 = index*element_bitlen  for some k
           // Since    8 ≡ 0  (mod spill)   And   element_bitlen ≡ 0  (mod spill)
           // we have  bit_offset ≡ 0  (mod spill)
-        HPBC_UTIL_ASSERT2(bit_offset < 8);
+        HPBC_UTIL_PRECONDITION2(bit_offset < 8);
         HPBC_UTIL_ASSERT2(bit_offset % spill == 0);
           // If element_bitlen == 9, then since bit_offset <= 7,
           //    element_bitlen + bit_offset <= 16.
@@ -665,21 +941,16 @@ private:
     }
 public:
     template <int BITS = element_bitlen>
+    HURCHALLA_FORCE_INLINE static
     typename std::enable_if<(BITS == 9)||(BITS == 10)||(BITS == 12), void>::type
-    setAt(size_type index, U value)
+    writeAt(NoAliasUcharPtr ptr, std::size_t bit_offset, U value)
     {
         HPBC_UTIL_PRECONDITION2(value <= max_allowed_value());
-        HPBC_UTIL_PRECONDITION2(index < size());
-
-        std::size_t starting_byte, bit_offset;
-        getLocationFromIndex(index, starting_byte, bit_offset);
-
-          // from getLocationFromIndex() we know
-        HPBC_UTIL_ASSERT2(element_bitlen + bit_offset <= 16);
-        HPBC_UTIL_ASSERT2(bit_offset < 8);
+        HPBC_UTIL_PRECONDITION2(element_bitlen + bit_offset <= 16);
+        HPBC_UTIL_PRECONDITION2(bit_offset < 8);
         uint16_t oldword = static_cast<uint16_t>(
-                (static_cast<uint16_t>(vec8[starting_byte + 0]) << 0) +
-                (static_cast<uint16_t>(vec8[starting_byte + 1]) << 8) );
+                (static_cast<uint16_t>(ptr[0]) << 0) +
+                (static_cast<uint16_t>(ptr[1]) << 8) );
         uint16_t newword = static_cast<uint16_t>(
                                static_cast<uint16_t>(value) << bit_offset );
 
@@ -688,26 +959,19 @@ public:
         uint16_t mask2 = static_cast<uint16_t>( ~(mask << bit_offset) );
         uint16_t word = (mask2 & oldword) | newword;
 
-        // mitigate the perf hit if the compiler assumes vec8 could alias *this
-        NoAliasUcharPtr ptr = vec8;
-        ptr[starting_byte + 0] = static_cast<unsigned char>(word);
-        ptr[starting_byte + 1] = static_cast<unsigned char>(word >> 8);
+        ptr[0] = static_cast<unsigned char>(word);
+        ptr[1] = static_cast<unsigned char>(word >> 8);
     }
     template <int BITS = element_bitlen>
+    HURCHALLA_FORCE_INLINE static
     typename std::enable_if<(BITS == 9)||(BITS == 10)||(BITS == 12), U>::type
-    getAt(size_type index) const
+    readAt(NoAliasConstUcharPtr ptr, std::size_t bit_offset)
     {
-        HPBC_UTIL_PRECONDITION2(index < size());
-
-        std::size_t starting_byte, bit_offset;
-        getLocationFromIndex(index, starting_byte, bit_offset);
-
-          // from getLocationFromIndex() we know
-        HPBC_UTIL_ASSERT2(element_bitlen + bit_offset <= 16);
-        HPBC_UTIL_ASSERT2(bit_offset < 8);
+        HPBC_UTIL_PRECONDITION2(element_bitlen + bit_offset <= 16);
+        HPBC_UTIL_PRECONDITION2(bit_offset < 8);
         uint16_t word = static_cast<uint16_t>(
-                (static_cast<uint16_t>(vec8[starting_byte + 0]) << 0) +
-                (static_cast<uint16_t>(vec8[starting_byte + 1]) << 8) );
+                (static_cast<uint16_t>(ptr[0]) << 0) +
+                (static_cast<uint16_t>(ptr[1]) << 8) );
 
         word = static_cast<uint16_t>(word >> bit_offset);
         static_assert(element_bitlen < 16, "");
@@ -723,13 +987,12 @@ public:
 private:
     // note that this function should work for any  8 < element_bitlen < 16
     template <int BITS = element_bitlen>
-    HURCHALLA_FORCE_INLINE
+    HURCHALLA_FORCE_INLINE static
     typename std::enable_if<(BITS == 11) || (BITS == 13) ||
                             (BITS == 14) || (BITS == 15), void>::type
     getLocationFromIndex(size_type index,
-                      std::size_t& starting_byte, std::size_t& bit_offset) const
+                      std::size_t& starting_byte, std::size_t& bit_offset)
     {
-        HPBC_UTIL_PRECONDITION2(index < size());
           // The constructor established a class invariant that any
           // index < size() will convert correctly by attemptGetLocationFromIndex().
           // Thus we don't need to check overflowed below- it is always false.
@@ -742,51 +1005,45 @@ private:
 public:
     // note that this function should work for any  8 < element_bitlen < 16
     template <int BITS = element_bitlen>
+    HURCHALLA_FORCE_INLINE static
     typename std::enable_if<(BITS == 11) || (BITS == 13) ||
                             (BITS == 14) || (BITS == 15), void>::type
-    setAt(size_type index, U value)
+    writeAt(NoAliasUcharPtr ptr, std::size_t bit_offset, U value)
     {
         HPBC_UTIL_PRECONDITION2(value <= max_allowed_value());
-        HPBC_UTIL_PRECONDITION2(index < size());
-
-        std::size_t starting_byte, bit_offset;
-        getLocationFromIndex(index, starting_byte, bit_offset);
-        HPBC_UTIL_ASSERT2(bit_offset < 8);
+        HPBC_UTIL_PRECONDITION2(bit_offset < 8);
         static_assert(element_bitlen < 16, "");
 
+        std::size_t last = (bit_offset + element_bitlen - 1) / 8;
         uint32_t oldword =
-                (static_cast<uint32_t>(vec8[starting_byte + 0]) << 0) +
-                (static_cast<uint32_t>(vec8[starting_byte + 1]) << 8) +
-                (static_cast<uint32_t>(vec8[starting_byte + 2]) << 16);
+                (static_cast<uint32_t>(ptr[0]) << 0) |
+                (static_cast<uint32_t>(ptr[1]) << 8) |
+                (static_cast<uint32_t>(ptr[last]) << (8 * last));
         uint32_t newword = static_cast<uint32_t>(value) << bit_offset;
 
         constexpr uint16_t mask = (static_cast<uint16_t>(1) << element_bitlen) - 1;
         uint32_t mask2 = ~(static_cast<uint32_t>(mask) << bit_offset);
         uint32_t word = (mask2 & oldword) | newword;
 
-        // mitigate the perf hit if the compiler assumes vec8 could alias *this
-        NoAliasUcharPtr ptr = vec8;
-        ptr[starting_byte + 0] = static_cast<unsigned char>(word);
-        ptr[starting_byte + 1] = static_cast<unsigned char>(word >> 8);
-        ptr[starting_byte + 2] = static_cast<unsigned char>(word >> 16);
+        ptr[0] = static_cast<unsigned char>(word);
+        ptr[1] = static_cast<unsigned char>(word >> 8);
+        ptr[last] = static_cast<unsigned char>(word >> (8 * last));
     }
     // note that this function should work for any  8 < element_bitlen < 16
     template <int BITS = element_bitlen>
+    HURCHALLA_FORCE_INLINE static
     typename std::enable_if<(BITS == 11) || (BITS == 13) ||
                             (BITS == 14) || (BITS == 15), U>::type
-    getAt(size_type index) const
+    readAt(NoAliasConstUcharPtr ptr, std::size_t bit_offset)
     {
-        HPBC_UTIL_PRECONDITION2(index < size());
-
-        std::size_t starting_byte, bit_offset;
-        getLocationFromIndex(index, starting_byte, bit_offset);
-        HPBC_UTIL_ASSERT2(bit_offset < 8);
+        HPBC_UTIL_PRECONDITION2(bit_offset < 8);
         static_assert(element_bitlen < 16, "");
 
+        std::size_t last = (bit_offset + element_bitlen - 1) / 8;
         uint32_t word =
-                (static_cast<uint32_t>(vec8[starting_byte + 0]) << 0) +
-                (static_cast<uint32_t>(vec8[starting_byte + 1]) << 8) +
-                (static_cast<uint32_t>(vec8[starting_byte + 2]) << 16);
+                (static_cast<uint32_t>(ptr[0]) << 0) |
+                (static_cast<uint32_t>(ptr[1]) << 8) |
+                (static_cast<uint32_t>(ptr[last]) << (8 * last));
 
         word = word >> bit_offset;
         constexpr uint16_t mask = (static_cast<uint16_t>(1) << element_bitlen) - 1;
@@ -801,15 +1058,14 @@ public:
 // 17 to 23 bit, and 25 to 31 bit functions:
 // (note these could be optimized for bitdepths 17 18 20 25 26 28 - similar to
 // the optimizations made above for the 9 10 12 bit functions)
+// getLocationFromIndex() also serves the 33 to 63 bit functions further below.
 private:
     template <int BITS = element_bitlen>
-    HURCHALLA_FORCE_INLINE
-    typename std::enable_if<((16 < BITS && BITS < 24) ||
-                             (24 < BITS && BITS < 32)), void>::type
+    HURCHALLA_FORCE_INLINE static
+    typename std::enable_if<(16 < BITS && BITS % 8 != 0), void>::type
     getLocationFromIndex(size_type index,
-                      std::size_t& starting_byte, std::size_t& bit_offset) const
+                      std::size_t& starting_byte, std::size_t& bit_offset)
     {
-        HPBC_UTIL_PRECONDITION2(index < size());
           // The constructor established a class invariant that any
           // index < size() will convert correctly by attemptGetLocationFromIndex().
           // Thus we don't need to check overflowed below- it is always false.
@@ -822,51 +1078,45 @@ private:
 public:
 // 17 to 23 bit:
     template <int BITS = element_bitlen>
+    HURCHALLA_FORCE_INLINE static
     typename std::enable_if<(16 < BITS && BITS < 24), void>::type
-    setAt(size_type index, U value)
+    writeAt(NoAliasUcharPtr ptr, std::size_t bit_offset, U value)
     {
         HPBC_UTIL_PRECONDITION2(value <= max_allowed_value());
-        HPBC_UTIL_PRECONDITION2(index < size());
-
-        std::size_t starting_byte, bit_offset;
-        getLocationFromIndex(index, starting_byte, bit_offset);
-        HPBC_UTIL_ASSERT2(bit_offset < 8);
+        HPBC_UTIL_PRECONDITION2(bit_offset < 8);
         static_assert(element_bitlen < 24, "");
 
+        std::size_t last = (bit_offset + element_bitlen - 1) / 8;
         uint32_t oldword =
-                (static_cast<uint32_t>(vec8[starting_byte + 0]) << 0) +
-                (static_cast<uint32_t>(vec8[starting_byte + 1]) << 8) +
-                (static_cast<uint32_t>(vec8[starting_byte + 2]) << 16) +
-                (static_cast<uint32_t>(vec8[starting_byte + 3]) << 24);
+                (static_cast<uint32_t>(ptr[0]) << 0) |
+                (static_cast<uint32_t>(ptr[1]) << 8) |
+                (static_cast<uint32_t>(ptr[2]) << 16) |
+                (static_cast<uint32_t>(ptr[last]) << (8 * last));
         uint32_t newword = static_cast<uint32_t>(value) << bit_offset;
 
         constexpr uint32_t mask = (static_cast<uint32_t>(1) << element_bitlen) - 1;
         uint32_t mask2 = ~(static_cast<uint32_t>(mask) << bit_offset);
         uint32_t word = (mask2 & oldword) | newword;
 
-        // mitigate the perf hit if the compiler assumes vec8 could alias *this
-        NoAliasUcharPtr ptr = vec8;
-        ptr[starting_byte + 0] = static_cast<unsigned char>(word);
-        ptr[starting_byte + 1] = static_cast<unsigned char>(word >> 8);
-        ptr[starting_byte + 2] = static_cast<unsigned char>(word >> 16);
-        ptr[starting_byte + 3] = static_cast<unsigned char>(word >> 24);
+        ptr[0] = static_cast<unsigned char>(word);
+        ptr[1] = static_cast<unsigned char>(word >> 8);
+        ptr[2] = static_cast<unsigned char>(word >> 16);
+        ptr[last] = static_cast<unsigned char>(word >> (8 * last));
     }
     template <int BITS = element_bitlen>
+    HURCHALLA_FORCE_INLINE static
     typename std::enable_if<(16 < BITS && BITS < 24), U>::type
-    getAt(size_type index) const
+    readAt(NoAliasConstUcharPtr ptr, std::size_t bit_offset)
     {
-        HPBC_UTIL_PRECONDITION2(index < size());
-
-        std::size_t starting_byte, bit_offset;
-        getLocationFromIndex(index, starting_byte, bit_offset);
-        HPBC_UTIL_ASSERT2(bit_offset < 8);
+        HPBC_UTIL_PRECONDITION2(bit_offset < 8);
         static_assert(element_bitlen < 24, "");
 
+        std::size_t last = (bit_offset + element_bitlen - 1) / 8;
         uint32_t word =
-                (static_cast<uint32_t>(vec8[starting_byte + 0]) << 0) +
-                (static_cast<uint32_t>(vec8[starting_byte + 1]) << 8) +
-                (static_cast<uint32_t>(vec8[starting_byte + 2]) << 16) +
-                (static_cast<uint32_t>(vec8[starting_byte + 3]) << 24);
+                (static_cast<uint32_t>(ptr[0]) << 0) |
+                (static_cast<uint32_t>(ptr[1]) << 8) |
+                (static_cast<uint32_t>(ptr[2]) << 16) |
+                (static_cast<uint32_t>(ptr[last]) << (8 * last));
 
         word = word >> bit_offset;
         constexpr uint32_t mask = (static_cast<uint32_t>(1) << element_bitlen) - 1;
@@ -878,56 +1128,50 @@ public:
 
 // 25 to 31 bit:
     template <int BITS = element_bitlen>
+    HURCHALLA_FORCE_INLINE static
     typename std::enable_if<(24 < BITS && BITS < 32), void>::type
-    setAt(size_type index, U value)
+    writeAt(NoAliasUcharPtr ptr, std::size_t bit_offset, U value)
     {
         HPBC_UTIL_PRECONDITION2(value <= max_allowed_value());
-        HPBC_UTIL_PRECONDITION2(index < size());
-
-        std::size_t starting_byte, bit_offset;
-        getLocationFromIndex(index, starting_byte, bit_offset);
-        HPBC_UTIL_ASSERT2(bit_offset < 8);
+        HPBC_UTIL_PRECONDITION2(bit_offset < 8);
         static_assert(element_bitlen < 32, "");
 
+        std::size_t last = (bit_offset + element_bitlen - 1) / 8;
         uint32_t oldword32 =
-                (static_cast<uint32_t>(vec8[starting_byte + 0]) << 0) +
-                (static_cast<uint32_t>(vec8[starting_byte + 1]) << 8) +
-                (static_cast<uint32_t>(vec8[starting_byte + 2]) << 16) +
-                (static_cast<uint32_t>(vec8[starting_byte + 3]) << 24);
-        uint64_t oldword = oldword32 +
-                (static_cast<uint64_t>(vec8[starting_byte + 4]) << 32);
+                (static_cast<uint32_t>(ptr[0]) << 0) |
+                (static_cast<uint32_t>(ptr[1]) << 8) |
+                (static_cast<uint32_t>(ptr[2]) << 16);
+        uint64_t oldword = oldword32 |
+                (static_cast<uint64_t>(ptr[3]) << 24) |
+                (static_cast<uint64_t>(ptr[last]) << (8 * last));
         uint64_t newword = static_cast<uint64_t>(value) << bit_offset;
 
         constexpr uint32_t mask = (static_cast<uint32_t>(1) << element_bitlen) - 1;
         uint64_t mask2 = ~(static_cast<uint64_t>(mask) << bit_offset);
         uint64_t word = (mask2 & oldword) | newword;
 
-        // mitigate the perf hit if the compiler assumes vec8 could alias *this
-        NoAliasUcharPtr ptr = vec8;
-        ptr[starting_byte + 0] = static_cast<unsigned char>(word);
-        ptr[starting_byte + 1] = static_cast<unsigned char>(word >> 8);
-        ptr[starting_byte + 2] = static_cast<unsigned char>(word >> 16);
-        ptr[starting_byte + 3] = static_cast<unsigned char>(word >> 24);
-        ptr[starting_byte + 4] = static_cast<unsigned char>(word >> 32);
+        ptr[0] = static_cast<unsigned char>(word);
+        ptr[1] = static_cast<unsigned char>(word >> 8);
+        ptr[2] = static_cast<unsigned char>(word >> 16);
+        ptr[3] = static_cast<unsigned char>(word >> 24);
+        ptr[last] = static_cast<unsigned char>(word >> (8 * last));
     }
     template <int BITS = element_bitlen>
+    HURCHALLA_FORCE_INLINE static
     typename std::enable_if<(24 < BITS && BITS < 32), U>::type
-    getAt(size_type index) const
+    readAt(NoAliasConstUcharPtr ptr, std::size_t bit_offset)
     {
-        HPBC_UTIL_PRECONDITION2(index < size());
-
-        std::size_t starting_byte, bit_offset;
-        getLocationFromIndex(index, starting_byte, bit_offset);
-        HPBC_UTIL_ASSERT2(bit_offset < 8);
+        HPBC_UTIL_PRECONDITION2(bit_offset < 8);
         static_assert(element_bitlen < 32, "");
 
+        std::size_t last = (bit_offset + element_bitlen - 1) / 8;
         uint32_t word32 =
-                (static_cast<uint32_t>(vec8[starting_byte + 0]) << 0) +
-                (static_cast<uint32_t>(vec8[starting_byte + 1]) << 8) +
-                (static_cast<uint32_t>(vec8[starting_byte + 2]) << 16) +
-                (static_cast<uint32_t>(vec8[starting_byte + 3]) << 24);
-        uint64_t word64 = word32 +
-                (static_cast<uint64_t>(vec8[starting_byte + 4]) << 32);
+                (static_cast<uint32_t>(ptr[0]) << 0) |
+                (static_cast<uint32_t>(ptr[1]) << 8) |
+                (static_cast<uint32_t>(ptr[2]) << 16);
+        uint64_t word64 = word32 |
+                (static_cast<uint64_t>(ptr[3]) << 24) |
+                (static_cast<uint64_t>(ptr[last]) << (8 * last));
 
         uint32_t word = static_cast<uint32_t>(word64 >> bit_offset);
         constexpr uint32_t mask = (static_cast<uint32_t>(1) << element_bitlen) - 1;
@@ -936,241 +1180,714 @@ public:
         HPBC_UTIL_POSTCONDITION2(value <= max_allowed_value());
         return static_cast<U>(value);
     }
-};
 
 
+// 40, 48, 56, and 64 bit functions:
+// (these and the 33 to 63 bit functions need U to be a 64 bit type, in
+// practice; the values pass through a uint64_t)
+    template <int BITS = element_bitlen>
+    HURCHALLA_FORCE_INLINE static
+    typename std::enable_if<(32 < BITS && BITS % 8 == 0), void>::type
+    writeAt(NoAliasUcharPtr ptr, std::size_t bit_offset, U value)
+    {
+        HPBC_UTIL_PRECONDITION2(bit_offset == 0);
+        (void)bit_offset;
+        HPBC_UTIL_PRECONDITION2(value <= max_allowed_value());
+        static_assert(element_bitlen <= 64, "");
+        storeLEBytes<element_bitlen / 8>(ptr, static_cast<uint64_t>(value));
+    }
+    template <int BITS = element_bitlen>
+    HURCHALLA_FORCE_INLINE static
+    typename std::enable_if<(32 < BITS && BITS % 8 == 0), U>::type
+    readAt(NoAliasConstUcharPtr ptr, std::size_t bit_offset)
+    {
+        HPBC_UTIL_PRECONDITION2(bit_offset == 0);
+        (void)bit_offset;
+        static_assert(element_bitlen <= 64, "");
+        U value = static_cast<U>(loadLEBytes<element_bitlen / 8>(ptr));
+        HPBC_UTIL_POSTCONDITION2(value <= max_allowed_value());
+        return value;
+    }
 
+// 33 to 63 bit functions (other than 40, 48, 56):
+// An element can span up to 9 bytes, which is more than a 64 bit word holds.
+// The element always covers bytes 0 to FIXED-1 (FIXED == ceil(element_bitlen
+// / 8) <= 8) which we access as one 64 bit little-endian word, and it ends in
+// byte 'last', which is either FIXED-1 or FIXED, and which we access on its
+// own.  When last == FIXED-1, the final byte access just repeats the same
+// byte with the same contents, so this stays branch free and still touches
+// only the element's bytes.  The bits of byte 'last' hold the element's bits
+// beginning at bit lshift == 8*last - bit_offset, which is always < 64.
+    template <int BITS = element_bitlen>
+    HURCHALLA_FORCE_INLINE static
+    typename std::enable_if<(32 < BITS && BITS < 64 && BITS % 8 != 0),
+                            void>::type
+    writeAt(NoAliasUcharPtr ptr, std::size_t bit_offset, U value)
+    {
+        HPBC_UTIL_PRECONDITION2(value <= max_allowed_value());
+        HPBC_UTIL_PRECONDITION2(bit_offset < 8);
+        constexpr std::size_t FIXED = (element_bitlen + 7) / 8;
+        constexpr uint64_t mask = (static_cast<uint64_t>(1) << element_bitlen) - 1;
 
+        std::size_t last = (bit_offset + element_bitlen - 1) / 8;
+        unsigned int lshift = static_cast<unsigned int>(8 * last - bit_offset);
+        uint64_t oldword = loadLEBytes<FIXED>(ptr);
+        uint64_t oldlast = ptr[last];
 
+        uint64_t val = static_cast<uint64_t>(value);
+        uint64_t word = (oldword & ~(mask << bit_offset)) | (val << bit_offset);
+        uint64_t lastbyte = (oldlast & ~(mask >> lshift)) | (val >> lshift);
 
+        storeLEBytes<FIXED>(ptr, word);
+        ptr[last] = static_cast<unsigned char>(lastbyte);
+    }
+    template <int BITS = element_bitlen>
+    HURCHALLA_FORCE_INLINE static
+    typename std::enable_if<(32 < BITS && BITS < 64 && BITS % 8 != 0),
+                            U>::type
+    readAt(NoAliasConstUcharPtr ptr, std::size_t bit_offset)
+    {
+        HPBC_UTIL_PRECONDITION2(bit_offset < 8);
+        constexpr std::size_t FIXED = (element_bitlen + 7) / 8;
+        constexpr uint64_t mask = (static_cast<uint64_t>(1) << element_bitlen) - 1;
 
-// The code below is completely untested, and also requires C++17.
-// It should not be considered finished, but it could be a good starting
-// point if you want to add support for generic element_bitlen > 32.
+        std::size_t last = (bit_offset + element_bitlen - 1) / 8;
+        unsigned int lshift = static_cast<unsigned int>(8 * last - bit_offset);
+        uint64_t word = (loadLEBytes<FIXED>(ptr) >> bit_offset) |
+                        (static_cast<uint64_t>(ptr[last]) << lshift);
+        U value = static_cast<U>(word & mask);
 
-#if 0
+        HPBC_UTIL_POSTCONDITION2(value <= max_allowed_value());
+        return value;
+    }
 
-#if (__cplusplus >= 201703L)   // requires C++ 17 or greater, for if constexpr
+private:
+    // Reads N bytes (4 <= N <= 8) starting at ptr, as a little-endian
+    // integer.  On little-endian targets, when N < 8 this uses two
+    // overlapping 4 byte loads, since gcc compiles a memcpy of N bytes into a
+    // uint64_t via the stack, and then the 8 byte load stalls waiting for the
+    // smaller stores to forward.
+    template <std::size_t N>
+    HURCHALLA_FORCE_INLINE static uint64_t loadLEBytes(NoAliasConstUcharPtr ptr)
+    {
+        static_assert(4 <= N && N <= 8, "");
+#if HURCHALLA_TARGET_IS_LITTLE_ENDIAN()
+        if (N == 8)
+            return loadLE64(ptr);
+        uint32_t lo, hi;
+        std::memcpy(&lo, ptr, sizeof(lo));
+        std::memcpy(&hi, ptr + (N - 4), sizeof(hi));
+        return lo | (static_cast<uint64_t>(hi) << (8 * (N - 4)));
+#else
+        uint64_t word = 0;
+        Unroll<N>::call([&](std::size_t i) HURCHALLA_INLINE_LAMBDA {
+            word |= static_cast<uint64_t>(ptr[i]) << (8 * i);
+        });
+        return word;
+#endif
+    }
+    // Writes the low N bytes (4 <= N <= 8) of word, little-endian, starting
+    // at ptr.  (Overlapping 4 byte stores, as above.)
+    template <std::size_t N>
+    HURCHALLA_FORCE_INLINE static void storeLEBytes(NoAliasUcharPtr ptr,
+                                                    uint64_t word)
+    {
+        static_assert(4 <= N && N <= 8, "");
+#if HURCHALLA_TARGET_IS_LITTLE_ENDIAN()
+        if (N == 8) {
+            std::memcpy(ptr, &word, sizeof(word));
+            return;
+        }
+        uint32_t lo = static_cast<uint32_t>(word);
+        uint32_t hi = static_cast<uint32_t>(word >> (8 * (N - 4)));
+        std::memcpy(ptr + (N - 4), &hi, sizeof(hi));
+        std::memcpy(ptr, &lo, sizeof(lo));
+#else
+        Unroll<N>::call([&](std::size_t i) HURCHALLA_INLINE_LAMBDA {
+            ptr[i] = static_cast<unsigned char>(word >> (8 * i));
+        });
+#endif
+    }
+
+
+// Bulk range functions (all element_bitlen):
+//
+// Any group of 8 consecutive elements that begins at an index that is a
+// multiple of 8 will begin on a byte boundary, and will occupy exactly
+// element_bitlen bytes.  So within such a group, the starting byte and the
+// bit_offset of every element are compile-time constants, and we can unpack
+// or pack the entire group without any of the index-to-location arithmetic
+// that getAt() and setAt() need.  Elements that precede the first group
+// boundary, or that follow the last full group, use getAt() and setAt().
+//
+// Timings for sequential access over 2^24 elements, in nanoseconds per
+// element (x64 Sapphire Rapids VM, gcc 12, -O2; best of 5 runs):
+//   bits  U         getAt() loop  getRange()   setAt() loop  setRange()
+//    3   uint8_t        1.8          0.46          5.0          0.34
+//   13   uint16_t       3.3          0.56          5.1          0.63
+//   17   uint32_t       2.1          0.83          4.6          0.90
+//   29   uint32_t       3.3          0.99          5.6          1.02
+//   32   uint32_t       1.05         0.91          1.10         0.81
+// The setAt() loop is especially slow because each setAt() reads bytes that
+// the previous setAt() just wrote, which defeats store-to-load forwarding.
+// setRange() never reads the vector.
+//
+// If you define HURCHALLA_ALLOW_SIMD_BITPACKED_UINT_VECTOR, getRange() and
+// setRange() will use the SIMD group kernels from
+// impl_bitpacked_group_kernels.h when the target ISA supports them.  These
+// help most when the data is in cache.  Timings over 2^13 elements (L1/L2
+// resident), same machine, in nanoseconds per element:
+//   bits  U         getRange()                   setRange()
+//                   scalar  SSE4.1 AVX2 VBMI     scalar  VBMI
+//    3   uint8_t     0.48    0.23  0.15  0.08     0.29   0.17
+//   13   uint16_t    0.39    0.18  0.11  0.08     0.27   0.12
+//   17   uint32_t    0.35    0.16  0.12  0.09     0.31   0.17
+//   29   uint32_t  (no kernel for 27, 29, 30, 31 bits)
+private:
+    static constexpr std::size_t GROUP_SIZE = 8;
+
+public:
+    // Reads 8 bytes starting at ptr, as a little-endian uint64_t.
+    HURCHALLA_FORCE_INLINE static uint64_t loadLE64(NoAliasConstUcharPtr ptr)
+    {
+#if HURCHALLA_TARGET_IS_LITTLE_ENDIAN()
+        uint64_t word;
+        std::memcpy(&word, ptr, sizeof(word));
+        return word;
+#else
+        return  (static_cast<uint64_t>(ptr[0]) << 0) |
+                (static_cast<uint64_t>(ptr[1]) << 8) |
+                (static_cast<uint64_t>(ptr[2]) << 16) |
+                (static_cast<uint64_t>(ptr[3]) << 24) |
+                (static_cast<uint64_t>(ptr[4]) << 32) |
+                (static_cast<uint64_t>(ptr[5]) << 40) |
+                (static_cast<uint64_t>(ptr[6]) << 48) |
+                (static_cast<uint64_t>(ptr[7]) << 56);
+#endif
+    }
+
+private:
+    // Writes word as 4 little-endian bytes, starting at ptr.  Note that gcc
+    // will not merge a sequence of byte stores into a single store when this
+    // function is used within a loop, and so on little-endian targets we use
+    // memcpy instead.
+    HURCHALLA_FORCE_INLINE static void storeLE32(NoAliasUcharPtr ptr,
+                                                 uint32_t word)
+    {
+#if HURCHALLA_TARGET_IS_LITTLE_ENDIAN()
+        std::memcpy(ptr, &word, sizeof(word));
+#else
+        ptr[0] = static_cast<unsigned char>(word);
+        ptr[1] = static_cast<unsigned char>(word >> 8);
+        ptr[2] = static_cast<unsigned char>(word >> 16);
+        ptr[3] = static_cast<unsigned char>(word >> 24);
+#endif
+    }
+    // Writes word as 8 little-endian bytes, starting at ptr.
+    HURCHALLA_FORCE_INLINE static void storeLE64(NoAliasUcharPtr ptr,
+                                                 uint64_t word)
+    {
+#if HURCHALLA_TARGET_IS_LITTLE_ENDIAN()
+        std::memcpy(ptr, &word, sizeof(word));
+#else
+        storeLE32(ptr, static_cast<uint32_t>(word));
+        storeLE32(ptr + 4, static_cast<uint32_t>(word >> 32));
+#endif
+    }
+
+public:
+    // The number of bytes unpackGroup() may read, beginning at a group's
+    // starting byte.  Up to 56 bits, this is more than the element_bitlen
+    // bytes the group occupies, since each element is read via an 8 byte
+    // window.  Wider elements don't always fit in an 8 byte window, and are
+    // read with readAt(), which reads only the group's bytes.
+    static constexpr std::size_t UNPACK_READ_BYTES = (element_bitlen <= 56) ?
+                  (GROUP_SIZE - 1) * element_bitlen / 8 + 8 : element_bitlen;
+
+    // Unpacks the 8 elements of the group that begins at byte 'group'.
+    // Requires that UNPACK_READ_BYTES beginning at 'group' are readable.
     template <int BITS = element_bitlen>
-    typename std::enable_if<(16 < BITS), void>::type
-    setAt(size_type index, U value)
+    HURCHALLA_FORCE_INLINE static
+    typename std::enable_if<(BITS <= 56), void>::type
+    unpackGroup(NoAliasConstUcharPtr group, U* out)
     {
-        HPBC_UTIL_PRECONDITION2(value <= max_allowed_value());
-        HPBC_UTIL_PRECONDITION2(index < size());
-        // The constructor and resize() maintain a class invariant that any
-        // index < size() will convert correctly by attemptGetLocationFromIndex().
-        // Thus we don't need to check overflowed below- it is always false
+        // bitpos % 8 <= 7, so every element fits within its 8 byte window
+        static_assert(element_bitlen <= 56, "");
+        constexpr uint64_t mask = (static_cast<uint64_t>(1) << element_bitlen) - 1;
+        Unroll<GROUP_SIZE>::call([&](std::size_t j) HURCHALLA_INLINE_LAMBDA {
+            std::size_t bitpos = j * element_bitlen;
+            uint64_t word = loadLE64(group + bitpos / 8);
+            out[j] = static_cast<U>((word >> (bitpos % 8)) & mask);
+        });
+    }
+    template <int BITS = element_bitlen>
+    HURCHALLA_FORCE_INLINE static
+    typename std::enable_if<(56 < BITS), void>::type
+    unpackGroup(NoAliasConstUcharPtr group, U* out)
+    {
+        // after unrolling, every location is a compile time constant
+        Unroll<GROUP_SIZE>::call([&](std::size_t j) HURCHALLA_INLINE_LAMBDA {
+            std::size_t bitpos = j * element_bitlen;
+            out[j] = readAt(group + bitpos / 8, bitpos % 8);
+        });
+    }
+
+private:
+    // Packs 8 elements from 'in' into the group that begins at byte 'group'.
+    // Writes exactly element_bitlen bytes, and reads nothing from the vector.
+    template <int BITS = element_bitlen>
+    HURCHALLA_FORCE_INLINE static
+    typename std::enable_if<(BITS <= 32), void>::type
+    packGroup(NoAliasUcharPtr group, const U* in)
+    {
+        static_assert(element_bitlen <= 32, "");
+        // Since (nbits < 32) prior to each shift, and element_bitlen <= 32, the
+        // accumulator never needs more than 63 bits.
+        uint64_t acc = 0;
+        unsigned int nbits = 0;
+        std::size_t byte = 0;
+        Unroll<GROUP_SIZE>::call([&](std::size_t j) HURCHALLA_INLINE_LAMBDA {
+            HPBC_UTIL_PRECONDITION2(in[j] <= max_allowed_value());
+            acc |= static_cast<uint64_t>(in[j]) << nbits;
+            nbits += element_bitlen;
+            if (nbits >= 32) {
+                storeLE32(group + byte, static_cast<uint32_t>(acc));
+                byte += 4;
+                acc >>= 32;
+                nbits -= 32;
+            }
+        });
+        // 8*element_bitlen bits is a whole number of bytes, so nbits is a
+        // multiple of 8 here.
+        HPBC_UTIL_ASSERT2(nbits % 8 == 0);
+        for (unsigned int k = 0; k < nbits / 8; ++k)
+            group[byte + k] = static_cast<unsigned char>(acc >> (8 * k));
+        HPBC_UTIL_ASSERT2(byte + nbits / 8 == element_bitlen);
+    }
+    template <int BITS = element_bitlen>
+    HURCHALLA_FORCE_INLINE static
+    typename std::enable_if<(32 < BITS), void>::type
+    packGroup(NoAliasUcharPtr group, const U* in)
+    {
+        static_assert(element_bitlen <= 64, "");
+        // Here an element can overflow the 64 bit accumulator.  When it does,
+        // we store the full accumulator and restart it with the bits of the
+        // element that didn't fit.  nbits < 64 prior to each shift.
+        uint64_t acc = 0;
+        unsigned int nbits = 0;
+        std::size_t byte = 0;
+        Unroll<GROUP_SIZE>::call([&](std::size_t j) HURCHALLA_INLINE_LAMBDA {
+            HPBC_UTIL_PRECONDITION2(in[j] <= max_allowed_value());
+            uint64_t val = static_cast<uint64_t>(in[j]);
+            acc |= val << nbits;
+            nbits += element_bitlen;
+            if (nbits >= 64) {
+                storeLE64(group + byte, acc);
+                byte += 8;
+                nbits -= 64;
+                // keep the top nbits bits of val (the two step shift
+                // avoids a shift by 64, when nbits == 0 and element_bitlen
+                // == 64)
+                acc = (val >> 1) >> (element_bitlen - nbits - 1);
+            }
+        });
+        HPBC_UTIL_ASSERT2(nbits % 8 == 0);
+        for (unsigned int k = 0; k < nbits / 8; ++k)
+            group[byte + k] = static_cast<unsigned char>(acc >> (8 * k));
+        HPBC_UTIL_ASSERT2(byte + nbits / 8 == element_bitlen);
+    }
 
-        size_type starting_byte, bit_offset;
+private:
+    // Returns the number of bytes that the elements [0, count) occupy.
+    static std::size_t occupiedBytes(size_type count)
+    {
+        std::size_t starting_byte, bit_offset;
         bool overflowed;
-        attemptGetLocationFromIndex(index, starting_byte, bit_offset, overflowed);
+        attemptGetLocationFromIndex(count, starting_byte, bit_offset, overflowed);
         HPBC_UTIL_ASSERT2(overflowed == false);
-        HPBC_UTIL_ASSERT2(bit_offset < 8);
-
-        uint8_t mask = (static_cast<uint8_t>(1) << bit_offset) - 1;
-        uint8_t oldbits = mask & vec8[starting_byte + 0];
-        uint8_t newbits = static_cast<uint8_t>(value << bit_offset);
-        vec8[starting_byte + 0] = oldbits | newbits;
-
-          // Section for complete byte copies, with any bit_offset
-        uint32_t val32 = static_cast<uint32_t>(value);
-        if constexpr (element_bitlen >= 16)
-            vec8[starting_byte + 1] = static_cast<uint8_t>(val32 >> (8 - bit_offset));
-        if constexpr (element_bitlen >= 24)
-            vec8[starting_byte + 2] = static_cast<uint8_t>(val32 >> (16 - bit_offset));
-        if constexpr (element_bitlen >= 32)
-            vec8[starting_byte + 3] = static_cast<uint8_t>(val32 >> (24 - bit_offset));
-        if constexpr (element_bitlen >= 40) {
-            static_assert(std::numeric_limits<U>::digits >= 40, "");
-            val32 = static_cast<uint32_t>(value >> (32 - bit_offset));
-            vec8[starting_byte + 4] = static_cast<uint8_t>(val32);
-            if constexpr (element_bitlen >= 48)
-                vec8[starting_byte + 5] = static_cast<uint8_t>(val32 >> 8);
-            if constexpr (element_bitlen >= 56)
-                vec8[starting_byte + 6] = static_cast<uint8_t>(val32 >> 16);
-            if constexpr (element_bitlen >= 64)
-                vec8[starting_byte + 7] = static_cast<uint8_t>(val32 >> 24);
-        }
-        if constexpr (element_bitlen >= 72) {
-            static_assert(std::numeric_limits<U>::digits >= 72, "");
-            val32 = static_cast<uint32_t>(value >> (64 - bit_offset));
-            vec8[starting_byte + 8] = static_cast<uint8_t>(val32);
-            if constexpr (element_bitlen >= 80)
-                vec8[starting_byte + 9] = static_cast<uint8_t>(val32 >> 8);
-            if constexpr (element_bitlen >= 88)
-                vec8[starting_byte + 10] = static_cast<uint8_t>(val32 >> 16);
-            if constexpr (element_bitlen >= 96)
-                vec8[starting_byte + 11] = static_cast<uint8_t>(val32 >> 24);
+        return starting_byte + (bit_offset != 0);
+    }
+
+    // Returns the number of elements from index up to the next multiple of
+    // GROUP_SIZE, but no more than count.
+    HURCHALLA_FORCE_INLINE static
+    unsigned int headCount(size_type index, size_type count)
+    {
+        unsigned int head = static_cast<unsigned int>(
+                               (GROUP_SIZE - index % GROUP_SIZE) % GROUP_SIZE);
+        if (head > count)
+            head = static_cast<unsigned int>(count);
+        return head;
+    }
+
+public:
+    // Reads the 'count' elements beginning at index 'first', into out[0] to
+    // out[count-1].
+    void getRange(size_type first, size_type count, U* out) const
+    {
+        HPBC_UTIL_PRECONDITION2(first <= size());
+        HPBC_UTIL_PRECONDITION2(count <= size() - first);
+        readRange(vec8, vec8_bytes, first, count, out);
+    }
+
+    // Writes in[0] to in[count-1] into the 'count' elements beginning at index
+    // 'first'.
+    void setRange(size_type first, size_type count, const U* in)
+    {
+        HPBC_UTIL_PRECONDITION2(first <= size());
+        HPBC_UTIL_PRECONDITION2(count <= size() - first);
+        // mitigate the perf hit if the compiler assumes vec8 could alias *this
+        NoAliasUcharPtr ptr = vec8;
+        writeRange(ptr, first, count, in);
+    }
+
+    // Static versions of getRange() and setRange(), for packed data at 'vec'
+    // that this class doesn't own.  readRange() never reads at or beyond
+    // vec + vec_bytes, and vec_bytes must be at least the number of bytes that
+    // the elements up to first + count occupy (dataSizeBytes(n) for any
+    // n >= first + count is always enough).  A smaller vec_bytes makes it use
+    // wide group reads for fewer of the elements.
+    static void readRange(NoAliasConstUcharPtr vec, std::size_t vec_bytes,
+                          size_type first, size_type count, U* out)
+    {
+        HPBC_UTIL_PRECONDITION2(occupiedBytes(first + count) <= vec_bytes);
+        const size_type end = first + count;
+        size_type index = first;
+        for (unsigned int k = headCount(first, count); k > 0; --k)
+            *out++ = readIndex(vec, index++);
+
+        // Groups near the end of the vector may be too close to the end of
+        // the allocation for the 8 byte window reads of unpackGroup().
+        size_type group_limit = 0;
+        if (vec_bytes >= UNPACK_READ_BYTES)
+            group_limit = static_cast<size_type>(
+                       (vec_bytes - UNPACK_READ_BYTES) / element_bitlen + 1);
+        size_type group_end = end / GROUP_SIZE;
+        if (group_end > group_limit)
+            group_end = group_limit;
+
+        size_type g = index / GROUP_SIZE;
+        {
+            // SIMD kernel (if enabled and available); it may read a different
+            // number of bytes per group than unpackGroup()
+            using Kernel = impl_unpack_bitpacked_groups<U, element_bitlen>;
+            size_type kernel_end = 0;
+            if (vec_bytes >= Kernel::read_bytes)
+                kernel_end = static_cast<size_type>(
+                       (vec_bytes - Kernel::read_bytes) / element_bitlen + 1);
+            if (kernel_end > end / GROUP_SIZE)
+                kernel_end = end / GROUP_SIZE;
+            if (kernel_end > g) {
+                std::size_t done = Kernel::call(
+                           vec + static_cast<std::size_t>(g) * element_bitlen,
+                           static_cast<std::size_t>(kernel_end - g), out);
+                g += static_cast<size_type>(done);
+                out += done * GROUP_SIZE;
+                index += static_cast<size_type>(done * GROUP_SIZE);
+            }
         }
-        if constexpr (element_bitlen >= 104) {
-            static_assert(std::numeric_limits<U>::digits >= 104, "");
-            val32 = static_cast<uint32_t>(value >> (96 - bit_offset));
-            vec8[starting_byte + 12] = static_cast<uint8_t>(val32);
-            if constexpr (element_bitlen >= 112)
-                vec8[starting_byte + 13] = static_cast<uint8_t>(val32 >> 8);
-            if constexpr (element_bitlen >= 120)
-                vec8[starting_byte + 14] = static_cast<uint8_t>(val32 >> 16);
-            if constexpr (element_bitlen >= 128)
-                vec8[starting_byte + 15] = static_cast<uint8_t>(val32 >> 24);
+        for (; g < group_end; ++g) {
+            unpackGroup(vec + static_cast<std::size_t>(g) * element_bitlen, out);
+            out += GROUP_SIZE;
+            index += GROUP_SIZE;
         }
-          // We'd need to write more clauses above to support larger
-          // element_bitlen.  For now, don't try to support unlimited sizes.
-        static_assert(element_bitlen <= 128, "");
-
-
-        if constexpr (element_bitlen % 8 == 0) {
-            HPBC_UTIL_ASSERT2(bit_offset == 0);
-            // there's nothing more to do.
-        } else {
-              // when 8 <= element_bitlen < 16, we need (conceptually at least)
-              // to write 3 bytes total.
-              // when 16 <= element_bitlen < 24, we need 4 bytes total.
-              // Etc.
-            static_assert(element_bitlen >= 8, "");
-            constexpr size_type num_bytes_written = element_bitlen/8;
-            static_assert(num_bytes_written >= 1, "");
-              // We still need to (conceptually at least) write to 2 more bytes
-
-
-            auto num_mask_newbits = bit_offset + (element_bitlen % 8);
-
-            static_assert(element_bitlen >= 8, "");
-              // so  element_bitlen - 8 >= (element_bitlen - 8) % 8 == element_bitlen % 8
-              // and thus,  element_bitlen - 8 >= element_bitlen % 8
-              // i.e.  element_bitlen >= 8 + element_bitlen % 8
-              // And since  bit_offset < 8
-              // element_bitlen > bit_offset + element_bitlen % 8 == num_mask_newbits
-              // Therefore
-            HPBC_UTIL_ASSERT2(element_bitlen > num_mask_newbits);
-              // Since bit_offset <= 7 and (element_bitlen % 8) <= 7,
-              // num_mask_newbits == bit_offset + (element_bitlen % 8) <= 14
-            HPBC_UTIL_ASSERT2(0 <= num_mask_newbits && num_mask_newbits <= 14);
-
-            uint16_t mask2 = ~((static_cast<uint16_t>(1) << num_mask_newbits) - 1);
-
-
-            // given that element_bitlen % 8 != 0, and that value's type
-            // presumably uses whole bytes,
-            static_assert(element_bitlen < std::numeric_limits<decltype(value)>::digits, "");
-            static_assert(element_bitlen >= 16, "");
-            value = value >> (element_bitlen - num_mask_newbits);
-
-            mask = static_cast<uint8_t>(mask2);
-            oldbits = mask & vec8[starting_byte + num_bytes_written];
-            newbits = static_cast<uint8_t>(value);
-            vec8[starting_byte + num_bytes_written] = oldbits | newbits;
-
-              // In the special case (element_bitlen % 8 <= 1), we have
-              // num_mask_newbits = bit_offset + (element_bitlen % 8) <= bit_offset + 1
-              // Since we know bit_offset <= 7, we have
-              // num_mask_newbits <= 8
-              // So in this case, the second byte never needs any newbits
-              // written to it: so for efficiency we do nothing.
-            if constexpr (element_bitlen % 8 <= 1) {
-// TODO: To improve efficiency further, I suspect any of  element_bitlen % 8 == 1 or 2 or 4
-// could be a special case, not just (element_bitlen % 8 <= 1) here.
-            }
-            else {
-                mask = static_cast<uint8_t>(mask2 >> 8);
-                oldbits = mask & vec8[starting_byte + num_bytes_written + 1];
-                newbits = static_cast<uint8_t>(value >> 8);
-                vec8[starting_byte + num_bytes_written + 1] = oldbits | newbits;
+        // Usually fewer than GROUP_SIZE elements remain here, but if we
+        // reached group_limit, there can be a few more (since
+        // UNPACK_READ_BYTES <= 9*element_bitlen, fewer than 10 groups' worth).
+        // Counting with an unsigned int lets the compiler see that the loop
+        // is short, which avoids a spurious gcc -Waggressive-loop-optimizations
+        // warning for 64 bit elements.
+        HPBC_UTIL_ASSERT2(end - index < 10 * GROUP_SIZE);
+        for (unsigned int k = static_cast<unsigned int>(end - index); k > 0; --k)
+            *out++ = readIndex(vec, index++);
+    }
+
+    static void writeRange(NoAliasUcharPtr vec,
+                           size_type first, size_type count, const U* in)
+    {
+        const size_type end = first + count;
+        size_type index = first;
+        for (unsigned int k = headCount(first, count); k > 0; --k)
+            writeIndex(vec, index++, *in++);
+
+        size_type g = index / GROUP_SIZE;
+        if (end / GROUP_SIZE > g) {
+            using Kernel = impl_pack_bitpacked_groups<U, element_bitlen>;
+            std::size_t num = static_cast<std::size_t>(end / GROUP_SIZE - g);
+            if (HPBC_UTIL_PRECONDITION2_MACRO_IS_ACTIVE) {
+                for (std::size_t i = 0; i < num * GROUP_SIZE; ++i)
+                    HPBC_UTIL_PRECONDITION2(in[i] <= max_allowed_value());
             }
+            std::size_t done = Kernel::call(
+                     vec + static_cast<std::size_t>(g) * element_bitlen, num, in);
+            g += static_cast<size_type>(done);
+            in += done * GROUP_SIZE;
+            index += static_cast<size_type>(done * GROUP_SIZE);
+        }
+        for (; g < end / GROUP_SIZE; ++g) {
+            packGroup(vec + static_cast<std::size_t>(g) * element_bitlen, in);
+            in += GROUP_SIZE;
+            index += GROUP_SIZE;
         }
+        HPBC_UTIL_ASSERT2(end - index < GROUP_SIZE);
+        for (unsigned int k = static_cast<unsigned int>(end - index); k > 0; --k)
+            writeIndex(vec, index++, *in++);
     }
 
 
-    template <int BITS = element_bitlen>
-    typename std::enable_if<(16 < BITS), U>::type
-    getAt(size_type index) const
+// Random gather and scatter:
+// On a vector much larger than the CPU caches, nearly every getAt() or setAt()
+// at a random index is a cache miss.  A loop of them gets little overlap of
+// the misses, since the CPU's out-of-order window holds only a few element
+// decodes at a time.  readGather() and writeScatter() instead convert each
+// index to its location 'distance' elements before they access it, and
+// prefetch its cache line(s) at that point, so that up to 'distance' misses
+// can be in flight at once.  The locations wait in a small ring buffer, so
+// each index is converted only once.  The elements are accessed in the order
+// of 'indices', and so for writeScatter(), the last of any duplicate indices
+// wins.
+public:
+    static constexpr std::size_t MAX_PREFETCH_DISTANCE = 63;
+    static constexpr std::size_t DEFAULT_PREFETCH_DISTANCE = 16;
+
+    static void readGather(NoAliasConstUcharPtr vec, const size_type* indices,
+                           std::size_t n, U* out, std::size_t distance)
     {
-        HPBC_UTIL_PRECONDITION2(index < size());
-        // The constructor and resize() maintain a class invariant that any
-        // index < size() will convert correctly by attemptGetLocationFromIndex().
-        // Thus we don't need to check overflowed below- it is always false
+        HPBC_UTIL_PRECONDITION2(distance <= MAX_PREFETCH_DISTANCE);
+        pipelineAccess(indices, n, distance,
+            [vec](std::size_t byte) HURCHALLA_INLINE_LAMBDA {
+                HURCHALLA_PREFETCH_FOR_READ(vec + byte);
+            },
+            [vec, out](std::size_t i, std::size_t byte, std::size_t bit_offset)
+                                                  HURCHALLA_INLINE_LAMBDA {
+                out[i] = readAt(vec + byte, bit_offset);
+            });
+    }
 
-        size_type starting_byte, bit_offset;
-        bool overflowed;
-        attemptGetLocationFromIndex(index, starting_byte, bit_offset, overflowed);
-        HPBC_UTIL_ASSERT2(overflowed == false);
-        HPBC_UTIL_ASSERT2(bit_offset < 8);
+    static void writeScatter(NoAliasUcharPtr vec, const size_type* indices,
+                             std::size_t n, const U* in, std::size_t distance)
+    {
+        HPBC_UTIL_PRECONDITION2(distance <= MAX_PREFETCH_DISTANCE);
+        pipelineAccess(indices, n, distance,
+            [vec](std::size_t byte) HURCHALLA_INLINE_LAMBDA {
+                HURCHALLA_PREFETCH_FOR_WRITE(vec + byte);
+            },
+            [vec, in](std::size_t i, std::size_t byte, std::size_t bit_offset)
+                                                  HURCHALLA_INLINE_LAMBDA {
+                HPBC_UTIL_PRECONDITION2(in[i] <= max_allowed_value());
+                writeAt(vec + byte, bit_offset, in[i]);
+            });
+    }
 
-        static_assert(element_bitlen >= 8, "");
-        U value = (static_cast<U>(vec8[starting_byte + 0]) << 0);
-
-        if constexpr (element_bitlen >= 16)
-            value += (static_cast<U>(vec8[starting_byte + 1]) << 8);
-        if constexpr (element_bitlen >= 24)
-            value += (static_cast<U>(vec8[starting_byte + 2]) << 16);
-        if constexpr (element_bitlen >= 32)
-            value += (static_cast<U>(vec8[starting_byte + 3]) << 24);
-        if constexpr (element_bitlen >= 40)
-            value += (static_cast<U>(vec8[starting_byte + 4]) << 32);
-        if constexpr (element_bitlen >= 48)
-            value += (static_cast<U>(vec8[starting_byte + 5]) << 40);
-        if constexpr (element_bitlen >= 56)
-            value += (static_cast<U>(vec8[starting_byte + 6]) << 48);
-        if constexpr (element_bitlen >= 64)
-            value += (static_cast<U>(vec8[starting_byte + 7]) << 56);
-
-        if constexpr (element_bitlen >= 72)
-            value += (static_cast<U>(vec8[starting_byte + 8]) << 64);
-        if constexpr (element_bitlen >= 80)
-            value += (static_cast<U>(vec8[starting_byte + 9]) << 72);
-        if constexpr (element_bitlen >= 88)
-            value += (static_cast<U>(vec8[starting_byte + 10]) << 80);
-        if constexpr (element_bitlen >= 96)
-            value += (static_cast<U>(vec8[starting_byte + 11]) << 88);
-        if constexpr (element_bitlen >= 104)
-            value += (static_cast<U>(vec8[starting_byte + 12]) << 96);
-        if constexpr (element_bitlen >= 112)
-            value += (static_cast<U>(vec8[starting_byte + 13]) << 104);
-        if constexpr (element_bitlen >= 120)
-            value += (static_cast<U>(vec8[starting_byte + 14]) << 112);
-        if constexpr (element_bitlen >= 128)
-            value += (static_cast<U>(vec8[starting_byte + 15]) << 120);
-
-          // We'd need to write more clauses above to support larger
-          // element_bitlen.  For now, don't try to support unlimited sizes.
-        static_assert(element_bitlen <= 128, "");
-
-        if constexpr (element_bitlen % 8 == 0) {
-            HPBC_UTIL_ASSERT2(bit_offset == 0);
-            return value;
-        } else {
-            value = value >> bit_offset;
-
-              // when 8 <= element_bitlen < 16, we need to read 3 bytes total.
-              // when 16 <= element_bitlen < 24, we need 4 bytes total.
-              // Etc.
-            static_assert(element_bitlen >= 8, "");
-            constexpr size_type num_bytes_read = element_bitlen/8;
-            static_assert(num_bytes_read >= 1, "");
-
-              // read two extra bytes to account for potential bit_offset > 0
-              // along with (element_bitlen % 8) != 0
-            uint16_t last_two_bytes =
-               (static_cast<uint16_t>(vec8[starting_byte + num_bytes_read]) << 0) +
-               (static_cast<uint16_t>(vec8[starting_byte + num_bytes_read + 1]) << 8);
-
-            auto num_mask_newbits = bit_offset + (element_bitlen % 8);
-            uint16_t mask2 = (static_cast<uint16_t>(1) << num_mask_newbits) - 1;
-            last_two_bytes = last_two_bytes & mask2;
-
-            // given that element_bitlen % 8 != 0, and U presumably using whole bytes,
-            static_assert(element_bitlen < std::numeric_limits<U>::digits, "");
-            static_assert(element_bitlen >= 16, "");
-            value += (static_cast<U>(last_two_bytes) << (element_bitlen - num_mask_newbits));
-
-            HPBC_UTIL_POSTCONDITION2(value <= max_allowed_value());
-            return value;
-
-            // TODO if constexpr (element_bitlen % 8 == 1 or 2 or 4) (?)  we could skip reading the final byte
+    void gather(const size_type* indices, std::size_t n, U* out,
+                std::size_t distance) const
+    {
+        readGather(vec8, indices, n, out, distance);
+    }
+    void scatter(const size_type* indices, std::size_t n, const U* in,
+                 std::size_t distance)
+    {
+        // mitigate the perf hit if the compiler assumes vec8 could alias *this
+        NoAliasUcharPtr ptr = vec8;
+        writeScatter(ptr, indices, n, in, distance);
+    }
+
+private:
+    template <class Prefetch, class Access>
+    HURCHALLA_FORCE_INLINE static
+    void pipelineAccess(const size_type* indices, std::size_t n,
+                        std::size_t distance, Prefetch prefetch, Access access)
+    {
+        constexpr std::size_t RING = MAX_PREFETCH_DISTANCE + 1;
+        static_assert((RING & (RING - 1)) == 0, "");
+        std::size_t ring_byte[RING];
+        std::size_t ring_offset[RING];
+        auto locate = [&](std::size_t i) HURCHALLA_INLINE_LAMBDA {
+            std::size_t byte, bit_offset;
+            getLocationFromIndex(indices[i], byte, bit_offset);
+            ring_byte[i % RING] = byte;
+            ring_offset[i % RING] = bit_offset;
+            // an element can straddle two cache lines, so we also prefetch
+            // the line of its last byte (usually the same line)
+            prefetch(byte);
+            prefetch(byte + (bit_offset + element_bitlen - 1) / 8);
+        };
+        std::size_t ahead = (distance < n) ? distance : n;
+        for (std::size_t i = 0; i < ahead; ++i)
+            locate(i);
+        for (std::size_t i = 0; i < n; ++i) {
+            if (distance < n - i)
+                locate(i + distance);
+            access(i, ring_byte[i % RING], ring_offset[i % RING]);
         }
     }
-#endif
 
+
+// Concurrent access:
+// Neighboring elements can share bytes, so two threads that call setAt() on
+// different indices may race.  There are two ways to avoid this.
+//
+// 1) partitionPoint() splits [0, count) into index ranges whose bytes never
+// overlap.  Separate threads can then use setAt(), getAt(), setRange(), and
+// iterators on separate ranges, without any synchronization.  (getRange() and
+// read cursors may read a few bytes beyond the elements they return, so don't
+// use them while another thread writes to a neighboring range.)
+//
+// 2) The atomic functions below require an element_bitlen that divides 64
+// (1, 2, 4, 8, 16, 32, or 64), so that an element never straddles a byte,
+// or for wider elements, an aligned unit of its own size.  Each operation is
+// a single atomic on the aligned unit that holds the element - a byte for
+// element_bitlen <= 8, and otherwise a uint16_t, uint32_t or uint64_t - with
+// a compare-and-swap loop for atomicWriteIndex(), and a single fetch-or for
+// atomicFetchOrIndex().  So every operation is indivisible, including
+// concurrent writes to the SAME element, and writes to different elements
+// are always safe.  For element_bitlen >= 16 the data must be aligned to
+// element_bitlen/8 bytes (allocations are; a view's memory must be too).  We
+// don't offer atomics for other widths, because some of their elements
+// straddle any aligned unit, and it would take two atomics to update them.
+// The atomics use relaxed memory ordering, so you need some other
+// synchronization (e.g. joining the threads) before a thread relies on
+// seeing another thread's writes.  They must not be mixed with concurrent
+// non-atomic writes to the same bytes.
+public:
+    // partitionPoint(count, 0, num_parts) == 0 and
+    // partitionPoint(count, num_parts, num_parts) == count.  For
+    // 0 < part < num_parts it returns roughly part*count/num_parts, rounded
+    // down to a multiple of partitionGranularity(), so that the element at the
+    // returned index begins at a byte boundary.  The ranges [partitionPoint(
+    // count, i, num_parts), partitionPoint(count, i+1, num_parts)) therefore
+    // occupy non-overlapping bytes, and since writeAt() writes only the bytes
+    // of its element (and setAt() only the bytes of its element's granule),
+    // separate threads can write to separate ranges.  Some
+    // ranges may be empty when count is small.
+    static constexpr size_type partitionGranularity()
+    {
+        return (element_bitlen % 8 == 0) ? 1 : (element_bitlen % 4 == 0) ? 2 :
+               (element_bitlen % 2 == 0) ? 4 : 8;
+    }
+
+    static size_type partitionPoint(size_type count,
+                                    unsigned int part, unsigned int num_parts)
+    {
+        HPBC_UTIL_PRECONDITION2(0 < num_parts);
+        HPBC_UTIL_PRECONDITION2(part <= num_parts);
+        if (part == num_parts)
+            return count;
+        size_type q = count / num_parts;
+        size_type r = count % num_parts;
+        // r < num_parts and part < num_parts, so this product can't overflow
+        uint64_t rpart = static_cast<uint64_t>(r) * part / num_parts;
+        size_type point = q * part + static_cast<size_type>(rpart);
+        HPBC_UTIL_ASSERT2(point <= count);
+        return point - point % partitionGranularity();
+    }
+
+    static void atomicWriteIndex(NoAliasUcharPtr vec, std::size_t vec_bytes,
+                                 size_type index, U value)
+    {
+        HPBC_UTIL_PRECONDITION2(value <= max_allowed_value());
+        atomicApply(vec, vec_bytes, index, value, AtomicStore());
+    }
+    static U atomicFetchOrIndex(NoAliasUcharPtr vec, std::size_t vec_bytes,
+                                size_type index, U bits)
+    {
+        HPBC_UTIL_PRECONDITION2(bits <= max_allowed_value());
+        return atomicApply(vec, vec_bytes, index, bits, AtomicOr());
+    }
+    static U atomicReadIndex(NoAliasConstUcharPtr vec, std::size_t vec_bytes,
+                             size_type index)
+    {
+        // the load doesn't write, so casting away const is safe
+        return atomicApply(const_cast<NoAliasUchar*>(vec), vec_bytes, index,
+                           0, AtomicLoad());
+    }
+
+    void atomicSetAt(size_type index, U value)
+    {
+        HPBC_UTIL_PRECONDITION2(index < size());
+        atomicWriteIndex(vec8, vec8_bytes, index, value);
+    }
+    U atomicFetchOr(size_type index, U bits)
+    {
+        HPBC_UTIL_PRECONDITION2(index < size());
+        return atomicFetchOrIndex(vec8, vec8_bytes, index, bits);
+    }
+    U atomicGetAt(size_type index) const
+    {
+        HPBC_UTIL_PRECONDITION2(index < size());
+        return atomicReadIndex(vec8, vec8_bytes, index);
+    }
+
+private:
+    struct AtomicStore {
+        template <typename T> HURCHALLA_FORCE_INLINE
+        T operator()(T* p, T mask, T bits) const
+        {
+            return impl_atomic_bits::update(p, mask, bits);
+        }
+    };
+    struct AtomicOr {
+        template <typename T> HURCHALLA_FORCE_INLINE
+        T operator()(T* p, T, T bits) const
+        {
+            return impl_atomic_bits::fetchOr(p, bits);
+        }
+    };
+    struct AtomicLoad {
+        template <typename T> HURCHALLA_FORCE_INLINE
+        T operator()(T* p, T, T) const
+        {
+            return impl_atomic_bits::load(p);
+        }
+    };
+
+    // the aligned unit that holds an element, for the atomic functions
+    using AtomicUnit = typename std::conditional<(element_bitlen <= 8),
+               uint8_t, typename std::conditional<(element_bitlen == 16),
+               uint16_t, typename std::conditional<(element_bitlen == 32),
+               uint32_t, uint64_t>::type>::type>::type;
+
+    // converts between a unit's value and its little-endian memory content
+    template <typename T>
+    HURCHALLA_FORCE_INLINE static T unitToMemory(T x)
+    {
+#if HURCHALLA_TARGET_IS_LITTLE_ENDIAN()
+        return x;
+#else
+        T r = 0;
+        for (unsigned int i = 0; i < sizeof(T); ++i)
+            r = static_cast<T>((static_cast<uint64_t>(r) << 8) |
+                               ((static_cast<uint64_t>(x) >> (8*i)) & 0xFF));
+        return r;
 #endif
+    }
+
+    // Applies 'op' (a single atomic operation) to the aligned unit that holds
+    // the element at 'index' (see the comment above), and returns the
+    // element's previous value.
+    template <class Op>
+    HURCHALLA_FORCE_INLINE static
+    U atomicApply(NoAliasUchar* vec, std::size_t vec_bytes,
+                  size_type index, U value, Op op)
+    {
+        static_assert(64 % element_bitlen == 0, "The atomic functions "
+                   "require an element_bitlen of 1, 2, 4, 8, 16, 32, or 64");
+        using T = AtomicUnit;
+        std::size_t starting_byte, bit_offset;
+        getLocationFromIndex(index, starting_byte, bit_offset);
+        HPBC_UTIL_PRECONDITION2(starting_byte < vec_bytes &&
+                                sizeof(T) <= vec_bytes - starting_byte);
+        const std::uintptr_t addr =
+                      reinterpret_cast<std::uintptr_t>(vec + starting_byte);
+        HPBC_UTIL_PRECONDITION2(addr % sizeof(T) == 0);
+        const T mask = static_cast<T>(
+                 static_cast<T>(max_allowed_value()) << bit_offset);
+        const T bits = static_cast<T>(static_cast<T>(value) << bit_offset);
+        T prev = unitToMemory(op(reinterpret_cast<T*>(addr),
+                                 unitToMemory(mask), unitToMemory(bits)));
+        return static_cast<U>((prev & mask) >> bit_offset);
+    }
+};
 
 
 }} // end namespace
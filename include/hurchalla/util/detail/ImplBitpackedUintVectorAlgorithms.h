@@ -0,0 +1,300 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#ifndef HURCHALLA_UTIL_IMPL_BITPACKED_UINT_VECTOR_ALGORITHMS_H_INCLUDED
+#define HURCHALLA_UTIL_IMPL_BITPACKED_UINT_VECTOR_ALGORITHMS_H_INCLUDED
+
+
+#include "hurchalla/util/detail/ImplBitpackedUintVector.h"
+#include "hurchalla/util/detail/util_programming_by_contract.h"
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace hurchalla { namespace detail {
+
+
+// Implements the functions of BitpackedUintVectorAlgorithms.h, on packed data
+// at 'vec' that holds 'count' elements.
+//
+// The work is split into one contiguous chunk per thread.  Every chunk but
+// the last begins and ends on a group boundary (a multiple of 8 elements),
+// and groups always begin and end on a byte boundary, so no two chunks share
+// a byte.  Each thread decodes its chunk BLOCK elements at a time into a
+// local buffer with readRange() (which uses the SIMD group kernels when they
+// are enabled), and writes with writeRange().  When other threads are
+// writing, a thread only reads bytes within its own chunk.
+template <typename U, unsigned int element_bitlen>
+struct ImplBitpackedUintVectorAlgorithms {
+private:
+    using Impl = ImplBitpackedUintVector<U, element_bitlen>;
+    using NoAliasUchar = typename Impl::NoAliasUchar;
+public:
+    using size_type = typename Impl::size_type;
+
+private:
+    static constexpr size_type GROUP_SIZE = 8;
+    // elements per readRange/writeRange call; a multiple of GROUP_SIZE
+    static constexpr size_type BLOCK = 2048;
+    // below this many elements per thread, starting a thread costs more than
+    // it saves
+    static constexpr size_type MIN_PER_THREAD = static_cast<size_type>(1) << 16;
+
+    static unsigned int threadCount(size_type count, unsigned int num_threads,
+                                 size_type min_per_thread = MIN_PER_THREAD)
+    {
+        if (num_threads == 0)
+            num_threads = std::thread::hardware_concurrency();
+        if (num_threads == 0)
+            num_threads = 1;
+        size_type limit = count / min_per_thread;
+        if (limit < num_threads)
+            num_threads = (limit == 0) ? 1 : static_cast<unsigned int>(limit);
+        return num_threads;
+    }
+
+    // Returns the first index of chunk 'part' of 'num_parts'; part ==
+    // num_parts gives count.  Chunks are as equal as possible in groups.
+    static size_type chunkStart(size_type count, unsigned int part,
+                                unsigned int num_parts)
+    {
+        HPBC_UTIL_PRECONDITION2(0 < num_parts && part <= num_parts);
+        if (part == num_parts)
+            return count;
+        size_type groups = count / GROUP_SIZE;
+        size_type g = groups / num_parts * part +
+                      groups % num_parts * part / num_parts;
+        return g * GROUP_SIZE;
+    }
+
+    // Calls f(part, first, last) for each chunk, each call (but the first) on
+    // a new thread, and waits for all of them.  If any call throws, rethrows
+    // the first such exception after all threads are joined.
+    template <class F>
+    static void run(size_type count, unsigned int num_threads, const F& f,
+                    size_type min_per_thread = MIN_PER_THREAD)
+    {
+        unsigned int parts = threadCount(count, num_threads, min_per_thread);
+        if (parts == 1) {
+            f(0u, static_cast<size_type>(0), count);
+            return;
+        }
+        std::vector<std::exception_ptr> errors(parts);
+        auto work = [&](unsigned int part) {
+            try {
+                f(part, chunkStart(count, part, parts),
+                        chunkStart(count, part + 1, parts));
+            } catch (...) {
+                errors[part] = std::current_exception();
+            }
+        };
+        std::vector<std::thread> threads;
+        threads.reserve(parts - 1);
+        try {
+            for (unsigned int part = 1; part < parts; ++part)
+                threads.emplace_back(work, part);
+        } catch (...) {
+            for (auto& th : threads)
+                th.join();
+            throw;
+        }
+        work(0u);
+        for (auto& th : threads)
+            th.join();
+        for (auto& e : errors) {
+            if (e)
+                std::rethrow_exception(e);
+        }
+    }
+
+    // Calls f(buf, n) for consecutive blocks of the elements [first, last),
+    // reading no byte at or beyond vec + vec_bytes.
+    template <class F>
+    static void forEachBlock(const NoAliasUchar* vec, std::size_t vec_bytes,
+                             size_type first, size_type last, F& f)
+    {
+        U buf[BLOCK];
+        for (size_type i = first; i < last; ) {
+            size_type n = (last - i < BLOCK) ? last - i : BLOCK;
+            Impl::readRange(vec, vec_bytes, i, n, buf);
+            f(static_cast<const U*>(buf), static_cast<std::size_t>(n));
+            i += n;
+        }
+    }
+
+public:
+    static void fill(NoAliasUchar* vec, size_type count, U value,
+                     unsigned int num_threads)
+    {
+        HPBC_UTIL_PRECONDITION2(value <= Impl::max_allowed_value());
+        // Every group holds the same 8 values, so every group has the same
+        // element_bitlen bytes.  We pack a block of groups once, and copy it.
+        constexpr std::size_t PATTERN_GROUPS = 64;
+        unsigned char pattern[PATTERN_GROUPS * element_bitlen];
+        {
+            U values[PATTERN_GROUPS * GROUP_SIZE];
+            for (auto& v : values)
+                v = value;
+            Impl::writeRange(reinterpret_cast<NoAliasUchar*>(pattern), 0,
+                       static_cast<size_type>(PATTERN_GROUPS * GROUP_SIZE),
+                       values);
+        }
+        run(count, num_threads,
+            [=](unsigned int, size_type first, size_type last) {
+                HPBC_UTIL_ASSERT2(first % GROUP_SIZE == 0);
+                std::size_t g = static_cast<std::size_t>(first / GROUP_SIZE);
+                std::size_t g_end = static_cast<std::size_t>(last / GROUP_SIZE);
+                unsigned char* p = reinterpret_cast<unsigned char*>(vec) +
+                                   g * element_bitlen;
+                while (g < g_end) {
+                    std::size_t n = (g_end - g < PATTERN_GROUPS) ?
+                                    g_end - g : PATTERN_GROUPS;
+                    std::memcpy(p, pattern, n * element_bitlen);
+                    p += n * element_bitlen;
+                    g += n;
+                }
+                for (size_type i = last - last % GROUP_SIZE; i < last; ++i)
+                    Impl::writeIndex(vec, i, value);
+            });
+    }
+
+    template <class F>
+    static void transform(NoAliasUchar* vec, std::size_t vec_bytes,
+                          size_type count, const F& f,
+                          unsigned int num_threads)
+    {
+        run(count, num_threads,
+            [=, &f](unsigned int, size_type first, size_type last) {
+                // read nothing from the next chunk, which another thread
+                // may be writing
+                std::size_t end_bytes = vec_bytes;
+                if (last != count) {
+                    std::size_t bit_offset;
+                    Impl::locateIndex(last, end_bytes, bit_offset);
+                    HPBC_UTIL_ASSERT2(bit_offset == 0);
+                }
+                U buf[BLOCK];
+                for (size_type i = first; i < last; ) {
+                    size_type n = (last - i < BLOCK) ? last - i : BLOCK;
+                    Impl::readRange(vec, end_bytes, i, n, buf);
+                    for (size_type k = 0; k < n; ++k) {
+                        U value = static_cast<U>(f(buf[k]));
+                        HPBC_UTIL_API_PRECONDITION(
+                                        value <= Impl::max_allowed_value());
+                        buf[k] = value;
+                    }
+                    Impl::writeRange(vec, i, n, buf);
+                    i += n;
+                }
+            });
+    }
+
+    template <class Pred>
+    static size_type countIf(const NoAliasUchar* vec, std::size_t vec_bytes,
+                             size_type count, const Pred& pred,
+                             unsigned int num_threads)
+    {
+        std::vector<size_type> counts(threadCount(count, num_threads), 0);
+        run(count, num_threads,
+            [=, &pred, &counts](unsigned int part, size_type first,
+                                size_type last) {
+                size_type total = 0;
+                auto block = [&](const U* buf, std::size_t n) {
+                    for (std::size_t k = 0; k < n; ++k)
+                        total += static_cast<size_type>(pred(buf[k]) ? 1 : 0);
+                };
+                forEachBlock(vec, vec_bytes, first, last, block);
+                counts[part] = total;
+            });
+        size_type total = 0;
+        for (size_type c : counts)
+            total += c;
+        return total;
+    }
+
+    // requires count > 0
+    static std::pair<U, U> minmax(const NoAliasUchar* vec,
+                                  std::size_t vec_bytes, size_type count,
+                                  unsigned int num_threads)
+    {
+        HPBC_UTIL_PRECONDITION2(count > 0);
+        std::vector<std::pair<U, U>> results(threadCount(count, num_threads),
+                          std::make_pair(Impl::max_allowed_value(), U(0)));
+        run(count, num_threads,
+            [=, &results](unsigned int part, size_type first, size_type last) {
+                U lo = Impl::max_allowed_value();
+                U hi = 0;
+                auto block = [&](const U* buf, std::size_t n) {
+                    for (std::size_t k = 0; k < n; ++k) {
+                        lo = (buf[k] < lo) ? buf[k] : lo;
+                        hi = (buf[k] > hi) ? buf[k] : hi;
+                    }
+                };
+                forEachBlock(vec, vec_bytes, first, last, block);
+                results[part] = std::make_pair(lo, hi);
+            });
+        std::pair<U, U> mm = results[0];
+        for (const auto& r : results) {
+            mm.first = (r.first < mm.first) ? r.first : mm.first;
+            mm.second = (r.second > mm.second) ? r.second : mm.second;
+        }
+        return mm;
+    }
+
+    // bin i counts the elements whose value >> bucket_shift equals i.
+    static std::vector<std::uint64_t> histogram(const NoAliasUchar* vec,
+                   std::size_t vec_bytes, size_type count,
+                   unsigned int bucket_shift, unsigned int num_threads)
+    {
+        HPBC_UTIL_PRECONDITION2(bucket_shift <= element_bitlen);
+        std::size_t num_bins = static_cast<std::size_t>(
+                  (bucket_shift == element_bitlen) ? 0 :
+                  Impl::max_allowed_value() >> bucket_shift) + 1;
+        // Each thread counts into its own bins, to avoid contention.  So that
+        // the bins take no more memory than (about) the result and the input,
+        // a thread needs at least num_bins elements.
+        size_type min_per_thread = (num_bins > MIN_PER_THREAD) ?
+                  static_cast<size_type>(num_bins) : MIN_PER_THREAD;
+        unsigned int parts = threadCount(count, num_threads, min_per_thread);
+        std::vector<std::vector<std::uint64_t>> bins(parts);
+        run(count, num_threads,
+            [=, &bins](unsigned int part, size_type first, size_type last) {
+                std::vector<std::uint64_t> local(num_bins, 0);
+                std::uint64_t* h = local.data();
+                auto block = [&](const U* buf, std::size_t n) {
+                    if (bucket_shift == element_bitlen) {
+                        h[0] += n;
+                        return;
+                    }
+                    for (std::size_t k = 0; k < n; ++k)
+                        ++h[buf[k] >> bucket_shift];
+                };
+                forEachBlock(vec, vec_bytes, first, last, block);
+                bins[part] = std::move(local);
+            }, min_per_thread);
+        std::vector<std::uint64_t> result = std::move(bins[0]);
+        if (parts > 1) {
+            // merge in parallel, each thread summing its own range of bins
+            run(static_cast<size_type>(num_bins), num_threads,
+                [&result, &bins, parts](unsigned int, size_type first,
+                                        size_type last) {
+                    for (unsigned int part = 1; part < parts; ++part) {
+                        const std::uint64_t* h = bins[part].data();
+                        for (size_type i = first; i < last; ++i)
+                            result[static_cast<std::size_t>(i)] +=
+                                               h[static_cast<std::size_t>(i)];
+                    }
+                });
+        }
+        return result;
+    }
+};
+
+
+}} // end namespace
+
+#endif
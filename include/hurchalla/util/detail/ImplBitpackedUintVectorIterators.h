@@ -0,0 +1,479 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#ifndef HURCHALLA_UTIL_IMPL_BITPACKED_UINT_VECTOR_ITERATORS_H_INCLUDED
+#define HURCHALLA_UTIL_IMPL_BITPACKED_UINT_VECTOR_ITERATORS_H_INCLUDED
+
+
+#include "hurchalla/util/detail/ImplBitpackedUintVector.h"
+#include "hurchalla/util/detail/util_programming_by_contract.h"
+#include "hurchalla/util/compiler_macros.h"
+#include <cstdint>
+#include <cstddef>
+#include <iterator>
+
+namespace hurchalla { namespace detail {
+
+
+// The location of an element of a BitpackedUintVector: the byte where the
+// element begins, and the bit_offset (0 to 7) of the element within that byte.
+// Moving a location by n elements only needs shifts and adds, since
+// element_bitlen is a compile-time constant, whereas converting an index to a
+// location (see attemptGetLocationFromIndex) needs more work to avoid
+// overflow.  Uchar is either NoAliasUchar or const NoAliasUchar.
+template <unsigned int element_bitlen, typename Uchar>
+struct BitpackedLocation {
+    Uchar* ptr;
+    unsigned int bit_offset;
+
+    HURCHALLA_FORCE_INLINE void increment()
+    {
+        unsigned int bits = bit_offset + element_bitlen;
+        ptr += bits / 8;
+        bit_offset = bits % 8;
+    }
+    HURCHALLA_FORCE_INLINE void decrement()
+    {
+        // 8*element_bitlen bits is a whole number of bytes, so stepping back
+        // one element is the same as stepping back element_bitlen bytes (8
+        // elements) and then forward 7 elements.
+        unsigned int bits = bit_offset + 7 * element_bitlen;
+        ptr += static_cast<std::ptrdiff_t>(bits / 8) -
+               static_cast<std::ptrdiff_t>(element_bitlen);
+        bit_offset = bits % 8;
+    }
+    HURCHALLA_FORCE_INLINE void advance(std::ptrdiff_t n)
+    {
+        // As in attemptGetLocationFromIndex, we split n into (n/8)*8 + (n%8)
+        // so that nothing can overflow.  q and r are floored, so 0 <= r < 8.
+        std::ptrdiff_t q = n / 8;
+        std::ptrdiff_t r = n % 8;
+        if (r < 0) {
+            r += 8;
+            --q;
+        }
+        std::ptrdiff_t bits = r * static_cast<std::ptrdiff_t>(element_bitlen)
+                              + static_cast<std::ptrdiff_t>(bit_offset);
+        ptr += q * static_cast<std::ptrdiff_t>(element_bitlen) + bits / 8;
+        bit_offset = static_cast<unsigned int>(bits % 8);
+    }
+    // returns the number of elements from 'other' to this location
+    HURCHALLA_FORCE_INLINE std::ptrdiff_t
+    distanceFrom(const BitpackedLocation& other) const
+    {
+        constexpr std::ptrdiff_t EB = static_cast<std::ptrdiff_t>(element_bitlen);
+        // The distance in bits is 8*d + (bit_offset - other.bit_offset), and it
+        // is a multiple of EB.  We avoid computing 8*d since it could overflow.
+        std::ptrdiff_t d = ptr - other.ptr;
+        std::ptrdiff_t rem = 8 * (d % EB) +
+                             static_cast<std::ptrdiff_t>(bit_offset) -
+                             static_cast<std::ptrdiff_t>(other.bit_offset);
+        HPBC_UTIL_ASSERT2(rem % EB == 0);
+        return 8 * (d / EB) + rem / EB;
+    }
+    HURCHALLA_FORCE_INLINE bool equals(const BitpackedLocation& other) const
+    {
+        return ptr == other.ptr && bit_offset == other.bit_offset;
+    }
+    HURCHALLA_FORCE_INLINE bool lessThan(const BitpackedLocation& other) const
+    {
+        return ptr < other.ptr ||
+               (ptr == other.ptr && bit_offset < other.bit_offset);
+    }
+};
+
+
+// A random access iterator over the elements of a BitpackedUintVector.
+// Dereferencing gives the element's value (there is no U object in memory to
+// refer to), and so 'pointer' is void and 'reference' is U.
+template <typename U, unsigned int element_bitlen>
+class BitpackedUintVectorConstIterator {
+    using Impl = ImplBitpackedUintVector<U, element_bitlen>;
+    using Location = BitpackedLocation<element_bitlen,
+                                       const typename Impl::NoAliasUchar>;
+    Location loc;
+public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = U;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = U;
+
+    BitpackedUintVectorConstIterator() : loc{nullptr, 0} {}
+    BitpackedUintVectorConstIterator(const typename Impl::NoAliasUchar* ptr,
+                                     unsigned int bit_offset) :
+            loc{ptr, bit_offset}
+    {
+        HPBC_UTIL_PRECONDITION2(bit_offset < 8);
+    }
+
+    HURCHALLA_FORCE_INLINE U operator*() const
+    {
+        return Impl::readAt(loc.ptr, loc.bit_offset);
+    }
+    HURCHALLA_FORCE_INLINE U operator[](difference_type n) const
+    {
+        return *(*this + n);
+    }
+
+    HURCHALLA_FORCE_INLINE BitpackedUintVectorConstIterator& operator++()
+    {
+        loc.increment();
+        return *this;
+    }
+    HURCHALLA_FORCE_INLINE BitpackedUintVectorConstIterator operator++(int)
+    {
+        BitpackedUintVectorConstIterator tmp = *this;
+        loc.increment();
+        return tmp;
+    }
+    HURCHALLA_FORCE_INLINE BitpackedUintVectorConstIterator& operator--()
+    {
+        loc.decrement();
+        return *this;
+    }
+    HURCHALLA_FORCE_INLINE BitpackedUintVectorConstIterator operator--(int)
+    {
+        BitpackedUintVectorConstIterator tmp = *this;
+        loc.decrement();
+        return tmp;
+    }
+    HURCHALLA_FORCE_INLINE
+    BitpackedUintVectorConstIterator& operator+=(difference_type n)
+    {
+        loc.advance(n);
+        return *this;
+    }
+    HURCHALLA_FORCE_INLINE
+    BitpackedUintVectorConstIterator& operator-=(difference_type n)
+    {
+        loc.advance(-n);
+        return *this;
+    }
+    HURCHALLA_FORCE_INLINE friend BitpackedUintVectorConstIterator
+    operator+(BitpackedUintVectorConstIterator it, difference_type n)
+    {
+        return it += n;
+    }
+    HURCHALLA_FORCE_INLINE friend BitpackedUintVectorConstIterator
+    operator+(difference_type n, BitpackedUintVectorConstIterator it)
+    {
+        return it += n;
+    }
+    HURCHALLA_FORCE_INLINE friend BitpackedUintVectorConstIterator
+    operator-(BitpackedUintVectorConstIterator it, difference_type n)
+    {
+        return it -= n;
+    }
+    HURCHALLA_FORCE_INLINE friend difference_type
+    operator-(const BitpackedUintVectorConstIterator& a,
+              const BitpackedUintVectorConstIterator& b)
+    {
+        return a.loc.distanceFrom(b.loc);
+    }
+
+    HURCHALLA_FORCE_INLINE friend bool operator==(
+                                      const BitpackedUintVectorConstIterator& a,
+                                      const BitpackedUintVectorConstIterator& b)
+    {
+        return a.loc.equals(b.loc);
+    }
+    HURCHALLA_FORCE_INLINE friend bool operator!=(
+                                      const BitpackedUintVectorConstIterator& a,
+                                      const BitpackedUintVectorConstIterator& b)
+    {
+        return !a.loc.equals(b.loc);
+    }
+    HURCHALLA_FORCE_INLINE friend bool operator<(
+                                      const BitpackedUintVectorConstIterator& a,
+                                      const BitpackedUintVectorConstIterator& b)
+    {
+        return a.loc.lessThan(b.loc);
+    }
+    HURCHALLA_FORCE_INLINE friend bool operator>(
+                                      const BitpackedUintVectorConstIterator& a,
+                                      const BitpackedUintVectorConstIterator& b)
+    {
+        return b.loc.lessThan(a.loc);
+    }
+    HURCHALLA_FORCE_INLINE friend bool operator<=(
+                                      const BitpackedUintVectorConstIterator& a,
+                                      const BitpackedUintVectorConstIterator& b)
+    {
+        return !b.loc.lessThan(a.loc);
+    }
+    HURCHALLA_FORCE_INLINE friend bool operator>=(
+                                      const BitpackedUintVectorConstIterator& a,
+                                      const BitpackedUintVectorConstIterator& b)
+    {
+        return !a.loc.lessThan(b.loc);
+    }
+};
+
+
+// A proxy for a single element of a BitpackedUintVector, similar to
+// std::vector<bool>::reference.  It converts to U, and assigning a U to it
+// writes the element.
+template <typename U, unsigned int element_bitlen>
+class BitpackedUintVectorReference {
+    using Impl = ImplBitpackedUintVector<U, element_bitlen>;
+    typename Impl::NoAliasUchar* ptr;
+    unsigned int bit_offset;
+public:
+    BitpackedUintVectorReference(typename Impl::NoAliasUchar* p,
+                                 unsigned int offset) :
+            ptr(p), bit_offset(offset) {}
+    BitpackedUintVectorReference(const BitpackedUintVectorReference&) = default;
+
+    HURCHALLA_FORCE_INLINE operator U() const
+    {
+        return Impl::readAt(ptr, bit_offset);
+    }
+    HURCHALLA_FORCE_INLINE BitpackedUintVectorReference& operator=(U value)
+    {
+        HPBC_UTIL_API_PRECONDITION(value <= Impl::max_allowed_value());
+        Impl::writeAt(ptr, bit_offset, value);
+        return *this;
+    }
+    // assigns the value of the element that 'other' refers to
+    HURCHALLA_FORCE_INLINE BitpackedUintVectorReference& operator=(
+                                       const BitpackedUintVectorReference& other)
+    {
+        return *this = static_cast<U>(other);
+    }
+
+    // swaps the values of the two elements
+    HURCHALLA_FORCE_INLINE friend void swap(BitpackedUintVectorReference a,
+                                            BitpackedUintVectorReference b)
+    {
+        U tmp = a;
+        a = static_cast<U>(b);
+        b = tmp;
+    }
+    HURCHALLA_FORCE_INLINE friend void swap(BitpackedUintVectorReference a,
+                                            U& b)
+    {
+        U tmp = a;
+        a = b;
+        b = tmp;
+    }
+    HURCHALLA_FORCE_INLINE friend void swap(U& a,
+                                            BitpackedUintVectorReference b)
+    {
+        U tmp = b;
+        b = a;
+        a = tmp;
+    }
+};
+
+
+// A mutable random access iterator over the elements of a BitpackedUintVector.
+// Like std::vector<bool>::iterator, dereferencing gives a proxy reference.
+// Writing an element writes only the bytes it occupies, but neighboring
+// elements can share a byte, so separate threads must not write through
+// iterators to neighboring elements (see partitionPoint()).
+template <typename U, unsigned int element_bitlen>
+class BitpackedUintVectorIterator {
+    using Impl = ImplBitpackedUintVector<U, element_bitlen>;
+    using Location = BitpackedLocation<element_bitlen,
+                                       typename Impl::NoAliasUchar>;
+    Location loc;
+public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = U;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = BitpackedUintVectorReference<U, element_bitlen>;
+
+    BitpackedUintVectorIterator() : loc{nullptr, 0} {}
+    BitpackedUintVectorIterator(typename Impl::NoAliasUchar* ptr,
+                                unsigned int bit_offset) :
+            loc{ptr, bit_offset}
+    {
+        HPBC_UTIL_PRECONDITION2(bit_offset < 8);
+    }
+    operator BitpackedUintVectorConstIterator<U, element_bitlen>() const
+    {
+        return BitpackedUintVectorConstIterator<U, element_bitlen>(
+                                                      loc.ptr, loc.bit_offset);
+    }
+
+    HURCHALLA_FORCE_INLINE reference operator*() const
+    {
+        return reference(loc.ptr, loc.bit_offset);
+    }
+    HURCHALLA_FORCE_INLINE reference operator[](difference_type n) const
+    {
+        return *(*this + n);
+    }
+
+    HURCHALLA_FORCE_INLINE BitpackedUintVectorIterator& operator++()
+    {
+        loc.increment();
+        return *this;
+    }
+    HURCHALLA_FORCE_INLINE BitpackedUintVectorIterator operator++(int)
+    {
+        BitpackedUintVectorIterator tmp = *this;
+        loc.increment();
+        return tmp;
+    }
+    HURCHALLA_FORCE_INLINE BitpackedUintVectorIterator& operator--()
+    {
+        loc.decrement();
+        return *this;
+    }
+    HURCHALLA_FORCE_INLINE BitpackedUintVectorIterator operator--(int)
+    {
+        BitpackedUintVectorIterator tmp = *this;
+        loc.decrement();
+        return tmp;
+    }
+    HURCHALLA_FORCE_INLINE
+    BitpackedUintVectorIterator& operator+=(difference_type n)
+    {
+        loc.advance(n);
+        return *this;
+    }
+    HURCHALLA_FORCE_INLINE
+    BitpackedUintVectorIterator& operator-=(difference_type n)
+    {
+        loc.advance(-n);
+        return *this;
+    }
+    HURCHALLA_FORCE_INLINE friend BitpackedUintVectorIterator
+    operator+(BitpackedUintVectorIterator it, difference_type n)
+    {
+        return it += n;
+    }
+    HURCHALLA_FORCE_INLINE friend BitpackedUintVectorIterator
+    operator+(difference_type n, BitpackedUintVectorIterator it)
+    {
+        return it += n;
+    }
+    HURCHALLA_FORCE_INLINE friend BitpackedUintVectorIterator
+    operator-(BitpackedUintVectorIterator it, difference_type n)
+    {
+        return it -= n;
+    }
+    HURCHALLA_FORCE_INLINE friend difference_type
+    operator-(const BitpackedUintVectorIterator& a,
+              const BitpackedUintVectorIterator& b)
+    {
+        return a.loc.distanceFrom(b.loc);
+    }
+
+    HURCHALLA_FORCE_INLINE friend bool operator==(
+                                           const BitpackedUintVectorIterator& a,
+                                           const BitpackedUintVectorIterator& b)
+    {
+        return a.loc.equals(b.loc);
+    }
+    HURCHALLA_FORCE_INLINE friend bool operator!=(
+                                           const BitpackedUintVectorIterator& a,
+                                           const BitpackedUintVectorIterator& b)
+    {
+        return !a.loc.equals(b.loc);
+    }
+    HURCHALLA_FORCE_INLINE friend bool operator<(
+                                           const BitpackedUintVectorIterator& a,
+                                           const BitpackedUintVectorIterator& b)
+    {
+        return a.loc.lessThan(b.loc);
+    }
+    HURCHALLA_FORCE_INLINE friend bool operator>(
+                                           const BitpackedUintVectorIterator& a,
+                                           const BitpackedUintVectorIterator& b)
+    {
+        return b.loc.lessThan(a.loc);
+    }
+    HURCHALLA_FORCE_INLINE friend bool operator<=(
+                                           const BitpackedUintVectorIterator& a,
+                                           const BitpackedUintVectorIterator& b)
+    {
+        return !b.loc.lessThan(a.loc);
+    }
+    HURCHALLA_FORCE_INLINE friend bool operator>=(
+                                           const BitpackedUintVectorIterator& a,
+                                           const BitpackedUintVectorIterator& b)
+    {
+        return !a.loc.lessThan(b.loc);
+    }
+};
+
+
+// A forward-only reader for sequential scans.  Rather than decoding one
+// element per call (as getAt() and the iterators do), it decodes a whole group
+// of 8 elements at a time into a small buffer, using unpackGroup() from
+// ImplBitpackedUintVector.  The 8 decodes are independent of each other, and
+// next() is usually just a read from the buffer.
+template <typename U, unsigned int element_bitlen>
+class BitpackedUintVectorReadCursor {
+    using Impl = ImplBitpackedUintVector<U, element_bitlen>;
+    using Uchar = typename Impl::NoAliasUchar;
+    using size_type = typename Impl::size_type;
+    static constexpr unsigned int GROUP_SIZE = 8;
+
+    const Uchar* group;         // the next group to decode
+    std::size_t fast_groups;    // groups that unpackGroup() can safely decode
+    size_type remaining;        // elements from 'group' to the vector's end
+    unsigned int position;      // the next element to return from 'buffer'
+    U buffer[GROUP_SIZE];
+
+    HURCHALLA_FORCE_INLINE void decodeGroup()
+    {
+        if (fast_groups > 0) {
+            Impl::unpackGroup(group, buffer);
+            --fast_groups;
+        } else {
+            // Near the end of the data, unpackGroup() could read past the
+            // end.  readAt() reads only within the data (it may read the
+            // extra byte at the end that dataSizeBytes() includes).
+            BitpackedLocation<element_bitlen, const Uchar> loc{group, 0};
+            for (unsigned int j = 0; j < GROUP_SIZE; ++j) {
+                buffer[j] = (j < remaining) ?
+                                    Impl::readAt(loc.ptr, loc.bit_offset) : 0;
+                loc.increment();
+            }
+        }
+        group += element_bitlen;
+        remaining = (remaining > GROUP_SIZE) ? remaining - GROUP_SIZE : 0;
+        position = 0;
+    }
+
+public:
+    // group_ptr points to the start of the group that holds the first element
+    // to read, and index_in_group is that element's position within the
+    // group.  elements_to_end is the number of elements from the start of the
+    // group to the end of the vector, and bytes_to_end is the number of bytes
+    // of data from group_ptr to the end of the data.
+    BitpackedUintVectorReadCursor(const Uchar* group_ptr,
+                                  unsigned int index_in_group,
+                                  size_type elements_to_end,
+                                  std::size_t bytes_to_end) :
+            group(group_ptr), fast_groups(0), remaining(elements_to_end),
+            position(0), buffer()
+    {
+        HPBC_UTIL_PRECONDITION2(index_in_group < GROUP_SIZE);
+        if (bytes_to_end >= Impl::UNPACK_READ_BYTES)
+            fast_groups = (bytes_to_end - Impl::UNPACK_READ_BYTES)
+                          / element_bitlen + 1;
+        decodeGroup();
+        position = index_in_group;
+    }
+
+    // Returns the current element and advances to the next element.  The
+    // caller must not read past the vector's last element (doing so is
+    // harmless, but the values are meaningless).
+    HURCHALLA_FORCE_INLINE U next()
+    {
+        if (position == GROUP_SIZE)
+            decodeGroup();
+        return buffer[position++];
+    }
+};
+
+
+}} // end namespace
+
+#endif
@@ -0,0 +1,230 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#ifndef HURCHALLA_UTIL_IMPL_BITPACKED_UINT_VECTOR_STREAM_H_INCLUDED
+#define HURCHALLA_UTIL_IMPL_BITPACKED_UINT_VECTOR_STREAM_H_INCLUDED
+
+
+#include "hurchalla/util/BitpackedUintVector.h"
+#include "hurchalla/util/BitpackedUintVectorView.h"
+#include "hurchalla/util/detail/ImplBitpackedUintVector.h"
+#include "hurchalla/util/detail/platform_specific/impl_crc32c.h"
+#include "hurchalla/util/detail/platform_specific/impl_fd_io.h"
+#include "hurchalla/util/detail/util_programming_by_contract.h"
+#include <cstdint>
+#include <cstddef>
+#include <istream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace hurchalla { namespace detail {
+
+
+// The chunked stream format of BitpackedUintVectorStream.h.  All integers
+// are little-endian.  The stream begins with a HEADER_BYTES header:
+//   bytes 0-7:    magic "HBPUVSTM"
+//   bytes 8-11:   format ID (BitpackedUintVector::getFormatID())
+//   bytes 12-15:  element_bitlen
+//   bytes 16-23:  element count
+//   bytes 24-31:  data size in bytes (dataSizeBytes())
+//   bytes 32-35:  chunk size in bytes
+//   bytes 36-59:  zero
+//   bytes 60-63:  CRC-32C of bytes 0-59
+// followed by the data, split into chunks of the chunk size (the last chunk
+// may be shorter), each immediately followed by the CRC-32C of its bytes.
+//
+// write(), readHeader() and readData() move the bytes through a Sink or
+// Source functor:
+//   void sink(const unsigned char* p, std::size_t n)  - writes n bytes
+//   std::size_t source(unsigned char* p, std::size_t n)  - reads up to n
+//       bytes, returning fewer only at end of stream
+struct ImplBitpackedUintVectorStream {
+    static constexpr std::size_t HEADER_BYTES = 64;
+    static constexpr std::size_t CRC_BYTES = 4;
+    static constexpr std::size_t MAX_CHUNK_BYTES = std::size_t(1) << 30;
+    static constexpr std::size_t DEFAULT_CHUNK_BYTES = std::size_t(1) << 20;
+
+    struct Header {
+        uint32_t format_id;
+        uint32_t element_bitlen;
+        uint64_t count;
+        uint64_t data_bytes;
+        uint32_t chunk_bytes;
+    };
+
+    template <class Sink>
+    static void write(Sink& sink, const Header& h, const unsigned char* data)
+    {
+        HPBC_UTIL_PRECONDITION2(0 < h.chunk_bytes &&
+                                h.chunk_bytes <= MAX_CHUNK_BYTES);
+        unsigned char header[HEADER_BYTES] = {};
+        for (std::size_t i = 0; i < MAGIC_BYTES; ++i)
+            header[i] = magic(i);
+        writeLE(header + 8, 4, h.format_id);
+        writeLE(header + 12, 4, h.element_bitlen);
+        writeLE(header + 16, 8, h.count);
+        writeLE(header + 24, 8, h.data_bytes);
+        writeLE(header + 32, 4, h.chunk_bytes);
+        writeLE(header + 60, 4, impl_crc32c::call(0, header, 60));
+        sink(header, HEADER_BYTES);
+
+        std::size_t total = static_cast<std::size_t>(h.data_bytes);
+        for (std::size_t done = 0; done < total; ) {
+            std::size_t n = (total - done < h.chunk_bytes) ? total - done
+                                                           : h.chunk_bytes;
+            unsigned char crc[CRC_BYTES];
+            writeLE(crc, CRC_BYTES, impl_crc32c::call(0, data + done, n));
+            sink(data + done, n);
+            sink(crc, CRC_BYTES);
+            done += n;
+        }
+    }
+
+    // Reads and validates the header, and returns it.  Throws
+    // std::runtime_error if the stream is short, isn't in this format, or if
+    // the header is corrupt.
+    template <class Source>
+    static Header readHeader(Source& source)
+    {
+        unsigned char header[HEADER_BYTES];
+        if (source(header, HEADER_BYTES) != HEADER_BYTES)
+            throw std::runtime_error("bitpacked stream is too short for a header");
+        for (std::size_t i = 0; i < MAGIC_BYTES; ++i) {
+            if (header[i] != magic(i))
+                throw std::runtime_error("not a bitpacked stream");
+        }
+        if (readLE(header + 60, 4) != impl_crc32c::call(0, header, 60))
+            throw std::runtime_error("bitpacked stream header checksum mismatch");
+        Header h;
+        h.format_id = static_cast<uint32_t>(readLE(header + 8, 4));
+        h.element_bitlen = static_cast<uint32_t>(readLE(header + 12, 4));
+        h.count = readLE(header + 16, 8);
+        h.data_bytes = readLE(header + 24, 8);
+        h.chunk_bytes = static_cast<uint32_t>(readLE(header + 32, 4));
+        if (h.chunk_bytes == 0 || h.chunk_bytes > MAX_CHUNK_BYTES)
+            throw std::runtime_error("bitpacked stream has an invalid chunk size");
+        return h;
+    }
+
+    // Reads the data that follows the header into 'data', verifying each
+    // chunk's checksum.  Throws std::runtime_error if the stream is short or
+    // a checksum doesn't match; 'data' may have been partly overwritten.
+    template <class Source>
+    static void readData(Source& source, const Header& h, unsigned char* data)
+    {
+        std::size_t total = static_cast<std::size_t>(h.data_bytes);
+        for (std::size_t done = 0; done < total; ) {
+            std::size_t n = (total - done < h.chunk_bytes) ? total - done
+                                                           : h.chunk_bytes;
+            unsigned char crc[CRC_BYTES];
+            if (source(data + done, n) != n ||
+                                    source(crc, CRC_BYTES) != CRC_BYTES)
+                throw std::runtime_error("bitpacked stream is truncated");
+            if (readLE(crc, CRC_BYTES) != impl_crc32c::call(0, data + done, n))
+                throw std::runtime_error("bitpacked stream checksum mismatch in chunk at byte " + std::to_string(done));
+            done += n;
+        }
+    }
+
+    // Writes the header and data of 'view' to sink.
+    template <class Sink, typename U, unsigned int element_bitlen, bool is_const>
+    static void writeView(Sink& sink,
+              const BitpackedUintVectorView<U, element_bitlen, is_const>& view,
+              std::size_t chunk_bytes)
+    {
+        Header h;
+        h.format_id = ImplBitpackedUintVector<U, element_bitlen>::getFormatID();
+        h.element_bitlen = element_bitlen;
+        h.count = static_cast<uint64_t>(view.size());
+        h.data_bytes = static_cast<uint64_t>(view.dataSizeBytes());
+        h.chunk_bytes = static_cast<uint32_t>(chunk_bytes);
+        write(sink, h, view.data());
+    }
+
+    // Reads the header, and checks that it describes data of a
+    // BitpackedUintVector<U, element_bitlen>.
+    template <typename U, unsigned int element_bitlen, class Source>
+    static Header readHeaderFor(Source& source)
+    {
+        using Impl = ImplBitpackedUintVector<U, element_bitlen>;
+        using size_type = typename Impl::size_type;
+        Header h = readHeader(source);
+        if (h.format_id != Impl::getFormatID())
+            throw std::runtime_error("bitpacked stream has a mismatched format ID");
+        if (h.element_bitlen != element_bitlen)
+            throw std::runtime_error("bitpacked stream has a mismatched element_bitlen");
+        if (h.count > std::numeric_limits<size_type>::max())
+            throw std::runtime_error("bitpacked stream has an element count that is too large");
+        std::size_t expected = Impl::dataSizeBytes(static_cast<size_type>(h.count));
+        if (expected == 0 || h.data_bytes != expected)
+            throw std::runtime_error("bitpacked stream has a data size that doesn't match its count");
+        return h;
+    }
+
+    template <typename U, unsigned int element_bitlen, class Source>
+    static void readIntoView(Source& source,
+                     const BitpackedUintVectorView<U, element_bitlen>& view)
+    {
+        Header h = readHeaderFor<U, element_bitlen>(source);
+        if (h.count != static_cast<uint64_t>(view.size()))
+            throw std::runtime_error("bitpacked stream element count doesn't match the view");
+        readData(source, h, view.data());
+    }
+
+    template <typename U, unsigned int element_bitlen, class Storage,
+              class Source>
+    static BitpackedUintVector<U, element_bitlen, Storage>
+    readVector(Source& source)
+    {
+        using Vec = BitpackedUintVector<U, element_bitlen, Storage>;
+        Header h = readHeaderFor<U, element_bitlen>(source);
+        Vec vec(static_cast<typename Vec::size_type>(h.count));
+        readData(source, h, vec.view().data());
+        return vec;
+    }
+
+    struct IstreamSource {
+        std::istream& is;
+        std::size_t operator()(unsigned char* p, std::size_t n)
+        {
+            is.read(reinterpret_cast<char*>(p), static_cast<std::streamsize>(n));
+            if (is.bad())
+                throw std::runtime_error("unable to read bitpacked stream");
+            return static_cast<std::size_t>(is.gcount());
+        }
+    };
+    struct FdSource {
+        int fd;
+        std::size_t operator()(unsigned char* p, std::size_t n)
+        {
+            return impl_fd_io::readAll(fd, p, n);
+        }
+    };
+
+private:
+    static constexpr std::size_t MAGIC_BYTES = 8;
+    static unsigned char magic(std::size_t i)
+    {
+        static const char m[MAGIC_BYTES] = { 'H','B','P','U','V','S','T','M' };
+        return static_cast<unsigned char>(m[i]);
+    }
+
+    static uint64_t readLE(const unsigned char* p, std::size_t num_bytes)
+    {
+        uint64_t x = 0;
+        for (std::size_t i = 0; i < num_bytes; ++i)
+            x |= static_cast<uint64_t>(p[i]) << (8 * i);
+        return x;
+    }
+    static void writeLE(unsigned char* p, std::size_t num_bytes, uint64_t x)
+    {
+        for (std::size_t i = 0; i < num_bytes; ++i)
+            p[i] = static_cast<unsigned char>(x >> (8 * i));
+    }
+};
+
+
+}} // end namespace
+
+#endif
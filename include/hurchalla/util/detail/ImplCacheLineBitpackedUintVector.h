@@ -0,0 +1,140 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#ifndef HURCHALLA_UTIL_IMPL_CACHE_LINE_BITPACKED_UINT_VECTOR_H_INCLUDED
+#define HURCHALLA_UTIL_IMPL_CACHE_LINE_BITPACKED_UINT_VECTOR_H_INCLUDED
+
+
+#include "hurchalla/util/detail/ImplBitpackedUintVector.h"
+#include "hurchalla/util/detail/util_programming_by_contract.h"
+#include "hurchalla/util/compiler_macros.h"
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+
+namespace hurchalla { namespace detail {
+
+
+// Element access for the cache line blocked layout.  The data is a sequence
+// of BLOCK_BYTES (64) byte blocks.  Block b holds the ELEMENTS_PER_BLOCK ==
+// floor(512/element_bitlen) elements beginning at index b*ELEMENTS_PER_BLOCK,
+// packed densely in the same little-endian bit order as
+// ImplBitpackedUintVector (element j of a block begins at bit j*element_bitlen
+// of the block), and the bits after the last element of a block are unused
+// and zero.  So within a block, the elements have exactly the layout of an
+// ImplBitpackedUintVector of ELEMENTS_PER_BLOCK elements, and we reuse its
+// readAt(), writeAt(), readRange(), and writeRange() on each block.  No
+// element crosses a block boundary, and so if the data is 64 byte aligned,
+// no element crosses a cache line.
+template <typename U, unsigned int element_bitlen>
+struct ImplCacheLineBitpackedUintVector {
+    using Dense = ImplBitpackedUintVector<U, element_bitlen>;
+    using NoAliasUchar = typename Dense::NoAliasUchar;
+    using NoAliasUcharPtr = typename Dense::NoAliasUcharPtr;
+    using NoAliasConstUcharPtr = typename Dense::NoAliasConstUcharPtr;
+
+    static constexpr std::size_t BLOCK_BYTES = 64;
+    static constexpr std::size_t ELEMENTS_PER_BLOCK =
+                                              8 * BLOCK_BYTES / element_bitlen;
+    static_assert(0 < element_bitlen && element_bitlen <= 64, "");
+    static_assert(ELEMENTS_PER_BLOCK >= 8, "");
+
+    static constexpr uint32_t getFormatID()
+    {
+        // As with ImplBitpackedUintVector::getFormatID(), the constant used
+        // below is an arbitrary random number that must never change; if the
+        // format changes, change dataVersion.
+        return UINT32_C(3580227155) + dataVersion;
+    }
+
+    // Returns the bytes needed for count elements: the number of blocks
+    // (at least one, even if count is 0) times BLOCK_BYTES.  Returns 0 if that
+    // would overflow std::size_t.
+    static constexpr std::size_t dataSizeBytes(std::size_t count)
+    {
+        return (count / ELEMENTS_PER_BLOCK + 1 >
+                    std::numeric_limits<std::size_t>::max() / BLOCK_BYTES) ? 0 :
+               BLOCK_BYTES * ((count == 0) ? 1 :
+                    (count - 1) / ELEMENTS_PER_BLOCK + 1);
+    }
+
+    HURCHALLA_FORCE_INLINE static
+    void locate(std::size_t index, std::size_t& byte, std::size_t& bit_offset)
+    {
+        // ELEMENTS_PER_BLOCK is a compile time constant, so the compiler
+        // replaces the division with a multiply and shift.
+        std::size_t block = index / ELEMENTS_PER_BLOCK;
+        std::size_t bitpos = (index % ELEMENTS_PER_BLOCK) * element_bitlen;
+        byte = block * BLOCK_BYTES + bitpos / 8;
+        bit_offset = bitpos % 8;
+    }
+
+    HURCHALLA_FORCE_INLINE static
+    U readIndex(NoAliasConstUcharPtr vec, std::size_t index)
+    {
+        std::size_t byte, bit_offset;
+        locate(index, byte, bit_offset);
+        return Dense::readAt(vec + byte, bit_offset);
+    }
+
+    HURCHALLA_FORCE_INLINE static
+    void writeIndex(NoAliasUcharPtr vec, std::size_t index, U value)
+    {
+        HPBC_UTIL_PRECONDITION2(value <= Dense::max_allowed_value());
+        std::size_t byte, bit_offset;
+        locate(index, byte, bit_offset);
+        Dense::writeAt(vec + byte, bit_offset, value);
+    }
+
+    // Reads (or writes) the 'count' elements beginning at index 'first', one
+    // block at a time.  Neither reads nor writes outside of the blocks that
+    // hold the elements.
+    static void readRange(NoAliasConstUcharPtr vec, std::size_t first,
+                          std::size_t count, U* out)
+    {
+        while (count > 0) {
+            std::size_t n;
+            NoAliasConstUcharPtr block = blockSpan(vec, first, count, n);
+            Dense::readRange(block, BLOCK_BYTES,
+                             static_cast<DenseSizeType>(first % ELEMENTS_PER_BLOCK),
+                             static_cast<DenseSizeType>(n), out);
+            first += n;
+            count -= n;
+            out += n;
+        }
+    }
+    static void writeRange(NoAliasUcharPtr vec, std::size_t first,
+                           std::size_t count, const U* in)
+    {
+        while (count > 0) {
+            std::size_t n;
+            NoAliasUcharPtr block = blockSpan(vec, first, count, n);
+            Dense::writeRange(block,
+                             static_cast<DenseSizeType>(first % ELEMENTS_PER_BLOCK),
+                             static_cast<DenseSizeType>(n), in);
+            first += n;
+            count -= n;
+            in += n;
+        }
+    }
+
+private:
+    static constexpr uint8_t dataVersion = 1;
+    using DenseSizeType = typename Dense::size_type;
+
+    // Returns the block that holds the element at 'first', and sets n to the
+    // number of the 'count' elements beginning at 'first' that are in it.
+    template <typename P>
+    HURCHALLA_FORCE_INLINE static
+    P blockSpan(P vec, std::size_t first, std::size_t count, std::size_t& n)
+    {
+        std::size_t left = ELEMENTS_PER_BLOCK - first % ELEMENTS_PER_BLOCK;
+        n = (count < left) ? count : left;
+        return vec + (first / ELEMENTS_PER_BLOCK) * BLOCK_BYTES;
+    }
+};
+
+
+}} // end namespace
+
+#endif
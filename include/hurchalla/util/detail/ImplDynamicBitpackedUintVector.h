@@ -0,0 +1,172 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#ifndef HURCHALLA_UTIL_IMPL_DYNAMIC_BITPACKED_UINT_VECTOR_H_INCLUDED
+#define HURCHALLA_UTIL_IMPL_DYNAMIC_BITPACKED_UINT_VECTOR_H_INCLUDED
+
+
+#include "hurchalla/util/BitpackedUintVectorView.h"
+#include "hurchalla/util/detail/util_programming_by_contract.h"
+#include "hurchalla/util/compiler_macros.h"
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+namespace hurchalla { namespace detail {
+
+
+// Element access for packed data whose element_bitlen is known only at run
+// time.  The layout is exactly that of ImplBitpackedUintVector<U, bitlen>.
+//
+// Every element is read and written through the unaligned little-endian 64
+// bit window that begins at the element's first byte.  Since bitlen <= 32
+// and the element begins at bit offset <= 7 of that byte, the window always
+// covers the element.  The window may extend up to WINDOW_PAD bytes beyond
+// dataSizeBytes(), so the owner must allocate that padding.  writeWindow()
+// rewrites all 8 bytes of the window (unchanged, except for the element), so
+// unlike ImplBitpackedUintVector::writeIndex(), it is not safe for separate
+// threads to write to neighboring elements.
+template <typename U>
+struct ImplDynamicBitpackedUintVector {
+    static_assert(std::numeric_limits<U>::is_integer, "");
+    static_assert(!std::numeric_limits<U>::is_signed, "");
+
+    static constexpr unsigned int MAX_BITLEN =
+                  (std::numeric_limits<U>::digits < 32) ?
+                  static_cast<unsigned int>(std::numeric_limits<U>::digits) : 32;
+    static constexpr std::size_t WINDOW_PAD = 7;
+
+    // returns the maximum value that fits within bitlen bits
+    HURCHALLA_FORCE_INLINE static U max_allowed_value(unsigned int bitlen)
+    {
+        HPBC_UTIL_PRECONDITION2(0 < bitlen && bitlen <= MAX_BITLEN);
+        return static_cast<U>((static_cast<U>(1) << (bitlen - 1)) - 1 +
+                              (static_cast<U>(1) << (bitlen - 1)));
+    }
+
+    // Returns the same value as ImplBitpackedUintVector<U, bitlen>::
+    // dataSizeBytes(count): the bytes that count elements occupy, plus one.
+    // Returns 0 if that would overflow std::size_t.
+    static std::size_t dataSizeBytes(unsigned int bitlen, std::size_t count)
+    {
+        HPBC_UTIL_PRECONDITION2(0 < bitlen && bitlen <= MAX_BITLEN);
+        constexpr std::size_t MAXSIZET = std::numeric_limits<std::size_t>::max();
+        std::size_t groups = count / 8;
+        if (groups > MAXSIZET / bitlen)
+            return 0;
+        std::size_t bytes = groups * bitlen;
+        std::size_t tail_bytes = ((count % 8) * bitlen + 7) / 8;
+        if (bytes > MAXSIZET - tail_bytes - 1)
+            return 0;
+        return bytes + tail_bytes + 1;
+    }
+
+    // Sets byte to the first byte of the element at index, and shift to its
+    // bit offset within that byte.
+    HURCHALLA_FORCE_INLINE static void locate(unsigned int bitlen,
+                   std::size_t index, std::size_t& byte, unsigned int& shift)
+    {
+        // index/8 groups of bitlen bytes each, then (index%8)*bitlen bits
+        std::size_t bits_in_group = (index % 8) * bitlen;
+        byte = (index / 8) * bitlen + bits_in_group / 8;
+        shift = static_cast<unsigned int>(bits_in_group % 8);
+    }
+
+    HURCHALLA_FORCE_INLINE static
+    U readWindow(const unsigned char* vec, unsigned int bitlen,
+                 std::size_t index)
+    {
+        std::size_t byte;
+        unsigned int shift;
+        locate(bitlen, index, byte, shift);
+        uint64_t mask = (static_cast<uint64_t>(1) << bitlen) - 1;
+        return static_cast<U>((loadLE64(vec + byte) >> shift) & mask);
+    }
+
+    HURCHALLA_FORCE_INLINE static
+    void writeWindow(unsigned char* vec, unsigned int bitlen,
+                     std::size_t index, U value)
+    {
+        HPBC_UTIL_PRECONDITION2(value <= max_allowed_value(bitlen));
+        std::size_t byte;
+        unsigned int shift;
+        locate(bitlen, index, byte, shift);
+        uint64_t mask = ((static_cast<uint64_t>(1) << bitlen) - 1) << shift;
+        uint64_t word = loadLE64(vec + byte);
+        word = (word & ~mask) | (static_cast<uint64_t>(value) << shift);
+        storeLE64(vec + byte, word);
+    }
+
+    // Calls f(BitpackedUintVectorView<U, B, is_const>(data, data_bytes,
+    // count)) for B == bitlen, and returns its result.  The dispatch is a
+    // single indirect call through a table with one entry per bit length.
+    template <bool is_const, class R, class F>
+    static R visit(unsigned int bitlen,
+                   typename std::conditional<is_const, const unsigned char,
+                                             unsigned char>::type* data,
+                   std::size_t data_bytes, std::size_t count, F& f)
+    {
+        HPBC_UTIL_PRECONDITION2(0 < bitlen && bitlen <= MAX_BITLEN);
+        return dispatch<is_const, R>(bitlen, data, data_bytes, count, f,
+                              std::make_index_sequence<MAX_BITLEN>());
+    }
+
+private:
+    template <bool is_const>
+    using Uchar = typename std::conditional<is_const, const unsigned char,
+                                            unsigned char>::type;
+
+    template <bool is_const, class R, class F, unsigned int B>
+    static R callWithView(Uchar<is_const>* data, std::size_t data_bytes,
+                          std::size_t count, F& f)
+    {
+        using View = BitpackedUintVectorView<U, B, is_const>;
+        return f(View(data, data_bytes, static_cast<typename View::size_type>(
+                                                                     count)));
+    }
+
+    template <bool is_const, class R, class F, std::size_t... I>
+    static R dispatch(unsigned int bitlen, Uchar<is_const>* data,
+                      std::size_t data_bytes, std::size_t count, F& f,
+                      std::index_sequence<I...>)
+    {
+        using Fn = R (*)(Uchar<is_const>*, std::size_t, std::size_t, F&);
+        static constexpr Fn table[] = {
+            &callWithView<is_const, R, F, static_cast<unsigned int>(I + 1)>...
+        };
+        return table[bitlen - 1](data, data_bytes, count, f);
+    }
+
+    HURCHALLA_FORCE_INLINE static uint64_t loadLE64(const unsigned char* ptr)
+    {
+#if HURCHALLA_TARGET_IS_LITTLE_ENDIAN()
+        uint64_t word;
+        std::memcpy(&word, ptr, sizeof(word));
+        return word;
+#else
+        uint64_t word = 0;
+        for (int i = 7; i >= 0; --i)
+            word = (word << 8) | ptr[i];
+        return word;
+#endif
+    }
+
+    HURCHALLA_FORCE_INLINE static void storeLE64(unsigned char* ptr,
+                                                 uint64_t word)
+    {
+#if HURCHALLA_TARGET_IS_LITTLE_ENDIAN()
+        std::memcpy(ptr, &word, sizeof(word));
+#else
+        for (int i = 0; i < 8; ++i)
+            ptr[i] = static_cast<unsigned char>(word >> (8 * i));
+#endif
+    }
+};
+
+
+}} // end namespace
+
+#endif
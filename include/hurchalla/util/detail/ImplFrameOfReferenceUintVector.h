@@ -0,0 +1,248 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#ifndef HURCHALLA_UTIL_IMPL_FRAME_OF_REFERENCE_UINT_VECTOR_H_INCLUDED
+#define HURCHALLA_UTIL_IMPL_FRAME_OF_REFERENCE_UINT_VECTOR_H_INCLUDED
+
+
+#include "hurchalla/util/detail/ImplBitpackedUintVector.h"
+#include "hurchalla/util/detail/ImplDynamicBitpackedUintVector.h"
+#include "hurchalla/util/detail/util_programming_by_contract.h"
+#include "hurchalla/util/compiler_macros.h"
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+namespace hurchalla { namespace detail {
+
+
+// Element access for frame of reference blocks.  Each block of BLOCK_SIZE
+// elements stores its elements as offsets from a base value (the block's
+// minimum), packed with the block's own bit width w, 0 <= w <= digits(U), in
+// exactly the layout of ImplBitpackedUintVector<U, w>.  Since BLOCK_SIZE is a
+// multiple of 8, a block's packed offsets are BLOCK_SIZE/8 * w bytes, and
+// every block begins on a byte boundary.
+//
+// A block header records the block's base, and its width and byte offset in
+// a single uint64_t (the width in the top 8 bits), so that a random access
+// reads the header and then the packed data.  Random access with w <= 32
+// uses ImplDynamicBitpackedUintVector's 64 bit window read, which may read up
+// to WINDOW_PAD (8) bytes past the last block, so the owner must allocate that
+// padding.  (A block with width 0 has no packed data; its window read is
+// masked to 0.)  Wider blocks and bulk reads dispatch, through a table
+// indexed by width, to the compile time specialized functions of
+// ImplBitpackedUintVector<U, w>, including its SIMD unpack kernels.
+template <typename U, std::size_t BLOCK_SIZE>
+struct ImplFrameOfReferenceUintVector {
+    static_assert(std::numeric_limits<U>::is_integer, "");
+    static_assert(!std::numeric_limits<U>::is_signed, "");
+    static_assert(std::numeric_limits<U>::digits <= 64, "");
+    static_assert(BLOCK_SIZE > 0 && BLOCK_SIZE % 8 == 0, "");
+
+    static constexpr unsigned int MAX_WIDTH =
+                          static_cast<unsigned int>(std::numeric_limits<U>::digits);
+    // A width 0 block at the end begins at the end of the packed data, and
+    // its (masked) window read covers the 8 bytes from there, so we need one
+    // more byte of padding than ImplDynamicBitpackedUintVector does.
+    static constexpr std::size_t WINDOW_PAD =
+                            ImplDynamicBitpackedUintVector<U>::WINDOW_PAD + 1;
+
+    struct BlockHeader {
+        uint64_t location;   // byte offset | (width << WIDTH_SHIFT)
+        U base;
+    };
+    static constexpr unsigned int WIDTH_SHIFT = 56;
+
+    HURCHALLA_FORCE_INLINE static unsigned int width(const BlockHeader& h)
+    {
+        return static_cast<unsigned int>(h.location >> WIDTH_SHIFT);
+    }
+    HURCHALLA_FORCE_INLINE static std::size_t offset(const BlockHeader& h)
+    {
+        return static_cast<std::size_t>(h.location &
+                    ((static_cast<uint64_t>(1) << WIDTH_SHIFT) - 1));
+    }
+
+    // returns the bytes of packed data for a block of the given width
+    HURCHALLA_FORCE_INLINE static constexpr
+    std::size_t blockBytes(unsigned int width)
+    {
+        return BLOCK_SIZE / 8 * width;
+    }
+
+    // Returns the smallest width that holds every value of in[0] to
+    // in[count-1] as an offset from their minimum, and sets base to the
+    // minimum.  count must be > 0.
+    static unsigned int chooseWidth(const U* in, std::size_t count, U& base)
+    {
+        HPBC_UTIL_PRECONDITION2(count > 0);
+        U lo = in[0];
+        U hi = in[0];
+        for (std::size_t i = 1; i < count; ++i) {
+            lo = (in[i] < lo) ? in[i] : lo;
+            hi = (in[i] > hi) ? in[i] : hi;
+        }
+        base = lo;
+        U range = static_cast<U>(hi - lo);
+        unsigned int w = 0;
+        while (range != 0) {
+            range = static_cast<U>(range >> 1);
+            ++w;
+        }
+        return w;
+    }
+
+    // Packs the BLOCK_SIZE offsets in[0] to in[BLOCK_SIZE-1] (each of which
+    // must fit in 'width' bits) into the block at 'block'.
+    static void packBlock(unsigned char* block, unsigned int width, const U* in)
+    {
+        HPBC_UTIL_PRECONDITION2(width <= MAX_WIDTH);
+        if (width != 0)
+            writeTable()[width - 1](block, in);
+    }
+
+    HURCHALLA_FORCE_INLINE static
+    U readIndex(const unsigned char* data, const BlockHeader* headers,
+                std::size_t index)
+    {
+        const BlockHeader& h = headers[index / BLOCK_SIZE];
+        unsigned int w = width(h);
+        std::size_t j = index % BLOCK_SIZE;
+        U delta;
+        if HURCHALLA_LIKELY(w <= ImplDynamicBitpackedUintVector<U>::MAX_BITLEN)
+            delta = ImplDynamicBitpackedUintVector<U>::readWindow(
+                                                  data + offset(h), w, j);
+        else
+            delta = readIndexWide(data + offset(h), w, j, HasWideWidths());
+        return static_cast<U>(h.base + delta);
+    }
+
+    // Reads the 'count' elements beginning at index 'first' into out.
+    // data_bytes is the size of the packed data (including any padding).
+    static void readRange(const unsigned char* data, std::size_t data_bytes,
+                          const BlockHeader* headers, std::size_t first,
+                          std::size_t count, U* out)
+    {
+        while (count > 0) {
+            const BlockHeader& h = headers[first / BLOCK_SIZE];
+            std::size_t j = first % BLOCK_SIZE;
+            std::size_t n = BLOCK_SIZE - j;
+            n = (count < n) ? count : n;
+            unsigned int w = width(h);
+            if (w == 0) {
+                for (std::size_t i = 0; i < n; ++i)
+                    out[i] = h.base;
+            } else {
+                std::size_t off = offset(h);
+                readRangeTable()[w - 1](data + off, data_bytes - off, j, n, out);
+                for (std::size_t i = 0; i < n; ++i)
+                    out[i] = static_cast<U>(out[i] + h.base);
+            }
+            first += n;
+            count -= n;
+            out += n;
+        }
+    }
+
+private:
+    // true if some widths are too wide for the window read
+    using HasWideWidths = std::integral_constant<bool,
+                  (MAX_WIDTH > ImplDynamicBitpackedUintVector<U>::MAX_BITLEN)>;
+
+    HURCHALLA_FORCE_INLINE static
+    U readIndexWide(const unsigned char* block, unsigned int w, std::size_t j,
+                    std::true_type)
+    {
+        HPBC_UTIL_PRECONDITION2(w <= MAX_WIDTH);
+        return readIndexTable()[w - 1](block, j);
+    }
+    // when every width fits the window read, readIndex() never gets here,
+    // and we don't instantiate the table lookup (whose index the compiler
+    // can't prove is in bounds).
+    HURCHALLA_FORCE_INLINE static
+    U readIndexWide(const unsigned char*, unsigned int, std::size_t,
+                    std::false_type)
+    {
+        HPBC_UTIL_ASSERT2(false);
+        return 0;
+    }
+
+    using WriteFn = void (*)(unsigned char*, const U*);
+    using ReadIndexFn = U (*)(const unsigned char*, std::size_t);
+    using ReadRangeFn = void (*)(const unsigned char*, std::size_t,
+                                 std::size_t, std::size_t, U*);
+
+    template <unsigned int W>
+    using Dense = ImplBitpackedUintVector<U, W>;
+
+    template <unsigned int W>
+    static void writeBlock(unsigned char* block, const U* in)
+    {
+        using Ptr = typename Dense<W>::NoAliasUchar*;
+        Dense<W>::writeRange(reinterpret_cast<Ptr>(block), 0,
+                             static_cast<typename Dense<W>::size_type>(
+                                                        BLOCK_SIZE), in);
+    }
+    template <unsigned int W>
+    static U readIndexW(const unsigned char* block, std::size_t j)
+    {
+        using Ptr = const typename Dense<W>::NoAliasUchar*;
+        return Dense<W>::readIndex(reinterpret_cast<Ptr>(block),
+                             static_cast<typename Dense<W>::size_type>(j));
+    }
+    template <unsigned int W>
+    static void readRangeW(const unsigned char* block, std::size_t avail_bytes,
+                           std::size_t first, std::size_t count, U* out)
+    {
+        using Ptr = const typename Dense<W>::NoAliasUchar*;
+        using ST = typename Dense<W>::size_type;
+        Dense<W>::readRange(reinterpret_cast<Ptr>(block), avail_bytes,
+                            static_cast<ST>(first), static_cast<ST>(count), out);
+    }
+
+    template <std::size_t... I>
+    static const WriteFn* writeTable(std::index_sequence<I...>)
+    {
+        static constexpr WriteFn table[] = {
+            &writeBlock<static_cast<unsigned int>(I + 1)>...
+        };
+        return table;
+    }
+    static const WriteFn* writeTable()
+    {
+        return writeTable(std::make_index_sequence<MAX_WIDTH>());
+    }
+
+    template <std::size_t... I>
+    static const ReadIndexFn* readIndexTable(std::index_sequence<I...>)
+    {
+        static constexpr ReadIndexFn table[] = {
+            &readIndexW<static_cast<unsigned int>(I + 1)>...
+        };
+        return table;
+    }
+    static const ReadIndexFn* readIndexTable()
+    {
+        return readIndexTable(std::make_index_sequence<MAX_WIDTH>());
+    }
+
+    template <std::size_t... I>
+    static const ReadRangeFn* readRangeTable(std::index_sequence<I...>)
+    {
+        static constexpr ReadRangeFn table[] = {
+            &readRangeW<static_cast<unsigned int>(I + 1)>...
+        };
+        return table;
+    }
+    static const ReadRangeFn* readRangeTable()
+    {
+        return readRangeTable(std::make_index_sequence<MAX_WIDTH>());
+    }
+};
+
+
+}} // end namespace
+
+#endif
@@ -0,0 +1,167 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#ifndef HURCHALLA_UTIL_IMPL_ATOMIC_BITS_H_INCLUDED
+#define HURCHALLA_UTIL_IMPL_ATOMIC_BITS_H_INCLUDED
+
+
+#include "hurchalla/util/compiler_macros.h"
+#include <cstdint>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#  include <intrin.h>
+#endif
+
+namespace hurchalla { namespace detail {
+
+
+// Atomic read-modify-write operations on a naturally aligned uint8_t,
+// uint16_t, uint32_t or uint64_t that lives inside an unsigned char buffer
+// (which is not a std::atomic object - in C++14 we have no std::atomic_ref).
+// We use the compiler's __atomic builtins (or Interlocked intrinsics for
+// MSVC), which operate on plain memory.  All operations use relaxed memory
+// ordering (MSVC's intrinsics are stronger than that).
+//
+// update() replaces the bits selected by 'mask' with those of 'bits'.  Every
+// function returns the entire previous content of the word, in native byte
+// order; a caller with little-endian packed data byte swaps the values on a
+// big-endian target.
+struct impl_atomic_bits {
+
+#if defined(_MSC_VER) && !defined(__clang__)
+    static uint64_t update(uint64_t* p, uint64_t mask, uint64_t bits)
+    {
+        volatile __int64* vp = reinterpret_cast<volatile __int64*>(p);
+        __int64 old = *vp;
+        for (;;) {
+            __int64 desired = static_cast<__int64>(
+                    (static_cast<uint64_t>(old) & ~mask) | (bits & mask));
+            __int64 seen = _InterlockedCompareExchange64(vp, desired, old);
+            if (seen == old)
+                return static_cast<uint64_t>(old);
+            old = seen;
+        }
+    }
+    static uint32_t update(uint32_t* p, uint32_t mask, uint32_t bits)
+    {
+        volatile long* vp = reinterpret_cast<volatile long*>(p);
+        long old = *vp;
+        for (;;) {
+            long desired = static_cast<long>(
+                    (static_cast<uint32_t>(old) & ~mask) | (bits & mask));
+            long seen = _InterlockedCompareExchange(vp, desired, old);
+            if (seen == old)
+                return static_cast<uint32_t>(old);
+            old = seen;
+        }
+    }
+    static uint16_t update(uint16_t* p, uint16_t mask, uint16_t bits)
+    {
+        volatile short* vp = reinterpret_cast<volatile short*>(p);
+        short old = *vp;
+        for (;;) {
+            short desired = static_cast<short>(
+                     (static_cast<uint16_t>(old) & ~mask) | (bits & mask));
+            short seen = _InterlockedCompareExchange16(vp, desired, old);
+            if (seen == old)
+                return static_cast<uint16_t>(old);
+            old = seen;
+        }
+    }
+    static uint8_t update(uint8_t* p, uint8_t mask, uint8_t bits)
+    {
+        volatile char* vp = reinterpret_cast<volatile char*>(p);
+        char old = *vp;
+        for (;;) {
+            char desired = static_cast<char>(
+                     (static_cast<uint8_t>(old) & ~mask) | (bits & mask));
+            char seen = _InterlockedCompareExchange8(vp, desired, old);
+            if (seen == old)
+                return static_cast<uint8_t>(old);
+            old = seen;
+        }
+    }
+    static uint64_t fetchOr(uint64_t* p, uint64_t bits)
+    {
+        return static_cast<uint64_t>(_InterlockedOr64(
+                 reinterpret_cast<volatile __int64*>(p),
+                 static_cast<__int64>(bits)));
+    }
+    static uint32_t fetchOr(uint32_t* p, uint32_t bits)
+    {
+        return static_cast<uint32_t>(_InterlockedOr(
+                 reinterpret_cast<volatile long*>(p), static_cast<long>(bits)));
+    }
+    static uint16_t fetchOr(uint16_t* p, uint16_t bits)
+    {
+        return static_cast<uint16_t>(_InterlockedOr16(
+                 reinterpret_cast<volatile short*>(p),
+                 static_cast<short>(bits)));
+    }
+    static uint8_t fetchOr(uint8_t* p, uint8_t bits)
+    {
+        return static_cast<uint8_t>(_InterlockedOr8(
+                 reinterpret_cast<volatile char*>(p), static_cast<char>(bits)));
+    }
+    // The loads must not write (e.g. with _InterlockedOr64(p, 0)), since the
+    // memory may be read only, such as a read only file mapping.  An aligned
+    // volatile load is a single (atomic) access, and _ReadWriteBarrier()
+    // keeps the compiler from moving other memory accesses across it.
+    static uint64_t load(const uint64_t* p)
+    {
+        uint64_t x = static_cast<uint64_t>(__iso_volatile_load64(
+                 reinterpret_cast<const volatile __int64*>(p)));
+        _ReadWriteBarrier();
+        return x;
+    }
+    static uint32_t load(const uint32_t* p)
+    {
+        uint32_t x = static_cast<uint32_t>(__iso_volatile_load32(
+                 reinterpret_cast<const volatile __int32*>(p)));
+        _ReadWriteBarrier();
+        return x;
+    }
+    static uint16_t load(const uint16_t* p)
+    {
+        uint16_t x = static_cast<uint16_t>(__iso_volatile_load16(
+                 reinterpret_cast<const volatile __int16*>(p)));
+        _ReadWriteBarrier();
+        return x;
+    }
+    static uint8_t load(const uint8_t* p)
+    {
+        uint8_t x = static_cast<uint8_t>(__iso_volatile_load8(
+                 reinterpret_cast<const volatile __int8*>(p)));
+        _ReadWriteBarrier();
+        return x;
+    }
+#else
+    template <typename T>
+    HURCHALLA_FORCE_INLINE static T update(T* p, T mask, T bits)
+    {
+        T old = __atomic_load_n(p, __ATOMIC_RELAXED);
+        T desired;
+        do {
+            desired = static_cast<T>((old & static_cast<T>(~mask)) |
+                                     (bits & mask));
+        } while (!__atomic_compare_exchange_n(p, &old, desired, true,
+                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+        return old;
+    }
+    template <typename T>
+    HURCHALLA_FORCE_INLINE static T fetchOr(T* p, T bits)
+    {
+        return __atomic_fetch_or(p, bits, __ATOMIC_RELAXED);
+    }
+    template <typename T>
+    HURCHALLA_FORCE_INLINE static T load(const T* p)
+    {
+        return __atomic_load_n(p, __ATOMIC_RELAXED);
+    }
+#endif
+};
+
+
+}} // end namespace
+
+#endif
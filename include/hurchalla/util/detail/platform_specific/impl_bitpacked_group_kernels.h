@@ -0,0 +1,657 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#ifndef HURCHALLA_UTIL_IMPL_BITPACKED_GROUP_KERNELS_H_INCLUDED
+#define HURCHALLA_UTIL_IMPL_BITPACKED_GROUP_KERNELS_H_INCLUDED
+
+// note: in order to get the SIMD versions of these kernels, you must define
+// HURCHALLA_ALLOW_SIMD_BITPACKED_UINT_VECTOR or HURCHALLA_ALLOW_SIMD_ALL, and
+// you must compile for an ISA extension that the kernels support (for
+// example, with gcc or clang, -mavx2 or -march=native).  The kernel that is
+// used is chosen at compile time, in this order of preference:
+//   x86: AVX-512 VBMI (requires __AVX512VBMI__ and __AVX512BW__),
+//        then AVX2 (__AVX2__), then SSE4.1 (__SSE4_1__)
+//   ARM64: NEON (__ARM_NEON)
+// All of these have unpack kernels (used by getRange()), but only AVX-512
+// VBMI has a pack kernel (used by setRange()).  Whenever a kernel is missing,
+// or if the opt-in macro is not defined, ImplBitpackedUintVector uses only its
+// scalar group functions.  All kernels produce output identical to the scalar
+// functions.
+
+
+#include "hurchalla/util/compiler_macros.h"
+#include "hurchalla/util/Unroll.h"
+#include "hurchalla/util/detail/util_programming_by_contract.h"
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+#if (defined(HURCHALLA_ALLOW_SIMD_BITPACKED_UINT_VECTOR) || \
+     defined(HURCHALLA_ALLOW_SIMD_ALL))
+#  if (defined(HURCHALLA_TARGET_ISA_X86_64) || \
+       defined(HURCHALLA_TARGET_ISA_X86_32))
+#    if defined(__AVX512VBMI__) && defined(__AVX512BW__)
+#      define HURCHALLA_BITPACKED_KERNELS_AVX512VBMI 1
+#      include <immintrin.h>
+#    elif defined(__AVX2__)
+#      define HURCHALLA_BITPACKED_KERNELS_AVX2 1
+#      include <immintrin.h>
+#    elif defined(__SSE4_1__)
+#      define HURCHALLA_BITPACKED_KERNELS_SSE4_1 1
+#      include <smmintrin.h>
+#    endif
+#  elif defined(HURCHALLA_TARGET_ISA_ARM_64) && defined(__ARM_NEON)
+#    define HURCHALLA_BITPACKED_KERNELS_NEON 1
+#    include <arm_neon.h>
+#  endif
+#endif
+
+#if defined(_MSC_VER)
+#  pragma warning(push)
+#  pragma warning(disable : 4127)
+#endif
+
+namespace hurchalla { namespace detail {
+
+
+// A "group" is 8 consecutive elements of a BitpackedUintVector, beginning at
+// an index that is a multiple of 8.  A group begins on a byte boundary and
+// occupies exactly element_bitlen bytes.  See ImplBitpackedUintVector.h.
+//
+// All kernels here work with 32 bit lanes: each element is extracted from
+// (or deposited into) a 4 byte window that begins at the element's starting
+// byte.  This requires that bit_offset + element_bitlen <= 32 for every
+// element of a group, which holds for every element_bitlen <= 32 except for
+// 27, 29, 30, and 31.  Those four widths always use the scalar code.
+template <unsigned int element_bitlen>
+struct bitpacked_group_layout {
+    static constexpr unsigned int GROUP_SIZE = 8;
+
+    // the byte (relative to the start of the group) where element j begins
+    static constexpr unsigned int byte(unsigned int j)
+    {
+        return (j * element_bitlen) / 8;
+    }
+    // the bit_offset of element j within its starting byte
+    static constexpr unsigned int offset(unsigned int j)
+    {
+        return (j * element_bitlen) % 8;
+    }
+
+    static constexpr bool fits_in_32bit_lanes()
+    {
+        for (unsigned int j = 0; j < GROUP_SIZE; ++j) {
+            if (offset(j) + element_bitlen > 32)
+                return false;
+        }
+        return true;
+    }
+
+    // Each byte of a group can receive bits from more than one element.  This
+    // is the greatest number of elements that any single byte receives.
+    static constexpr unsigned int max_elements_per_byte()
+    {
+        unsigned int result = 0;
+        for (unsigned int k = 0; k < element_bitlen; ++k) {
+            unsigned int count = 0;
+            for (unsigned int j = 0; j < GROUP_SIZE; ++j) {
+                if (j * element_bitlen < 8 * (k + 1) &&
+                                    8 * k < (j + 1) * element_bitlen)
+                    ++count;
+            }
+            if (count > result)
+                result = count;
+        }
+        return result;
+    }
+
+    // When packing, this finds the t-th (counting from 0) element whose bits
+    // reach byte k of a group.  Returns false if there is no such element.
+    // Otherwise sets j to that element, and sets q to the byte of the 32 bit
+    // lane (after the lane has been shifted left by offset(j)) that holds the
+    // element's bits for byte k.
+    static constexpr bool contributor(unsigned int k, unsigned int t,
+                                      unsigned int& j, unsigned int& q)
+    {
+        for (unsigned int e = 0; e < GROUP_SIZE; ++e) {
+            if (e * element_bitlen < 8 * (k + 1) &&
+                                    8 * k < (e + 1) * element_bitlen) {
+                if (t == 0) {
+                    j = e;
+                    q = k - byte(e);
+                    return true;
+                }
+                --t;
+            }
+        }
+        return false;
+    }
+};
+
+
+// Casts through void* (avoiding -Wcast-align warnings) to get a pointer for a
+// SIMD load or store.  Unaligned loads and stores are fine with this pointer;
+// aligned loads and stores are only used with the alignas(64) tables below.
+template <typename V, typename T>
+HURCHALLA_FORCE_INLINE V* simd_ptr(T* ptr)
+{
+    return static_cast<V*>(static_cast<void*>(ptr));
+}
+template <typename V, typename T>
+HURCHALLA_FORCE_INLINE const V* simd_ptr(const T* ptr)
+{
+    return static_cast<const V*>(static_cast<const void*>(ptr));
+}
+
+
+template <std::size_t N>
+struct bitpacked_byte_table {
+    alignas(64) std::uint8_t v[N];
+};
+template <std::size_t N>
+struct bitpacked_u32_table {
+    alignas(64) std::uint32_t v[N];
+};
+
+
+// Primary templates - these do nothing, and so the caller's scalar code
+// processes all the groups.
+//
+// call() unpacks (or packs) some number of leading groups from the
+// num_groups groups that begin at src (or dest), and returns how many groups
+// it processed.  The caller must ensure that read_bytes bytes are readable
+// beginning at the start of each of the num_groups groups.  Pack kernels
+// write only the bytes of the groups they process.
+template <typename U, unsigned int element_bitlen, class Enable = void>
+struct impl_unpack_bitpacked_groups {
+    static constexpr std::size_t read_bytes = 0;
+    template <typename P>
+    HURCHALLA_FORCE_INLINE static std::size_t call(P, std::size_t, U*)
+    {
+        return 0;
+    }
+};
+template <typename U, unsigned int element_bitlen, class Enable = void>
+struct impl_pack_bitpacked_groups {
+    template <typename P>
+    HURCHALLA_FORCE_INLINE static std::size_t call(P, std::size_t, const U*)
+    {
+        return 0;
+    }
+};
+
+
+// True if the SIMD kernels (when they exist) support U and element_bitlen.
+template <typename U, unsigned int element_bitlen>
+struct bitpacked_kernels_supported {
+    static constexpr bool value = std::is_unsigned<U>::value &&
+            (sizeof(U) == 1 || sizeof(U) == 2 || sizeof(U) == 4 ||
+             sizeof(U) == 8) &&
+            element_bitlen <= 32 &&
+            bitpacked_group_layout<element_bitlen>::fits_in_32bit_lanes();
+};
+
+
+
+
+#if defined(HURCHALLA_BITPACKED_KERNELS_AVX512VBMI)
+
+// ------------------------------ AVX-512 VBMI --------------------------------
+// Each 512 bit register holds 16 elements (two groups) in 32 bit lanes.  The
+// two groups occupy 2*element_bitlen <= 64 bytes, so a single byte-masked load
+// (or store) covers them exactly, and vpermb can move any byte to any lane.
+//
+// gcc 12's unmasked 512 bit intrinsics (the ones that pass an undefined
+// vector as their merge source) can trigger a spurious -Wmaybe-uninitialized
+// inside its own headers.  We use the zero-masking forms with an all-ones
+// mask, which compile to the same instructions.
+
+constexpr __mmask16 avx512_all16 = 0xFFFF;
+constexpr __mmask64 avx512_all64 = ~static_cast<__mmask64>(0);
+
+template <std::size_t SIZE> struct avx512_u32_lanes;
+template <> struct avx512_u32_lanes<1> {
+    template <typename U> HURCHALLA_FORCE_INLINE static void store(U* out, __m512i v)
+    { _mm_storeu_si128(simd_ptr<__m128i>(out), _mm512_maskz_cvtepi32_epi8(avx512_all16, v)); }
+    template <typename U> HURCHALLA_FORCE_INLINE static __m512i load(const U* in)
+    { return _mm512_maskz_cvtepu8_epi32(avx512_all16, _mm_loadu_si128(simd_ptr<__m128i>(in))); }
+};
+template <> struct avx512_u32_lanes<2> {
+    template <typename U> HURCHALLA_FORCE_INLINE static void store(U* out, __m512i v)
+    { _mm256_storeu_si256(simd_ptr<__m256i>(out), _mm512_maskz_cvtepi32_epi16(avx512_all16, v)); }
+    template <typename U> HURCHALLA_FORCE_INLINE static __m512i load(const U* in)
+    { return _mm512_maskz_cvtepu16_epi32(avx512_all16, _mm256_loadu_si256(simd_ptr<__m256i>(in))); }
+};
+template <> struct avx512_u32_lanes<4> {
+    template <typename U> HURCHALLA_FORCE_INLINE static void store(U* out, __m512i v)
+    { _mm512_storeu_si512(out, v); }
+    template <typename U> HURCHALLA_FORCE_INLINE static __m512i load(const U* in)
+    { return _mm512_loadu_si512(in); }
+};
+template <> struct avx512_u32_lanes<8> {
+    template <typename U> HURCHALLA_FORCE_INLINE static void store(U* out, __m512i v)
+    {
+        const __mmask8 all8 = 0xFF;
+        const __mmask8 all4 = 0xF;
+        _mm512_storeu_si512(out, _mm512_maskz_cvtepu32_epi64(all8,
+                                   _mm512_maskz_extracti64x4_epi64(all4, v, 0)));
+        _mm512_storeu_si512(out + 8, _mm512_maskz_cvtepu32_epi64(all8,
+                                   _mm512_maskz_extracti64x4_epi64(all4, v, 1)));
+    }
+    template <typename U> HURCHALLA_FORCE_INLINE static __m512i load(const U* in)
+    {
+        // gather the low 32 bits of each 64 bit element
+        const __m512i even = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14,
+                                        16, 18, 20, 22, 24, 26, 28, 30);
+        return _mm512_maskz_permutex2var_epi32(avx512_all16,
+                   _mm512_loadu_si512(in), even, _mm512_loadu_si512(in + 8));
+    }
+};
+
+template <unsigned int element_bitlen>
+struct avx512vbmi_bitpacked_tables {
+    using L = bitpacked_group_layout<element_bitlen>;
+    static constexpr unsigned int T = L::max_elements_per_byte();
+
+    // for lane j of 16 (two groups), the bytes of its 4 byte window
+    static constexpr bitpacked_byte_table<64> unpack_index()
+    {
+        bitpacked_byte_table<64> t{};
+        for (unsigned int j = 0; j < 16; ++j)
+            for (unsigned int k = 0; k < 4; ++k) {
+                unsigned int b = (j/8)*element_bitlen + L::byte(j%8) + k;
+                t.v[4*j + k] = static_cast<std::uint8_t>(b < 64 ? b : 63);
+            }
+        return t;
+    }
+    static constexpr bitpacked_u32_table<16> offsets()
+    {
+        bitpacked_u32_table<16> t{};
+        for (unsigned int j = 0; j < 16; ++j)
+            t.v[j] = L::offset(j%8);
+        return t;
+    }
+    // for output byte k of two groups, the t-th contributing lane byte
+    static constexpr bitpacked_byte_table<64> pack_index(unsigned int t)
+    {
+        bitpacked_byte_table<64> tbl{};
+        for (unsigned int k = 0; k < 2*element_bitlen; ++k) {
+            unsigned int j = 0, q = 0;
+            if (L::contributor(k % element_bitlen, t, j, q))
+                tbl.v[k] = static_cast<std::uint8_t>(
+                                4*(j + 8*(k/element_bitlen)) + q);
+        }
+        return tbl;
+    }
+    static constexpr std::uint64_t pack_mask(unsigned int t)
+    {
+        std::uint64_t mask = 0;
+        for (unsigned int k = 0; k < 2*element_bitlen; ++k) {
+            unsigned int j = 0, q = 0;
+            if (L::contributor(k % element_bitlen, t, j, q))
+                mask |= static_cast<std::uint64_t>(1) << k;
+        }
+        return mask;
+    }
+    static constexpr __mmask64 byte_mask()
+    {
+        return (2*element_bitlen == 64) ? ~static_cast<__mmask64>(0) :
+               (static_cast<__mmask64>(1) << (2*element_bitlen)) - 1;
+    }
+};
+
+template <typename U, unsigned int element_bitlen>
+struct impl_unpack_bitpacked_groups<U, element_bitlen, typename std::enable_if<
+              bitpacked_kernels_supported<U, element_bitlen>::value>::type> {
+    // the masked loads never read outside of the groups
+    static constexpr std::size_t read_bytes = element_bitlen;
+
+    template <typename P>
+    HURCHALLA_FORCE_INLINE static std::size_t call(P src, std::size_t num_groups, U* out)
+    {
+        using TB = avx512vbmi_bitpacked_tables<element_bitlen>;
+        static constexpr bitpacked_byte_table<64> idx_tbl = TB::unpack_index();
+        static constexpr bitpacked_u32_table<16> off_tbl = TB::offsets();
+        constexpr std::uint32_t maskval = static_cast<std::uint32_t>(
+                              (static_cast<std::uint64_t>(1) << element_bitlen) - 1);
+        const __m512i idx = _mm512_load_si512(idx_tbl.v);
+        const __m512i off = _mm512_load_si512(off_tbl.v);
+        const __m512i mask = _mm512_set1_epi32(static_cast<int>(maskval));
+        constexpr __mmask64 bmask = TB::byte_mask();
+
+        std::size_t num_pairs = num_groups / 2;
+        for (std::size_t i = 0; i < num_pairs; ++i) {
+            __m512i data = _mm512_maskz_loadu_epi8(bmask, src);
+            __m512i v = _mm512_maskz_permutexvar_epi8(avx512_all64, idx, data);
+            v = _mm512_and_si512(_mm512_maskz_srlv_epi32(avx512_all16, v, off),
+                                 mask);
+            avx512_u32_lanes<sizeof(U)>::store(out, v);
+            src += 2*element_bitlen;
+            out += 16;
+        }
+        return 2*num_pairs;
+    }
+};
+
+template <typename U, unsigned int element_bitlen>
+struct impl_pack_bitpacked_groups<U, element_bitlen, typename std::enable_if<
+              bitpacked_kernels_supported<U, element_bitlen>::value>::type> {
+    template <typename P>
+    HURCHALLA_FORCE_INLINE static std::size_t call(P dest, std::size_t num_groups, const U* in)
+    {
+        using TB = avx512vbmi_bitpacked_tables<element_bitlen>;
+        constexpr unsigned int T = TB::T;
+        static constexpr bitpacked_u32_table<16> off_tbl = TB::offsets();
+        static constexpr bitpacked_byte_table<64> idx_tbl[] = {
+            TB::pack_index(0), TB::pack_index(1), TB::pack_index(2),
+            TB::pack_index(3), TB::pack_index(4), TB::pack_index(5),
+            TB::pack_index(6), TB::pack_index(7), TB::pack_index(8) };
+        static_assert(T <= sizeof(idx_tbl)/sizeof(idx_tbl[0]), "");
+        const __m512i off = _mm512_load_si512(off_tbl.v);
+        constexpr __mmask64 bmask = TB::byte_mask();
+
+        __m512i idx[T];
+        __mmask64 kmask[T];
+        Unroll<T>::call([&](std::size_t t) HURCHALLA_INLINE_LAMBDA {
+            idx[t] = _mm512_load_si512(idx_tbl[t].v);
+            kmask[t] = TB::pack_mask(static_cast<unsigned int>(t));
+        });
+
+        std::size_t num_pairs = num_groups / 2;
+        for (std::size_t i = 0; i < num_pairs; ++i) {
+            __m512i v = avx512_u32_lanes<sizeof(U)>::load(in);
+            v = _mm512_maskz_sllv_epi32(avx512_all16, v, off);
+            __m512i result = _mm512_setzero_si512();
+            Unroll<T>::call([&](std::size_t t) HURCHALLA_INLINE_LAMBDA {
+                result = _mm512_or_si512(result,
+                           _mm512_maskz_permutexvar_epi8(kmask[t], idx[t], v));
+            });
+            _mm512_mask_storeu_epi8(dest, bmask, result);
+            dest += 2*element_bitlen;
+            in += 16;
+        }
+        return 2*num_pairs;
+    }
+};
+
+
+#elif defined(HURCHALLA_BITPACKED_KERNELS_AVX2)
+
+// ---------------------------------- AVX2 ------------------------------------
+// Each 256 bit register holds one group in 32 bit lanes.  Since vpshufb can't
+// move bytes between the two 128 bit halves of the register, the low half
+// gets elements 0-3 (loaded from the start of the group), and the high half
+// gets elements 4-7 (loaded from the byte where element 4 begins).
+// There is no AVX2 pack kernel: without byte-masked stores, writing exactly
+// element_bitlen bytes per group made it slower than the scalar packGroup().
+
+template <std::size_t SIZE> struct avx2_u32_lanes;
+template <> struct avx2_u32_lanes<1> {
+    template <typename U> HURCHALLA_FORCE_INLINE static void store(U* out, __m256i v)
+    {
+        __m128i w = _mm_packus_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+        _mm_storel_epi64(simd_ptr<__m128i>(out), _mm_packus_epi16(w, w));
+    }
+};
+template <> struct avx2_u32_lanes<2> {
+    template <typename U> HURCHALLA_FORCE_INLINE static void store(U* out, __m256i v)
+    {
+        __m128i w = _mm_packus_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+        _mm_storeu_si128(simd_ptr<__m128i>(out), w);
+    }
+};
+template <> struct avx2_u32_lanes<4> {
+    template <typename U> HURCHALLA_FORCE_INLINE static void store(U* out, __m256i v)
+    { _mm256_storeu_si256(simd_ptr<__m256i>(out), v); }
+};
+template <> struct avx2_u32_lanes<8> {
+    template <typename U> HURCHALLA_FORCE_INLINE static void store(U* out, __m256i v)
+    {
+        _mm256_storeu_si256(simd_ptr<__m256i>(out), _mm256_cvtepu32_epi64(_mm256_castsi256_si128(v)));
+        _mm256_storeu_si256(simd_ptr<__m256i>(out + 4), _mm256_cvtepu32_epi64(_mm256_extracti128_si256(v, 1)));
+    }
+};
+
+template <unsigned int element_bitlen>
+struct avx2_bitpacked_tables {
+    using L = bitpacked_group_layout<element_bitlen>;
+    static constexpr unsigned int HIGH_BASE = L::byte(4);
+
+    static constexpr bitpacked_byte_table<32> unpack_shuffle()
+    {
+        bitpacked_byte_table<32> t{};
+        for (unsigned int j = 0; j < 8; ++j)
+            for (unsigned int k = 0; k < 4; ++k)
+                t.v[4*j + k] = static_cast<std::uint8_t>(
+                                L::byte(j) - ((j < 4) ? 0 : HIGH_BASE) + k);
+        return t;
+    }
+    static constexpr bitpacked_u32_table<8> offsets()
+    {
+        bitpacked_u32_table<8> t{};
+        for (unsigned int j = 0; j < 8; ++j)
+            t.v[j] = L::offset(j);
+        return t;
+    }
+};
+
+template <typename U, unsigned int element_bitlen>
+struct impl_unpack_bitpacked_groups<U, element_bitlen, typename std::enable_if<
+              bitpacked_kernels_supported<U, element_bitlen>::value>::type> {
+    using TB = avx2_bitpacked_tables<element_bitlen>;
+    static constexpr std::size_t read_bytes = TB::HIGH_BASE + 16;
+
+    template <typename P>
+    HURCHALLA_FORCE_INLINE static std::size_t call(P src, std::size_t num_groups, U* out)
+    {
+        static constexpr bitpacked_byte_table<32> shuf_tbl = TB::unpack_shuffle();
+        static constexpr bitpacked_u32_table<8> off_tbl = TB::offsets();
+        constexpr std::uint32_t maskval = static_cast<std::uint32_t>(
+                              (static_cast<std::uint64_t>(1) << element_bitlen) - 1);
+        const __m256i shuf = _mm256_load_si256(simd_ptr<__m256i>(shuf_tbl.v));
+        const __m256i off = _mm256_load_si256(simd_ptr<__m256i>(off_tbl.v));
+        const __m256i mask = _mm256_set1_epi32(static_cast<int>(maskval));
+
+        for (std::size_t i = 0; i < num_groups; ++i) {
+            __m128i lo = _mm_loadu_si128(simd_ptr<__m128i>(&src[0]));
+            __m128i hi = _mm_loadu_si128(simd_ptr<__m128i>(&src[TB::HIGH_BASE]));
+            __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+            v = _mm256_shuffle_epi8(v, shuf);
+            v = _mm256_and_si256(_mm256_srlv_epi32(v, off), mask);
+            avx2_u32_lanes<sizeof(U)>::store(out, v);
+            src += element_bitlen;
+            out += 8;
+        }
+        return num_groups;
+    }
+};
+
+
+#elif defined(HURCHALLA_BITPACKED_KERNELS_SSE4_1) || \
+      defined(HURCHALLA_BITPACKED_KERNELS_NEON)
+
+// ------------------------------ SSE4.1 / NEON -------------------------------
+// Each 128 bit register holds half a group (4 elements) in 32 bit lanes.  The
+// first half is loaded from the start of the group, and the second half from
+// the byte where element 4 begins.  There are no pack kernels for these ISAs
+// (see the AVX2 comment above).
+
+template <unsigned int element_bitlen>
+struct sse_neon_bitpacked_tables {
+    using L = bitpacked_group_layout<element_bitlen>;
+    static constexpr unsigned int HIGH_BASE = L::byte(4);
+
+    static constexpr bitpacked_byte_table<16> unpack_shuffle(unsigned int half)
+    {
+        bitpacked_byte_table<16> t{};
+        for (unsigned int i = 0; i < 4; ++i)
+            for (unsigned int k = 0; k < 4; ++k)
+                t.v[4*i + k] = static_cast<std::uint8_t>(
+                         L::byte(4*half + i) - ((half == 0) ? 0 : HIGH_BASE) + k);
+        return t;
+    }
+    // SSE4.1 has no variable shift, so for SSE we instead multiply each lane
+    // by 2^(32 - offset - element_bitlen) to move the element to the top of
+    // its lane, and then shift right by the constant (32 - element_bitlen).
+    static constexpr bitpacked_u32_table<4> multipliers(unsigned int half)
+    {
+        bitpacked_u32_table<4> t{};
+        for (unsigned int i = 0; i < 4; ++i)
+            t.v[i] = static_cast<std::uint32_t>(1) <<
+                           (32 - L::offset(4*half + i) - element_bitlen);
+        return t;
+    }
+    // NEON's vshlq_u32 shifts right when given a negative shift count
+    static constexpr bitpacked_u32_table<4> neg_offsets(unsigned int half)
+    {
+        bitpacked_u32_table<4> t{};
+        for (unsigned int i = 0; i < 4; ++i)
+            t.v[i] = static_cast<std::uint32_t>(0) - L::offset(4*half + i);
+        return t;
+    }
+};
+
+# if defined(HURCHALLA_BITPACKED_KERNELS_SSE4_1)
+
+template <std::size_t SIZE> struct sse_u32_lanes;
+template <> struct sse_u32_lanes<1> {
+    template <typename U> HURCHALLA_FORCE_INLINE static void store(U* out, __m128i v)
+    {
+        __m128i w = _mm_packus_epi32(v, v);
+        std::uint32_t x = static_cast<std::uint32_t>(_mm_cvtsi128_si32(_mm_packus_epi16(w, w)));
+        std::memcpy(out, &x, sizeof(x));
+    }
+};
+template <> struct sse_u32_lanes<2> {
+    template <typename U> HURCHALLA_FORCE_INLINE static void store(U* out, __m128i v)
+    { _mm_storel_epi64(simd_ptr<__m128i>(out), _mm_packus_epi32(v, v)); }
+};
+template <> struct sse_u32_lanes<4> {
+    template <typename U> HURCHALLA_FORCE_INLINE static void store(U* out, __m128i v)
+    { _mm_storeu_si128(simd_ptr<__m128i>(out), v); }
+};
+template <> struct sse_u32_lanes<8> {
+    template <typename U> HURCHALLA_FORCE_INLINE static void store(U* out, __m128i v)
+    {
+        _mm_storeu_si128(simd_ptr<__m128i>(out), _mm_cvtepu32_epi64(v));
+        _mm_storeu_si128(simd_ptr<__m128i>(out + 2), _mm_cvtepu32_epi64(_mm_srli_si128(v, 8)));
+    }
+};
+
+template <typename U, unsigned int element_bitlen>
+struct impl_unpack_bitpacked_groups<U, element_bitlen, typename std::enable_if<
+              bitpacked_kernels_supported<U, element_bitlen>::value>::type> {
+    using TB = sse_neon_bitpacked_tables<element_bitlen>;
+    static constexpr std::size_t read_bytes = TB::HIGH_BASE + 16;
+
+    template <typename P>
+    HURCHALLA_FORCE_INLINE static std::size_t call(P src, std::size_t num_groups, U* out)
+    {
+        static constexpr bitpacked_byte_table<16> shuf_tbl[2] = {
+                             TB::unpack_shuffle(0), TB::unpack_shuffle(1) };
+        static constexpr bitpacked_u32_table<4> mul_tbl[2] = {
+                             TB::multipliers(0), TB::multipliers(1) };
+        const __m128i shuf0 = _mm_load_si128(simd_ptr<__m128i>(shuf_tbl[0].v));
+        const __m128i shuf1 = _mm_load_si128(simd_ptr<__m128i>(shuf_tbl[1].v));
+        const __m128i mul0 = _mm_load_si128(simd_ptr<__m128i>(mul_tbl[0].v));
+        const __m128i mul1 = _mm_load_si128(simd_ptr<__m128i>(mul_tbl[1].v));
+        constexpr int rshift = 32 - static_cast<int>(element_bitlen);
+
+        for (std::size_t i = 0; i < num_groups; ++i) {
+            __m128i lo = _mm_loadu_si128(simd_ptr<__m128i>(&src[0]));
+            __m128i hi = _mm_loadu_si128(simd_ptr<__m128i>(&src[TB::HIGH_BASE]));
+            lo = _mm_srli_epi32(_mm_mullo_epi32(_mm_shuffle_epi8(lo, shuf0), mul0), rshift);
+            hi = _mm_srli_epi32(_mm_mullo_epi32(_mm_shuffle_epi8(hi, shuf1), mul1), rshift);
+            sse_u32_lanes<sizeof(U)>::store(out, lo);
+            sse_u32_lanes<sizeof(U)>::store(out + 4, hi);
+            src += element_bitlen;
+            out += 8;
+        }
+        return num_groups;
+    }
+};
+
+# else   // NEON
+
+template <std::size_t SIZE> struct neon_u32_lanes;
+template <> struct neon_u32_lanes<1> {
+    template <typename U> HURCHALLA_FORCE_INLINE static void store(U* out, uint32x4_t v)
+    {
+        uint16x4_t w = vmovn_u32(v);
+        uint8x8_t b = vmovn_u16(vcombine_u16(w, w));
+        std::uint32_t x = vget_lane_u32(vreinterpret_u32_u8(b), 0);
+        std::memcpy(out, &x, sizeof(x));
+    }
+};
+template <> struct neon_u32_lanes<2> {
+    template <typename U> HURCHALLA_FORCE_INLINE static void store(U* out, uint32x4_t v)
+    { vst1_u16(simd_ptr<std::uint16_t>(out), vmovn_u32(v)); }
+};
+template <> struct neon_u32_lanes<4> {
+    template <typename U> HURCHALLA_FORCE_INLINE static void store(U* out, uint32x4_t v)
+    { vst1q_u32(simd_ptr<std::uint32_t>(out), v); }
+};
+template <> struct neon_u32_lanes<8> {
+    template <typename U> HURCHALLA_FORCE_INLINE static void store(U* out, uint32x4_t v)
+    {
+        vst1q_u64(simd_ptr<std::uint64_t>(out), vmovl_u32(vget_low_u32(v)));
+        vst1q_u64(simd_ptr<std::uint64_t>(out + 2), vmovl_u32(vget_high_u32(v)));
+    }
+};
+
+template <typename U, unsigned int element_bitlen>
+struct impl_unpack_bitpacked_groups<U, element_bitlen, typename std::enable_if<
+              bitpacked_kernels_supported<U, element_bitlen>::value>::type> {
+    using TB = sse_neon_bitpacked_tables<element_bitlen>;
+    static constexpr std::size_t read_bytes = TB::HIGH_BASE + 16;
+
+    template <typename P>
+    HURCHALLA_FORCE_INLINE static std::size_t call(P src, std::size_t num_groups, U* out)
+    {
+        static constexpr bitpacked_byte_table<16> shuf_tbl[2] = {
+                             TB::unpack_shuffle(0), TB::unpack_shuffle(1) };
+        static constexpr bitpacked_u32_table<4> shift_tbl[2] = {
+                             TB::neg_offsets(0), TB::neg_offsets(1) };
+        const uint8x16_t shuf0 = vld1q_u8(shuf_tbl[0].v);
+        const uint8x16_t shuf1 = vld1q_u8(shuf_tbl[1].v);
+        const int32x4_t shift0 = vreinterpretq_s32_u32(vld1q_u32(shift_tbl[0].v));
+        const int32x4_t shift1 = vreinterpretq_s32_u32(vld1q_u32(shift_tbl[1].v));
+        constexpr std::uint32_t maskval = static_cast<std::uint32_t>(
+                              (static_cast<std::uint64_t>(1) << element_bitlen) - 1);
+        const uint32x4_t mask = vdupq_n_u32(maskval);
+
+        for (std::size_t i = 0; i < num_groups; ++i) {
+            uint8x16_t lo = vld1q_u8(simd_ptr<std::uint8_t>(&src[0]));
+            uint8x16_t hi = vld1q_u8(simd_ptr<std::uint8_t>(&src[TB::HIGH_BASE]));
+            uint32x4_t vlo = vreinterpretq_u32_u8(vqtbl1q_u8(lo, shuf0));
+            uint32x4_t vhi = vreinterpretq_u32_u8(vqtbl1q_u8(hi, shuf1));
+            vlo = vandq_u32(vshlq_u32(vlo, shift0), mask);
+            vhi = vandq_u32(vshlq_u32(vhi, shift1), mask);
+            neon_u32_lanes<sizeof(U)>::store(out, vlo);
+            neon_u32_lanes<sizeof(U)>::store(out + 4, vhi);
+            src += element_bitlen;
+            out += 8;
+        }
+        return num_groups;
+    }
+};
+
+# endif
+
+#endif
+
+
+}} // end namespace
+
+
+#undef HURCHALLA_BITPACKED_KERNELS_AVX512VBMI
+#undef HURCHALLA_BITPACKED_KERNELS_AVX2
+#undef HURCHALLA_BITPACKED_KERNELS_SSE4_1
+#undef HURCHALLA_BITPACKED_KERNELS_NEON
+
+#if defined(_MSC_VER)
+#  pragma warning(pop)
+#endif
+
+#endif
@@ -0,0 +1,114 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#ifndef HURCHALLA_UTIL_IMPL_CRC32C_H_INCLUDED
+#define HURCHALLA_UTIL_IMPL_CRC32C_H_INCLUDED
+
+
+#include "hurchalla/util/compiler_macros.h"
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#if defined(__SSE4_2__) || (defined(_MSC_VER) && defined(__AVX__) && \
+                       (defined(_M_X64) || defined(_M_IX86)))
+#  include <nmmintrin.h>
+#  define HURCHALLA_UTIL_CRC32C_X86 1
+#elif defined(__ARM_FEATURE_CRC32)
+#  include <arm_acle.h>
+#  define HURCHALLA_UTIL_CRC32C_ARM 1
+#endif
+
+namespace hurchalla { namespace detail {
+
+
+// CRC-32C (the Castagnoli polynomial, as used by iSCSI, ext4, etc).  call()
+// continues a CRC in the same way as zlib's crc32(): start with crc = 0, and
+// pass each result back in for the next piece of the data.  The result is
+// the same as for a single call over all of the data.
+//
+// If the compiler targets x86 with SSE 4.2 (or ARM with the CRC extension),
+// this uses the CPU's crc32c instructions, at several bytes per cycle.
+// Otherwise it uses table driven slicing-by-8, at roughly a byte per cycle.
+struct impl_crc32c {
+    static uint32_t call(uint32_t crc, const unsigned char* data,
+                         std::size_t len)
+    {
+        uint32_t c = ~crc;
+#if defined(HURCHALLA_UTIL_CRC32C_X86)
+#  if defined(__x86_64__) || defined(_M_X64)
+        uint64_t c64 = c;
+        for (; len >= 8; len -= 8, data += 8) {
+            uint64_t word;
+            std::memcpy(&word, data, sizeof(word));
+            c64 = _mm_crc32_u64(c64, word);
+        }
+        c = static_cast<uint32_t>(c64);
+#  else
+        for (; len >= 4; len -= 4, data += 4) {
+            uint32_t word;
+            std::memcpy(&word, data, sizeof(word));
+            c = _mm_crc32_u32(c, word);
+        }
+#  endif
+        for (; len > 0; --len)
+            c = _mm_crc32_u8(c, *data++);
+#elif defined(HURCHALLA_UTIL_CRC32C_ARM)
+        for (; len >= 8; len -= 8, data += 8) {
+            uint64_t word;
+            std::memcpy(&word, data, sizeof(word));
+            c = __crc32cd(c, word);
+        }
+        for (; len > 0; --len)
+            c = __crc32cb(c, *data++);
+#else
+        const Table& t = table();
+        for (; len >= 8; len -= 8, data += 8) {
+            uint32_t lo = c ^ (static_cast<uint32_t>(data[0]) |
+                               static_cast<uint32_t>(data[1]) << 8 |
+                               static_cast<uint32_t>(data[2]) << 16 |
+                               static_cast<uint32_t>(data[3]) << 24);
+            c = t.t[7][lo & 0xFF] ^ t.t[6][(lo >> 8) & 0xFF] ^
+                t.t[5][(lo >> 16) & 0xFF] ^ t.t[4][lo >> 24] ^
+                t.t[3][data[4]] ^ t.t[2][data[5]] ^
+                t.t[1][data[6]] ^ t.t[0][data[7]];
+        }
+        for (; len > 0; --len)
+            c = t.t[0][(c ^ *data++) & 0xFF] ^ (c >> 8);
+#endif
+        return ~c;
+    }
+
+private:
+#if !defined(HURCHALLA_UTIL_CRC32C_X86) && !defined(HURCHALLA_UTIL_CRC32C_ARM)
+    // t[0] is the usual byte at a time table for the reflected polynomial;
+    // t[k][b] is the CRC of byte b followed by k zero bytes.
+    struct Table {
+        uint32_t t[8][256];
+        Table()
+        {
+            const uint32_t poly = UINT32_C(0x82F63B78);
+            for (uint32_t b = 0; b < 256; ++b) {
+                uint32_t c = b;
+                for (int k = 0; k < 8; ++k)
+                    c = (c >> 1) ^ ((c & 1) ? poly : 0);
+                t[0][b] = c;
+            }
+            for (uint32_t b = 0; b < 256; ++b) {
+                for (int k = 1; k < 8; ++k)
+                    t[k][b] = (t[k-1][b] >> 8) ^ t[0][t[k-1][b] & 0xFF];
+            }
+        }
+    };
+    static const Table& table()
+    {
+        static const Table tbl;
+        return tbl;
+    }
+#endif
+};
+
+
+}} // end namespace
+
+#endif
@@ -0,0 +1,79 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#ifndef HURCHALLA_UTIL_IMPL_FD_IO_H_INCLUDED
+#define HURCHALLA_UTIL_IMPL_FD_IO_H_INCLUDED
+
+
+#include <cerrno>
+#include <cstddef>
+#include <system_error>
+
+#if defined(_WIN32)
+#  include <io.h>
+#else
+#  include <unistd.h>
+#endif
+
+namespace hurchalla { namespace detail {
+
+
+// Blocking reads and writes of whole buffers on a file descriptor, which
+// retry after partial transfers and EINTR.  Throws std::system_error on
+// failure.
+struct impl_fd_io {
+    static void writeAll(int fd, const unsigned char* data, std::size_t len)
+    {
+        while (len > 0) {
+            std::size_t n = (len < MAX_IO) ? len : MAX_IO;
+#if defined(_WIN32)
+            int r = ::_write(fd, data, static_cast<unsigned int>(n));
+#else
+            ssize_t r = ::write(fd, data, n);
+#endif
+            if (r < 0) {
+                if (errno == EINTR)
+                    continue;
+                throw std::system_error(errno, std::generic_category(),
+                                        "write to file descriptor failed");
+            }
+            data += static_cast<std::size_t>(r);
+            len -= static_cast<std::size_t>(r);
+        }
+    }
+
+    // Reads up to len bytes, stopping early only at end of file, and returns
+    // the number of bytes read.
+    static std::size_t readAll(int fd, unsigned char* data, std::size_t len)
+    {
+        std::size_t total = 0;
+        while (total < len) {
+            std::size_t n = (len - total < MAX_IO) ? len - total : MAX_IO;
+#if defined(_WIN32)
+            int r = ::_read(fd, data + total, static_cast<unsigned int>(n));
+#else
+            ssize_t r = ::read(fd, data + total, n);
+#endif
+            if (r < 0) {
+                if (errno == EINTR)
+                    continue;
+                throw std::system_error(errno, std::generic_category(),
+                                        "read from file descriptor failed");
+            }
+            if (r == 0)
+                break;
+            total += static_cast<std::size_t>(r);
+        }
+        return total;
+    }
+
+private:
+    // (some platforms fail or transfer less for single requests of 2GB or
+    // more, and Windows takes an unsigned int count)
+    static constexpr std::size_t MAX_IO = std::size_t(1) << 30;
+};
+
+
+}} // end namespace
+
+#endif
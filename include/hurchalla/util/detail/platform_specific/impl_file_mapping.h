@@ -0,0 +1,172 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#ifndef HURCHALLA_UTIL_IMPL_FILE_MAPPING_H_INCLUDED
+#define HURCHALLA_UTIL_IMPL_FILE_MAPPING_H_INCLUDED
+
+
+#include "hurchalla/util/detail/util_programming_by_contract.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <system_error>
+
+#if defined(_WIN32)
+#  include "hurchalla/util/detail/platform_specific/impl_windows_h.h"
+#else
+#  include <cerrno>
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+namespace hurchalla { namespace detail {
+
+
+// RAII ownership of a memory mapping of an entire existing file, shared with
+// the file (writes through a writable mapping go to the file).  Throws
+// std::system_error if the file can't be opened or mapped.
+class FileMapping {
+    unsigned char* base;
+    std::size_t length;
+#if defined(_WIN32)
+    HANDLE file_handle;
+    HANDLE mapping_handle;
+#endif
+
+    static std::system_error lastError(const std::string& what)
+    {
+#if defined(_WIN32)
+        return std::system_error(static_cast<int>(::GetLastError()),
+                                 std::system_category(), what);
+#else
+        return std::system_error(errno, std::generic_category(), what);
+#endif
+    }
+
+    void release() noexcept
+    {
+#if defined(_WIN32)
+        if (base != nullptr)
+            ::UnmapViewOfFile(base);
+        if (mapping_handle != nullptr)
+            ::CloseHandle(mapping_handle);
+        if (file_handle != INVALID_HANDLE_VALUE)
+            ::CloseHandle(file_handle);
+        mapping_handle = nullptr;
+        file_handle = INVALID_HANDLE_VALUE;
+#else
+        if (base != nullptr)
+            ::munmap(base, length);
+#endif
+        base = nullptr;
+        length = 0;
+    }
+
+public:
+    FileMapping(const FileMapping&) = delete;
+    FileMapping& operator=(const FileMapping&) = delete;
+
+    FileMapping(FileMapping&& other) noexcept :
+            base(other.base), length(other.length)
+#if defined(_WIN32)
+            , file_handle(other.file_handle),
+            mapping_handle(other.mapping_handle)
+#endif
+    {
+        other.base = nullptr;
+        other.length = 0;
+#if defined(_WIN32)
+        other.file_handle = INVALID_HANDLE_VALUE;
+        other.mapping_handle = nullptr;
+#endif
+    }
+
+    FileMapping(const char* path, bool writable) :
+            base(nullptr), length(0)
+#if defined(_WIN32)
+            , file_handle(INVALID_HANDLE_VALUE), mapping_handle(nullptr)
+#endif
+    {
+        HPBC_UTIL_PRECONDITION2(path != nullptr);
+#if defined(_WIN32)
+        DWORD access = writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ;
+        file_handle = ::CreateFileA(path, access, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file_handle == INVALID_HANDLE_VALUE)
+            throw lastError(std::string("unable to open ") + path);
+        LARGE_INTEGER file_size;
+        if (!::GetFileSizeEx(file_handle, &file_size)) {
+            std::system_error err = lastError("GetFileSizeEx failed");
+            release();
+            throw err;
+        }
+        length = static_cast<std::size_t>(file_size.QuadPart);
+        if (length == 0)
+            return;
+        mapping_handle = ::CreateFileMappingA(file_handle, nullptr,
+                           writable ? PAGE_READWRITE : PAGE_READONLY,
+                           0, 0, nullptr);
+        if (mapping_handle == nullptr) {
+            std::system_error err = lastError("CreateFileMapping failed");
+            release();
+            throw err;
+        }
+        void* p = ::MapViewOfFile(mapping_handle,
+                           writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+        if (p == nullptr) {
+            std::system_error err = lastError("MapViewOfFile failed");
+            release();
+            throw err;
+        }
+        base = static_cast<unsigned char*>(p);
+#else
+        int fd = ::open(path, writable ? O_RDWR : O_RDONLY);
+        if (fd < 0)
+            throw lastError(std::string("unable to open ") + path);
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            std::system_error err = lastError("fstat failed");
+            ::close(fd);
+            throw err;
+        }
+        length = static_cast<std::size_t>(st.st_size);
+        if (length == 0) {
+            ::close(fd);
+            return;
+        }
+        int prot = writable ? (PROT_READ | PROT_WRITE) : PROT_READ;
+        void* p = ::mmap(nullptr, length, prot, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) {
+            // get the error before close() can change errno
+            std::system_error err = lastError("mmap failed");
+            ::close(fd);
+            length = 0;
+            throw err;
+        }
+        // the mapping stays valid after the file descriptor is closed
+        ::close(fd);
+        base = static_cast<unsigned char*>(p);
+#endif
+    }
+
+    ~FileMapping()
+    {
+        release();
+    }
+
+    unsigned char* data() const
+    {
+        return base;
+    }
+    std::size_t size() const
+    {
+        return length;
+    }
+};
+
+
+}} // end namespace
+
+#endif
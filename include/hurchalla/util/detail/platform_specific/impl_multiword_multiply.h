@@ -0,0 +1,447 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#ifndef HURCHALLA_UTIL_IMPL_MULTIWORD_MULTIPLY_H_INCLUDED
+#define HURCHALLA_UTIL_IMPL_MULTIWORD_MULTIPLY_H_INCLUDED
+
+// Multiword (N word by 1 word, and N word by N word) multiply kernels, in the
+// style of GMP's mpn_mul_1, mpn_addmul_1, mpn_submul_1 and mpn_mul_n.  Word
+// [0] is the least significant.  See multiword_multiply.h.
+//
+// note: in order to get the inline asm versions, you must define
+// HURCHALLA_ALLOW_INLINE_ASM_MULTIWORD_MULTIPLY or
+// HURCHALLA_ALLOW_INLINE_ASM_ALL, and you must compile for BMI2 and ADX
+// (for example, with gcc or clang, -mbmi2 -madx or -march=native).  They
+// exist for uint64_t with N == 4 and N == 8, on x86-64 for gcc and clang.
+// mulx doesn't change the flags, and adcx and adox each use only one flag
+// (CF and OF respectively), so the carries of the products and the carries
+// of the accumulation are two separate chains that never leave the flags.
+// Without ADX, a compiler has only one carry flag, and it generally moves
+// one of the chains through a register.
+// ARM64 has no second carry flag; there, the portable versions compile to
+// mul/umulh/adds/adc, which is what asm would use anyway.
+
+
+#include "hurchalla/util/detail/platform_specific/impl_unsigned_multiply_add_to_hilo_product.h"
+#include "hurchalla/util/Unroll.h"
+#include "hurchalla/util/traits/ut_numeric_limits.h"
+#include "hurchalla/util/compiler_macros.h"
+#include "hurchalla/util/detail/util_programming_by_contract.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+namespace hurchalla { namespace detail {
+
+
+// Works for all unsigned integer types T and all N.  Each word's step is a
+// call to impl_unsigned_multiply_add_to_hilo_product<T>, which can't overflow
+// (see impl_unsigned_multiply_add_to_hilo_product.h).
+// For each function, r may be the same array as a, but the two must not
+// otherwise overlap.  Uses static member functions to disallow ADL.
+struct slow_multiword_multiply {
+  // r = the low N words of a*b.  Returns the high word of a*b.
+  template <std::size_t N, typename T>
+  HURCHALLA_FORCE_INLINE static T mul_1(T* r, const T* a, T b)
+  {
+    static_assert(ut_numeric_limits<T>::is_integer, "");
+    static_assert(!(ut_numeric_limits<T>::is_signed), "");
+    using MA = impl_unsigned_multiply_add_to_hilo_product<T>;
+    T carry = 0;
+    Unroll<N>::call([&](std::size_t i) HURCHALLA_INLINE_LAMBDA {
+        T lo;
+        carry = MA::call(lo, a[i], b, carry);
+        r[i] = lo;
+    });
+    return carry;
+  }
+
+  // r = the low N words of r + a*b.  Returns the high word of r + a*b.
+  template <std::size_t N, typename T>
+  HURCHALLA_FORCE_INLINE static T addmul_1(T* r, const T* a, T b)
+  {
+    static_assert(ut_numeric_limits<T>::is_integer, "");
+    static_assert(!(ut_numeric_limits<T>::is_signed), "");
+    using MA = impl_unsigned_multiply_add_to_hilo_product<T>;
+    T carry = 0;
+    Unroll<N>::call([&](std::size_t i) HURCHALLA_INLINE_LAMBDA {
+        T lo;
+        carry = MA::call(lo, a[i], b, r[i], carry);
+        r[i] = lo;
+    });
+    return carry;
+  }
+
+  // r = the low N words of r - a*b.  Returns the borrow, i.e. the word w such
+  // that r - a*b + w*2^(N*digits) is the new r.
+  // The carry can't overflow: hi:lo = a[i]*b + carry <= (R-1)*(R-1) + R-1,
+  // with R = 2^digits, so if hi == R-1 then lo == 0 and there is no borrow.
+  template <std::size_t N, typename T>
+  HURCHALLA_FORCE_INLINE static T submul_1(T* r, const T* a, T b)
+  {
+    static_assert(ut_numeric_limits<T>::is_integer, "");
+    static_assert(!(ut_numeric_limits<T>::is_signed), "");
+    using MA = impl_unsigned_multiply_add_to_hilo_product<T>;
+    T carry = 0;
+    Unroll<N>::call([&](std::size_t i) HURCHALLA_INLINE_LAMBDA {
+        T lo;
+        T hi = MA::call(lo, a[i], b, carry);
+        T ri = r[i];
+        carry = static_cast<T>(hi + static_cast<T>(ri < lo));
+        r[i] = static_cast<T>(ri - lo);
+    });
+    return carry;
+  }
+};
+
+
+// primary template
+template <typename T, std::size_t N>
+struct impl_multiword_multiply {
+  HURCHALLA_FORCE_INLINE static T mul_1(T* r, const T* a, T b)
+  {
+    return slow_multiword_multiply::mul_1<N>(r, a, b);
+  }
+  HURCHALLA_FORCE_INLINE static T addmul_1(T* r, const T* a, T b)
+  {
+    return slow_multiword_multiply::addmul_1<N>(r, a, b);
+  }
+  HURCHALLA_FORCE_INLINE static T submul_1(T* r, const T* a, T b)
+  {
+    return slow_multiword_multiply::submul_1<N>(r, a, b);
+  }
+};
+
+
+// The asm versions take r and a through pointer registers, with the arrays
+// themselves as memory operands so that the compiler knows what the asm reads
+// and writes (see the note in impl_uint_fixed.h about "rm" and clang).
+// In every version, the high words of the products alternate between h0 and
+// h1, so that word i's high half is still available to add into word i+1.
+// For submul_1, each r[i] - t (with t the word of the product) is computed as
+// r[i] + ~t + carry: the product chain uses adox (OF), and the subtraction
+// chain uses adcx (CF), starting with CF set for the +1 of r + ~t + 1.  At
+// the end, CF clear means there was a borrow.
+#if (defined(HURCHALLA_ALLOW_INLINE_ASM_MULTIWORD_MULTIPLY) || \
+     defined(HURCHALLA_ALLOW_INLINE_ASM_ALL)) && \
+    defined(HURCHALLA_TARGET_ISA_X86_64) && defined(__GNUC__) && \
+    defined(__BMI2__) && defined(__ADX__)
+
+template <> struct impl_multiword_multiply<std::uint64_t, 4> {
+  using T = std::uint64_t;
+  static constexpr std::size_t N = 4;
+  using A = std::array<T, N>;
+  HURCHALLA_FORCE_INLINE static T mul_1(T* r, const T* a, T b)
+  {
+    A a0, r0;
+    if (HPBC_UTIL_POSTCONDITION2_MACRO_IS_ACTIVE) {
+        std::copy(a, a + N, a0.begin());
+    }
+    T lo, h0, h1, zero;
+    __asm__ ("xorl %k[zero], %k[zero] \n\t"      /* clears CF */
+             "mulxq 0(%[pa]), %[lo], %[h0] \n\t"
+             "movq %[lo], 0(%[pr]) \n\t"
+             "mulxq 8(%[pa]), %[lo], %[h1] \n\t"
+             "adcxq %[h0], %[lo] \n\t"
+             "movq %[lo], 8(%[pr]) \n\t"
+             "mulxq 16(%[pa]), %[lo], %[h0] \n\t"
+             "adcxq %[h1], %[lo] \n\t"
+             "movq %[lo], 16(%[pr]) \n\t"
+             "mulxq 24(%[pa]), %[lo], %[h1] \n\t"
+             "adcxq %[h0], %[lo] \n\t"
+             "movq %[lo], 24(%[pr]) \n\t"
+             "adcxq %[zero], %[h1] \n\t"
+             : [lo]"=&r"(lo), [h0]"=&r"(h0), [h1]"=&r"(h1),
+               [zero]"=&r"(zero),
+               "=m"(*reinterpret_cast<T(*)[N]>(r))
+             : [pr]"r"(r), [pa]"r"(a), "d"(b),
+               "m"(*reinterpret_cast<const T(*)[N]>(a))
+             : "cc");
+    if (HPBC_UTIL_POSTCONDITION2_MACRO_IS_ACTIVE) {
+        T h2 = slow_multiword_multiply::mul_1<N>(r0.data(), a0.data(), b);
+        HPBC_UTIL_POSTCONDITION2(h1 == h2 &&
+                                 std::equal(r0.begin(), r0.end(), r));
+    }
+    return h1;
+  }
+  HURCHALLA_FORCE_INLINE static T addmul_1(T* r, const T* a, T b)
+  {
+    A a0, r0;
+    if (HPBC_UTIL_POSTCONDITION2_MACRO_IS_ACTIVE) {
+        std::copy(a, a + N, a0.begin());
+        std::copy(r, r + N, r0.begin());
+    }
+    T lo, h0, h1, zero;
+    __asm__ ("xorl %k[zero], %k[zero] \n\t"      /* clears CF and OF */
+             "mulxq 0(%[pa]), %[lo], %[h0] \n\t"
+             "adoxq 0(%[pr]), %[lo] \n\t"
+             "movq %[lo], 0(%[pr]) \n\t"
+             "mulxq 8(%[pa]), %[lo], %[h1] \n\t"
+             "adcxq %[h0], %[lo] \n\t"
+             "adoxq 8(%[pr]), %[lo] \n\t"
+             "movq %[lo], 8(%[pr]) \n\t"
+             "mulxq 16(%[pa]), %[lo], %[h0] \n\t"
+             "adcxq %[h1], %[lo] \n\t"
+             "adoxq 16(%[pr]), %[lo] \n\t"
+             "movq %[lo], 16(%[pr]) \n\t"
+             "mulxq 24(%[pa]), %[lo], %[h1] \n\t"
+             "adcxq %[h0], %[lo] \n\t"
+             "adoxq 24(%[pr]), %[lo] \n\t"
+             "movq %[lo], 24(%[pr]) \n\t"
+             "adcxq %[zero], %[h1] \n\t"
+             "adoxq %[zero], %[h1] \n\t"
+             : [lo]"=&r"(lo), [h0]"=&r"(h0), [h1]"=&r"(h1),
+               [zero]"=&r"(zero),
+               "+m"(*reinterpret_cast<T(*)[N]>(r))
+             : [pr]"r"(r), [pa]"r"(a), "d"(b),
+               "m"(*reinterpret_cast<const T(*)[N]>(a))
+             : "cc");
+    if (HPBC_UTIL_POSTCONDITION2_MACRO_IS_ACTIVE) {
+        T h2 = slow_multiword_multiply::addmul_1<N>(r0.data(), a0.data(), b);
+        HPBC_UTIL_POSTCONDITION2(h1 == h2 &&
+                                 std::equal(r0.begin(), r0.end(), r));
+    }
+    return h1;
+  }
+  HURCHALLA_FORCE_INLINE static T submul_1(T* r, const T* a, T b)
+  {
+    A a0, r0;
+    if (HPBC_UTIL_POSTCONDITION2_MACRO_IS_ACTIVE) {
+        std::copy(a, a + N, a0.begin());
+        std::copy(r, r + N, r0.begin());
+    }
+    T lo, h0, h1, zero;
+    __asm__ ("xorl %k[zero], %k[zero] \n\t"      /* clears CF and OF */
+             "stc \n\t"                           /* CF = 1 */
+             "mulxq 0(%[pa]), %[lo], %[h0] \n\t"
+             "notq %[lo] \n\t"
+             "adcxq 0(%[pr]), %[lo] \n\t"
+             "movq %[lo], 0(%[pr]) \n\t"
+             "mulxq 8(%[pa]), %[lo], %[h1] \n\t"
+             "adoxq %[h0], %[lo] \n\t"
+             "notq %[lo] \n\t"
+             "adcxq 8(%[pr]), %[lo] \n\t"
+             "movq %[lo], 8(%[pr]) \n\t"
+             "mulxq 16(%[pa]), %[lo], %[h0] \n\t"
+             "adoxq %[h1], %[lo] \n\t"
+             "notq %[lo] \n\t"
+             "adcxq 16(%[pr]), %[lo] \n\t"
+             "movq %[lo], 16(%[pr]) \n\t"
+             "mulxq 24(%[pa]), %[lo], %[h1] \n\t"
+             "adoxq %[h0], %[lo] \n\t"
+             "notq %[lo] \n\t"
+             "adcxq 24(%[pr]), %[lo] \n\t"
+             "movq %[lo], 24(%[pr]) \n\t"
+             "adoxq %[zero], %[h1] \n\t"
+             "cmc \n\t"                           /* CF = borrow */
+             "adcxq %[zero], %[h1] \n\t"
+             : [lo]"=&r"(lo), [h0]"=&r"(h0), [h1]"=&r"(h1),
+               [zero]"=&r"(zero),
+               "+m"(*reinterpret_cast<T(*)[N]>(r))
+             : [pr]"r"(r), [pa]"r"(a), "d"(b),
+               "m"(*reinterpret_cast<const T(*)[N]>(a))
+             : "cc");
+    if (HPBC_UTIL_POSTCONDITION2_MACRO_IS_ACTIVE) {
+        T h2 = slow_multiword_multiply::submul_1<N>(r0.data(), a0.data(), b);
+        HPBC_UTIL_POSTCONDITION2(h1 == h2 &&
+                                 std::equal(r0.begin(), r0.end(), r));
+    }
+    return h1;
+  }
+};
+
+template <> struct impl_multiword_multiply<std::uint64_t, 8> {
+  using T = std::uint64_t;
+  static constexpr std::size_t N = 8;
+  using A = std::array<T, N>;
+  HURCHALLA_FORCE_INLINE static T mul_1(T* r, const T* a, T b)
+  {
+    A a0, r0;
+    if (HPBC_UTIL_POSTCONDITION2_MACRO_IS_ACTIVE) {
+        std::copy(a, a + N, a0.begin());
+    }
+    T lo, h0, h1, zero;
+    __asm__ ("xorl %k[zero], %k[zero] \n\t"      /* clears CF */
+             "mulxq 0(%[pa]), %[lo], %[h0] \n\t"
+             "movq %[lo], 0(%[pr]) \n\t"
+             "mulxq 8(%[pa]), %[lo], %[h1] \n\t"
+             "adcxq %[h0], %[lo] \n\t"
+             "movq %[lo], 8(%[pr]) \n\t"
+             "mulxq 16(%[pa]), %[lo], %[h0] \n\t"
+             "adcxq %[h1], %[lo] \n\t"
+             "movq %[lo], 16(%[pr]) \n\t"
+             "mulxq 24(%[pa]), %[lo], %[h1] \n\t"
+             "adcxq %[h0], %[lo] \n\t"
+             "movq %[lo], 24(%[pr]) \n\t"
+             "mulxq 32(%[pa]), %[lo], %[h0] \n\t"
+             "adcxq %[h1], %[lo] \n\t"
+             "movq %[lo], 32(%[pr]) \n\t"
+             "mulxq 40(%[pa]), %[lo], %[h1] \n\t"
+             "adcxq %[h0], %[lo] \n\t"
+             "movq %[lo], 40(%[pr]) \n\t"
+             "mulxq 48(%[pa]), %[lo], %[h0] \n\t"
+             "adcxq %[h1], %[lo] \n\t"
+             "movq %[lo], 48(%[pr]) \n\t"
+             "mulxq 56(%[pa]), %[lo], %[h1] \n\t"
+             "adcxq %[h0], %[lo] \n\t"
+             "movq %[lo], 56(%[pr]) \n\t"
+             "adcxq %[zero], %[h1] \n\t"
+             : [lo]"=&r"(lo), [h0]"=&r"(h0), [h1]"=&r"(h1),
+               [zero]"=&r"(zero),
+               "=m"(*reinterpret_cast<T(*)[N]>(r))
+             : [pr]"r"(r), [pa]"r"(a), "d"(b),
+               "m"(*reinterpret_cast<const T(*)[N]>(a))
+             : "cc");
+    if (HPBC_UTIL_POSTCONDITION2_MACRO_IS_ACTIVE) {
+        T h2 = slow_multiword_multiply::mul_1<N>(r0.data(), a0.data(), b);
+        HPBC_UTIL_POSTCONDITION2(h1 == h2 &&
+                                 std::equal(r0.begin(), r0.end(), r));
+    }
+    return h1;
+  }
+  HURCHALLA_FORCE_INLINE static T addmul_1(T* r, const T* a, T b)
+  {
+    A a0, r0;
+    if (HPBC_UTIL_POSTCONDITION2_MACRO_IS_ACTIVE) {
+        std::copy(a, a + N, a0.begin());
+        std::copy(r, r + N, r0.begin());
+    }
+    T lo, h0, h1, zero;
+    __asm__ ("xorl %k[zero], %k[zero] \n\t"      /* clears CF and OF */
+             "mulxq 0(%[pa]), %[lo], %[h0] \n\t"
+             "adoxq 0(%[pr]), %[lo] \n\t"
+             "movq %[lo], 0(%[pr]) \n\t"
+             "mulxq 8(%[pa]), %[lo], %[h1] \n\t"
+             "adcxq %[h0], %[lo] \n\t"
+             "adoxq 8(%[pr]), %[lo] \n\t"
+             "movq %[lo], 8(%[pr]) \n\t"
+             "mulxq 16(%[pa]), %[lo], %[h0] \n\t"
+             "adcxq %[h1], %[lo] \n\t"
+             "adoxq 16(%[pr]), %[lo] \n\t"
+             "movq %[lo], 16(%[pr]) \n\t"
+             "mulxq 24(%[pa]), %[lo], %[h1] \n\t"
+             "adcxq %[h0], %[lo] \n\t"
+             "adoxq 24(%[pr]), %[lo] \n\t"
+             "movq %[lo], 24(%[pr]) \n\t"
+             "mulxq 32(%[pa]), %[lo], %[h0] \n\t"
+             "adcxq %[h1], %[lo] \n\t"
+             "adoxq 32(%[pr]), %[lo] \n\t"
+             "movq %[lo], 32(%[pr]) \n\t"
+             "mulxq 40(%[pa]), %[lo], %[h1] \n\t"
+             "adcxq %[h0], %[lo] \n\t"
+             "adoxq 40(%[pr]), %[lo] \n\t"
+             "movq %[lo], 40(%[pr]) \n\t"
+             "mulxq 48(%[pa]), %[lo], %[h0] \n\t"
+             "adcxq %[h1], %[lo] \n\t"
+             "adoxq 48(%[pr]), %[lo] \n\t"
+             "movq %[lo], 48(%[pr]) \n\t"
+             "mulxq 56(%[pa]), %[lo], %[h1] \n\t"
+             "adcxq %[h0], %[lo] \n\t"
+             "adoxq 56(%[pr]), %[lo] \n\t"
+             "movq %[lo], 56(%[pr]) \n\t"
+             "adcxq %[zero], %[h1] \n\t"
+             "adoxq %[zero], %[h1] \n\t"
+             : [lo]"=&r"(lo), [h0]"=&r"(h0), [h1]"=&r"(h1),
+               [zero]"=&r"(zero),
+               "+m"(*reinterpret_cast<T(*)[N]>(r))
+             : [pr]"r"(r), [pa]"r"(a), "d"(b),
+               "m"(*reinterpret_cast<const T(*)[N]>(a))
+             : "cc");
+    if (HPBC_UTIL_POSTCONDITION2_MACRO_IS_ACTIVE) {
+        T h2 = slow_multiword_multiply::addmul_1<N>(r0.data(), a0.data(), b);
+        HPBC_UTIL_POSTCONDITION2(h1 == h2 &&
+                                 std::equal(r0.begin(), r0.end(), r));
+    }
+    return h1;
+  }
+  HURCHALLA_FORCE_INLINE static T submul_1(T* r, const T* a, T b)
+  {
+    A a0, r0;
+    if (HPBC_UTIL_POSTCONDITION2_MACRO_IS_ACTIVE) {
+        std::copy(a, a + N, a0.begin());
+        std::copy(r, r + N, r0.begin());
+    }
+    T lo, h0, h1, zero;
+    __asm__ ("xorl %k[zero], %k[zero] \n\t"      /* clears CF and OF */
+             "stc \n\t"                           /* CF = 1 */
+             "mulxq 0(%[pa]), %[lo], %[h0] \n\t"
+             "notq %[lo] \n\t"
+             "adcxq 0(%[pr]), %[lo] \n\t"
+             "movq %[lo], 0(%[pr]) \n\t"
+             "mulxq 8(%[pa]), %[lo], %[h1] \n\t"
+             "adoxq %[h0], %[lo] \n\t"
+             "notq %[lo] \n\t"
+             "adcxq 8(%[pr]), %[lo] \n\t"
+             "movq %[lo], 8(%[pr]) \n\t"
+             "mulxq 16(%[pa]), %[lo], %[h0] \n\t"
+             "adoxq %[h1], %[lo] \n\t"
+             "notq %[lo] \n\t"
+             "adcxq 16(%[pr]), %[lo] \n\t"
+             "movq %[lo], 16(%[pr]) \n\t"
+             "mulxq 24(%[pa]), %[lo], %[h1] \n\t"
+             "adoxq %[h0], %[lo] \n\t"
+             "notq %[lo] \n\t"
+             "adcxq 24(%[pr]), %[lo] \n\t"
+             "movq %[lo], 24(%[pr]) \n\t"
+             "mulxq 32(%[pa]), %[lo], %[h0] \n\t"
+             "adoxq %[h1], %[lo] \n\t"
+             "notq %[lo] \n\t"
+             "adcxq 32(%[pr]), %[lo] \n\t"
+             "movq %[lo], 32(%[pr]) \n\t"
+             "mulxq 40(%[pa]), %[lo], %[h1] \n\t"
+             "adoxq %[h0], %[lo] \n\t"
+             "notq %[lo] \n\t"
+             "adcxq 40(%[pr]), %[lo] \n\t"
+             "movq %[lo], 40(%[pr]) \n\t"
+             "mulxq 48(%[pa]), %[lo], %[h0] \n\t"
+             "adoxq %[h1], %[lo] \n\t"
+             "notq %[lo] \n\t"
+             "adcxq 48(%[pr]), %[lo] \n\t"
+             "movq %[lo], 48(%[pr]) \n\t"
+             "mulxq 56(%[pa]), %[lo], %[h1] \n\t"
+             "adoxq %[h0], %[lo] \n\t"
+             "notq %[lo] \n\t"
+             "adcxq 56(%[pr]), %[lo] \n\t"
+             "movq %[lo], 56(%[pr]) \n\t"
+             "adoxq %[zero], %[h1] \n\t"
+             "cmc \n\t"                           /* CF = borrow */
+             "adcxq %[zero], %[h1] \n\t"
+             : [lo]"=&r"(lo), [h0]"=&r"(h0), [h1]"=&r"(h1),
+               [zero]"=&r"(zero),
+               "+m"(*reinterpret_cast<T(*)[N]>(r))
+             : [pr]"r"(r), [pa]"r"(a), "d"(b),
+               "m"(*reinterpret_cast<const T(*)[N]>(a))
+             : "cc");
+    if (HPBC_UTIL_POSTCONDITION2_MACRO_IS_ACTIVE) {
+        T h2 = slow_multiword_multiply::submul_1<N>(r0.data(), a0.data(), b);
+        HPBC_UTIL_POSTCONDITION2(h1 == h2 &&
+                                 std::equal(r0.begin(), r0.end(), r));
+    }
+    return h1;
+  }
+};
+
+#endif
+
+
+// N word by N word schoolbook multiplication: r (2*N words) = a*b.  Each row
+// is one addmul_1, and each row's returned carry word is the row's top word.
+// r must not overlap a or b.
+struct impl_multiword_mul_n {
+  template <std::size_t N, typename T>
+  HURCHALLA_FORCE_INLINE static void call(T* r, const T* a, const T* b)
+  {
+    using MW = impl_multiword_multiply<T, N>;
+    r[N] = MW::mul_1(r, a, b[0]);
+    Unroll<N>::call([&](std::size_t j) HURCHALLA_INLINE_LAMBDA {
+        if (j > 0)
+            r[N+j] = MW::addmul_1(r + j, a, b[j]);
+    });
+  }
+};
+
+
+}} // end namespace
+
+#endif
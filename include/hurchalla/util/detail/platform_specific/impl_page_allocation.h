@@ -0,0 +1,195 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#ifndef HURCHALLA_UTIL_IMPL_PAGE_ALLOCATION_H_INCLUDED
+#define HURCHALLA_UTIL_IMPL_PAGE_ALLOCATION_H_INCLUDED
+
+
+#include "hurchalla/util/detail/util_programming_by_contract.h"
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#  include "hurchalla/util/detail/platform_specific/impl_windows_h.h"
+#elif defined(__unix__) || defined(__APPLE__)
+#  include <sys/mman.h>
+#  include <unistd.h>
+#  define HURCHALLA_UTIL_PAGE_ALLOCATION_USE_MMAP 1
+#else
+#  include <cstdlib>
+#endif
+
+namespace hurchalla { namespace detail {
+
+
+// Allocates zero-filled memory directly from the OS (mmap on POSIX,
+// VirtualAlloc on Windows).  The OS maps every page to a shared zero page
+// until it is first written, so unlike new[]() this never runs a memset, and
+// a page is only physically placed (on the NUMA node of the thread that
+// first writes it) once it's used.  On other platforms this falls back to
+// calloc.
+struct impl_page_allocation {
+
+    static std::size_t page_size()
+    {
+#if defined(_WIN32)
+        SYSTEM_INFO si;
+        ::GetSystemInfo(&si);
+        return static_cast<std::size_t>(si.dwPageSize);
+#elif defined(HURCHALLA_UTIL_PAGE_ALLOCATION_USE_MMAP)
+        long sz = ::sysconf(_SC_PAGESIZE);
+        return (sz > 0) ? static_cast<std::size_t>(sz) : 4096;
+#else
+        return 4096;
+#endif
+    }
+
+    // If huge_pages is true, we ask the OS to back the memory with
+    // transparent huge pages where that is supported (Linux, via
+    // madvise(MADV_HUGEPAGE)); it's only a hint.  Throws std::bad_alloc on
+    // failure.
+    static unsigned char* allocate(std::size_t bytes, bool huge_pages)
+    {
+        HPBC_UTIL_PRECONDITION2(bytes > 0);
+#if defined(_WIN32)
+        (void)huge_pages;   // large pages on Windows need special privileges
+        void* p = ::VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT,
+                                 PAGE_READWRITE);
+        if (p == nullptr)
+            throw std::bad_alloc();
+        return static_cast<unsigned char*>(p);
+#elif defined(HURCHALLA_UTIL_PAGE_ALLOCATION_USE_MMAP)
+        std::size_t length = roundUp(bytes, page_size());
+        if (length < bytes)
+            throw std::bad_alloc();
+#  if defined(MADV_HUGEPAGE)
+        // The kernel can only use a huge page for a huge page aligned range,
+        // so we over-map and then trim down to an aligned range.
+        constexpr std::size_t HUGE_PAGE = std::size_t(1) << 21;
+        if (huge_pages && length >= HUGE_PAGE &&
+                                   length <= SIZE_MAX - HUGE_PAGE) {
+            unsigned char* raw = mapAnonymous(length + HUGE_PAGE);
+            std::uintptr_t addr = reinterpret_cast<std::uintptr_t>(raw);
+            std::size_t head = static_cast<std::size_t>(
+                       roundUp(addr, HUGE_PAGE) - addr);
+            unsigned char* p = raw + head;
+            if (head > 0)
+                ::munmap(raw, head);
+            if (HUGE_PAGE - head > 0)
+                ::munmap(p + length, HUGE_PAGE - head);
+            // this is only a hint, so we ignore failure
+            ::madvise(p, length, MADV_HUGEPAGE);
+            return p;
+        }
+#  endif
+        (void)huge_pages;
+        return mapAnonymous(length);
+#else
+        (void)huge_pages;
+        void* p = std::calloc(bytes, 1);
+        if (p == nullptr)
+            throw std::bad_alloc();
+        return static_cast<unsigned char*>(p);
+#endif
+    }
+
+    // 'bytes' must be the same value that was passed to allocate().
+    static void deallocate(unsigned char* p, std::size_t bytes) noexcept
+    {
+        if (p == nullptr)
+            return;
+#if defined(_WIN32)
+        (void)bytes;
+        ::VirtualFree(p, 0, MEM_RELEASE);
+#elif defined(HURCHALLA_UTIL_PAGE_ALLOCATION_USE_MMAP)
+        ::munmap(p, roundUp(bytes, page_size()));
+#else
+        (void)bytes;
+        std::free(p);
+#endif
+    }
+
+    // Writes a zero to one byte of each page in [p, p+bytes), splitting the
+    // pages evenly over 'num_threads' threads, so that with a first-touch
+    // NUMA policy the pages are spread over the nodes those threads run on.
+    // If a thread can't be started, the calling thread touches the pages
+    // that it would have (the placement is only an optimization).
+    static void first_touch(unsigned char* p, std::size_t bytes,
+                            unsigned int num_threads)
+    {
+        std::size_t psize = page_size();
+        std::size_t num_pages = bytes / psize + (bytes % psize != 0);
+        if (num_threads <= 1 || num_pages < num_threads) {
+            touchPages(p, bytes, 0, num_pages, psize);
+            return;
+        }
+        std::vector<std::thread> threads;
+        std::size_t per_thread = num_pages / num_threads;
+        // thread t (for 1 <= t < num_threads) touches the pages from
+        // t*per_thread; 'started_end' is the end of the started threads' pages
+        std::size_t started_end = per_thread;
+        try {
+            threads.reserve(num_threads - 1);
+            for (unsigned int t = 1; t < num_threads; ++t) {
+                std::size_t first = t * per_thread;
+                std::size_t last = (t + 1 == num_threads) ? num_pages
+                                                          : first + per_thread;
+                threads.emplace_back(touchPages, p, bytes, first, last, psize);
+                started_end = last;
+            }
+        } catch (...) {
+            // (std::thread throws std::system_error if it can't start a
+            // thread.)  Destroying a joinable std::thread would terminate,
+            // so we carry on and join the started threads below.
+        }
+        touchPages(p, bytes, 0, per_thread, psize);
+        touchPages(p, bytes, started_end, num_pages, psize);
+        for (auto& th : threads)
+            th.join();
+    }
+
+private:
+    static std::size_t roundUp(std::size_t x, std::size_t multiple)
+    {
+        return (x + multiple - 1) / multiple * multiple;
+    }
+
+#if defined(HURCHALLA_UTIL_PAGE_ALLOCATION_USE_MMAP)
+    static unsigned char* mapAnonymous(std::size_t length)
+    {
+#  if defined(MAP_ANONYMOUS)
+        constexpr int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#  else
+        constexpr int flags = MAP_PRIVATE | MAP_ANON;
+#  endif
+        void* p = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (p == MAP_FAILED)
+            throw std::bad_alloc();
+        return static_cast<unsigned char*>(p);
+    }
+#endif
+
+    static void touchPages(unsigned char* p, std::size_t bytes,
+                           std::size_t first_page, std::size_t last_page,
+                           std::size_t psize)
+    {
+        for (std::size_t i = first_page; i < last_page; ++i) {
+            std::size_t offset = i * psize;
+            HPBC_UTIL_ASSERT2(offset < bytes);
+            (void)bytes;
+            // the memory is already zero, but the write makes the OS
+            // allocate the page now, from this thread
+            static_cast<volatile unsigned char*>(p)[offset] = 0;
+        }
+    }
+};
+
+
+}} // end namespace
+
+#undef HURCHALLA_UTIL_PAGE_ALLOCATION_USE_MMAP
+
+#endif
@@ -0,0 +1,431 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#ifndef HURCHALLA_UTIL_IMPL_UINT_FIXED_H_INCLUDED
+#define HURCHALLA_UTIL_IMPL_UINT_FIXED_H_INCLUDED
+
+// Word-array kernels for uint_fixed (see uint_fixed.h).  Each word is a
+// uint64_t, and word [0] is the least significant.
+//
+// note: in order to get the inline asm versions of add and sub, you must
+// define HURCHALLA_ALLOW_INLINE_ASM_UINT_FIXED or
+// HURCHALLA_ALLOW_INLINE_ASM_ALL.
+// They exist for 4 and 8 words (256 and 512 bits), on x86-64 (add/adc,
+// sub/sbb) and ARM64 (adds/adcs, subs/sbcs), for gcc and clang.  Compilers
+// rarely turn the portable versions' carry computations back into a single
+// carry flag chain, so the asm is about twice as fast.
+// The truncated multiply is built on unsigned_multiply_add_to_hilo_product's
+// uint64_t kernel, and so it gets that function's inline asm (which keeps
+// each step's carry in the flags) if you define
+// HURCHALLA_ALLOW_INLINE_ASM_MULTIPLY_ADD_TO_HILO.  The full multiply is
+// multiword_multiply.h's mul_n, which has mulx/adcx/adox asm for 4 and 8
+// words if you define HURCHALLA_ALLOW_INLINE_ASM_MULTIWORD_MULTIPLY.
+
+
+#include "hurchalla/util/detail/platform_specific/impl_unsigned_multiply_add_to_hilo_product.h"
+#include "hurchalla/util/detail/platform_specific/impl_multiword_multiply.h"
+#include "hurchalla/util/Unroll.h"
+#include "hurchalla/util/compiler_macros.h"
+#include "hurchalla/util/detail/util_programming_by_contract.h"
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+namespace hurchalla { namespace detail {
+
+
+// r = a + b (mod 2^(64*N)).  Returns the carry out, 0 or 1.
+// r may be the same array as a or b.
+struct slow_uint_fixed_add {
+  template <std::size_t N>
+  HURCHALLA_FORCE_INLINE static
+  std::uint64_t call(std::array<std::uint64_t,N>& r,
+                     const std::array<std::uint64_t,N>& a,
+                     const std::array<std::uint64_t,N>& b)
+  {
+    using std::uint64_t;
+    uint64_t carry = 0;
+    Unroll<N>::call([&](std::size_t i) HURCHALLA_INLINE_LAMBDA {
+        uint64_t s = a[i] + b[i];
+        uint64_t c = (s < b[i]);
+        s = s + carry;
+        carry = c | (s < carry);
+        r[i] = s;
+    });
+    return carry;
+  }
+};
+
+// r = a - b (mod 2^(64*N)).  Returns the borrow out, 0 or 1.
+// r may be the same array as a or b.
+struct slow_uint_fixed_sub {
+  template <std::size_t N>
+  HURCHALLA_FORCE_INLINE static
+  std::uint64_t call(std::array<std::uint64_t,N>& r,
+                     const std::array<std::uint64_t,N>& a,
+                     const std::array<std::uint64_t,N>& b)
+  {
+    using std::uint64_t;
+    uint64_t borrow = 0;
+    Unroll<N>::call([&](std::size_t i) HURCHALLA_INLINE_LAMBDA {
+        uint64_t d = a[i] - b[i];
+        uint64_t c = (a[i] < b[i]);
+        uint64_t d2 = d - borrow;
+        borrow = c | (d < borrow);
+        r[i] = d2;
+    });
+    return borrow;
+  }
+};
+
+
+// primary templates
+template <std::size_t N>
+struct impl_uint_fixed_add {
+  HURCHALLA_FORCE_INLINE static
+  std::uint64_t call(std::array<std::uint64_t,N>& r,
+                     const std::array<std::uint64_t,N>& a,
+                     const std::array<std::uint64_t,N>& b)
+  {
+    return slow_uint_fixed_add::call(r, a, b);
+  }
+};
+template <std::size_t N>
+struct impl_uint_fixed_sub {
+  HURCHALLA_FORCE_INLINE static
+  std::uint64_t call(std::array<std::uint64_t,N>& r,
+                     const std::array<std::uint64_t,N>& a,
+                     const std::array<std::uint64_t,N>& b)
+  {
+    return slow_uint_fixed_sub::call(r, a, b);
+  }
+};
+
+
+// The asm versions take b's words through a pointer register, with b itself
+// as a memory input operand so that the compiler knows the asm reads it.
+// Passing each word as its own "rm" operand would be nicer for gcc, but for
+// 8 words clang would need 17 registers (it won't choose memory for "rm"; see
+// https://bugs.llvm.org/show_bug.cgi?id=20197).
+#if (defined(HURCHALLA_ALLOW_INLINE_ASM_UINT_FIXED) || \
+     defined(HURCHALLA_ALLOW_INLINE_ASM_ALL)) && \
+    defined(HURCHALLA_TARGET_ISA_X86_64) && defined(__GNUC__)
+
+template <>
+struct impl_uint_fixed_add<4> {
+  using A = std::array<std::uint64_t, 4>;
+  HURCHALLA_FORCE_INLINE static
+  std::uint64_t call(A& r, const A& a, const A& b)
+  {
+    using std::uint64_t;
+    uint64_t r0 = a[0], r1 = a[1], r2 = a[2], r3 = a[3];
+    uint64_t carry;
+    __asm__ ("addq 0(%[pb]), %[r0] \n\t"
+             "adcq 8(%[pb]), %[r1] \n\t"
+             "adcq 16(%[pb]), %[r2] \n\t"
+             "adcq 24(%[pb]), %[r3] \n\t"
+             "movl $0, %k[carry] \n\t"       /* mov doesn't change CF */
+             "adcl $0, %k[carry] \n\t"
+             : [r0]"+&r"(r0), [r1]"+&r"(r1), [r2]"+&r"(r2), [r3]"+&r"(r3),
+               [carry]"=&r"(carry)
+             : [pb]"r"(b.data()), "m"(b)
+             : "cc");
+    A result = {{ r0, r1, r2, r3 }};
+    if (HPBC_UTIL_POSTCONDITION2_MACRO_IS_ACTIVE) {
+        A expected;
+        uint64_t carry2 = slow_uint_fixed_add::call(expected, a, b);
+        HPBC_UTIL_POSTCONDITION2(carry == carry2 && result == expected);
+    }
+    r = result;
+    return carry;
+  }
+};
+template <>
+struct impl_uint_fixed_sub<4> {
+  using A = std::array<std::uint64_t, 4>;
+  HURCHALLA_FORCE_INLINE static
+  std::uint64_t call(A& r, const A& a, const A& b)
+  {
+    using std::uint64_t;
+    uint64_t r0 = a[0], r1 = a[1], r2 = a[2], r3 = a[3];
+    uint64_t borrow;
+    __asm__ ("subq 0(%[pb]), %[r0] \n\t"
+             "sbbq 8(%[pb]), %[r1] \n\t"
+             "sbbq 16(%[pb]), %[r2] \n\t"
+             "sbbq 24(%[pb]), %[r3] \n\t"
+             "movl $0, %k[borrow] \n\t"      /* mov doesn't change CF */
+             "adcl $0, %k[borrow] \n\t"
+             : [r0]"+&r"(r0), [r1]"+&r"(r1), [r2]"+&r"(r2), [r3]"+&r"(r3),
+               [borrow]"=&r"(borrow)
+             : [pb]"r"(b.data()), "m"(b)
+             : "cc");
+    A result = {{ r0, r1, r2, r3 }};
+    if (HPBC_UTIL_POSTCONDITION2_MACRO_IS_ACTIVE) {
+        A expected;
+        uint64_t borrow2 = slow_uint_fixed_sub::call(expected, a, b);
+        HPBC_UTIL_POSTCONDITION2(borrow == borrow2 && result == expected);
+    }
+    r = result;
+    return borrow;
+  }
+};
+
+template <>
+struct impl_uint_fixed_add<8> {
+  using A = std::array<std::uint64_t, 8>;
+  HURCHALLA_FORCE_INLINE static
+  std::uint64_t call(A& r, const A& a, const A& b)
+  {
+    using std::uint64_t;
+    uint64_t r0 = a[0], r1 = a[1], r2 = a[2], r3 = a[3],
+             r4 = a[4], r5 = a[5], r6 = a[6], r7 = a[7];
+    uint64_t carry;
+    __asm__ ("addq 0(%[pb]), %[r0] \n\t"
+             "adcq 8(%[pb]), %[r1] \n\t"
+             "adcq 16(%[pb]), %[r2] \n\t"
+             "adcq 24(%[pb]), %[r3] \n\t"
+             "adcq 32(%[pb]), %[r4] \n\t"
+             "adcq 40(%[pb]), %[r5] \n\t"
+             "adcq 48(%[pb]), %[r6] \n\t"
+             "adcq 56(%[pb]), %[r7] \n\t"
+             "movl $0, %k[carry] \n\t"       /* mov doesn't change CF */
+             "adcl $0, %k[carry] \n\t"
+             : [r0]"+&r"(r0), [r1]"+&r"(r1), [r2]"+&r"(r2), [r3]"+&r"(r3),
+               [r4]"+&r"(r4), [r5]"+&r"(r5), [r6]"+&r"(r6), [r7]"+&r"(r7),
+               [carry]"=&r"(carry)
+             : [pb]"r"(b.data()), "m"(b)
+             : "cc");
+    A result = {{ r0, r1, r2, r3, r4, r5, r6, r7 }};
+    if (HPBC_UTIL_POSTCONDITION2_MACRO_IS_ACTIVE) {
+        A expected;
+        uint64_t carry2 = slow_uint_fixed_add::call(expected, a, b);
+        HPBC_UTIL_POSTCONDITION2(carry == carry2 && result == expected);
+    }
+    r = result;
+    return carry;
+  }
+};
+template <>
+struct impl_uint_fixed_sub<8> {
+  using A = std::array<std::uint64_t, 8>;
+  HURCHALLA_FORCE_INLINE static
+  std::uint64_t call(A& r, const A& a, const A& b)
+  {
+    using std::uint64_t;
+    uint64_t r0 = a[0], r1 = a[1], r2 = a[2], r3 = a[3],
+             r4 = a[4], r5 = a[5], r6 = a[6], r7 = a[7];
+    uint64_t borrow;
+    __asm__ ("subq 0(%[pb]), %[r0] \n\t"
+             "sbbq 8(%[pb]), %[r1] \n\t"
+             "sbbq 16(%[pb]), %[r2] \n\t"
+             "sbbq 24(%[pb]), %[r3] \n\t"
+             "sbbq 32(%[pb]), %[r4] \n\t"
+             "sbbq 40(%[pb]), %[r5] \n\t"
+             "sbbq 48(%[pb]), %[r6] \n\t"
+             "sbbq 56(%[pb]), %[r7] \n\t"
+             "movl $0, %k[borrow] \n\t"      /* mov doesn't change CF */
+             "adcl $0, %k[borrow] \n\t"
+             : [r0]"+&r"(r0), [r1]"+&r"(r1), [r2]"+&r"(r2), [r3]"+&r"(r3),
+               [r4]"+&r"(r4), [r5]"+&r"(r5), [r6]"+&r"(r6), [r7]"+&r"(r7),
+               [borrow]"=&r"(borrow)
+             : [pb]"r"(b.data()), "m"(b)
+             : "cc");
+    A result = {{ r0, r1, r2, r3, r4, r5, r6, r7 }};
+    if (HPBC_UTIL_POSTCONDITION2_MACRO_IS_ACTIVE) {
+        A expected;
+        uint64_t borrow2 = slow_uint_fixed_sub::call(expected, a, b);
+        HPBC_UTIL_POSTCONDITION2(borrow == borrow2 && result == expected);
+    }
+    r = result;
+    return borrow;
+  }
+};
+
+#elif (defined(HURCHALLA_ALLOW_INLINE_ASM_UINT_FIXED) || \
+       defined(HURCHALLA_ALLOW_INLINE_ASM_ALL)) && \
+      defined(HURCHALLA_TARGET_ISA_ARM_64) && defined(__GNUC__)
+
+// ARM64's subs/sbcs set C when there is *no* borrow, so the borrow out is
+// the carry flag clear ("cc").
+template <>
+struct impl_uint_fixed_add<4> {
+  using A = std::array<std::uint64_t, 4>;
+  HURCHALLA_FORCE_INLINE static
+  std::uint64_t call(A& r, const A& a, const A& b)
+  {
+    using std::uint64_t;
+    uint64_t r0 = a[0], r1 = a[1], r2 = a[2], r3 = a[3];
+    uint64_t carry;
+    __asm__ ("adds %[r0], %[r0], %[b0] \n\t"
+             "adcs %[r1], %[r1], %[b1] \n\t"
+             "adcs %[r2], %[r2], %[b2] \n\t"
+             "adcs %[r3], %[r3], %[b3] \n\t"
+             "cset %[carry], cs \n\t"
+             : [r0]"+&r"(r0), [r1]"+&r"(r1), [r2]"+&r"(r2), [r3]"+&r"(r3),
+               [carry]"=r"(carry)
+             : [b0]"r"(b[0]), [b1]"r"(b[1]), [b2]"r"(b[2]), [b3]"r"(b[3])
+             : "cc");
+    A result = {{ r0, r1, r2, r3 }};
+    if (HPBC_UTIL_POSTCONDITION2_MACRO_IS_ACTIVE) {
+        A expected;
+        uint64_t carry2 = slow_uint_fixed_add::call(expected, a, b);
+        HPBC_UTIL_POSTCONDITION2(carry == carry2 && result == expected);
+    }
+    r = result;
+    return carry;
+  }
+};
+template <>
+struct impl_uint_fixed_sub<4> {
+  using A = std::array<std::uint64_t, 4>;
+  HURCHALLA_FORCE_INLINE static
+  std::uint64_t call(A& r, const A& a, const A& b)
+  {
+    using std::uint64_t;
+    uint64_t r0 = a[0], r1 = a[1], r2 = a[2], r3 = a[3];
+    uint64_t borrow;
+    __asm__ ("subs %[r0], %[r0], %[b0] \n\t"
+             "sbcs %[r1], %[r1], %[b1] \n\t"
+             "sbcs %[r2], %[r2], %[b2] \n\t"
+             "sbcs %[r3], %[r3], %[b3] \n\t"
+             "cset %[borrow], cc \n\t"
+             : [r0]"+&r"(r0), [r1]"+&r"(r1), [r2]"+&r"(r2), [r3]"+&r"(r3),
+               [borrow]"=r"(borrow)
+             : [b0]"r"(b[0]), [b1]"r"(b[1]), [b2]"r"(b[2]), [b3]"r"(b[3])
+             : "cc");
+    A result = {{ r0, r1, r2, r3 }};
+    if (HPBC_UTIL_POSTCONDITION2_MACRO_IS_ACTIVE) {
+        A expected;
+        uint64_t borrow2 = slow_uint_fixed_sub::call(expected, a, b);
+        HPBC_UTIL_POSTCONDITION2(borrow == borrow2 && result == expected);
+    }
+    r = result;
+    return borrow;
+  }
+};
+
+template <>
+struct impl_uint_fixed_add<8> {
+  using A = std::array<std::uint64_t, 8>;
+  HURCHALLA_FORCE_INLINE static
+  std::uint64_t call(A& r, const A& a, const A& b)
+  {
+    using std::uint64_t;
+    uint64_t r0 = a[0], r1 = a[1], r2 = a[2], r3 = a[3],
+             r4 = a[4], r5 = a[5], r6 = a[6], r7 = a[7];
+    uint64_t carry;
+    __asm__ ("adds %[r0], %[r0], %[b0] \n\t"
+             "adcs %[r1], %[r1], %[b1] \n\t"
+             "adcs %[r2], %[r2], %[b2] \n\t"
+             "adcs %[r3], %[r3], %[b3] \n\t"
+             "adcs %[r4], %[r4], %[b4] \n\t"
+             "adcs %[r5], %[r5], %[b5] \n\t"
+             "adcs %[r6], %[r6], %[b6] \n\t"
+             "adcs %[r7], %[r7], %[b7] \n\t"
+             "cset %[carry], cs \n\t"
+             : [r0]"+&r"(r0), [r1]"+&r"(r1), [r2]"+&r"(r2), [r3]"+&r"(r3),
+               [r4]"+&r"(r4), [r5]"+&r"(r5), [r6]"+&r"(r6), [r7]"+&r"(r7),
+               [carry]"=r"(carry)
+             : [b0]"r"(b[0]), [b1]"r"(b[1]), [b2]"r"(b[2]), [b3]"r"(b[3]),
+               [b4]"r"(b[4]), [b5]"r"(b[5]), [b6]"r"(b[6]), [b7]"r"(b[7])
+             : "cc");
+    A result = {{ r0, r1, r2, r3, r4, r5, r6, r7 }};
+    if (HPBC_UTIL_POSTCONDITION2_MACRO_IS_ACTIVE) {
+        A expected;
+        uint64_t carry2 = slow_uint_fixed_add::call(expected, a, b);
+        HPBC_UTIL_POSTCONDITION2(carry == carry2 && result == expected);
+    }
+    r = result;
+    return carry;
+  }
+};
+template <>
+struct impl_uint_fixed_sub<8> {
+  using A = std::array<std::uint64_t, 8>;
+  HURCHALLA_FORCE_INLINE static
+  std::uint64_t call(A& r, const A& a, const A& b)
+  {
+    using std::uint64_t;
+    uint64_t r0 = a[0], r1 = a[1], r2 = a[2], r3 = a[3],
+             r4 = a[4], r5 = a[5], r6 = a[6], r7 = a[7];
+    uint64_t borrow;
+    __asm__ ("subs %[r0], %[r0], %[b0] \n\t"
+             "sbcs %[r1], %[r1], %[b1] \n\t"
+             "sbcs %[r2], %[r2], %[b2] \n\t"
+             "sbcs %[r3], %[r3], %[b3] \n\t"
+             "sbcs %[r4], %[r4], %[b4] \n\t"
+             "sbcs %[r5], %[r5], %[b5] \n\t"
+             "sbcs %[r6], %[r6], %[b6] \n\t"
+             "sbcs %[r7], %[r7], %[b7] \n\t"
+             "cset %[borrow], cc \n\t"
+             : [r0]"+&r"(r0), [r1]"+&r"(r1), [r2]"+&r"(r2), [r3]"+&r"(r3),
+               [r4]"+&r"(r4), [r5]"+&r"(r5), [r6]"+&r"(r6), [r7]"+&r"(r7),
+               [borrow]"=r"(borrow)
+             : [b0]"r"(b[0]), [b1]"r"(b[1]), [b2]"r"(b[2]), [b3]"r"(b[3]),
+               [b4]"r"(b[4]), [b5]"r"(b[5]), [b6]"r"(b[6]), [b7]"r"(b[7])
+             : "cc");
+    A result = {{ r0, r1, r2, r3, r4, r5, r6, r7 }};
+    if (HPBC_UTIL_POSTCONDITION2_MACRO_IS_ACTIVE) {
+        A expected;
+        uint64_t borrow2 = slow_uint_fixed_sub::call(expected, a, b);
+        HPBC_UTIL_POSTCONDITION2(borrow == borrow2 && result == expected);
+    }
+    r = result;
+    return borrow;
+  }
+};
+
+#endif
+
+
+// Schoolbook multiplication.  Each step is  hi:lo = a[i]*b[j] + r[i+j] + carry
+// which can't overflow (see impl_unsigned_multiply_add_to_hilo_product.h).
+// Karatsuba isn't used; with 64 bit words its crossover point is far beyond
+// 8 words.
+struct impl_uint_fixed_mul {
+  // r = the low N words of a*b.  r must not be the same array as a or b.
+  template <std::size_t N>
+  HURCHALLA_FORCE_INLINE static void low(std::array<std::uint64_t,N>& r,
+          const std::array<std::uint64_t,N>& a,
+          const std::array<std::uint64_t,N>& b)
+  {
+    using std::uint64_t;
+    using MA = impl_unsigned_multiply_add_to_hilo_product<uint64_t>;
+    Unroll<N>::call([&](std::size_t i) HURCHALLA_INLINE_LAMBDA {
+        r[i] = 0;
+    });
+    Unroll<N>::call([&](std::size_t i) HURCHALLA_INLINE_LAMBDA {
+        uint64_t carry = 0;
+        Unroll<N>::call([&](std::size_t j) HURCHALLA_INLINE_LAMBDA {
+            if (i + j < N - 1) {
+                uint64_t lo;
+                carry = MA::call(lo, a[i], b[j], r[i+j], carry);
+                r[i+j] = lo;
+            } else if (i + j == N - 1) {
+                // only the low word of the last step is needed
+                r[i+j] = a[i] * b[j] + r[i+j] + carry;
+            }
+        });
+    });
+  }
+
+  // hi:lo = a*b.  hi and lo must not be the same array as a or b.
+  template <std::size_t N>
+  HURCHALLA_FORCE_INLINE static void full(std::array<std::uint64_t,N>& hi,
+          std::array<std::uint64_t,N>& lo,
+          const std::array<std::uint64_t,N>& a,
+          const std::array<std::uint64_t,N>& b)
+  {
+    std::uint64_t r[2*N];
+    impl_multiword_mul_n::call<N>(r, a.data(), b.data());
+    Unroll<N>::call([&](std::size_t i) HURCHALLA_INLINE_LAMBDA {
+        lo[i] = r[i];
+        hi[i] = r[i+N];
+    });
+  }
+};
+
+
+}} // end namespace
+
+#endif
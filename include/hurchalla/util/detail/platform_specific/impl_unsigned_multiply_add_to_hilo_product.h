@@ -0,0 +1,294 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#ifndef HURCHALLA_UTIL_IMPL_UNSIGNED_MULT_ADD_TO_HILO_H_INCLUDED
+#define HURCHALLA_UTIL_IMPL_UNSIGNED_MULT_ADD_TO_HILO_H_INCLUDED
+
+
+#include "hurchalla/util/detail/platform_specific/impl_unsigned_multiply_to_hilo_product.h"
+#include "hurchalla/util/traits/ut_numeric_limits.h"
+#include "hurchalla/util/compiler_macros.h"
+#include "hurchalla/util/detail/util_programming_by_contract.h"
+#include <cstdint>
+
+namespace hurchalla { namespace detail {
+
+
+// The results of u*v + a  and  u*v + a + b  always fit in two words of type T.
+// Proof: let R = 2^(digits of T).  Since u, v, a, b are each <= R-1,
+// u*v + a + b <= (R-1)*(R-1) + 2*(R-1) == R*R - 1.  So neither the addition
+// of a nor of b can carry out of the high word.
+
+
+// Works for all types, compilers and architectures.  It computes the
+// double-width product and then propagates the carry of each addition into
+// the high word.  Uses static member functions to disallow ADL.
+struct slow_unsigned_multiply_add_to_hilo_product {
+  template <typename T>
+  HURCHALLA_FORCE_INLINE static T call(T& lowResult, T u, T v, T a)
+  {
+    static_assert(ut_numeric_limits<T>::is_integer, "");
+    static_assert(!(ut_numeric_limits<T>::is_signed), "");
+    T lo;
+    T hi = impl_unsigned_multiply_to_hilo_product<T>::call(lo, u, v);
+    lo = static_cast<T>(lo + a);
+    hi = static_cast<T>(hi + static_cast<T>(lo < a));
+    lowResult = lo;
+    return hi;
+  }
+  template <typename T>
+  HURCHALLA_FORCE_INLINE static T call(T& lowResult, T u, T v, T a, T b)
+  {
+    T lo;
+    T hi = call(lo, u, v, a);
+    lo = static_cast<T>(lo + b);
+    hi = static_cast<T>(hi + static_cast<T>(lo < b));
+    lowResult = lo;
+    return hi;
+  }
+};
+
+
+// Intended as a helper for the specializations below, for types T that have
+// an unsigned integer type T2 at least twice as wide.  The compiler sees the
+// whole calculation, so it can use a multiply-accumulate instruction if the
+// ISA has one, and it can't spill a carry flag.
+struct umult_add_to_hilo_product {
+  template <typename T, typename T2>
+  HURCHALLA_FORCE_INLINE static T call(T& lowResult, T u, T v, T a)
+  {
+    static_assert(ut_numeric_limits<T2>::digits >=
+                  2*ut_numeric_limits<T>::digits, "");
+    T2 result = static_cast<T2>(static_cast<T2>(static_cast<T2>(u) *
+                                 static_cast<T2>(v)) + static_cast<T2>(a));
+    lowResult = static_cast<T>(result);
+    return static_cast<T>(result >> ut_numeric_limits<T>::digits);
+  }
+  template <typename T, typename T2>
+  HURCHALLA_FORCE_INLINE static T call(T& lowResult, T u, T v, T a, T b)
+  {
+    static_assert(ut_numeric_limits<T2>::digits >=
+                  2*ut_numeric_limits<T>::digits, "");
+    T2 result = static_cast<T2>(static_cast<T2>(static_cast<T2>(u) *
+                                 static_cast<T2>(v)) + static_cast<T2>(a));
+    result = static_cast<T2>(result + static_cast<T2>(b));
+    lowResult = static_cast<T>(result);
+    return static_cast<T>(result >> ut_numeric_limits<T>::digits);
+  }
+};
+
+
+// primary template
+template <typename T>
+struct impl_unsigned_multiply_add_to_hilo_product {
+  HURCHALLA_FORCE_INLINE static T call(T& lowResult, T u, T v, T a)
+  {
+    return slow_unsigned_multiply_add_to_hilo_product::call(lowResult, u,v,a);
+  }
+  HURCHALLA_FORCE_INLINE static T call(T& lowResult, T u, T v, T a, T b)
+  {
+    return slow_unsigned_multiply_add_to_hilo_product::call(lowResult,
+                                                            u, v, a, b);
+  }
+};
+
+template <> struct impl_unsigned_multiply_add_to_hilo_product<std::uint8_t> {
+  using T = std::uint8_t;
+  HURCHALLA_FORCE_INLINE static T call(T& lowResult, T u, T v, T a)
+  {
+    return umult_add_to_hilo_product::call<T, std::uint16_t>(lowResult,u,v,a);
+  }
+  HURCHALLA_FORCE_INLINE static T call(T& lowResult, T u, T v, T a, T b)
+  {
+    return umult_add_to_hilo_product::call<T, std::uint16_t>(lowResult,
+                                                             u, v, a, b);
+  }
+};
+template <> struct impl_unsigned_multiply_add_to_hilo_product<std::uint16_t> {
+  using T = std::uint16_t;
+  HURCHALLA_FORCE_INLINE static T call(T& lowResult, T u, T v, T a)
+  {
+    return umult_add_to_hilo_product::call<T, std::uint32_t>(lowResult,u,v,a);
+  }
+  HURCHALLA_FORCE_INLINE static T call(T& lowResult, T u, T v, T a, T b)
+  {
+    return umult_add_to_hilo_product::call<T, std::uint32_t>(lowResult,
+                                                             u, v, a, b);
+  }
+};
+template <> struct impl_unsigned_multiply_add_to_hilo_product<std::uint32_t> {
+  using T = std::uint32_t;
+  HURCHALLA_FORCE_INLINE static T call(T& lowResult, T u, T v, T a)
+  {
+    return umult_add_to_hilo_product::call<T, std::uint64_t>(lowResult,u,v,a);
+  }
+  HURCHALLA_FORCE_INLINE static T call(T& lowResult, T u, T v, T a, T b)
+  {
+    return umult_add_to_hilo_product::call<T, std::uint64_t>(lowResult,
+                                                             u, v, a, b);
+  }
+};
+
+
+// For uint64_t, gcc and clang are mostly good with __uint128_t, but once the
+// result is part of a longer carry chain (as in multiprecision or REDC code)
+// they sometimes move the carry through a register or spill.  The inline asm
+// keeps the whole calculation in one block with the carries in flags.
+
+#if (HURCHALLA_COMPILER_HAS_UINT128_T()) && \
+    defined(HURCHALLA_TARGET_ISA_X86_64) && \
+    (defined(HURCHALLA_ALLOW_INLINE_ASM_MULTIPLY_ADD_TO_HILO) || \
+     defined(HURCHALLA_ALLOW_INLINE_ASM_ALL))
+
+template <> struct impl_unsigned_multiply_add_to_hilo_product<std::uint64_t> {
+  using T = std::uint64_t;
+  HURCHALLA_FORCE_INLINE static T call(T& lowResult, T u, T v, T a)
+  {
+    T rrax = u;
+    T rrdx;
+    __asm__ ("mulq %[v] \n\t"          /* rdx:rax = rax*v (rax == u) */
+             "addq %[a], %%rax \n\t"
+             "adcq $0, %%rdx \n\t"
+             : "+&a"(rrax), "=&d"(rrdx)
+#  if defined(__clang__)       /* https://bugs.llvm.org/show_bug.cgi?id=20197 */
+             : [v]"r"(v), [a]"r"(a)
+#  else
+             : [v]"rm"(v), [a]"rm"(a)
+#  endif
+             : "cc");
+    lowResult = rrax;
+    if (HPBC_UTIL_POSTCONDITION2_MACRO_IS_ACTIVE) {
+        T low2;
+        T high2 = slow_unsigned_multiply_add_to_hilo_product::call(low2,u,v,a);
+        HPBC_UTIL_POSTCONDITION2(lowResult == low2 && rrdx == high2);
+    }
+    return rrdx;
+  }
+
+  HURCHALLA_FORCE_INLINE static T call(T& lowResult, T u, T v, T a, T b)
+  {
+#  if defined(__BMI2__) && defined(__ADX__)
+    // adcx and adox use only CF and only OF respectively, so the two
+    // additions into the low word are two independent carry chains, and
+    // their carries can both be folded into the high word afterward.  mulx
+    // doesn't touch the flags, so the xor that zeroes 'zero' also clears CF
+    // and OF for the whole sequence.
+    T rrdx = u;
+    T lo, hi, zero;
+    __asm__ ("xorl %k[zero], %k[zero] \n\t"
+             "mulxq %[v], %[lo], %[hi] \n\t"   /* hi:lo = rdx*v (rdx == u) */
+             "adcxq %[a], %[lo] \n\t"
+             "adoxq %[b], %[lo] \n\t"
+             "adcxq %[zero], %[hi] \n\t"
+             "adoxq %[zero], %[hi] \n\t"
+             : [lo]"=&r"(lo), [hi]"=&r"(hi), [zero]"=&r"(zero)
+#    if defined(__clang__)     /* https://bugs.llvm.org/show_bug.cgi?id=20197 */
+             : "d"(rrdx), [v]"r"(v), [a]"r"(a), [b]"r"(b)
+#    else
+             : "d"(rrdx), [v]"rm"(v), [a]"rm"(a), [b]"rm"(b)
+#    endif
+             : "cc");
+#  else
+    T lo = u;
+    T hi;
+    __asm__ ("mulq %[v] \n\t"          /* rdx:rax = rax*v (rax == u) */
+             "addq %[a], %%rax \n\t"
+             "adcq $0, %%rdx \n\t"
+             "addq %[b], %%rax \n\t"
+             "adcq $0, %%rdx \n\t"
+             : "+&a"(lo), "=&d"(hi)
+#    if defined(__clang__)     /* https://bugs.llvm.org/show_bug.cgi?id=20197 */
+             : [v]"r"(v), [a]"r"(a), [b]"r"(b)
+#    else
+             : [v]"rm"(v), [a]"rm"(a), [b]"rm"(b)
+#    endif
+             : "cc");
+#  endif
+    lowResult = lo;
+    if (HPBC_UTIL_POSTCONDITION2_MACRO_IS_ACTIVE) {
+        T low2;
+        T high2 = slow_unsigned_multiply_add_to_hilo_product::call(low2,
+                                                               u, v, a, b);
+        HPBC_UTIL_POSTCONDITION2(lowResult == low2 && hi == high2);
+    }
+    return hi;
+  }
+};
+
+#elif (HURCHALLA_COMPILER_HAS_UINT128_T()) && \
+      defined(HURCHALLA_TARGET_ISA_ARM_64) && \
+      (defined(HURCHALLA_ALLOW_INLINE_ASM_MULTIPLY_ADD_TO_HILO) || \
+       defined(HURCHALLA_ALLOW_INLINE_ASM_ALL))
+
+// ARM64 has madd, but it gives only the low word of u*v+a, and recovering the
+// carry from it needs a compare; mul/umulh followed by adds/adc is the same
+// number of instructions and keeps the carry in the flags.
+template <> struct impl_unsigned_multiply_add_to_hilo_product<std::uint64_t> {
+  using T = std::uint64_t;
+  HURCHALLA_FORCE_INLINE static T call(T& lowResult, T u, T v, T a)
+  {
+    T lo, hi;
+    __asm__ ("mul %[lo], %[u], %[v] \n\t"
+             "umulh %[hi], %[u], %[v] \n\t"
+             "adds %[lo], %[lo], %[a] \n\t"
+             "adc %[hi], %[hi], xzr \n\t"
+             : [lo]"=&r"(lo), [hi]"=&r"(hi)
+             : [u]"r"(u), [v]"r"(v), [a]"r"(a)
+             : "cc");
+    lowResult = lo;
+    if (HPBC_UTIL_POSTCONDITION2_MACRO_IS_ACTIVE) {
+        T low2;
+        T high2 = slow_unsigned_multiply_add_to_hilo_product::call(low2,u,v,a);
+        HPBC_UTIL_POSTCONDITION2(lowResult == low2 && hi == high2);
+    }
+    return hi;
+  }
+
+  HURCHALLA_FORCE_INLINE static T call(T& lowResult, T u, T v, T a, T b)
+  {
+    T lo, hi;
+    __asm__ ("mul %[lo], %[u], %[v] \n\t"
+             "umulh %[hi], %[u], %[v] \n\t"
+             "adds %[lo], %[lo], %[a] \n\t"
+             "adc %[hi], %[hi], xzr \n\t"
+             "adds %[lo], %[lo], %[b] \n\t"
+             "adc %[hi], %[hi], xzr \n\t"
+             : [lo]"=&r"(lo), [hi]"=&r"(hi)
+             : [u]"r"(u), [v]"r"(v), [a]"r"(a), [b]"r"(b)
+             : "cc");
+    lowResult = lo;
+    if (HPBC_UTIL_POSTCONDITION2_MACRO_IS_ACTIVE) {
+        T low2;
+        T high2 = slow_unsigned_multiply_add_to_hilo_product::call(low2,
+                                                               u, v, a, b);
+        HPBC_UTIL_POSTCONDITION2(lowResult == low2 && hi == high2);
+    }
+    return hi;
+  }
+};
+
+#elif (HURCHALLA_COMPILER_HAS_UINT128_T())
+
+template <> struct impl_unsigned_multiply_add_to_hilo_product<std::uint64_t> {
+  using T = std::uint64_t;
+  HURCHALLA_FORCE_INLINE static T call(T& lowResult, T u, T v, T a)
+  {
+    return umult_add_to_hilo_product::call<T, __uint128_t>(lowResult,u,v,a);
+  }
+  HURCHALLA_FORCE_INLINE static T call(T& lowResult, T u, T v, T a, T b)
+  {
+    return umult_add_to_hilo_product::call<T, __uint128_t>(lowResult,
+                                                           u, v, a, b);
+  }
+};
+
+#endif
+// For MSVC, the primary template's composition with _umul128 (x64) or
+// __umulh (ARM64) is used for uint64_t, and likewise for __uint128_t on all
+// compilers, where the product comes from the __uint128_t specializations of
+// impl_unsigned_multiply_to_hilo_product.
+
+
+}} // end namespace
+
+#endif
@@ -9,18 +9,17 @@
 #include "hurchalla/util/traits/safely_promote_unsigned.h"
 #include "hurchalla/util/traits/ut_numeric_limits.h"
 #include "hurchalla/util/sized_uint.h"
+#include "hurchalla/util/Unroll.h"
 #include "hurchalla/util/compiler_macros.h"
 #include "hurchalla/util/detail/util_programming_by_contract.h"
 #include <cstdint>
+#include <cstddef>
+#include <type_traits>
 #if defined(_MSC_VER)
 #  include <intrin.h>
 #  pragma warning(push)
 #  pragma warning(disable : 4127)
 #endif
-#ifdef __clang__
-#  pragma GCC diagnostic push
-#  pragma GCC diagnostic ignored "-Wc++98-c++11-c++14-compat"
-#endif
 
 namespace hurchalla { namespace detail {
 
@@ -32,13 +31,40 @@ struct impl_unsigned_multiply_to_hilo_product;
 // Return Value:
 //   Returns the high portion of the product.
 // Notes:
-//   - I adapted this code from https://stackoverflow.com/a/58381061
-//     On ARM32 with clang it compiles nicely with T=uint64_t, using the UMAAL
-//     instruction (you may need -march=armv7-a or similar)
-//   - Uses static member function to disallow ADL.
+//   - call() uses by_limbs() for class types (which the compiler doesn't
+//     natively support) that are a whole number of native words wide, for
+//     example a user-defined 256 or 512 bit type, so that the product is
+//     computed entirely with native multiplies.  Otherwise it uses
+//     by_halves().  (uint_fixed has its own specialization of
+//     impl_unsigned_multiply_to_hilo_product, in uint_fixed.h.)
+//   - Uses static member functions to disallow ADL.
 struct slow_unsigned_multiply_to_hilo_product {
+  // The widest type that we expect to have a native double-width multiply,
+  // via impl_unsigned_multiply_to_hilo_product.
+  using Limb = typename sized_uint<(HURCHALLA_TARGET_BIT_WIDTH >= 64) ? 64
+                                                                  : 32>::type;
+
   template <typename T>
   HURCHALLA_FORCE_INLINE static T call(T& lowProduct, T u, T v)
+  {
+    static_assert(ut_numeric_limits<T>::is_integer, "");
+    static_assert(!(ut_numeric_limits<T>::is_signed), "");
+    constexpr int digits = ut_numeric_limits<T>::digits;
+    constexpr int limb_digits = ut_numeric_limits<Limb>::digits;
+    using use_limbs = std::integral_constant<bool,
+                                   std::is_class<T>::value &&
+                                   (digits > limb_digits) &&
+                                   (digits % limb_digits == 0)>;
+    return dispatch(lowProduct, u, v, use_limbs());
+  }
+
+  // Splits u and v into halves held in type T, and computes the four cross
+  // products with T's own multiply.
+  // I adapted this code from https://stackoverflow.com/a/58381061
+  // On ARM32 with clang it compiles nicely with T=uint64_t, using the UMAAL
+  // instruction (you may need -march=armv7-a or similar)
+  template <typename T>
+  HURCHALLA_FORCE_INLINE static T by_halves(T& lowProduct, T u, T v)
   {
     static_assert(ut_numeric_limits<T>::is_integer, "");
     static_assert(!(ut_numeric_limits<T>::is_signed), "");
@@ -48,76 +74,102 @@ struct slow_unsigned_multiply_to_hilo_product {
     // for example, if T==uint64_t, lowmask ought to == 0xFFFFFFFF
     static constexpr T lowmask = (static_cast<T>(1)<<shift) - static_cast<T>(1);
 
-#if __cplusplus >= 201703L
-    // The intent here is to find out if T is an integral type that the compiler
-    // has in-built support for (and thus, that it could optimize well).  If
-    // it is not, then we use this if clause - which ensures via recursion that
-    // the compiler gets a type that it can optimize well.
-    // To use the contents of this if clause, we also need sized_uint<shift> to
-    // be valid, which is why we test for that too.
-    //
-    // It's not ideal currently that the clause relies on sized_uint<shift>,
-    // since effectively that means the clause can only run when T is twice as
-    // big as the largest integer the compiler supports.  E.g. - currently this
-    // clause will not run when T is 4x or 8x the size of largest integer the
-    // compiler knows, which is not ideal.
-    if constexpr (!is_valid_sized_uint<ut_numeric_limits<T>::digits>::value &&
-                  is_valid_sized_uint<static_cast<int>(shift)>::value)
-    {
-      using U = typename sized_uint<static_cast<int>(shift)>::type;
-
-      U u0 = static_cast<U>(u);
-      U v0 = static_cast<U>(v);
-      U u1 = static_cast<U>(u >> shift);
-      U v1 = static_cast<U>(v >> shift);
-
-      // Calculate all the cross products.
-      U lo_lo_0;  U lo_lo_1 = impl_unsigned_multiply_to_hilo_product<U>::call(
-                                                               lo_lo_0, u0, v0);
-      U hi_lo_0;  U hi_lo_1 = impl_unsigned_multiply_to_hilo_product<U>::call(
-                                                               hi_lo_0, u1, v0);
-      U lo_hi_0;  U lo_hi_1 = impl_unsigned_multiply_to_hilo_product<U>::call(
-                                                               lo_hi_0, u0, v1);
-      U hi_hi_0;  U hi_hi_1 = impl_unsigned_multiply_to_hilo_product<U>::call(
-                                                               hi_hi_0, u1, v1);
-
-      T lo_hi = (static_cast<T>(lo_hi_1) << shift) | static_cast<T>(lo_hi_0);
-      T hi_hi = (static_cast<T>(hi_hi_1) << shift) | static_cast<T>(hi_hi_0);
-
-      // See the else clause below for why this works.  It is a direct
-      // translation of the corresponding part of the else clause.
-      T cross = static_cast<T>(lo_lo_1) + static_cast<T>(hi_lo_0) + lo_hi;
-      T high = static_cast<T>(hi_lo_1) + (cross >> shift) + hi_hi;
-
-      lowProduct = (cross << shift) | static_cast<T>(lo_lo_0);
-      return high;
-    }
-    else
-#endif
-    {
-      T u0 = u & lowmask;
-      T v0 = v & lowmask;
-      T u1 = u >> shift;
-      T v1 = v >> shift;
-
-      // Calculate all the cross products.
-      T lo_lo = u0 * v0;
-      T hi_lo = u1 * v0;
-      T lo_hi = u0 * v1;
-      T hi_hi = u1 * v1;
-
-      // The next statement will not overflow.  Proof: let S=2^(shift). We can see
-      // that both (lo_lo >> shift) and (hi_lo & lowmask) must be less than S.
-      // Therefore the max possible value of cross= (S-1) + (S-1) + (S-1)*(S-1) ==
-      // S-1 + S-1 + S*S - 2*S + 1 == S*S - 1, which is the max value that can be
-      // represented in type T.  Thus the calculation will never overflow.
-      T cross = (lo_lo >> shift) + (hi_lo & lowmask) + lo_hi;
-      // The next statement will not overflow, for the same reason as above.
-      T high = (hi_lo >> shift) + (cross >> shift) + hi_hi;
-
-      lowProduct = (cross << shift) | (lo_lo & lowmask);
-      return high;
-    }
+    T u0 = u & lowmask;
+    T v0 = v & lowmask;
+    T u1 = u >> shift;
+    T v1 = v >> shift;
+
+    // Calculate all the cross products.
+    T lo_lo = u0 * v0;
+    T hi_lo = u1 * v0;
+    T lo_hi = u0 * v1;
+    T hi_hi = u1 * v1;
+
+    // The next statement will not overflow.  Proof: let S=2^(shift). We can see
+    // that both (lo_lo >> shift) and (hi_lo & lowmask) must be less than S.
+    // Therefore the max possible value of cross= (S-1) + (S-1) + (S-1)*(S-1) ==
+    // S-1 + S-1 + S*S - 2*S + 1 == S*S - 1, which is the max value that can be
+    // represented in type T.  Thus the calculation will never overflow.
+    T cross = (lo_lo >> shift) + (hi_lo & lowmask) + lo_hi;
+    // The next statement will not overflow, for the same reason as above.
+    T high = (hi_lo >> shift) + (cross >> shift) + hi_hi;
+
+    lowProduct = (cross << shift) | (lo_lo & lowmask);
+    return high;
+  }
+
+  // Splits u and v into N words of type L, computes their 2N word product by
+  // schoolbook multiplication using L's native double-width multiply, and
+  // reassembles the product into T.  T must be constructible from L, and
+  // static_cast<L>(T) must give the low bits of T.
+  // Karatsuba isn't used: with 64 bit words its crossover point is around
+  // 20-30 words, far beyond the 4 and 8 word (256 and 512 bit) types that
+  // this is meant for.
+  template <typename T, typename L = Limb>
+  HURCHALLA_FORCE_INLINE static T by_limbs(T& lowProduct, T u, T v)
+  {
+    static_assert(ut_numeric_limits<T>::is_integer, "");
+    static_assert(!(ut_numeric_limits<T>::is_signed), "");
+    static_assert(ut_numeric_limits<L>::is_integer, "");
+    static_assert(!(ut_numeric_limits<L>::is_signed), "");
+    constexpr unsigned int limb_bits =
+                           static_cast<unsigned int>(ut_numeric_limits<L>::digits);
+    static_assert(ut_numeric_limits<T>::digits % limb_bits == 0, "");
+    constexpr std::size_t N = static_cast<std::size_t>(
+                              ut_numeric_limits<T>::digits) / limb_bits;
+    static_assert(N >= 2, "");
+
+    // The loops are unrolled with Unroll<N>, since gcc at -O2 otherwise
+    // leaves them as loops with the words in memory.
+    L a[N], b[N], r[2*N];
+    Unroll<N>::call([&](std::size_t i) HURCHALLA_INLINE_LAMBDA {
+        a[i] = static_cast<L>(u);
+        b[i] = static_cast<L>(v);
+        u = u >> limb_bits;
+        v = v >> limb_bits;
+        r[i] = 0;
+    });
+    Unroll<N>::call([&](std::size_t i) HURCHALLA_INLINE_LAMBDA {
+        L carry = 0;
+        Unroll<N>::call([&](std::size_t j) HURCHALLA_INLINE_LAMBDA {
+            // hi:lo = a[i]*b[j] + r[i+j] + carry, which can't overflow (the
+            // max is (2^limb_bits)^2 - 1)
+            L lo;
+            L hi = impl_unsigned_multiply_to_hilo_product<L>::call(lo,
+                                                                 a[i], b[j]);
+            lo = static_cast<L>(lo + r[i+j]);
+            hi = static_cast<L>(hi + static_cast<L>(lo < r[i+j]));
+            lo = static_cast<L>(lo + carry);
+            hi = static_cast<L>(hi + static_cast<L>(lo < carry));
+            r[i+j] = lo;
+            carry = hi;
+        });
+        r[i+N] = carry;
+    });
+
+    T low = static_cast<T>(r[N-1]);
+    T high = static_cast<T>(r[2*N-1]);
+    Unroll<N-1>::call([&](std::size_t k) HURCHALLA_INLINE_LAMBDA {
+        std::size_t i = N - 2 - k;
+        low = (low << limb_bits) | static_cast<T>(r[i]);
+        high = (high << limb_bits) | static_cast<T>(r[i+N]);
+    });
+    lowProduct = low;
+    return high;
+  }
+
+private:
+  template <typename T>
+  HURCHALLA_FORCE_INLINE static
+  T dispatch(T& lowProduct, T u, T v, std::true_type)
+  {
+    return by_limbs(lowProduct, u, v);
+  }
+  template <typename T>
+  HURCHALLA_FORCE_INLINE static
+  T dispatch(T& lowProduct, T u, T v, std::false_type)
+  {
+    return by_halves(lowProduct, u, v);
   }
 };
 
@@ -558,9 +610,6 @@ template <> struct impl_unsigned_multiply_to_hilo_product<__uint128_t> {
 }} // end namespace
 
 
-#ifdef __clang__
-#  pragma GCC diagnostic pop
-#endif
 #if defined(_MSC_VER)
 #  pragma warning(pop)
 #endif
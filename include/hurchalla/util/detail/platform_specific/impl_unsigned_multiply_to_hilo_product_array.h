@@ -0,0 +1,184 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#ifndef HURCHALLA_UTIL_IMPL_UNSIGNED_MULT_TO_HILO_ARRAY_H_INCLUDED
+#define HURCHALLA_UTIL_IMPL_UNSIGNED_MULT_TO_HILO_ARRAY_H_INCLUDED
+
+// note: in order to get the SIMD versions of these functions, you must define
+// HURCHALLA_ALLOW_SIMD_MULTIPLY_TO_HILO or HURCHALLA_ALLOW_SIMD_ALL, and you
+// must compile for an ISA extension that they support (for example, with gcc
+// or clang, -mavx2 or -march=native).  The kernels are chosen at compile time:
+//   uint32_t, x86: AVX2 (__AVX2__), using vpmuludq
+//   uint32_t, ARM64: NEON (__ARM_NEON), using umull/umull2
+//   uint64_t, x86: AVX-512 IFMA (__AVX512IFMA__ and __AVX512F__), using
+//                  vpmadd52luq/vpmadd52huq
+// Every other type and ISA, and the elements left over after the last full
+// SIMD vector, use the scalar unsigned_multiply_to_hilo_product() - which for
+// uint64_t on x86-64 is a mul or mulx per element (mulx when compiling for
+// BMI2).  All kernels produce output identical to the scalar function.
+
+
+#include "hurchalla/util/detail/platform_specific/impl_unsigned_multiply_to_hilo_product.h"
+#include "hurchalla/util/compiler_macros.h"
+#include "hurchalla/util/detail/util_programming_by_contract.h"
+#include <cstdint>
+#include <cstddef>
+
+#if (defined(HURCHALLA_ALLOW_SIMD_MULTIPLY_TO_HILO) || \
+     defined(HURCHALLA_ALLOW_SIMD_ALL))
+#  if (defined(HURCHALLA_TARGET_ISA_X86_64) || \
+       defined(HURCHALLA_TARGET_ISA_X86_32))
+#    if defined(__AVX2__)
+#      define HURCHALLA_MULTIPLY_TO_HILO_ARRAY_AVX2 1
+#    endif
+#    if defined(__AVX512IFMA__) && defined(__AVX512F__)
+#      define HURCHALLA_MULTIPLY_TO_HILO_ARRAY_AVX512IFMA 1
+#    endif
+#    if defined(HURCHALLA_MULTIPLY_TO_HILO_ARRAY_AVX2) || \
+        defined(HURCHALLA_MULTIPLY_TO_HILO_ARRAY_AVX512IFMA)
+#      include <immintrin.h>
+#    endif
+#  elif defined(HURCHALLA_TARGET_ISA_ARM_64) && defined(__ARM_NEON)
+#    define HURCHALLA_MULTIPLY_TO_HILO_ARRAY_NEON 1
+#    include <arm_neon.h>
+#  endif
+#endif
+
+namespace hurchalla { namespace detail {
+
+
+// Each call() computes, for every i in [0, n),  hi[i]:lo[i] = u[i] * v[i].
+// hi and lo must not overlap each other, but either may be the same array as
+// u or v (every kernel loads a vector of u and v before storing to hi or lo).
+template <typename T>
+struct impl_unsigned_multiply_to_hilo_product_array {
+    static void call(T* hi, T* lo, const T* u, const T* v, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i) {
+            T low;
+            T high = impl_unsigned_multiply_to_hilo_product<T>::call(low,
+                                                                   u[i], v[i]);
+            hi[i] = high;
+            lo[i] = low;
+        }
+    }
+};
+
+
+#if defined(HURCHALLA_MULTIPLY_TO_HILO_ARRAY_AVX2) || \
+    defined(HURCHALLA_MULTIPLY_TO_HILO_ARRAY_NEON)
+template <>
+struct impl_unsigned_multiply_to_hilo_product_array<std::uint32_t> {
+    using T = std::uint32_t;
+    static void call(T* hi, T* lo, const T* u, const T* v, std::size_t n)
+    {
+        std::size_t i = 0;
+#  if defined(HURCHALLA_MULTIPLY_TO_HILO_ARRAY_AVX2)
+        // vpmuludq multiplies the low 32 bits of each 64 bit lane, giving
+        // the products of the even elements; shifting each lane right by 32
+        // first gives the products of the odd elements.
+        for (; n - i >= 8; i += 8) {
+            __m256i a = _mm256_loadu_si256(static_cast<const __m256i*>(
+                                          static_cast<const void*>(u + i)));
+            __m256i b = _mm256_loadu_si256(static_cast<const __m256i*>(
+                                          static_cast<const void*>(v + i)));
+            __m256i even = _mm256_mul_epu32(a, b);
+            __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32),
+                                           _mm256_srli_epi64(b, 32));
+            __m256i vlo = _mm256_blend_epi32(even,
+                                       _mm256_slli_epi64(odd, 32), 0xAA);
+            __m256i vhi = _mm256_blend_epi32(_mm256_srli_epi64(even, 32),
+                                       odd, 0xAA);
+            _mm256_storeu_si256(static_cast<__m256i*>(
+                                          static_cast<void*>(lo + i)), vlo);
+            _mm256_storeu_si256(static_cast<__m256i*>(
+                                          static_cast<void*>(hi + i)), vhi);
+        }
+#  else
+        // umull/umull2 give the 64 bit products of the low and high pairs of
+        // elements; uzp1/uzp2 separate their low and high halves.
+        for (; n - i >= 4; i += 4) {
+            uint32x4_t a = vld1q_u32(u + i);
+            uint32x4_t b = vld1q_u32(v + i);
+            uint32x4_t p01 = vreinterpretq_u32_u64(
+                                 vmull_u32(vget_low_u32(a), vget_low_u32(b)));
+            uint32x4_t p23 = vreinterpretq_u32_u64(vmull_high_u32(a, b));
+            vst1q_u32(lo + i, vuzp1q_u32(p01, p23));
+            vst1q_u32(hi + i, vuzp2q_u32(p01, p23));
+        }
+#  endif
+        for (; i < n; ++i) {
+            std::uint64_t p = static_cast<std::uint64_t>(u[i]) * v[i];
+            hi[i] = static_cast<T>(p >> 32);
+            lo[i] = static_cast<T>(p);
+        }
+    }
+};
+#endif
+
+
+#if defined(HURCHALLA_MULTIPLY_TO_HILO_ARRAY_AVX512IFMA)
+template <>
+struct impl_unsigned_multiply_to_hilo_product_array<std::uint64_t> {
+    using T = std::uint64_t;
+    // vpmadd52luq/vpmadd52huq add the low/high 52 bits of the 104 bit
+    // product of the low 52 bits of each lane.  Splitting each operand into
+    // x = x1*2^52 + x0  (x1 < 2^12, x0 < 2^52):
+    //   u*v = u0*v0 + (u1*v0 + u0*v1)*2^52 + u1*v1*2^104
+    // and accumulating the 52 bit product halves by their weight gives
+    //   t0 = lo52(u0*v0)                                      (< 2^52)
+    //   t1 = hi52(u0*v0) + lo52(u1*v0) + lo52(u0*v1)          (< 2^54)
+    //   t2 = hi52(u1*v0) + hi52(u0*v1) + lo52(u1*v1)          (< 2^26)
+    // with u*v = t0 + t1*2^52 + t2*2^104.  Since t0 < 2^52,
+    //   lo = t0 + (t1 << 52)  (mod 2^64)
+    //   hi = (t1 >> 12) + (t2 << 40)
+    // and neither sum carries.
+    static void call(T* hi, T* lo, const T* u, const T* v, std::size_t n)
+    {
+        const __m512i mask52 = _mm512_set1_epi64(
+                                   static_cast<long long>((1ULL << 52) - 1));
+        const __m512i zero = _mm512_setzero_si512();
+        // gcc 12's unmasked 512 bit shift intrinsics can trigger a spurious
+        // -Wmaybe-uninitialized inside its own headers.  The zero-masking
+        // forms with an all-ones mask compile to the same instructions.
+        const __mmask8 all = 0xFF;
+        std::size_t i = 0;
+        for (; n - i >= 8; i += 8) {
+            __m512i a = _mm512_loadu_si512(u + i);
+            __m512i b = _mm512_loadu_si512(v + i);
+            __m512i a0 = _mm512_and_si512(a, mask52);
+            __m512i b0 = _mm512_and_si512(b, mask52);
+            __m512i a1 = _mm512_maskz_srli_epi64(all, a, 52);
+            __m512i b1 = _mm512_maskz_srli_epi64(all, b, 52);
+
+            __m512i t0 = _mm512_madd52lo_epu64(zero, a0, b0);
+            __m512i t1 = _mm512_madd52hi_epu64(zero, a0, b0);
+            t1 = _mm512_madd52lo_epu64(t1, a1, b0);
+            t1 = _mm512_madd52lo_epu64(t1, a0, b1);
+            __m512i t2 = _mm512_madd52hi_epu64(zero, a1, b0);
+            t2 = _mm512_madd52hi_epu64(t2, a0, b1);
+            t2 = _mm512_madd52lo_epu64(t2, a1, b1);
+
+            __m512i vlo = _mm512_or_si512(t0,
+                                     _mm512_maskz_slli_epi64(all, t1, 52));
+            __m512i vhi = _mm512_add_epi64(
+                                     _mm512_maskz_srli_epi64(all, t1, 12),
+                                     _mm512_maskz_slli_epi64(all, t2, 40));
+            _mm512_storeu_si512(lo + i, vlo);
+            _mm512_storeu_si512(hi + i, vhi);
+        }
+        for (; i < n; ++i) {
+            T low;
+            T high = impl_unsigned_multiply_to_hilo_product<T>::call(low,
+                                                                   u[i], v[i]);
+            hi[i] = high;
+            lo[i] = low;
+        }
+    }
+};
+#endif
+
+
+}} // end namespace
+
+#endif
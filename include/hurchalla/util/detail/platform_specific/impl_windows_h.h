@@ -0,0 +1,34 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#ifndef HURCHALLA_UTIL_IMPL_WINDOWS_H_H_INCLUDED
+#define HURCHALLA_UTIL_IMPL_WINDOWS_H_H_INCLUDED
+
+
+// Includes <windows.h> (on Windows only) with WIN32_LEAN_AND_MEAN and
+// NOMINMAX, without leaving either macro defined for the code that includes
+// our headers: we only define them if the includer hadn't, and we #undef
+// whichever ones we defined once <windows.h> is in.
+
+#if defined(_WIN32)
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN
+#    define HURCHALLA_UTIL_DEFINED_WIN32_LEAN_AND_MEAN 1
+#  endif
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#    define HURCHALLA_UTIL_DEFINED_NOMINMAX 1
+#  endif
+#  include <windows.h>
+#  ifdef HURCHALLA_UTIL_DEFINED_WIN32_LEAN_AND_MEAN
+#    undef WIN32_LEAN_AND_MEAN
+#    undef HURCHALLA_UTIL_DEFINED_WIN32_LEAN_AND_MEAN
+#  endif
+#  ifdef HURCHALLA_UTIL_DEFINED_NOMINMAX
+#    undef NOMINMAX
+#    undef HURCHALLA_UTIL_DEFINED_NOMINMAX
+#  endif
+#endif
+
+
+#endif
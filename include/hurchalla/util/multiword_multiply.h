@@ -0,0 +1,118 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#ifndef HURCHALLA_UTIL_MULTIWORD_MULTIPLY_H_INCLUDED
+#define HURCHALLA_UTIL_MULTIWORD_MULTIPLY_H_INCLUDED
+
+// note: in order to get the inline asm (potentially faster) versions of these
+// functions, you must define HURCHALLA_ALLOW_INLINE_ASM_MULTIWORD_MULTIPLY or
+// HURCHALLA_ALLOW_INLINE_ASM_ALL, and compile for x86-64 with BMI2 and ADX.
+// See impl_multiword_multiply.h.
+
+
+#include "hurchalla/util/detail/platform_specific/impl_multiword_multiply.h"
+#include "hurchalla/util/traits/ut_numeric_limits.h"
+#include "hurchalla/util/compiler_macros.h"
+#include "hurchalla/util/detail/util_programming_by_contract.h"
+#include <array>
+#include <cstddef>
+
+namespace hurchalla {
+
+
+// Multiword multiplication kernels, modeled on GMP's mpn layer.  A multiword
+// number is an array of N words of unsigned integer type T, with word [0] the
+// least significant.  N is a compile time constant, and every loop is fully
+// unrolled.  These are the inner loops of schoolbook and Montgomery
+// multiplication of multiword numbers.
+//
+// The pointer versions need N to be given explicitly, e.g. mul_1<4>(r, a, b).
+// The std::array versions deduce it.
+//
+// For mul_1, addmul_1 and submul_1, r may be the same array as a (in-place),
+// but the two must not otherwise overlap.
+
+
+// r = the low N words of a*b.  Returns the high word of a*b.
+template <std::size_t N, typename T>
+HURCHALLA_FORCE_INLINE T mul_1(T* r, const T* a, T b)
+{
+    static_assert(ut_numeric_limits<T>::is_integer, "");
+    static_assert(!(ut_numeric_limits<T>::is_signed), "");
+    static_assert(N > 0, "");
+    HPBC_UTIL_PRECONDITION2(r != nullptr && a != nullptr);
+    return detail::impl_multiword_multiply<T, N>::mul_1(r, a, b);
+}
+
+// r = the low N words of r + a*b.  Returns the high word of r + a*b (the
+// carry), which never overflows.
+template <std::size_t N, typename T>
+HURCHALLA_FORCE_INLINE T addmul_1(T* r, const T* a, T b)
+{
+    static_assert(ut_numeric_limits<T>::is_integer, "");
+    static_assert(!(ut_numeric_limits<T>::is_signed), "");
+    static_assert(N > 0, "");
+    HPBC_UTIL_PRECONDITION2(r != nullptr && a != nullptr);
+    return detail::impl_multiword_multiply<T, N>::addmul_1(r, a, b);
+}
+
+// r = the low N words of r - a*b.  Returns the borrow: the word w for which
+// (the old r) - a*b + w*2^(N*digits) == (the new r), where digits is the bit
+// width of T.
+template <std::size_t N, typename T>
+HURCHALLA_FORCE_INLINE T submul_1(T* r, const T* a, T b)
+{
+    static_assert(ut_numeric_limits<T>::is_integer, "");
+    static_assert(!(ut_numeric_limits<T>::is_signed), "");
+    static_assert(N > 0, "");
+    HPBC_UTIL_PRECONDITION2(r != nullptr && a != nullptr);
+    return detail::impl_multiword_multiply<T, N>::submul_1(r, a, b);
+}
+
+// r = a*b, where r has 2*N words.  r must not overlap a or b.
+template <std::size_t N, typename T>
+HURCHALLA_FORCE_INLINE void mul_n(T* r, const T* a, const T* b)
+{
+    static_assert(ut_numeric_limits<T>::is_integer, "");
+    static_assert(!(ut_numeric_limits<T>::is_signed), "");
+    static_assert(N > 0, "");
+    HPBC_UTIL_PRECONDITION2(r != nullptr && a != nullptr && b != nullptr);
+    detail::impl_multiword_mul_n::call<N>(r, a, b);
+}
+
+
+// std::array versions
+
+template <typename T, std::size_t N>
+HURCHALLA_FORCE_INLINE
+T mul_1(std::array<T, N>& r, const std::array<T, N>& a, T b)
+{
+    return mul_1<N>(r.data(), a.data(), b);
+}
+
+template <typename T, std::size_t N>
+HURCHALLA_FORCE_INLINE
+T addmul_1(std::array<T, N>& r, const std::array<T, N>& a, T b)
+{
+    return addmul_1<N>(r.data(), a.data(), b);
+}
+
+template <typename T, std::size_t N>
+HURCHALLA_FORCE_INLINE
+T submul_1(std::array<T, N>& r, const std::array<T, N>& a, T b)
+{
+    return submul_1<N>(r.data(), a.data(), b);
+}
+
+template <typename T, std::size_t N>
+HURCHALLA_FORCE_INLINE
+void mul_n(std::array<T, 2*N>& r, const std::array<T, N>& a,
+           const std::array<T, N>& b)
+{
+    mul_n<N>(r.data(), a.data(), b.data());
+}
+
+
+} // end namespace
+
+#endif
@@ -60,6 +60,18 @@ template <typename DUMMY> struct sized_uint<64, DUMMY>
   };
 #endif
 
+// The types wider than 128 bits are uint_fixed, which is only declared here.
+// To use them you need to include "hurchalla/util/uint_fixed.h".
+template <int BITS> class uint_fixed;
+template <typename DUMMY> struct sized_uint<256, DUMMY>
+{
+    using type = uint_fixed<256>;
+};
+template <typename DUMMY> struct sized_uint<512, DUMMY>
+{
+    using type = uint_fixed<512>;
+};
+
 
 
 // Utility trait to determine (at compile time) if a particular sized_uint is
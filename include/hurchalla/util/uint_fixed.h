@@ -0,0 +1,492 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#ifndef HURCHALLA_UTIL_UINT_FIXED_H_INCLUDED
+#define HURCHALLA_UTIL_UINT_FIXED_H_INCLUDED
+
+
+#include "hurchalla/util/detail/platform_specific/impl_uint_fixed.h"
+#include "hurchalla/util/detail/platform_specific/impl_unsigned_multiply_to_hilo_product.h"
+#include "hurchalla/util/traits/extensible_make_unsigned.h"
+#include "hurchalla/util/traits/ut_numeric_limits.h"
+#include "hurchalla/util/sized_uint.h"
+#include "hurchalla/util/Unroll.h"
+#include "hurchalla/util/compiler_macros.h"
+#include "hurchalla/util/detail/util_programming_by_contract.h"
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+namespace hurchalla {
+
+
+// uint_fixed<BITS> is an unsigned integer type of BITS bits, for widths that
+// are beyond the compiler's native types.  BITS must be a multiple of 64, and
+// at least 128.  sized_uint<256>::type is uint_fixed<256>, and
+// sized_uint<512>::type is uint_fixed<512>.
+//
+// It behaves like a native unsigned integer type:
+//   - arithmetic is modulo 2^BITS
+//   - it implicitly converts from any native integer type, with the same
+//     result as a native conversion (a negative value is sign extended)
+//   - it converts to a native integer type with static_cast, which gives the
+//     low bits
+//   - shifting by BITS or more, or by a negative amount, is undefined
+//     (a precondition)
+// and ut_numeric_limits, extensible_make_unsigned and safely_promote_unsigned
+// all support it, so the unsigned functions in this library, such as
+// unsigned_multiply_to_hilo_product, accept it.  Division and remainder are
+// not provided.
+//
+// The value is stored as a std::array of N uint64_t limbs, with limb [0] the
+// least significant.  Addition, subtraction and comparison can use inline asm
+// carry chains (see impl_uint_fixed.h).  The shifts are branchless: the shift
+// amount chooses the result's limbs by masking, and never by branching.
+//
+// There is no signed counterpart, so extensible_make_signed is not
+// specialized for uint_fixed.
+//
+// (uint_fixed is declared in sized_uint.h.)
+
+
+namespace detail {
+  // C++11 doesn't have std::index_sequence
+  template <std::size_t... I> struct uint_fixed_index_list {};
+  template <std::size_t K, std::size_t... I>
+  struct uint_fixed_make_index_list :
+                             uint_fixed_make_index_list<K-1, K-1, I...> {};
+  template <std::size_t... I>
+  struct uint_fixed_make_index_list<0, I...> {
+      using type = uint_fixed_index_list<I...>;
+  };
+
+  template <typename U>
+  struct uint_fixed_is_native_integer : std::integral_constant<bool,
+                !std::is_class<U>::value && ut_numeric_limits<U>::is_integer> {};
+
+  // Converts a native integer x to limbs.  Everything is constexpr, in C++11
+  // form, so that uint_fixed's constructors can be constexpr.
+  struct uint_fixed_from_native {
+      template <typename U>
+      static constexpr std::uint64_t extension(U, std::false_type /*signed*/)
+      {
+          return 0;
+      }
+      template <typename U>
+      static constexpr std::uint64_t extension(U x, std::true_type /*signed*/)
+      {
+          return (x < 0) ? ~static_cast<std::uint64_t>(0) : 0;
+      }
+      template <typename U>
+      static constexpr std::uint64_t limb(U x, std::size_t i,
+                                          std::false_type /*wider than 64*/)
+      {
+          return (i == 0) ? static_cast<std::uint64_t>(x) :
+              extension(x, std::integral_constant<bool,
+                                           ut_numeric_limits<U>::is_signed>());
+      }
+      template <typename U>
+      static constexpr std::uint64_t limb(U x, std::size_t i,
+                                          std::true_type /*wider than 64*/)
+      {
+          return (i == 0) ? static_cast<std::uint64_t>(x) :
+                 (i == 1) ? static_cast<std::uint64_t>(x >> 64) :
+              extension(x, std::integral_constant<bool,
+                                           ut_numeric_limits<U>::is_signed>());
+      }
+      template <std::size_t N, typename U, std::size_t... I>
+      static constexpr std::array<std::uint64_t, N>
+      call(U x, uint_fixed_index_list<I...>)
+      {
+          static_assert(ut_numeric_limits<U>::digits <= 128, "");
+          return {{ limb(x, I, std::integral_constant<bool,
+                                   (ut_numeric_limits<U>::digits > 64)>())... }};
+      }
+  };
+}
+
+
+template <int BITS>
+class uint_fixed {
+    static_assert(BITS % 64 == 0 && BITS >= 128, "");
+public:
+    static constexpr std::size_t N = static_cast<std::size_t>(BITS) / 64;
+    using limb_array = std::array<std::uint64_t, N>;
+
+    constexpr uint_fixed() noexcept : limbs() {}
+
+    template <typename U, typename std::enable_if<
+              detail::uint_fixed_is_native_integer<U>::value, int>::type = 0>
+    constexpr uint_fixed(U x) noexcept :
+        limbs(detail::uint_fixed_from_native::call<N>(x,
+                     typename detail::uint_fixed_make_index_list<N>::type())) {}
+
+    constexpr explicit uint_fixed(const limb_array& x) noexcept : limbs(x) {}
+
+    // truncates or zero extends, like a conversion between native types
+    template <int B2, typename std::enable_if<B2 != BITS, int>::type = 0>
+    explicit uint_fixed(const uint_fixed<B2>& x) noexcept : limbs()
+    {
+        constexpr std::size_t M = (uint_fixed<B2>::N < N) ? uint_fixed<B2>::N
+                                                          : N;
+        Unroll<M>::call([&](std::size_t i) HURCHALLA_INLINE_LAMBDA {
+            limbs[i] = x.getLimbs()[i];
+        });
+    }
+
+    const limb_array& getLimbs() const noexcept { return limbs; }
+
+    // gives the low bits of the value, like a conversion between native types
+    template <typename U, typename std::enable_if<
+              detail::uint_fixed_is_native_integer<U>::value &&
+              !std::is_same<U, bool>::value, int>::type = 0>
+    explicit operator U() const noexcept
+    {
+        return to_native<U>(std::integral_constant<bool,
+                                   (ut_numeric_limits<U>::digits > 64)>());
+    }
+    explicit operator bool() const noexcept
+    {
+        std::uint64_t x = 0;
+        Unroll<N>::call([&](std::size_t i) HURCHALLA_INLINE_LAMBDA {
+            x |= limbs[i];
+        });
+        return x != 0;
+    }
+
+
+    friend uint_fixed operator+(const uint_fixed& a, const uint_fixed& b)
+    {
+        uint_fixed r;
+        detail::impl_uint_fixed_add<N>::call(r.limbs, a.limbs, b.limbs);
+        return r;
+    }
+    friend uint_fixed operator-(const uint_fixed& a, const uint_fixed& b)
+    {
+        uint_fixed r;
+        detail::impl_uint_fixed_sub<N>::call(r.limbs, a.limbs, b.limbs);
+        return r;
+    }
+    friend uint_fixed operator*(const uint_fixed& a, const uint_fixed& b)
+    {
+        uint_fixed r;
+        detail::impl_uint_fixed_mul::low(r.limbs, a.limbs, b.limbs);
+        return r;
+    }
+    friend uint_fixed operator&(const uint_fixed& a, const uint_fixed& b)
+    {
+        uint_fixed r;
+        Unroll<N>::call([&](std::size_t i) HURCHALLA_INLINE_LAMBDA {
+            r.limbs[i] = a.limbs[i] & b.limbs[i];
+        });
+        return r;
+    }
+    friend uint_fixed operator|(const uint_fixed& a, const uint_fixed& b)
+    {
+        uint_fixed r;
+        Unroll<N>::call([&](std::size_t i) HURCHALLA_INLINE_LAMBDA {
+            r.limbs[i] = a.limbs[i] | b.limbs[i];
+        });
+        return r;
+    }
+    friend uint_fixed operator^(const uint_fixed& a, const uint_fixed& b)
+    {
+        uint_fixed r;
+        Unroll<N>::call([&](std::size_t i) HURCHALLA_INLINE_LAMBDA {
+            r.limbs[i] = a.limbs[i] ^ b.limbs[i];
+        });
+        return r;
+    }
+    friend uint_fixed operator~(const uint_fixed& a)
+    {
+        uint_fixed r;
+        Unroll<N>::call([&](std::size_t i) HURCHALLA_INLINE_LAMBDA {
+            r.limbs[i] = ~a.limbs[i];
+        });
+        return r;
+    }
+    friend uint_fixed operator-(const uint_fixed& a)
+    {
+        return uint_fixed() - a;
+    }
+    friend uint_fixed operator+(const uint_fixed& a)
+    {
+        return a;
+    }
+
+    template <typename S, typename std::enable_if<
+                               std::is_integral<S>::value, int>::type = 0>
+    friend uint_fixed operator<<(const uint_fixed& a, S shift)
+    {
+        HPBC_UTIL_PRECONDITION2(static_cast<unsigned long long>(shift) <
+                                static_cast<unsigned long long>(BITS));
+        return shift_left(a, static_cast<unsigned int>(shift));
+    }
+    template <typename S, typename std::enable_if<
+                               std::is_integral<S>::value, int>::type = 0>
+    friend uint_fixed operator>>(const uint_fixed& a, S shift)
+    {
+        HPBC_UTIL_PRECONDITION2(static_cast<unsigned long long>(shift) <
+                                static_cast<unsigned long long>(BITS));
+        return shift_right(a, static_cast<unsigned int>(shift));
+    }
+
+
+    friend bool operator==(const uint_fixed& a, const uint_fixed& b)
+    {
+        std::uint64_t x = 0;
+        Unroll<N>::call([&](std::size_t i) HURCHALLA_INLINE_LAMBDA {
+            x |= a.limbs[i] ^ b.limbs[i];
+        });
+        return x == 0;
+    }
+    friend bool operator!=(const uint_fixed& a, const uint_fixed& b)
+    {
+        return !(a == b);
+    }
+    // a < b exactly when a - b borrows
+    friend bool operator<(const uint_fixed& a, const uint_fixed& b)
+    {
+        limb_array tmp;
+        return detail::impl_uint_fixed_sub<N>::call(tmp, a.limbs, b.limbs) != 0;
+    }
+    friend bool operator>(const uint_fixed& a, const uint_fixed& b)
+    {
+        return b < a;
+    }
+    friend bool operator<=(const uint_fixed& a, const uint_fixed& b)
+    {
+        return !(b < a);
+    }
+    friend bool operator>=(const uint_fixed& a, const uint_fixed& b)
+    {
+        return !(a < b);
+    }
+
+
+    uint_fixed& operator+=(const uint_fixed& b) { return *this = *this + b; }
+    uint_fixed& operator-=(const uint_fixed& b) { return *this = *this - b; }
+    uint_fixed& operator*=(const uint_fixed& b) { return *this = *this * b; }
+    uint_fixed& operator&=(const uint_fixed& b) { return *this = *this & b; }
+    uint_fixed& operator|=(const uint_fixed& b) { return *this = *this | b; }
+    uint_fixed& operator^=(const uint_fixed& b) { return *this = *this ^ b; }
+    template <typename S, typename std::enable_if<
+                               std::is_integral<S>::value, int>::type = 0>
+    uint_fixed& operator<<=(S shift) { return *this = *this << shift; }
+    template <typename S, typename std::enable_if<
+                               std::is_integral<S>::value, int>::type = 0>
+    uint_fixed& operator>>=(S shift) { return *this = *this >> shift; }
+
+    uint_fixed& operator++() { return *this += uint_fixed(1); }
+    uint_fixed& operator--() { return *this -= uint_fixed(1); }
+    uint_fixed operator++(int) { uint_fixed tmp = *this; ++*this; return tmp; }
+    uint_fixed operator--(int) { uint_fixed tmp = *this; --*this; return tmp; }
+
+private:
+    template <typename U>
+    U to_native(std::false_type /*wider than 64*/) const
+    {
+        return static_cast<U>(limbs[0]);
+    }
+    template <typename U>
+    U to_native(std::true_type /*wider than 64*/) const
+    {
+        using UU = typename extensible_make_unsigned<U>::type;
+        return static_cast<U>(static_cast<UU>(static_cast<UU>(limbs[1]) << 64)
+                              | static_cast<UU>(limbs[0]));
+    }
+
+    // Whole limbs are moved in log2(N) steps, where step k moves them by 2^k
+    // limbs if bit k of the limb count is set, selecting with a mask.  Then
+    // every limb is shifted by the remaining bit count.
+    // (x >> 1) >> (63 - bits) is x >> (64 - bits), without the undefined
+    // shift by 64 when bits is 0.
+    static uint_fixed shift_left(const uint_fixed& a, unsigned int shift)
+    {
+        using std::uint64_t;
+        unsigned int q = shift / 64;
+        unsigned int bits = shift % 64;
+        limb_array w = a.limbs;
+        for (std::size_t k = 1; k < N; k *= 2) {
+            uint64_t mask = 0 - static_cast<uint64_t>((q & k) != 0);
+            Unroll<N>::call([&](std::size_t j) HURCHALLA_INLINE_LAMBDA {
+                std::size_t i = N - 1 - j;   // high to low, so w[i-k] is old
+                uint64_t from = (i >= k) ? w[i-k] : 0;
+                w[i] = (from & mask) | (w[i] & ~mask);
+            });
+        }
+        uint_fixed r;
+        Unroll<N-1>::call([&](std::size_t j) HURCHALLA_INLINE_LAMBDA {
+            std::size_t i = N - 1 - j;
+            r.limbs[i] = (w[i] << bits) | ((w[i-1] >> 1) >> (63 - bits));
+        });
+        r.limbs[0] = w[0] << bits;
+        return r;
+    }
+    static uint_fixed shift_right(const uint_fixed& a, unsigned int shift)
+    {
+        using std::uint64_t;
+        unsigned int q = shift / 64;
+        unsigned int bits = shift % 64;
+        limb_array w = a.limbs;
+        for (std::size_t k = 1; k < N; k *= 2) {
+            uint64_t mask = 0 - static_cast<uint64_t>((q & k) != 0);
+            Unroll<N>::call([&](std::size_t i) HURCHALLA_INLINE_LAMBDA {
+                // low to high, so w[i+k] is old
+                uint64_t from = (i + k < N) ? w[i+k] : 0;
+                w[i] = (from & mask) | (w[i] & ~mask);
+            });
+        }
+        uint_fixed r;
+        Unroll<N-1>::call([&](std::size_t i) HURCHALLA_INLINE_LAMBDA {
+            r.limbs[i] = (w[i] >> bits) | ((w[i+1] << 1) << (63 - bits));
+        });
+        r.limbs[N-1] = w[N-1] >> bits;
+        return r;
+    }
+
+    limb_array limbs;
+};
+#if __cplusplus < 201703L
+template <int BITS>
+constexpr std::size_t uint_fixed<BITS>::N;
+#endif
+
+
+
+template <int BITS, typename U>
+struct ut_numeric_limits<uint_fixed<BITS>, U> {
+    static constexpr bool is_specialized = true;
+    static constexpr bool is_signed = false;
+    static constexpr bool is_integer = true;
+    static constexpr bool is_exact = true;
+    static constexpr bool has_infinity = false;
+    static constexpr bool has_quiet_NaN = false;
+    static constexpr bool has_signaling_NaN = false;
+    static constexpr std::float_denorm_style has_denorm = std::denorm_absent;
+    static constexpr bool has_denorm_loss = false;
+    static constexpr std::float_round_style round_style= std::round_toward_zero;
+    static constexpr bool is_iec559 = false;
+    static constexpr bool is_bounded = true;
+    static constexpr bool is_modulo = true;
+    static constexpr int digits = BITS;
+    // digits*std::log10(2)  (rounded down)
+    static constexpr int digits10 = static_cast<int>(
+                        static_cast<long long>(BITS) * 30103 / 100000);
+    static constexpr int max_digits10 = 0;
+    static constexpr int radix = 2;
+    static constexpr int min_exponent = 0;
+    static constexpr int min_exponent10 = 0;
+    static constexpr int max_exponent = 0;
+    static constexpr int max_exponent10 = 0;
+    static constexpr bool traps= std::numeric_limits<unsigned long long>::traps;
+    static constexpr bool tinyness_before = false;
+    static constexpr uint_fixed<BITS> min() noexcept { return 0; }
+    static constexpr uint_fixed<BITS> lowest() noexcept { return 0; }
+    static constexpr uint_fixed<BITS> max() noexcept
+    {
+        // -1 is sign extended, which sets every bit
+        return uint_fixed<BITS>(-1);
+    }
+    static constexpr uint_fixed<BITS> epsilon() noexcept { return 0; }
+    static constexpr uint_fixed<BITS> round_error() noexcept { return 0; }
+    static constexpr uint_fixed<BITS> infinity() noexcept { return 0; }
+    static constexpr uint_fixed<BITS> quiet_NaN() noexcept { return 0; }
+    static constexpr uint_fixed<BITS> signaling_NaN() noexcept { return 0; }
+    static constexpr uint_fixed<BITS> denorm_min() noexcept { return 0; }
+};
+// This section is only needed prior to C++17, and can cause deprecation
+// warnings if enabled after C++17
+#if __cplusplus < 201703L
+template <int BITS, typename U>
+constexpr bool ut_numeric_limits<uint_fixed<BITS>, U>::is_specialized;
+template <int BITS, typename U>
+constexpr bool ut_numeric_limits<uint_fixed<BITS>, U>::is_signed;
+template <int BITS, typename U>
+constexpr bool ut_numeric_limits<uint_fixed<BITS>, U>::is_integer;
+template <int BITS, typename U>
+constexpr bool ut_numeric_limits<uint_fixed<BITS>, U>::is_exact;
+template <int BITS, typename U>
+constexpr bool ut_numeric_limits<uint_fixed<BITS>, U>::has_infinity;
+template <int BITS, typename U>
+constexpr bool ut_numeric_limits<uint_fixed<BITS>, U>::has_quiet_NaN;
+template <int BITS, typename U>
+constexpr bool ut_numeric_limits<uint_fixed<BITS>, U>::has_signaling_NaN;
+template <int BITS, typename U>
+constexpr std::float_denorm_style
+                     ut_numeric_limits<uint_fixed<BITS>, U>::has_denorm;
+template <int BITS, typename U>
+constexpr bool ut_numeric_limits<uint_fixed<BITS>, U>::has_denorm_loss;
+template <int BITS, typename U>
+constexpr std::float_round_style
+                     ut_numeric_limits<uint_fixed<BITS>, U>::round_style;
+template <int BITS, typename U>
+constexpr bool ut_numeric_limits<uint_fixed<BITS>, U>::is_iec559;
+template <int BITS, typename U>
+constexpr bool ut_numeric_limits<uint_fixed<BITS>, U>::is_bounded;
+template <int BITS, typename U>
+constexpr bool ut_numeric_limits<uint_fixed<BITS>, U>::is_modulo;
+template <int BITS, typename U>
+constexpr int ut_numeric_limits<uint_fixed<BITS>, U>::digits;
+template <int BITS, typename U>
+constexpr int ut_numeric_limits<uint_fixed<BITS>, U>::digits10;
+template <int BITS, typename U>
+constexpr int ut_numeric_limits<uint_fixed<BITS>, U>::max_digits10;
+template <int BITS, typename U>
+constexpr int ut_numeric_limits<uint_fixed<BITS>, U>::radix;
+template <int BITS, typename U>
+constexpr int ut_numeric_limits<uint_fixed<BITS>, U>::min_exponent;
+template <int BITS, typename U>
+constexpr int ut_numeric_limits<uint_fixed<BITS>, U>::min_exponent10;
+template <int BITS, typename U>
+constexpr int ut_numeric_limits<uint_fixed<BITS>, U>::max_exponent;
+template <int BITS, typename U>
+constexpr int ut_numeric_limits<uint_fixed<BITS>, U>::max_exponent10;
+template <int BITS, typename U>
+constexpr bool ut_numeric_limits<uint_fixed<BITS>, U>::traps;
+template <int BITS, typename U>
+constexpr bool ut_numeric_limits<uint_fixed<BITS>, U>::tinyness_before;
+#endif
+
+
+
+template <int BITS>
+struct extensible_make_unsigned<uint_fixed<BITS>> {
+    using type = uint_fixed<BITS>;
+};
+template <int BITS>
+struct extensible_make_unsigned<const uint_fixed<BITS>> {
+    using type = const uint_fixed<BITS>;
+};
+template <int BITS>
+struct extensible_make_unsigned<volatile uint_fixed<BITS>> {
+    using type = volatile uint_fixed<BITS>;
+};
+template <int BITS>
+struct extensible_make_unsigned<const volatile uint_fixed<BITS>> {
+    using type = const volatile uint_fixed<BITS>;
+};
+
+
+
+namespace detail {
+  // computes the full product directly on the limbs, rather than through
+  // slow_unsigned_multiply_to_hilo_product's shifts and masks
+  template <int BITS>
+  struct impl_unsigned_multiply_to_hilo_product<uint_fixed<BITS>> {
+    using T = uint_fixed<BITS>;
+    HURCHALLA_FORCE_INLINE static T call(T& lowProduct, T u, T v)
+    {
+      typename T::limb_array hi, lo;
+      impl_uint_fixed_mul::full(hi, lo, u.getLimbs(), v.getLimbs());
+      lowProduct = T(lo);
+      return T(hi);
+    }
+  };
+}
+
+
+} // end namespace
+
+#endif
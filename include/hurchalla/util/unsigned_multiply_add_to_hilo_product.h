@@ -0,0 +1,64 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#ifndef HURCHALLA_UTIL_UNSIGNED_MULT_ADD_TO_HILO_H_INCLUDED
+#define HURCHALLA_UTIL_UNSIGNED_MULT_ADD_TO_HILO_H_INCLUDED
+
+// note: in order to get the inline asm (potentially faster) version of these
+// functions, you must define HURCHALLA_ALLOW_INLINE_ASM_MULTIPLY_ADD_TO_HILO
+// or HURCHALLA_ALLOW_INLINE_ASM_ALL.  This doesn't apply to MSVC since MSVC
+// doesn't support inline asm.
+
+
+#include "hurchalla/util/detail/platform_specific/impl_unsigned_multiply_add_to_hilo_product.h"
+#include "hurchalla/util/traits/ut_numeric_limits.h"
+#include "hurchalla/util/compiler_macros.h"
+
+namespace hurchalla {
+
+
+// unsigned_multiply_add_to_hilo_product() calculates the 'double-width'
+// result of a*b + c.  The result always fits in two words of type T (the max
+// possible result is (2^N - 1)^2 + 2^N - 1 < 2^(2N), with N the bit width of
+// T), so this never overflows.
+//
+// Returns the high-bit portion of the result, and stores the low-bit portion
+// in lowResult.
+template <typename T>
+HURCHALLA_FORCE_INLINE
+T unsigned_multiply_add_to_hilo_product(T& lowResult, T a, T b, T c)
+{
+    static_assert(ut_numeric_limits<T>::is_integer, "");
+    static_assert(!(ut_numeric_limits<T>::is_signed), "");
+    // POSTCONDITION: Stores the low-bits portion of (a*b + c) in lowResult.
+    // POSTCONDITION: Returns the high-bits portion of (a*b + c).
+
+    return detail::impl_unsigned_multiply_add_to_hilo_product<T>::call(
+                                                           lowResult, a, b, c);
+}
+
+// Calculates the 'double-width' result of a*b + c + d.  This also never
+// overflows: the max possible result is (2^N - 1)^2 + 2*(2^N - 1) == 2^(2N) - 1.
+// This is the step of schoolbook multiprecision multiplication and of
+// Montgomery REDC, where c is a word of the accumulator and d is the carry.
+//
+// Returns the high-bit portion of the result, and stores the low-bit portion
+// in lowResult.
+template <typename T>
+HURCHALLA_FORCE_INLINE
+T unsigned_multiply_add_to_hilo_product(T& lowResult, T a, T b, T c, T d)
+{
+    static_assert(ut_numeric_limits<T>::is_integer, "");
+    static_assert(!(ut_numeric_limits<T>::is_signed), "");
+    // POSTCONDITION: Stores the low-bits portion of (a*b + c + d) in
+    //                lowResult.
+    // POSTCONDITION: Returns the high-bits portion of (a*b + c + d).
+
+    return detail::impl_unsigned_multiply_add_to_hilo_product<T>::call(
+                                                        lowResult, a, b, c, d);
+}
+
+
+} // end namespace
+
+#endif
@@ -0,0 +1,61 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#ifndef HURCHALLA_UTIL_UNSIGNED_MULT_TO_HILO_ARRAY_H_INCLUDED
+#define HURCHALLA_UTIL_UNSIGNED_MULT_TO_HILO_ARRAY_H_INCLUDED
+
+// note: in order to get the SIMD versions of these functions, you must define
+// HURCHALLA_ALLOW_SIMD_MULTIPLY_TO_HILO or HURCHALLA_ALLOW_SIMD_ALL, and you
+// must compile for a supported ISA extension (AVX2 or NEON for uint32_t,
+// AVX-512 IFMA for uint64_t).  See
+// impl_unsigned_multiply_to_hilo_product_array.h.
+
+
+#include "hurchalla/util/detail/platform_specific/impl_unsigned_multiply_to_hilo_product_array.h"
+#include "hurchalla/util/traits/ut_numeric_limits.h"
+#include "hurchalla/util/compiler_macros.h"
+#include "hurchalla/util/detail/util_programming_by_contract.h"
+#include <array>
+#include <cstddef>
+
+namespace hurchalla {
+
+
+// Batched unsigned_multiply_to_hilo_product(): for each i in [0, n), computes
+// the double-width product u[i]*v[i], and stores its high-bit portion in
+// highProducts[i] and its low-bit portion in lowProducts[i].
+// highProducts and lowProducts must not overlap each other, but either of
+// them may be the same array as u or v (i.e. in-place is allowed).  No other
+// partial overlap is allowed.
+template <typename T>
+void unsigned_multiply_to_hilo_product_array(T* highProducts, T* lowProducts,
+                                     const T* u, const T* v, std::size_t n)
+{
+    static_assert(ut_numeric_limits<T>::is_integer, "");
+    static_assert(!(ut_numeric_limits<T>::is_signed), "");
+    HPBC_UTIL_PRECONDITION2(n == 0 || (highProducts != nullptr &&
+                lowProducts != nullptr && u != nullptr && v != nullptr));
+    HPBC_UTIL_PRECONDITION2(highProducts != lowProducts || n == 0);
+
+    detail::impl_unsigned_multiply_to_hilo_product_array<T>::call(
+                                  highProducts, lowProducts, u, v, n);
+}
+
+// std::array version.  Returns the high-bit portions of the products, and
+// stores the low-bit portions in lowProducts.
+template <typename T, std::size_t N>
+std::array<T, N> unsigned_multiply_to_hilo_product_array(
+                               std::array<T, N>& lowProducts,
+                               const std::array<T, N>& u,
+                               const std::array<T, N>& v)
+{
+    std::array<T, N> highProducts;
+    unsigned_multiply_to_hilo_product_array(highProducts.data(),
+                                  lowProducts.data(), u.data(), v.data(), N);
+    return highProducts;
+}
+
+
+} // end namespace
+
+#endif
@@ -0,0 +1,90 @@
+# --- This file is distributed under the MIT Open Source License, as detailed
+# in the file "LICENSE.TXT" in the root of this repository ---
+
+# Run as a script:
+#   cmake -DCOMPILER=<c++ compiler> -DARCH=<x86_64|aarch64>
+#         -DSOURCE=<codegen_branchless.cpp> -DINCLUDE_DIR=<include dir>
+#         -DOUTPUT_DIR=<dir> [-DEXTRA_FLAGS=<;-list>] -P CheckBranchless.cmake
+#
+# Compiles SOURCE to assembly at several optimization levels, and fails if any
+# function whose name begins with codegen_ contains a conditional branch, or
+# if any codegen_ function declared in SOURCE is missing from the assembly
+# (so that the check can't silently pass by checking nothing).  This expects
+# gcc/clang style assembly output, with .cfi directives.
+
+foreach(var COMPILER ARCH SOURCE INCLUDE_DIR OUTPUT_DIR)
+    if(NOT DEFINED ${var})
+        message(FATAL_ERROR "CheckBranchless.cmake: ${var} is not set")
+    endif()
+endforeach()
+
+if(ARCH STREQUAL "x86_64")
+    # every jcc, plus jrcxz/jecxz and the loop instructions; jmp is fine
+    set(cond_branch_regex "^[ \t]+(j[a-ln-z][a-z]*|loop[a-z]*)[ \t]")
+elseif(ARCH STREQUAL "aarch64")
+    set(cond_branch_regex "^[ \t]+(b\\.[a-z]+|cbn?z|tbn?z)[ \t]")
+else()
+    message(FATAL_ERROR "CheckBranchless.cmake: unsupported ARCH ${ARCH}")
+endif()
+
+# the codegen_ functions that SOURCE defines
+file(STRINGS "${SOURCE}" source_lines REGEX "CODEGEN_API .*codegen_[A-Za-z0-9_]+\\(")
+set(expected_functions "")
+foreach(line IN LISTS source_lines)
+    string(REGEX MATCH "codegen_[A-Za-z0-9_]+" name "${line}")
+    list(APPEND expected_functions ${name})
+endforeach()
+list(LENGTH expected_functions num_expected)
+if(num_expected EQUAL 0)
+    message(FATAL_ERROR "CheckBranchless.cmake: no codegen_ functions found in ${SOURCE}")
+endif()
+
+file(MAKE_DIRECTORY "${OUTPUT_DIR}")
+set(failures "")
+
+foreach(opt -O1 -O2 -O3)
+    string(REPLACE "-" "" opt_name ${opt})
+    set(asm_file "${OUTPUT_DIR}/codegen_branchless_${ARCH}_${opt_name}.s")
+    execute_process(
+        COMMAND "${COMPILER}" -std=c++14 ${opt} -DNDEBUG
+                -DHURCHALLA_ALLOW_INLINE_ASM_ALL ${EXTRA_FLAGS}
+                -I "${INCLUDE_DIR}" -S -o "${asm_file}" "${SOURCE}"
+        RESULT_VARIABLE result
+        ERROR_VARIABLE errors)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "CheckBranchless.cmake: compiling ${SOURCE} with ${opt} failed:\n${errors}")
+    endif()
+
+    file(STRINGS "${asm_file}" asm_lines)
+    set(current "")
+    set(found_functions "")
+    foreach(line IN LISTS asm_lines)
+        if(line MATCHES "^_?(codegen_[A-Za-z0-9_]+):")
+            set(current ${CMAKE_MATCH_1})
+            list(APPEND found_functions ${current})
+        elseif(line MATCHES "^[ \t]+\\.cfi_endproc")
+            set(current "")
+        elseif(current AND line MATCHES "${cond_branch_regex}")
+            string(STRIP "${line}" insn)
+            list(APPEND failures "${opt} ${current}: ${insn}")
+        endif()
+    endforeach()
+
+    foreach(name IN LISTS expected_functions)
+        list(FIND found_functions ${name} index)
+        if(index EQUAL -1)
+            # __uint128_t functions are absent when the compiler lacks the type
+            if(NOT name MATCHES "_u128$")
+                list(APPEND failures "${opt} ${name}: not found in ${asm_file}")
+            endif()
+        endif()
+    endforeach()
+endforeach()
+
+if(failures)
+    list(JOIN failures "\n  " failure_text)
+    message(FATAL_ERROR "Conditional branches (or missing functions) in "
+                        "branchless code for ${ARCH}:\n  ${failure_text}\n"
+                        "See the assembly in ${OUTPUT_DIR}")
+endif()
+message(STATUS "${ARCH}: no conditional branches in ${num_expected} codegen_ functions at -O1, -O2, -O3")
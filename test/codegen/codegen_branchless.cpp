@@ -0,0 +1,101 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+// Instantiations of the functions that promise branch-free machine code.  This
+// file isn't run - CheckBranchless.cmake compiles it to assembly and fails if
+// any function named codegen_* contains a conditional branch.  Each function
+// is extern "C" so that its assembly label is its plain name.
+//
+// cselect_on_bit only guarantees branchless code when its inline asm is
+// enabled, so this file is compiled with HURCHALLA_ALLOW_INLINE_ASM_ALL.
+
+#include "hurchalla/util/cselect_on_bit.h"
+#include "hurchalla/util/branchless_shift_left.h"
+#include "hurchalla/util/branchless_shift_right.h"
+#include "hurchalla/util/branchless_large_shift_left.h"
+#include "hurchalla/util/branchless_small_shift_right.h"
+#include "hurchalla/util/branchless_shift_left_to_hilo.h"
+#include "hurchalla/util/branchless_two_times_shift_left_to_hilo.h"
+#include "hurchalla/util/compiler_macros.h"
+#include <array>
+#include <cstdint>
+
+namespace hc = ::hurchalla;
+
+#if defined(_MSC_VER)
+#  define CODEGEN_API extern "C" __declspec(noinline)
+#else
+#  define CODEGEN_API extern "C" __attribute__((noinline))
+#endif
+
+
+CODEGEN_API uint64_t codegen_cselect_on_bit_eq_0_u64(uint64_t v, uint64_t a,
+                                                      uint64_t b)
+{
+    return hc::cselect_on_bit<0>::eq_0(v, a, b);
+}
+CODEGEN_API uint64_t codegen_cselect_on_bit_ne_0_u64(uint64_t v, uint64_t a,
+                                                      uint64_t b)
+{
+    return hc::cselect_on_bit<63>::ne_0(v, a, b);
+}
+CODEGEN_API uint32_t codegen_cselect_on_bit_eq_0_u32(uint64_t v, uint32_t a,
+                                                      uint32_t b)
+{
+    return hc::cselect_on_bit<17>::eq_0(v, a, b);
+}
+CODEGEN_API void codegen_cselect_on_bit_array4(uint64_t v,
+                         const uint64_t* a, const uint64_t* b, uint64_t* out)
+{
+    std::array<uint64_t, 4> x = {{ a[0], a[1], a[2], a[3] }};
+    std::array<uint64_t, 4> y = {{ b[0], b[1], b[2], b[3] }};
+    std::array<uint64_t, 4> r = hc::cselect_on_bit<5>::ne_0(v, x, y);
+    for (int i = 0; i < 4; ++i)
+        out[i] = r[static_cast<std::size_t>(i)];
+}
+
+CODEGEN_API uint64_t codegen_shift_left_u64(uint64_t a, int shift)
+{
+    return hc::branchless_shift_left(a, shift);
+}
+CODEGEN_API uint64_t codegen_shift_right_u64(uint64_t a, int shift)
+{
+    return hc::branchless_shift_right(a, shift);
+}
+CODEGEN_API uint64_t codegen_small_shift_right_u64(uint64_t a, int shift)
+{
+    return hc::branchless_small_shift_right(a, shift);
+}
+CODEGEN_API uint64_t codegen_large_shift_left_u64(uint64_t a, int shift)
+{
+    return hc::branchless_large_shift_left(a, shift);
+}
+CODEGEN_API uint64_t codegen_shift_left_to_hilo_u64(uint64_t* lo, uint64_t a,
+                                                     int shift)
+{
+    return hc::branchless_shift_left_to_hilo(*lo, a, shift);
+}
+CODEGEN_API uint64_t codegen_two_times_shift_left_to_hilo_u64(uint64_t* lo,
+                                                     uint64_t a, int shift)
+{
+    return hc::branchless_two_times_shift_left_to_hilo(*lo, a, shift);
+}
+
+#if HURCHALLA_COMPILER_HAS_UINT128_T()
+CODEGEN_API void codegen_shift_left_u128(__uint128_t* a, int shift)
+{
+    *a = hc::branchless_shift_left(*a, shift);
+}
+CODEGEN_API void codegen_shift_right_u128(__uint128_t* a, int shift)
+{
+    *a = hc::branchless_shift_right(*a, shift);
+}
+CODEGEN_API void codegen_small_shift_right_u128(__uint128_t* a, int shift)
+{
+    *a = hc::branchless_small_shift_right(*a, shift);
+}
+CODEGEN_API void codegen_large_shift_left_u128(__uint128_t* a, int shift)
+{
+    *a = hc::branchless_large_shift_left(*a, shift);
+}
+#endif
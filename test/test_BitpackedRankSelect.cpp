@@ -0,0 +1,116 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#include "hurchalla/util/BitpackedRankSelect.h"
+#include "hurchalla/util/BitpackedUintVector.h"
+#include "hurchalla/util/BitpackedUintVectorView.h"
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace {
+
+
+// checks every rank1(), rank0() and select1() of rs against the bits in ref
+template <class RS>
+void check_all(const RS& rs, const std::vector<uint8_t>& ref)
+{
+    std::vector<std::size_t> ones;
+    for (std::size_t i = 0; i < ref.size(); ++i) {
+        if (ref[i])
+            ones.push_back(i);
+    }
+    EXPECT_TRUE(rs.size() == ref.size());
+    EXPECT_TRUE(rs.count1() == ones.size());
+    bool all_ok = true;
+    std::size_t count = 0;
+    for (std::size_t i = 0; i <= ref.size(); ++i) {
+        all_ok = all_ok && (rs.rank1(i) == count) && (rs.rank0(i) == i - count);
+        if (i < ref.size())
+            count += ref[i];
+    }
+    EXPECT_TRUE(all_ok);
+    all_ok = true;
+    for (std::size_t k = 0; k < ones.size(); ++k)
+        all_ok = all_ok && (rs.select1(k) == ones[k]);
+    EXPECT_TRUE(all_ok);
+}
+
+// fills a vector of n bits where each bit is 1 with probability 1/one_in
+// (or never, if one_in is 0), and checks rank/select over it
+void check_density(std::size_t n, unsigned int one_in)
+{
+    namespace hc = ::hurchalla;
+    using BV = hc::BitpackedUintVector<uint8_t, 1>;
+    BV bv(n);
+    std::vector<uint8_t> ref(n);
+    std::mt19937_64 mt(n + one_in);
+    for (std::size_t i = 0; i < n; ++i) {
+        ref[i] = (one_in != 0 && mt() % one_in == 0) ? 1 : 0;
+        bv.setAt(i, ref[i]);
+    }
+    hc::BitpackedRankSelect<uint8_t> rs(bv.view());
+    check_all(rs, ref);
+}
+
+
+TEST(HurchallaUtilCpp14, BitpackedRankSelect) {
+    for (std::size_t n : { 0u, 1u, 7u, 8u, 63u, 64u, 65u, 511u, 512u, 513u,
+                           5000u }) {
+        for (unsigned int one_in : { 0u, 1u, 2u, 3u, 100u })
+            check_density(n, one_in);
+    }
+    // crosses superblocks (65536 bits) and select samples (8192 ones)
+    check_density(300001, 2);
+    check_density(300001, 1);
+    check_density(300001, 37);
+    // sparse: long stretches between samples, for select's binary search
+    check_density(1000003, 5000);
+}
+
+TEST(HurchallaUtilCpp14, BitpackedRankSelectClusters) {
+    namespace hc = ::hurchalla;
+    // dense clusters of ones separated by long runs of zeros
+    std::size_t n = 1 << 20;
+    hc::BitpackedUintVector<uint32_t, 1> bv(n);
+    std::vector<uint8_t> ref(n);
+    for (std::size_t start : { std::size_t(0), std::size_t(100000),
+                               std::size_t(700001), n - 9000 }) {
+        for (std::size_t i = start; i < start + 9000; ++i) {
+            ref[i] = 1;
+            bv.setAt(i, 1);
+        }
+    }
+    hc::BitpackedRankSelect<uint32_t> rs(bv.view());
+    check_all(rs, ref);
+
+    // the directory is about 3-4% of the bit vector
+    std::size_t bit_bytes = n / 8;
+    EXPECT_TRUE(rs.directoryBytes() * 100 <= bit_bytes * 5);
+    EXPECT_TRUE(rs.directoryBytes() * 100 >= bit_bytes * 3);
+
+    // after changing the bits, rebuild()
+    for (std::size_t i = 0; i < n; i += 3) {
+        ref[i] = static_cast<uint8_t>(1 - ref[i]);
+        bv.setAt(i, ref[i]);
+    }
+    rs.rebuild();
+    check_all(rs, ref);
+}
+
+TEST(HurchallaUtilCpp14, BitpackedRankSelectIgnoresTrailingBits) {
+    namespace hc = ::hurchalla;
+    // a view over memory whose bits beyond the view's size are all ones
+    std::vector<unsigned char> mem(200, 0xFF);
+    for (std::size_t n : { 1u, 13u, 64u, 100u, 777u, 1500u }) {
+        hc::ConstBitpackedUintVectorView<uint16_t, 1> view(mem.data(),
+                                                            mem.size(), n);
+        hc::BitpackedRankSelect<uint16_t> rs(view);
+        std::vector<uint8_t> ref(n, 1);
+        check_all(rs, ref);
+    }
+}
+
+
+} // end unnamed namespace
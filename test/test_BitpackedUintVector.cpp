@@ -1,12 +1,22 @@
 // --- This file is distributed under the MIT Open Source License, as detailed
 // by the file "LICENSE.TXT" in the root of this repository ---
 
+
+// Strictly for testing purposes, we make sure to enable the SIMD group kernels
+// for getRange() and setRange().  These kernels are only compiled if the
+// target ISA supports them (see impl_bitpacked_group_kernels.h), and the
+// tests compare their results with getAt(), which never uses them.
+#undef HURCHALLA_ALLOW_SIMD_BITPACKED_UINT_VECTOR
+#define HURCHALLA_ALLOW_SIMD_BITPACKED_UINT_VECTOR
+
 #include "hurchalla/util/BitpackedUintVector.h"
 #include "hurchalla/util/sized_uint.h"
 #include "gtest/gtest.h"
 #include <cstdint>
 #include <random>
 #include <cstring>
+#include <algorithm>
+#include <vector>
 
 namespace {
 
@@ -73,6 +83,145 @@ void check_buv(std::vector<uint64_t>& vec)
 
 
 
+template <typename U, unsigned int BITS>
+void check_buv_range(std::vector<uint64_t>& vec)
+{
+    namespace hc = ::hurchalla;
+    static_assert(BITS > 0, "");
+
+    U tmp = (static_cast<U>(1) << (BITS-1));
+    U mask = static_cast<U>(tmp + (tmp - 1));
+
+    std::vector<U> vals;
+    for (std::size_t i = 0; i < vec.size(); ++i)
+        vals.push_back(static_cast<U>(mask & vec[i]));
+
+    hc::BitpackedUintVector<U, BITS> buv(vec.size());
+    using size_type = typename decltype(buv)::size_type;
+    size_type num_elements = buv.size();
+
+    buv.setRange(0, num_elements, vals.data());
+    for (size_type i = 0; i < num_elements; ++i)
+        EXPECT_TRUE(buv.getAt(i) == vals[static_cast<std::size_t>(i)]);
+
+    std::vector<U> out(vec.size() + 1, 0);
+    buv.getRange(0, num_elements, out.data());
+    for (size_type i = 0; i < num_elements; ++i)
+        EXPECT_TRUE(out[static_cast<std::size_t>(i)] ==
+                    vals[static_cast<std::size_t>(i)]);
+
+    // test ranges that begin and end at and off of group boundaries.
+    size_type firsts[] = { 0, 1, 7, 8, 9, 21 };
+    size_type counts[] = { 0, 1, 5, 8, 16, 27, 1000 };
+    for (size_type first : firsts) {
+        for (size_type count : counts) {
+            if (first > num_elements || count > num_elements - first)
+                continue;
+            buv.getRange(first, count, out.data());
+            for (size_type i = 0; i < count; ++i)
+                EXPECT_TRUE(out[static_cast<std::size_t>(i)] ==
+                            vals[static_cast<std::size_t>(first + i)]);
+
+            // overwrite the range with the complement values, then restore
+            std::vector<U> comp;
+            for (size_type i = 0; i < count; ++i)
+                comp.push_back(static_cast<U>(
+                           mask & ~vals[static_cast<std::size_t>(first + i)]));
+            buv.setRange(first, count, comp.data());
+            for (size_type i = 0; i < num_elements; ++i) {
+                U expected = (first <= i && i < first + count) ?
+                             comp[static_cast<std::size_t>(i - first)] :
+                             vals[static_cast<std::size_t>(i)];
+                EXPECT_TRUE(buv.getAt(i) == expected);
+            }
+            buv.setRange(first, count, vals.data() + first);
+        }
+    }
+}
+
+
+
+template <typename U, unsigned int BITS>
+void check_buv_gather(std::vector<uint64_t>& vec)
+{
+    namespace hc = ::hurchalla;
+    U tmp = (static_cast<U>(1) << (BITS-1));
+    U mask = static_cast<U>(tmp + (tmp - 1));
+
+    using V = hc::BitpackedUintVector<U, BITS>;
+    using size_type = typename V::size_type;
+    V buv(vec.size());
+    std::vector<U> vals;
+    for (std::size_t i = 0; i < vec.size(); ++i)
+        vals.push_back(static_cast<U>(mask & vec[i]));
+    buv.setRange(0, buv.size(), vals.data());
+
+    // random indices with repeats, and each index 0 to size()-1 once
+    std::mt19937_64 mt(BITS);
+    std::vector<size_type> indices;
+    for (std::size_t i = 0; i < 2 * vec.size(); ++i)
+        indices.push_back(static_cast<size_type>(mt() % vec.size()));
+    for (std::size_t i = 0; i < vec.size(); ++i)
+        indices.push_back(static_cast<size_type>(i));
+
+    std::vector<U> out(indices.size());
+    for (std::size_t distance : { 0u, 1u, 16u, 63u }) {
+        std::fill(out.begin(), out.end(), static_cast<U>(0));
+        buv.gather(indices.data(), indices.size(), out.data(), distance);
+        bool all_ok = true;
+        for (std::size_t i = 0; i < indices.size(); ++i)
+            all_ok = all_ok &&
+                     (out[i] == vals[static_cast<std::size_t>(indices[i])]);
+        EXPECT_TRUE(all_ok);
+    }
+    buv.gather(indices.data(), 0, out.data());
+
+    // scatter; for a repeated index, the last write wins
+    std::vector<U> in(indices.size());
+    for (auto& x : in)
+        x = static_cast<U>(mask & mt());
+    buv.scatter(indices.data(), indices.size(), in.data(), 5);
+    for (std::size_t i = 0; i < indices.size(); ++i)
+        vals[static_cast<std::size_t>(indices[i])] = in[i];
+    bool all_ok = true;
+    for (size_type i = 0; i < buv.size(); ++i)
+        all_ok = all_ok && (buv.getAt(i) == vals[static_cast<std::size_t>(i)]);
+    EXPECT_TRUE(all_ok);
+}
+
+
+
+// The serialized format is the same on every platform: bit k of the element
+// at index i is bit (i*BITS + k) % 8 of byte (i*BITS + k) / 8.
+template <typename U, unsigned int BITS>
+void check_buv_layout(std::vector<uint64_t>& vec)
+{
+    namespace hc = ::hurchalla;
+    U tmp = (static_cast<U>(1) << (BITS-1));
+    U mask = static_cast<U>(tmp + (tmp - 1));
+
+    hc::BitpackedUintVector<U, BITS> buv(vec.size());
+    using size_type = typename decltype(buv)::size_type;
+    for (size_type i = 0; i < vec.size(); ++i)
+        buv.setAt(i, static_cast<U>(mask & vec[static_cast<std::size_t>(i)]));
+
+    const unsigned char* data = buv.data();
+    bool all_ok = true;
+    for (std::size_t i = 0; i < vec.size(); ++i) {
+        U val = static_cast<U>(mask & vec[i]);
+        for (unsigned int k = 0; k < BITS; ++k) {
+            uint64_t bitpos = static_cast<uint64_t>(i) * BITS + k;
+            unsigned int bit =
+                  static_cast<unsigned int>(data[bitpos / 8] >> (bitpos % 8)) & 1u;
+            unsigned int expected = static_cast<unsigned int>(val >> k) & 1u;
+            all_ok = all_ok && (bit == expected);
+        }
+    }
+    EXPECT_TRUE(all_ok);
+}
+
+
+
 template <int x>
 struct HighestSetBit
 {
@@ -86,6 +235,97 @@ struct HighestSetBit<1>
 };
 
 
+template <typename U, unsigned int BITS>
+void check_buv_iterators(std::vector<uint64_t>& vec)
+{
+    namespace hc = ::hurchalla;
+    static_assert(BITS > 0, "");
+
+    U tmp = (static_cast<U>(1) << (BITS-1));
+    U mask = static_cast<U>(tmp + (tmp - 1));
+
+    std::vector<U> vals;
+    for (std::size_t i = 0; i < vec.size(); ++i)
+        vals.push_back(static_cast<U>(mask & vec[i]));
+    std::size_t n = vals.size();
+
+    hc::BitpackedUintVector<U, BITS> buv(n);
+    using size_type = typename decltype(buv)::size_type;
+
+    // write through the mutable iterator's proxy reference
+    {
+        std::size_t i = 0;
+        for (auto it = buv.begin(); it != buv.end(); ++it, ++i)
+            *it = vals[i];
+        EXPECT_TRUE(i == n);
+    }
+    for (size_type i = 0; i < buv.size(); ++i)
+        EXPECT_TRUE(buv.getAt(i) == vals[static_cast<std::size_t>(i)]);
+
+    // range-for over a const vector
+    const auto& cbuv = buv;
+    {
+        std::size_t i = 0;
+        for (U val : cbuv)
+            EXPECT_TRUE(val == vals[i++]);
+        EXPECT_TRUE(i == n);
+    }
+    EXPECT_TRUE(std::equal(cbuv.cbegin(), cbuv.cend(), vals.begin()));
+    EXPECT_TRUE(cbuv.cend() - cbuv.cbegin() ==
+                static_cast<std::ptrdiff_t>(n));
+    EXPECT_TRUE(std::distance(buv.begin(), buv.end()) ==
+                static_cast<std::ptrdiff_t>(n));
+
+    // random access, in both directions
+    auto b = cbuv.begin();
+    auto e = cbuv.end();
+    for (std::size_t i = 0; i < n; ++i) {
+        std::ptrdiff_t d = static_cast<std::ptrdiff_t>(i);
+        EXPECT_TRUE(b[d] == vals[i]);
+        EXPECT_TRUE(*(b + d) == vals[i]);
+        EXPECT_TRUE(*(e - static_cast<std::ptrdiff_t>(n - i)) == vals[i]);
+        EXPECT_TRUE((b + d) - b == d);
+        EXPECT_TRUE(b - (b + d) == -d);
+        EXPECT_TRUE(b + d < e);
+        EXPECT_TRUE(b + d >= b);
+    }
+    {
+        std::size_t i = n;
+        for (auto it = e; it != b; ) {
+            --it;
+            EXPECT_TRUE(*it == vals[--i]);
+        }
+    }
+    typename decltype(buv)::const_iterator cit = buv.begin();
+    EXPECT_TRUE(cit == cbuv.begin());
+
+    // the cursor, starting at various indices
+    size_type firsts[] = { 0, 1, 7, 8, 9, 21, 100 };
+    for (size_type first : firsts) {
+        if (first > buv.size())
+            continue;
+        auto cursor = buv.readCursor(first);
+        for (size_type i = first; i < buv.size(); ++i)
+            EXPECT_TRUE(cursor.next() == vals[static_cast<std::size_t>(i)]);
+    }
+
+    // algorithms that write through proxy references
+    std::reverse(buv.begin(), buv.end());
+    std::reverse(vals.begin(), vals.end());
+    EXPECT_TRUE(std::equal(cbuv.begin(), cbuv.end(), vals.begin()));
+    std::sort(buv.begin(), buv.end());
+    std::sort(vals.begin(), vals.end());
+    EXPECT_TRUE(std::equal(cbuv.begin(), cbuv.end(), vals.begin()));
+    if (n > 1) {
+        buv.begin()[0] = mask;
+        EXPECT_TRUE(buv.getAt(0) == mask);
+        buv.begin()[0] = buv.end()[-1];
+        EXPECT_TRUE(buv.getAt(0) == vals[n-1]);
+    }
+}
+
+
+
 template <int BITS>
 void test_bpuv(std::vector<uint64_t>& vec1, std::vector<uint64_t>& vec2,
                std::vector<uint64_t>& vec3, std::vector<uint64_t>& vec4,
@@ -104,6 +344,21 @@ void test_bpuv(std::vector<uint64_t>& vec1, std::vector<uint64_t>& vec2,
     check_buv<U, BITS>(vec4);
     check_buv<U, BITS>(vec5);
     check_buv<U, BITS>(vec6);
+
+    check_buv_range<U, BITS>(vec1);
+    check_buv_range<U, BITS>(vec4);
+    check_buv_range<U, BITS>(vec6);
+    // the kernels convert between 32 bit lanes and U, so test a wider U too
+    check_buv_range<uint64_t, BITS>(vec6);
+
+    check_buv_iterators<U, BITS>(vec1);
+    check_buv_iterators<U, BITS>(vec4);
+    check_buv_iterators<U, BITS>(vec6);
+
+    check_buv_layout<U, BITS>(vec4);
+    check_buv_gather<U, BITS>(vec4);
+    check_buv_gather<U, BITS>(vec6);
+    check_buv_layout<U, BITS>(vec6);
 }
 
 
@@ -168,6 +423,38 @@ TEST(HurchallaUtilCpp14, BitpackedUintVector) {
     test_bpuv<30>(vec1, vec2, vec3, vec4, vec5, vec6);
     test_bpuv<31>(vec1, vec2, vec3, vec4, vec5, vec6);
     test_bpuv<32>(vec1, vec2, vec3, vec4, vec5, vec6);
+    test_bpuv<33>(vec1, vec2, vec3, vec4, vec5, vec6);
+    test_bpuv<34>(vec1, vec2, vec3, vec4, vec5, vec6);
+    test_bpuv<35>(vec1, vec2, vec3, vec4, vec5, vec6);
+    test_bpuv<36>(vec1, vec2, vec3, vec4, vec5, vec6);
+    test_bpuv<37>(vec1, vec2, vec3, vec4, vec5, vec6);
+    test_bpuv<38>(vec1, vec2, vec3, vec4, vec5, vec6);
+    test_bpuv<39>(vec1, vec2, vec3, vec4, vec5, vec6);
+    test_bpuv<40>(vec1, vec2, vec3, vec4, vec5, vec6);
+    test_bpuv<41>(vec1, vec2, vec3, vec4, vec5, vec6);
+    test_bpuv<42>(vec1, vec2, vec3, vec4, vec5, vec6);
+    test_bpuv<43>(vec1, vec2, vec3, vec4, vec5, vec6);
+    test_bpuv<44>(vec1, vec2, vec3, vec4, vec5, vec6);
+    test_bpuv<45>(vec1, vec2, vec3, vec4, vec5, vec6);
+    test_bpuv<46>(vec1, vec2, vec3, vec4, vec5, vec6);
+    test_bpuv<47>(vec1, vec2, vec3, vec4, vec5, vec6);
+    test_bpuv<48>(vec1, vec2, vec3, vec4, vec5, vec6);
+    test_bpuv<49>(vec1, vec2, vec3, vec4, vec5, vec6);
+    test_bpuv<50>(vec1, vec2, vec3, vec4, vec5, vec6);
+    test_bpuv<51>(vec1, vec2, vec3, vec4, vec5, vec6);
+    test_bpuv<52>(vec1, vec2, vec3, vec4, vec5, vec6);
+    test_bpuv<53>(vec1, vec2, vec3, vec4, vec5, vec6);
+    test_bpuv<54>(vec1, vec2, vec3, vec4, vec5, vec6);
+    test_bpuv<55>(vec1, vec2, vec3, vec4, vec5, vec6);
+    test_bpuv<56>(vec1, vec2, vec3, vec4, vec5, vec6);
+    test_bpuv<57>(vec1, vec2, vec3, vec4, vec5, vec6);
+    test_bpuv<58>(vec1, vec2, vec3, vec4, vec5, vec6);
+    test_bpuv<59>(vec1, vec2, vec3, vec4, vec5, vec6);
+    test_bpuv<60>(vec1, vec2, vec3, vec4, vec5, vec6);
+    test_bpuv<61>(vec1, vec2, vec3, vec4, vec5, vec6);
+    test_bpuv<62>(vec1, vec2, vec3, vec4, vec5, vec6);
+    test_bpuv<63>(vec1, vec2, vec3, vec4, vec5, vec6);
+    test_bpuv<64>(vec1, vec2, vec3, vec4, vec5, vec6);
 }
 
 
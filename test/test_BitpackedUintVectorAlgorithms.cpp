@@ -0,0 +1,187 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#include "hurchalla/util/BitpackedUintVectorAlgorithms.h"
+#include "hurchalla/util/BitpackedUintVector.h"
+#include "hurchalla/util/BitpackedUintVectorView.h"
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+
+
+template <typename U, unsigned int BITS>
+void check_algorithms(std::size_t n, unsigned int num_threads)
+{
+    namespace hc = ::hurchalla;
+    using V = hc::BitpackedUintVector<U, BITS>;
+    using size_type = typename V::size_type;
+    const U maxval = V::max_allowed_value();
+    V buv(static_cast<size_type>(n));
+
+    // fill
+    U fillval = static_cast<U>(maxval / 3 * 2 + 1);
+    hc::parallel_fill(buv, fillval, num_threads);
+    bool all_ok = true;
+    for (size_type i = 0; i < buv.size(); ++i)
+        all_ok = all_ok && (buv.getAt(i) == fillval);
+    EXPECT_TRUE(all_ok);
+    hc::parallel_fill(buv, 0, num_threads);
+    EXPECT_TRUE(hc::parallel_count_if(buv, [](U x) { return x != 0; },
+                                      num_threads) == 0);
+
+    // load random values, and make a reference copy
+    std::vector<U> ref(n);
+    std::mt19937_64 mt(n + BITS);
+    for (std::size_t i = 0; i < n; ++i) {
+        ref[i] = static_cast<U>(mt() & maxval);
+        buv.setAt(static_cast<size_type>(i), ref[i]);
+    }
+
+    // transform
+    auto f = [maxval](U x) { return static_cast<U>((maxval - x) ^ (x >> 1)); };
+    hc::parallel_transform(buv, f, num_threads);
+    for (auto& x : ref)
+        x = f(x);
+    all_ok = true;
+    for (std::size_t i = 0; i < n; ++i)
+        all_ok = all_ok && (buv.getAt(static_cast<size_type>(i)) == ref[i]);
+    EXPECT_TRUE(all_ok);
+
+    // count_if
+    auto pred = [](U x) { return (x & 1) != 0; };
+    size_type expected_count = 0;
+    for (auto x : ref)
+        expected_count += static_cast<size_type>(pred(x) ? 1 : 0);
+    EXPECT_TRUE(hc::parallel_count_if(buv, pred, num_threads) ==
+                expected_count);
+
+    // minmax
+    if (n > 0) {
+        U lo = maxval, hi = 0;
+        for (auto x : ref) {
+            lo = (x < lo) ? x : lo;
+            hi = (x > hi) ? x : hi;
+        }
+        std::pair<U, U> mm = hc::parallel_minmax(buv, num_threads);
+        EXPECT_TRUE(mm.first == lo);
+        EXPECT_TRUE(mm.second == hi);
+    }
+
+    // histogram
+    unsigned int shift = (BITS > 12) ? BITS - 12 : 0;
+    std::vector<std::uint64_t> hist =
+                       hc::parallel_histogram(buv, shift, num_threads);
+    std::vector<std::uint64_t> expected_hist(
+                       static_cast<std::size_t>(maxval >> shift) + 1, 0);
+    for (auto x : ref)
+        ++expected_hist[static_cast<std::size_t>(x >> shift)];
+    EXPECT_TRUE(hist == expected_hist);
+    std::vector<std::uint64_t> one_bin =
+                       hc::parallel_histogram(buv, BITS, num_threads);
+    EXPECT_TRUE(one_bin.size() == 1 && one_bin[0] == n);
+
+    // the read only functions also work on const and non-const views
+    hc::ConstBitpackedUintVectorView<U, BITS> cview = buv.view();
+    EXPECT_TRUE(hc::parallel_count_if(cview, pred, num_threads) ==
+                expected_count);
+    EXPECT_TRUE(hc::parallel_count_if(buv.view(), pred, num_threads) ==
+                expected_count);
+}
+
+
+template <typename U, unsigned int BITS>
+void check_all()
+{
+    // small sizes run on the calling thread; the larger sizes are split
+    // into chunks that don't end on a multiple of 8 elements
+    for (std::size_t n : { 0u, 1u, 7u, 8u, 9u, 1000u })
+        check_algorithms<U, BITS>(n, 4);
+    check_algorithms<U, BITS>(300001, 4);
+    check_algorithms<U, BITS>(262147, 3);
+    check_algorithms<U, BITS>(200000, 0);
+}
+
+
+// a view over part of a larger buffer must not touch the bytes around it
+TEST(HurchallaUtilCpp14, BitpackedAlgorithmsViewBounds) {
+    namespace hc = ::hurchalla;
+    using View = hc::BitpackedUintVectorView<uint32_t, 13>;
+    const View::size_type n = 250003;
+    std::size_t bytes = View::dataSizeBytes(n);
+    std::vector<unsigned char> buf(bytes + 64, 0xA5);
+    View view(buf.data() + 32, bytes, n);
+    hc::parallel_fill(view, 0, 4);
+    hc::parallel_transform(view, [](uint32_t x) { return x + 5; }, 4);
+    EXPECT_TRUE(hc::parallel_count_if(view,
+                    [](uint32_t x) { return x == 5; }, 4) == n);
+    for (std::size_t i = 0; i < 32; ++i) {
+        EXPECT_TRUE(buf[i] == 0xA5);
+        EXPECT_TRUE(buf[32 + bytes + i] == 0xA5);
+    }
+}
+
+TEST(HurchallaUtilCpp14, BitpackedAlgorithmsException) {
+    namespace hc = ::hurchalla;
+    hc::BitpackedUintVector<uint16_t, 11> buv(500000);
+    hc::parallel_fill(buv, 3, 4);
+    EXPECT_THROW(hc::parallel_transform(buv, [](uint16_t x) -> uint16_t {
+                         throw std::runtime_error("f"); return x; }, 4),
+                 std::runtime_error);
+    EXPECT_THROW(hc::parallel_count_if(buv, [](uint16_t) -> bool {
+                         throw std::runtime_error("pred"); }, 4),
+                 std::runtime_error);
+}
+
+// with many bins, the histogram uses one thread per (number of bins)
+// elements, and merges the threads' bins in parallel
+TEST(HurchallaUtilCpp14, BitpackedAlgorithmsHistogramManyBins) {
+    namespace hc = ::hurchalla;
+    const std::size_t n = 600001;
+    hc::BitpackedUintVector<uint32_t, 18> buv(n);
+    std::vector<std::uint64_t> expected_hist(std::size_t(1) << 18, 0);
+    std::mt19937_64 mt(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        uint32_t x = static_cast<uint32_t>(mt() & ((1u << 18) - 1));
+        buv.setAt(i, x);
+        ++expected_hist[x];
+    }
+    EXPECT_TRUE(hc::parallel_histogram(buv, 0, 8) == expected_hist);
+    EXPECT_TRUE(hc::parallel_histogram(buv, 0, 1) == expected_hist);
+    // the default bucket_shift gives one bin per value, up to 2^24 bins
+    EXPECT_TRUE(hc::parallel_histogram(buv) == expected_hist);
+}
+
+TEST(HurchallaUtilCpp14, BitpackedAlgorithmsHistogramDefaultShift) {
+    namespace hc = ::hurchalla;
+    hc::BitpackedUintVector<uint32_t, 26> buv(1000);
+    hc::parallel_fill(buv, (1u << 26) - 1);
+    std::vector<std::uint64_t> hist = hc::parallel_histogram(buv);
+    EXPECT_TRUE(hist.size() == (std::size_t(1) << 24));
+    EXPECT_TRUE(hist.back() == 1000);
+    EXPECT_TRUE(hc::parallel_histogram(buv.view()).size() == hist.size());
+}
+
+TEST(HurchallaUtilCpp14, BitpackedAlgorithms) {
+    check_all<uint8_t, 1>();
+    check_all<uint8_t, 3>();
+    check_all<uint8_t, 7>();
+    check_all<uint8_t, 8>();
+    check_all<uint16_t, 9>();
+    check_all<uint16_t, 13>();
+    check_all<uint16_t, 16>();
+    check_all<uint32_t, 17>();
+    check_all<uint32_t, 24>();
+    check_all<uint32_t, 29>();
+    check_all<uint32_t, 32>();
+    check_all<uint64_t, 20>();
+    check_all<uint64_t, 40>();
+    check_all<uint64_t, 61>();
+}
+
+
+} // end unnamed namespace
@@ -0,0 +1,256 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#include "hurchalla/util/BitpackedUintVector.h"
+#include "hurchalla/util/BitpackedUintVectorView.h"
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+
+// setAt() must not change any byte outside of the bytes its element occupies
+template <typename U, unsigned int BITS>
+void check_write_span()
+{
+    namespace hc = ::hurchalla;
+    using V = hc::BitpackedUintVector<U, BITS>;
+    using size_type = typename V::size_type;
+    const size_type n = 40;
+    V buv(n);
+    std::vector<unsigned char> before(buv.dataSizeBytes());
+    for (size_type i = 0; i < n; ++i) {
+        // fill everything with ones, so a stale rewrite would be visible
+        for (size_type j = 0; j < n; ++j)
+            buv.setAt(j, V::max_allowed_value());
+        std::memcpy(before.data(), buv.data(), before.size());
+        buv.setAt(i, 0);
+        std::size_t first_byte = static_cast<std::size_t>(i * BITS / 8);
+        std::size_t last_byte = static_cast<std::size_t>((i*BITS + BITS-1) / 8);
+        for (std::size_t k = 0; k < before.size(); ++k) {
+            if (k < first_byte || k > last_byte) {
+                EXPECT_TRUE(buv.data()[k] == before[k]);
+            }
+        }
+        EXPECT_TRUE(buv.getAt(i) == 0);
+    }
+}
+
+
+template <typename U, unsigned int BITS>
+void check_partition(std::size_t n, unsigned int num_parts)
+{
+    namespace hc = ::hurchalla;
+    using V = hc::BitpackedUintVector<U, BITS>;
+    using size_type = typename V::size_type;
+    V buv(static_cast<size_type>(n));
+
+    EXPECT_TRUE(buv.partitionPoint(0, num_parts) == 0);
+    EXPECT_TRUE(buv.partitionPoint(num_parts, num_parts) == buv.size());
+    for (unsigned int i = 0; i < num_parts; ++i) {
+        size_type a = buv.partitionPoint(i, num_parts);
+        size_type b = buv.partitionPoint(i + 1, num_parts);
+        EXPECT_TRUE(a <= b);
+        // every boundary (except the end) begins at a byte boundary
+        if (b < buv.size()) {
+            EXPECT_TRUE((static_cast<uint64_t>(b) * BITS) % 8 == 0);
+        }
+        // and is close to the proportional split
+        double ideal = static_cast<double>(n) * (i + 1) / num_parts;
+        EXPECT_TRUE(static_cast<double>(b) > ideal - 8.5);
+    }
+
+    // each thread writes its own range, with no synchronization
+    std::vector<U> expected(n);
+    std::mt19937_64 mt(n);
+    for (auto& x : expected)
+        x = static_cast<U>(mt() & V::max_allowed_value());
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < num_parts; ++t) {
+        threads.emplace_back([&buv, &expected, t, num_parts]() {
+            size_type a = buv.partitionPoint(t, num_parts);
+            size_type b = buv.partitionPoint(t + 1, num_parts);
+            // write in a scattered order, twice
+            for (int rep = 0; rep < 2; ++rep) {
+                for (size_type i = a; i < b; i += 2)
+                    buv.setAt(i, expected[static_cast<std::size_t>(i)]);
+                for (size_type i = a + 1; i < b; i += 2)
+                    buv.setAt(i, expected[static_cast<std::size_t>(i)]);
+            }
+        });
+    }
+    for (auto& th : threads)
+        th.join();
+    for (size_type i = 0; i < buv.size(); ++i)
+        EXPECT_TRUE(buv.getAt(i) == expected[static_cast<std::size_t>(i)]);
+}
+
+
+template <typename U, unsigned int BITS>
+void check_atomics(std::size_t n, unsigned int num_threads)
+{
+    namespace hc = ::hurchalla;
+    using V = hc::BitpackedUintVector<U, BITS>;
+    using size_type = typename V::size_type;
+    const U maxval = V::max_allowed_value();
+
+    // single threaded semantics
+    {
+        V buv(static_cast<size_type>(n));
+        std::mt19937_64 mt(n);
+        std::vector<U> vals(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            vals[i] = static_cast<U>(mt() & maxval);
+            buv.atomicSetAt(static_cast<size_type>(i), vals[i]);
+        }
+        for (std::size_t i = 0; i < n; ++i) {
+            size_type idx = static_cast<size_type>(i);
+            EXPECT_TRUE(buv.getAt(idx) == vals[i]);
+            EXPECT_TRUE(buv.atomicGetAt(idx) == vals[i]);
+            U bits = static_cast<U>(mt() & maxval);
+            EXPECT_TRUE(buv.atomicFetchOr(idx, bits) == vals[i]);
+            EXPECT_TRUE(buv.getAt(idx) == static_cast<U>(vals[i] | bits));
+        }
+    }
+
+    // interleaved indices: every thread writes its own elements, which (for
+    // BITS < 8) share bytes with the other threads' elements
+    {
+        V buv(static_cast<size_type>(n));
+        std::vector<std::thread> threads;
+        for (unsigned int t = 0; t < num_threads; ++t) {
+            threads.emplace_back([&buv, t, num_threads, maxval]() {
+                for (unsigned int rep = 0; rep < 3; ++rep) {
+                    for (size_type i = t; i < buv.size(); i += num_threads) {
+                        U val = static_cast<U>((i * 2654435761u + rep) & maxval);
+                        buv.atomicSetAt(i, val);
+                    }
+                }
+            });
+        }
+        for (auto& th : threads)
+            th.join();
+        for (size_type i = 0; i < buv.size(); ++i)
+            EXPECT_TRUE(buv.getAt(i) ==
+                        static_cast<U>((i * 2654435761u + 2) & maxval));
+    }
+
+    // all threads OR different bits into the same elements
+    {
+        V buv(static_cast<size_type>(n));
+        std::vector<std::thread> threads;
+        for (unsigned int t = 0; t < num_threads; ++t) {
+            threads.emplace_back([&buv, t, num_threads]() {
+                for (size_type i = 0; i < buv.size(); ++i) {
+                    for (unsigned int bit = t; bit < BITS; bit += num_threads)
+                        buv.atomicFetchOr(i, static_cast<U>(U(1) << bit));
+                }
+            });
+        }
+        for (auto& th : threads)
+            th.join();
+        for (size_type i = 0; i < buv.size(); ++i)
+            EXPECT_TRUE(buv.getAt(i) == maxval);
+    }
+
+    // a view that's only aligned as much as the atomics require (an odd
+    // address for BITS <= 8), with guard bytes on both sides
+    {
+        using View = hc::BitpackedUintVectorView<U, BITS>;
+        std::size_t bytes = View::dataSizeBytes(static_cast<size_type>(n));
+        const std::size_t unit = (BITS <= 8) ? 1 : BITS / 8;
+        std::vector<uint64_t> storage((bytes + 2*unit) / 8 + 3);
+        std::memset(storage.data(), 0xA5, storage.size() * 8);
+        unsigned char* base =
+                 reinterpret_cast<unsigned char*>(storage.data() + 1) + unit;
+        std::memset(base, 0, bytes);
+        View view(base, bytes, static_cast<size_type>(n));
+        std::vector<std::thread> threads;
+        for (unsigned int t = 0; t < num_threads; ++t) {
+            threads.emplace_back([view, t, num_threads, maxval]() {
+                for (size_type i = t; i < view.size(); i += num_threads)
+                    view.atomicSetAt(i, static_cast<U>((i + 7) & maxval));
+            });
+        }
+        for (auto& th : threads)
+            th.join();
+        for (size_type i = 0; i < view.size(); ++i) {
+            EXPECT_TRUE(view.getAt(i) == static_cast<U>((i + 7) & maxval));
+            EXPECT_TRUE(view.atomicGetAt(i) == static_cast<U>((i + 7) & maxval));
+        }
+        for (std::size_t k = 1; k <= unit; ++k) {
+            EXPECT_TRUE(*(base - k) == 0xA5);
+            EXPECT_TRUE(base[bytes + k - 1] == 0xA5);
+        }
+    }
+}
+
+
+// the atomics exist only for widths that divide 64
+template <typename U, unsigned int BITS>
+void check_atomics_if_available(std::true_type)
+{
+    check_atomics<U, BITS>(1, 2);
+    check_atomics<U, BITS>(1000, 4);
+}
+template <typename U, unsigned int BITS>
+void check_atomics_if_available(std::false_type) {}
+
+template <unsigned int BITS, typename U>
+void check_all()
+{
+    check_write_span<U, BITS>();
+    check_partition<U, BITS>(0, 3);
+    check_partition<U, BITS>(5, 4);
+    check_partition<U, BITS>(1000, 1);
+    check_partition<U, BITS>(1000, 7);
+    check_partition<U, BITS>(100003, 4);
+    check_atomics_if_available<U, BITS>(
+                          std::integral_constant<bool, (64 % BITS == 0)>());
+}
+
+
+TEST(HurchallaUtilCpp14, BitpackedUintVectorConcurrency) {
+    check_all<1, uint8_t>();
+    check_all<2, uint8_t>();
+    check_all<3, uint8_t>();
+    check_all<4, uint8_t>();
+    check_all<5, uint8_t>();
+    check_all<6, uint8_t>();
+    check_all<7, uint8_t>();
+    check_all<8, uint8_t>();
+    check_all<9, uint16_t>();
+    check_all<10, uint16_t>();
+    check_all<11, uint16_t>();
+    check_all<12, uint16_t>();
+    check_all<13, uint16_t>();
+    check_all<15, uint16_t>();
+    check_all<16, uint16_t>();
+    check_all<17, uint32_t>();
+    check_all<21, uint32_t>();
+    check_all<24, uint32_t>();
+    check_all<25, uint32_t>();
+    check_all<29, uint32_t>();
+    check_all<31, uint32_t>();
+    check_all<32, uint32_t>();
+    check_all<13, uint64_t>();
+    check_all<1, uint64_t>();
+    check_all<4, uint32_t>();
+    check_all<8, uint64_t>();
+    check_all<16, uint64_t>();
+    check_all<32, uint64_t>();
+    check_all<33, uint64_t>();
+    check_all<40, uint64_t>();
+    check_all<47, uint64_t>();
+    check_all<57, uint64_t>();
+    check_all<63, uint64_t>();
+    check_all<64, uint64_t>();
+}
+
+
+} // end unnamed namespace
@@ -0,0 +1,106 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#include "hurchalla/util/BitpackedUintVector.h"
+#include "hurchalla/util/BitpackedUintVectorStorage.h"
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+
+// a storage policy that counts its outstanding allocations
+struct CountingStorage {
+    static int outstanding;
+    static std::size_t last_bytes;
+    static unsigned char* allocate(std::size_t bytes)
+    {
+        ++outstanding;
+        last_bytes = bytes;
+        return new unsigned char[bytes]();
+    }
+    static void deallocate(unsigned char* p, std::size_t bytes) noexcept
+    {
+        --outstanding;
+        EXPECT_TRUE(bytes == last_bytes);
+        delete[] p;
+    }
+};
+int CountingStorage::outstanding = 0;
+std::size_t CountingStorage::last_bytes = 0;
+
+
+template <typename U, unsigned int BITS, class Storage>
+void check_storage(std::size_t n)
+{
+    namespace hc = ::hurchalla;
+    using V = hc::BitpackedUintVector<U, BITS, Storage>;
+    using size_type = typename V::size_type;
+
+    V buv(static_cast<size_type>(n));
+    // every storage policy gives zero-filled memory
+    for (std::size_t i = 0; i < buv.dataSizeBytes(); ++i)
+        EXPECT_TRUE(buv.data()[i] == 0);
+
+    std::mt19937_64 mt(n);
+    std::vector<U> vals;
+    for (std::size_t i = 0; i < n; ++i)
+        vals.push_back(static_cast<U>(mt() & V::max_allowed_value()));
+    buv.setRange(0, buv.size(), vals.data());
+    for (size_type i = 0; i < buv.size(); ++i)
+        EXPECT_TRUE(buv.getAt(i) == vals[static_cast<std::size_t>(i)]);
+
+    // deserialization, which copies unless Storage uses new[]
+    std::unique_ptr<unsigned char[]> data(
+                                   new unsigned char[buv.dataSizeBytes()]);
+    std::memcpy(data.get(), buv.data(), buv.dataSizeBytes());
+    V buv2(std::move(data), buv.dataSizeBytes(), buv.size());
+    EXPECT_TRUE(std::memcmp(buv.data(), buv2.data(), buv.dataSizeBytes())
+                == 0);
+
+    V buv3(std::move(buv2));
+    for (size_type i = 0; i < buv3.size(); ++i)
+        EXPECT_TRUE(buv3.getAt(i) == vals[static_cast<std::size_t>(i)]);
+}
+
+
+TEST(HurchallaUtilCpp14, BitpackedUintVectorStorage) {
+    namespace hc = ::hurchalla;
+    std::size_t counts[] = { 0, 1, 9, 1000 };
+    for (std::size_t n : counts) {
+        check_storage<uint16_t, 13, hc::BitpackedHeapStorage>(n);
+        check_storage<uint16_t, 13, hc::BitpackedPageStorage<>>(n);
+        check_storage<uint16_t, 13, hc::BitpackedPageStorage<false>>(n);
+        check_storage<uint8_t, 3, hc::BitpackedPageStorage<true, 3>>(n);
+        check_storage<uint32_t, 32, hc::BitpackedPageStorage<false, 2>>(n);
+    }
+    // large enough to use huge pages, where they're available
+    check_storage<uint32_t, 21, hc::BitpackedPageStorage<>>(3000000);
+    check_storage<uint32_t, 21, hc::BitpackedPageStorage<true, 4>>(3000000);
+}
+
+
+TEST(HurchallaUtilCpp14, BitpackedUintVectorCustomStorage) {
+    namespace hc = ::hurchalla;
+    {
+        hc::BitpackedUintVector<uint16_t, 11, CountingStorage> buv(100);
+        EXPECT_TRUE(CountingStorage::outstanding == 1);
+        EXPECT_TRUE(CountingStorage::last_bytes == buv.dataSizeBytes());
+        buv.setAt(99, 2047);
+        EXPECT_TRUE(buv.getAt(99) == 2047);
+        hc::BitpackedUintVector<uint16_t, 11, CountingStorage> buv2(
+                                                              std::move(buv));
+        EXPECT_TRUE(CountingStorage::outstanding == 1);
+        EXPECT_TRUE(buv2.getAt(99) == 2047);
+    }
+    EXPECT_TRUE(CountingStorage::outstanding == 0);
+    check_storage<uint16_t, 11, CountingStorage>(100);
+    EXPECT_TRUE(CountingStorage::outstanding == 0);
+}
+
+
+} // end unnamed namespace
@@ -0,0 +1,196 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#include "hurchalla/util/BitpackedUintVectorStream.h"
+#include "hurchalla/util/BitpackedUintVector.h"
+#include "hurchalla/util/BitpackedUintVectorView.h"
+#include "hurchalla/util/detail/platform_specific/impl_crc32c.h"
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+#  include <unistd.h>
+#endif
+
+namespace {
+
+
+template <typename U, unsigned int B>
+hurchalla::BitpackedUintVector<U, B> make_vector(std::size_t n)
+{
+    hurchalla::BitpackedUintVector<U, B> vec(n);
+    std::mt19937_64 mt(n + B);
+    for (std::size_t i = 0; i < n; ++i)
+        vec.setAt(i, static_cast<U>(mt() & vec.max_allowed_value()));
+    return vec;
+}
+
+template <typename U, unsigned int B>
+bool same_contents(const hurchalla::BitpackedUintVector<U, B>& a,
+                   const hurchalla::BitpackedUintVector<U, B>& b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (a.getAt(i) != b.getAt(i))
+            return false;
+    }
+    return true;
+}
+
+template <typename U, unsigned int B>
+std::string write_to_string(const hurchalla::BitpackedUintVector<U, B>& vec,
+                            std::size_t chunk_bytes)
+{
+    std::ostringstream os;
+    hurchalla::write_bitpacked_stream(os, vec, chunk_bytes);
+    return os.str();
+}
+
+template <typename U, unsigned int B>
+void check_roundtrip()
+{
+    namespace hc = ::hurchalla;
+    for (std::size_t n : { 0u, 1u, 7u, 8u, 9u, 100u, 4099u }) {
+        auto vec = make_vector<U, B>(n);
+        for (std::size_t chunk : { std::size_t(1), std::size_t(7),
+                 std::size_t(64), hc::detail::ImplBitpackedUintVectorStream::
+                                                       DEFAULT_CHUNK_BYTES }) {
+            std::string s = write_to_string(vec, chunk);
+            std::size_t data_bytes = vec.dataSizeBytes();
+            std::size_t num_chunks = (data_bytes + chunk - 1) / chunk;
+            EXPECT_TRUE(s.size() == 64 + data_bytes + 4 * num_chunks);
+
+            std::istringstream is(s);
+            auto vec2 = hc::read_bitpacked_stream<U, B>(is);
+            EXPECT_TRUE(same_contents(vec, vec2));
+        }
+        // read into an existing view
+        std::string s = write_to_string(vec, 5);
+        hc::BitpackedUintVector<U, B> vec3(n);
+        std::istringstream is(s);
+        hc::read_bitpacked_stream(is, vec3.view());
+        EXPECT_TRUE(same_contents(vec, vec3));
+    }
+}
+
+
+TEST(HurchallaUtilCpp14, BitpackedUintVectorStreamCrc32c) {
+    namespace hc = ::hurchalla;
+    const char* str = "123456789";
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(str);
+    EXPECT_TRUE(hc::detail::impl_crc32c::call(0, p, 9) == UINT32_C(0xE3069283));
+    EXPECT_TRUE(hc::detail::impl_crc32c::call(0, p, 0) == 0);
+    // continuing a CRC gives the same result as a single call
+    std::vector<unsigned char> buf(1000);
+    std::mt19937 mt(7);
+    for (auto& b : buf)
+        b = static_cast<unsigned char>(mt());
+    uint32_t whole = hc::detail::impl_crc32c::call(0, buf.data(), buf.size());
+    for (std::size_t split : { 1u, 3u, 8u, 13u, 500u, 999u }) {
+        uint32_t c = hc::detail::impl_crc32c::call(0, buf.data(), split);
+        c = hc::detail::impl_crc32c::call(c, buf.data() + split,
+                                          buf.size() - split);
+        EXPECT_TRUE(c == whole);
+    }
+}
+
+TEST(HurchallaUtilCpp14, BitpackedUintVectorStreamRoundtrip) {
+    check_roundtrip<uint8_t, 1>();
+    check_roundtrip<uint8_t, 8>();
+    check_roundtrip<uint16_t, 13>();
+    check_roundtrip<uint32_t, 21>();
+    check_roundtrip<uint64_t, 64>();
+}
+
+TEST(HurchallaUtilCpp14, BitpackedUintVectorStreamCorruption) {
+    namespace hc = ::hurchalla;
+    auto vec = make_vector<uint32_t, 19>(1000);
+    std::string good = write_to_string(vec, 256);
+
+    // a flipped bit anywhere (header, data, or a chunk's CRC) is detected
+    for (std::size_t byte = 0; byte < good.size(); byte += 7) {
+        std::string bad = good;
+        bad[byte] = static_cast<char>(bad[byte] ^ 0x10);
+        std::istringstream is(bad);
+        EXPECT_THROW((hc::read_bitpacked_stream<uint32_t, 19>(is)),
+                     std::runtime_error);
+    }
+    // truncation
+    for (std::size_t len : { std::size_t(0), std::size_t(10), std::size_t(64),
+                             std::size_t(300), good.size() - 1 }) {
+        std::istringstream is(good.substr(0, len));
+        EXPECT_THROW((hc::read_bitpacked_stream<uint32_t, 19>(is)),
+                     std::runtime_error);
+    }
+    // wrong element_bitlen
+    {
+        std::istringstream is(good);
+        EXPECT_THROW((hc::read_bitpacked_stream<uint32_t, 18>(is)),
+                     std::runtime_error);
+    }
+    // a different format ID, with a valid header checksum
+    {
+        std::string bad = good;
+        bad[8] = static_cast<char>(bad[8] ^ 1);
+        uint32_t crc = hc::detail::impl_crc32c::call(0,
+                         reinterpret_cast<const unsigned char*>(bad.data()), 60);
+        for (int i = 0; i < 4; ++i)
+            bad[static_cast<std::size_t>(60 + i)] =
+                                          static_cast<char>(crc >> (8 * i));
+        std::istringstream is(bad);
+        EXPECT_THROW((hc::read_bitpacked_stream<uint32_t, 19>(is)),
+                     std::runtime_error);
+    }
+    // the data format doesn't depend on U, so a wider U can read the stream
+    {
+        std::istringstream is(good);
+        auto wide = hc::read_bitpacked_stream<uint64_t, 19>(is);
+        bool all_ok = (wide.size() == vec.size());
+        for (std::size_t i = 0; all_ok && i < vec.size(); ++i)
+            all_ok = (wide.getAt(i) == vec.getAt(i));
+        EXPECT_TRUE(all_ok);
+    }
+    // a view whose size doesn't match the stream
+    {
+        hc::BitpackedUintVector<uint32_t, 19> other(999);
+        std::istringstream is(good);
+        EXPECT_THROW(hc::read_bitpacked_stream(is, other.view()),
+                     std::runtime_error);
+    }
+    // the good stream is still fine
+    std::istringstream is(good);
+    auto vec2 = hc::read_bitpacked_stream<uint32_t, 19>(is);
+    EXPECT_TRUE(same_contents(vec, vec2));
+}
+
+#if !defined(_WIN32)
+TEST(HurchallaUtilCpp14, BitpackedUintVectorStreamFileDescriptor) {
+    namespace hc = ::hurchalla;
+    auto vec = make_vector<uint16_t, 11>(100000);
+    std::FILE* f = std::tmpfile();
+    ASSERT_TRUE(f != nullptr);
+    int fd = fileno(f);
+    hc::write_bitpacked_stream(fd, vec, 1000);
+    hc::write_bitpacked_stream(fd, vec.view());
+    ASSERT_TRUE(::lseek(fd, 0, SEEK_SET) == 0);
+    auto vec2 = hc::read_bitpacked_stream<uint16_t, 11>(fd);
+    EXPECT_TRUE(same_contents(vec, vec2));
+    hc::BitpackedUintVector<uint16_t, 11> vec3(vec.size());
+    hc::read_bitpacked_stream(fd, vec3.view());
+    EXPECT_TRUE(same_contents(vec, vec3));
+    // at end of file
+    EXPECT_THROW((hc::read_bitpacked_stream<uint16_t, 11>(fd)),
+                 std::runtime_error);
+    std::fclose(f);
+}
+#endif
+
+
+} // end unnamed namespace
@@ -0,0 +1,156 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+
+// As in test_BitpackedUintVector.cpp, enable the SIMD group kernels so that
+// the view's getRange() and setRange() test them when they're available.
+#undef HURCHALLA_ALLOW_SIMD_BITPACKED_UINT_VECTOR
+#define HURCHALLA_ALLOW_SIMD_BITPACKED_UINT_VECTOR
+
+#include "hurchalla/util/BitpackedUintVectorView.h"
+#include "hurchalla/util/BitpackedUintVector.h"
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+
+template <typename U, unsigned int BITS>
+void check_view(std::size_t n)
+{
+    namespace hc = ::hurchalla;
+    using View = hc::BitpackedUintVectorView<U, BITS>;
+    using ConstView = hc::ConstBitpackedUintVectorView<U, BITS>;
+    using size_type = typename View::size_type;
+
+    std::mt19937_64 mt(n + BITS);
+    std::vector<U> vals;
+    for (std::size_t i = 0; i < n; ++i)
+        vals.push_back(static_cast<U>(mt() & View::max_allowed_value()));
+
+    // place the view inside a larger buffer that we own, at an odd offset
+    std::size_t bytes = View::dataSizeBytes(static_cast<size_type>(n));
+    std::vector<unsigned char> arena(bytes + 3, 0xA5);
+    std::fill(arena.begin() + 1, arena.begin() + 1 +
+                     static_cast<std::ptrdiff_t>(bytes), 0);
+    View view(arena.data() + 1, bytes, static_cast<size_type>(n));
+    EXPECT_TRUE(view.size() == n);
+    EXPECT_TRUE(view.dataSizeBytes() == bytes);
+    EXPECT_TRUE(view.data() == arena.data() + 1);
+
+    for (size_type i = 0; i < view.size(); ++i)
+        view.setAt(i, vals[static_cast<std::size_t>(i)]);
+    for (size_type i = 0; i < view.size(); ++i)
+        EXPECT_TRUE(view.getAt(i) == vals[static_cast<std::size_t>(i)]);
+    // the view never touches memory outside of its data
+    EXPECT_TRUE(arena[0] == 0xA5);
+    EXPECT_TRUE(arena[bytes + 1] == 0xA5 && arena[bytes + 2] == 0xA5);
+
+    // the layout is identical to BitpackedUintVector's
+    hc::BitpackedUintVector<U, BITS> buv(static_cast<size_type>(n));
+    buv.setRange(0, buv.size(), vals.data());
+    EXPECT_TRUE(buv.dataSizeBytes() == bytes);
+    EXPECT_TRUE(std::memcmp(buv.data(), view.data(), bytes) == 0);
+
+    // a const view of the vector's data
+    ConstView cview(buv.data(), buv.dataSizeBytes(), buv.size());
+    for (size_type i = 0; i < cview.size(); ++i)
+        EXPECT_TRUE(cview.getAt(i) == vals[static_cast<std::size_t>(i)]);
+
+    // ranges, from various starting points
+    std::vector<U> out(n + 1);
+    size_type firsts[] = { 0, 1, 7, 8, 9, 21, 100 };
+    for (size_type first : firsts) {
+        if (first > n)
+            continue;
+        size_type count = static_cast<size_type>(n) - first;
+        cview.getRange(first, count, out.data());
+        EXPECT_TRUE(std::equal(out.begin(), out.begin() +
+                static_cast<std::ptrdiff_t>(count), vals.begin() +
+                static_cast<std::ptrdiff_t>(first)));
+        auto cursor = cview.readCursor(first);
+        for (size_type i = first; i < cview.size(); ++i)
+            EXPECT_TRUE(cursor.next() == vals[static_cast<std::size_t>(i)]);
+    }
+    std::reverse(vals.begin(), vals.end());
+    view.setRange(0, view.size(), vals.data());
+    for (size_type i = 0; i < view.size(); ++i)
+        EXPECT_TRUE(view.getAt(i) == vals[static_cast<std::size_t>(i)]);
+    EXPECT_TRUE(arena[0] == 0xA5);
+    EXPECT_TRUE(arena[bytes + 1] == 0xA5 && arena[bytes + 2] == 0xA5);
+
+    // gather from a const view, and scatter through a view, both in reverse
+    // order; scatter must not touch the bytes outside of the view
+    std::vector<size_type> indices;
+    for (std::size_t i = 0; i < n; ++i)
+        indices.push_back(static_cast<size_type>(n - 1 - i));
+    ConstView(view).gather(indices.data(), n, out.data());
+    EXPECT_TRUE(std::equal(out.begin(), out.begin() +
+                static_cast<std::ptrdiff_t>(n), vals.rbegin()));
+    view.scatter(indices.data(), n, vals.data(), 3);
+    std::reverse(vals.begin(), vals.end());
+    for (size_type i = 0; i < view.size(); ++i)
+        EXPECT_TRUE(view.getAt(i) == vals[static_cast<std::size_t>(i)]);
+    EXPECT_TRUE(arena[0] == 0xA5);
+    EXPECT_TRUE(arena[bytes + 1] == 0xA5 && arena[bytes + 2] == 0xA5);
+
+    // iterators, and conversion to a const view
+    ConstView cview2 = view;
+    EXPECT_TRUE(std::equal(cview2.begin(), cview2.end(), vals.begin()));
+    EXPECT_TRUE(std::equal(view.cbegin(), view.cend(), vals.begin()));
+    std::sort(view.begin(), view.end());
+    std::sort(vals.begin(), vals.end());
+    EXPECT_TRUE(std::equal(cview2.begin(), cview2.end(), vals.begin()));
+    // copies of a view refer to the same memory
+    View view2 = view;
+    if (n > 0) {
+        view2.setAt(0, View::max_allowed_value());
+        EXPECT_TRUE(view.getAt(0) == View::max_allowed_value());
+    }
+}
+
+
+template <unsigned int BITS, typename U>
+void check_view_all()
+{
+    std::size_t counts[] = { 0, 1, 7, 8, 9, 100, 3000 };
+    for (std::size_t n : counts)
+        check_view<U, BITS>(n);
+}
+
+
+TEST(HurchallaUtilCpp14, BitpackedUintVectorView) {
+    check_view_all<1, uint8_t>();
+    check_view_all<3, uint8_t>();
+    check_view_all<4, uint8_t>();
+    check_view_all<7, uint8_t>();
+    check_view_all<8, uint8_t>();
+    check_view_all<11, uint16_t>();
+    check_view_all<16, uint16_t>();
+    check_view_all<17, uint32_t>();
+    check_view_all<24, uint32_t>();
+    check_view_all<29, uint32_t>();
+    check_view_all<32, uint32_t>();
+    check_view_all<13, uint64_t>();
+}
+
+
+TEST(HurchallaUtilCpp14, BitpackedUintVectorViewErrors) {
+    namespace hc = ::hurchalla;
+    using View = hc::BitpackedUintVectorView<uint16_t, 13>;
+    std::vector<unsigned char> buf(View::dataSizeBytes(100));
+    EXPECT_THROW(View(buf.data(), buf.size() - 1, 100), std::length_error);
+    EXPECT_NO_THROW(View(buf.data(), buf.size(), 100));
+    EXPECT_THROW(View(buf.data(), buf.size(),
+                      std::numeric_limits<View::size_type>::max()),
+                 std::length_error);
+}
+
+
+} // end unnamed namespace
@@ -0,0 +1,167 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#include "hurchalla/util/CacheLineBitpackedUintVector.h"
+#include "hurchalla/util/BitpackedUintVector.h"
+#include "hurchalla/util/BitpackedUintVectorStorage.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+
+
+// returns bit 'bit' of the little-endian bit stream at 'data'
+unsigned int getBit(const unsigned char* data, std::size_t bit)
+{
+    return static_cast<unsigned int>(data[bit / 8] >> (bit % 8)) & 1u;
+}
+
+// Checks that every element is where the cache line blocked layout says it
+// is, and that the unused bits at the end of each block are zero.
+template <class CV, typename U, unsigned int BITS>
+bool check_layout(const CV& cv, const std::vector<U>& ref)
+{
+    const unsigned char* data = cv.data();
+    std::size_t epb = CV::elements_per_block();
+    std::size_t num_blocks = cv.dataSizeBytes() / 64;
+    for (std::size_t b = 0; b < num_blocks; ++b) {
+        std::size_t block_bit = b * 512;
+        for (std::size_t j = 0; j < epb; ++j) {
+            std::size_t i = b * epb + j;
+            U val = (i < ref.size()) ? ref[i] : 0;
+            for (unsigned int k = 0; k < BITS; ++k) {
+                unsigned int expected = static_cast<unsigned int>(val >> k) & 1u;
+                if (getBit(data, block_bit + j * BITS + k) != expected)
+                    return false;
+            }
+        }
+        for (std::size_t bit = epb * BITS; bit < 512; ++bit) {
+            if (getBit(data, block_bit + bit) != 0)
+                return false;
+        }
+    }
+    return true;
+}
+
+
+template <typename U, unsigned int BITS,
+          class Storage = ::hurchalla::BitpackedHeapStorage>
+void check_clbv(std::size_t n)
+{
+    namespace hc = ::hurchalla;
+    using CV = hc::CacheLineBitpackedUintVector<U, BITS, Storage>;
+    CV cv(n);
+    std::size_t epb = CV::elements_per_block();
+    EXPECT_TRUE(epb == 512 / BITS);
+    std::size_t num_blocks = (n == 0) ? 1 : (n + epb - 1) / epb;
+    EXPECT_TRUE(cv.size() == n);
+    EXPECT_TRUE(cv.dataSizeBytes() == 64 * num_blocks);
+    EXPECT_TRUE(CV::dataSizeBytes(n) == cv.dataSizeBytes());
+    EXPECT_TRUE(reinterpret_cast<std::uintptr_t>(cv.data()) % 64 == 0);
+    using BV = hc::BitpackedUintVector<U, BITS>;
+    EXPECT_TRUE(CV::max_allowed_value() == BV::max_allowed_value());
+    EXPECT_TRUE(CV::getFormatID() != BV::getFormatID());
+
+    std::vector<U> ref(n);
+    EXPECT_TRUE((check_layout<CV, U, BITS>(cv, ref)));
+
+    // setAt/getAt, in a scattered order
+    std::mt19937_64 mt(n + BITS);
+    for (auto& x : ref)
+        x = static_cast<U>(mt() & CV::max_allowed_value());
+    for (std::size_t i = 0; i < n; i += 2)
+        cv.setAt(i, ref[i]);
+    for (std::size_t i = 1; i < n; i += 2)
+        cv.setAt(i, ref[i]);
+    bool all_ok = true;
+    for (std::size_t i = 0; i < n; ++i)
+        all_ok = all_ok && (cv.getAt(i) == ref[i]);
+    EXPECT_TRUE(all_ok);
+    EXPECT_TRUE((check_layout<CV, U, BITS>(cv, ref)));
+
+    // getRange/setRange, for ranges that begin, end, and cross blocks at
+    // various positions
+    std::vector<std::pair<std::size_t, std::size_t>> ranges = {
+        { 0, n }, { 0, 0 }, { n, 0 } };
+    for (std::size_t first : { std::size_t(1), epb - 1, epb, epb + 3 }) {
+        for (std::size_t count : { std::size_t(1), std::size_t(7), epb - 1,
+                                   epb, epb + 1, 3 * epb + 5 }) {
+            if (first <= n && count <= n - first)
+                ranges.push_back({ first, count });
+        }
+    }
+    for (auto r : ranges) {
+        std::vector<U> out(r.second + 1, static_cast<U>(1));
+        cv.getRange(r.first, r.second, out.data());
+        EXPECT_TRUE(std::equal(out.begin(), out.begin() + static_cast<
+                    std::ptrdiff_t>(r.second), ref.begin() + static_cast<
+                    std::ptrdiff_t>(r.first)));
+        EXPECT_TRUE(out.back() == 1);
+
+        for (auto& x : out)
+            x = static_cast<U>(mt() & CV::max_allowed_value());
+        cv.setRange(r.first, r.second, out.data());
+        std::copy(out.begin(), out.begin() + static_cast<std::ptrdiff_t>(
+                  r.second), ref.begin() + static_cast<std::ptrdiff_t>(r.first));
+        all_ok = true;
+        for (std::size_t i = 0; i < n; ++i)
+            all_ok = all_ok && (cv.getAt(i) == ref[i]);
+        EXPECT_TRUE(all_ok);
+    }
+    EXPECT_TRUE((check_layout<CV, U, BITS>(cv, ref)));
+
+    // deserialization, and move construction
+    CV cv2(cv.data(), cv.dataSizeBytes(), n);
+    EXPECT_TRUE(std::memcmp(cv2.data(), cv.data(), cv.dataSizeBytes()) == 0);
+    EXPECT_TRUE(reinterpret_cast<std::uintptr_t>(cv2.data()) % 64 == 0);
+    CV cv3(std::move(cv2));
+    all_ok = true;
+    for (std::size_t i = 0; i < n; ++i)
+        all_ok = all_ok && (cv3.getAt(i) == ref[i]);
+    EXPECT_TRUE(all_ok);
+}
+
+
+template <typename U, unsigned int BITS>
+void check_sizes()
+{
+    for (std::size_t n : { 0u, 1u, 7u, 8u, 9u, 63u, 64u, 65u, 100u, 1001u })
+        check_clbv<U, BITS>(n);
+}
+
+
+TEST(HurchallaUtilCpp14, CacheLineBitpackedUintVector) {
+    check_sizes<uint8_t, 1>();
+    check_sizes<uint8_t, 3>();
+    check_sizes<uint8_t, 7>();
+    check_sizes<uint8_t, 8>();
+    check_sizes<uint16_t, 13>();
+    check_sizes<uint32_t, 13>();
+    check_sizes<uint32_t, 21>();
+    check_sizes<uint32_t, 29>();
+    check_sizes<uint32_t, 32>();
+    check_sizes<uint64_t, 40>();
+    check_sizes<uint64_t, 47>();
+    check_sizes<uint64_t, 57>();
+    check_sizes<uint64_t, 64>();
+    check_clbv<uint32_t, 23, hurchalla::BitpackedPageStorage<false>>(5000);
+}
+
+TEST(HurchallaUtilCpp14, CacheLineBitpackedUintVectorErrors) {
+    namespace hc = ::hurchalla;
+    using CV = hc::CacheLineBitpackedUintVector<uint16_t, 13>;
+    unsigned char bytes[128] = {};
+    EXPECT_THROW(CV(bytes, 128, 10), std::length_error);
+    EXPECT_NO_THROW(CV(bytes, 128, 50));
+    EXPECT_TRUE(CV::dataSizeBytes(SIZE_MAX) == 0);
+    EXPECT_THROW(CV(SIZE_MAX), std::length_error);
+}
+
+
+} // end unnamed namespace
@@ -0,0 +1,139 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#include "hurchalla/util/DynamicBitpackedUintVector.h"
+#include "hurchalla/util/BitpackedUintVector.h"
+#include "hurchalla/util/BitpackedUintVectorAlgorithms.h"
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+
+
+// compares a DynamicBitpackedUintVector of width BITS against the compile
+// time specialized BitpackedUintVector
+template <typename U, unsigned int BITS>
+void check_dynamic(std::size_t n)
+{
+    namespace hc = ::hurchalla;
+    using DV = hc::DynamicBitpackedUintVector<U>;
+    using BV = hc::BitpackedUintVector<U, BITS>;
+    DV dv(BITS, n);
+    BV bv(static_cast<typename BV::size_type>(n));
+    EXPECT_TRUE(dv.element_bitlen() == BITS);
+    EXPECT_TRUE(dv.max_allowed_value() == BV::max_allowed_value());
+    EXPECT_TRUE(dv.dataSizeBytes() == bv.dataSizeBytes());
+    EXPECT_TRUE(DV::dataSizeBytes(BITS, n) == BV::dataSizeBytes(
+                                   static_cast<typename BV::size_type>(n)));
+    EXPECT_TRUE(DV::getFormatID() == BV::getFormatID());
+
+    // setAt/getAt, in a scattered order
+    std::mt19937_64 mt(n + BITS);
+    std::vector<U> ref(n);
+    for (auto& x : ref)
+        x = static_cast<U>(mt() & BV::max_allowed_value());
+    for (std::size_t i = 0; i < n; i += 2)
+        dv.setAt(i, ref[i]);
+    for (std::size_t i = 1; i < n; i += 2)
+        dv.setAt(i, ref[i]);
+    for (std::size_t i = 0; i < n; ++i)
+        bv.setAt(static_cast<typename BV::size_type>(i), ref[i]);
+    bool all_ok = true;
+    for (std::size_t i = 0; i < n; ++i)
+        all_ok = all_ok && (dv.getAt(i) == ref[i]);
+    EXPECT_TRUE(all_ok);
+    EXPECT_TRUE(std::memcmp(dv.data(), bv.data(), bv.dataSizeBytes()) == 0);
+
+    // getRange/setRange go through visit()
+    if (n > 10) {
+        std::vector<U> out(n - 3);
+        dv.getRange(3, n - 3, out.data());
+        EXPECT_TRUE(std::equal(out.begin(), out.end(), ref.begin() + 3));
+        for (auto& x : out)
+            x = static_cast<U>(mt() & BV::max_allowed_value());
+        dv.setRange(3, n - 3, out.data());
+        std::copy(out.begin(), out.end(), ref.begin() + 3);
+        all_ok = true;
+        for (std::size_t i = 0; i < n; ++i)
+            all_ok = all_ok && (dv.getAt(i) == ref[i]);
+        EXPECT_TRUE(all_ok);
+    }
+
+    // visit() gives a view of the right width, and returns f's result
+    std::size_t width = dv.visit([](const auto& view) {
+        return static_cast<std::size_t>(view.max_allowed_value());
+    });
+    EXPECT_TRUE(width == static_cast<std::size_t>(BV::max_allowed_value()));
+    const DV& cdv = dv;
+    uint64_t sum = cdv.visit([](const auto& view) {
+        uint64_t s = 0;
+        for (auto x : view)
+            s += x;
+        return s;
+    });
+    uint64_t expected_sum = 0;
+    for (auto x : ref)
+        expected_sum += x;
+    EXPECT_TRUE(sum == expected_sum);
+    dv.visit([](const auto& view) { hc::parallel_fill(view, 1, 2); });
+    EXPECT_TRUE(n == 0 || (dv.getAt(0) == 1 && dv.getAt(n - 1) == 1));
+
+    // deserialization, both ways
+    DV dv2(BITS, dv.data(), dv.dataSizeBytes(), n);
+    EXPECT_TRUE(std::memcmp(dv2.data(), dv.data(), dv.dataSizeBytes()) == 0);
+    std::unique_ptr<unsigned char[]> data(
+                                    new unsigned char[dv.dataSizeBytes()]);
+    std::memcpy(data.get(), dv.data(), dv.dataSizeBytes());
+    BV bv2(std::move(data), dv.dataSizeBytes(),
+           static_cast<typename BV::size_type>(n));
+    all_ok = true;
+    for (std::size_t i = 0; i < n; ++i) {
+        all_ok = all_ok && (bv2.getAt(static_cast<typename BV::size_type>(i))
+                            == dv.getAt(i));
+    }
+    EXPECT_TRUE(all_ok);
+}
+
+
+template <typename U, unsigned int BITS>
+void check_sizes()
+{
+    for (std::size_t n : { 0u, 1u, 7u, 8u, 9u, 100u, 1001u })
+        check_dynamic<U, BITS>(n);
+}
+
+template <typename U, unsigned int... B>
+void check_widths(std::integer_sequence<unsigned int, B...>)
+{
+    int dummy[] = { (check_sizes<U, B + 1>(), 0)... };
+    (void)dummy;
+}
+
+
+TEST(HurchallaUtilCpp14, DynamicBitpackedUintVector) {
+    check_widths<uint32_t>(std::make_integer_sequence<unsigned int, 32>());
+    check_widths<uint8_t>(std::make_integer_sequence<unsigned int, 8>());
+    check_widths<uint16_t>(std::make_integer_sequence<unsigned int, 16>());
+    check_sizes<uint64_t, 32>();
+    check_sizes<uint64_t, 5>();
+}
+
+TEST(HurchallaUtilCpp14, DynamicBitpackedUintVectorErrors) {
+    namespace hc = ::hurchalla;
+    using DV = hc::DynamicBitpackedUintVector<uint16_t>;
+    EXPECT_TRUE(DV::max_bitlen() == 16);
+    EXPECT_TRUE(hc::DynamicBitpackedUintVector<uint64_t>::max_bitlen() == 32);
+    EXPECT_THROW(DV(0, 10), std::invalid_argument);
+    EXPECT_THROW(DV(17, 10), std::invalid_argument);
+    unsigned char bytes[4] = {};
+    EXPECT_THROW(DV(10, bytes, 4, 10), std::length_error);
+}
+
+
+} // end unnamed namespace
@@ -0,0 +1,133 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#include "hurchalla/util/FrameOfReferenceUintVector.h"
+#include "hurchalla/util/BitpackedUintVector.h"
+#include "hurchalla/util/BitpackedUintVectorStorage.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+
+
+template <class FV, typename U>
+void check_contents(const FV& fv, const std::vector<U>& ref)
+{
+    std::size_t n = ref.size();
+    EXPECT_TRUE(fv.size() == n);
+    bool all_ok = true;
+    for (std::size_t i = 0; i < n; ++i)
+        all_ok = all_ok && (fv.getAt(i) == ref[i]);
+    EXPECT_TRUE(all_ok);
+
+    std::size_t bs = FV::elements_per_block();
+    std::vector<std::pair<std::size_t, std::size_t>> ranges = {
+        { 0, n }, { 0, 0 }, { n, 0 } };
+    for (std::size_t first : { std::size_t(1), bs - 1, bs, bs + 5 }) {
+        for (std::size_t count : { std::size_t(1), std::size_t(9), bs - 1,
+                                   bs, bs + 1, 3 * bs + 7 }) {
+            if (first <= n && count <= n - first)
+                ranges.push_back({ first, count });
+        }
+    }
+    for (auto r : ranges) {
+        std::vector<U> out(r.second + 1, static_cast<U>(3));
+        fv.getRange(r.first, r.second, out.data());
+        EXPECT_TRUE(std::equal(out.begin(), out.begin() + static_cast<
+                    std::ptrdiff_t>(r.second), ref.begin() + static_cast<
+                    std::ptrdiff_t>(r.first)));
+        EXPECT_TRUE(out.back() == 3);
+    }
+}
+
+// Values that drift slowly, with a spread that varies from block to block
+// (including some constant blocks), plus a few blocks that span the entire
+// range of U.
+template <typename U, std::size_t BS,
+          class Storage = ::hurchalla::BitpackedHeapStorage>
+void check_clustered(std::size_t n)
+{
+    namespace hc = ::hurchalla;
+    using FV = hc::FrameOfReferenceUintVector<U, BS, Storage>;
+    constexpr unsigned int digits = std::numeric_limits<U>::digits;
+    std::mt19937_64 mt(n + BS + digits);
+    std::vector<U> ref(n);
+    U center = static_cast<U>(mt());
+    for (std::size_t b = 0; b * BS < n; ++b) {
+        unsigned int spread_bits = static_cast<unsigned int>(mt() % (digits + 1));
+        if (b % 7 == 3)
+            spread_bits = 0;
+        U mask = (spread_bits == 0) ? static_cast<U>(0) : static_cast<U>(
+                     std::numeric_limits<U>::max() >> (digits - spread_bits));
+        for (std::size_t i = b * BS; i < n && i < (b + 1) * BS; ++i)
+            ref[i] = static_cast<U>(center + (static_cast<U>(mt()) & mask));
+        center = static_cast<U>(center + static_cast<U>(mt() % 1000));
+    }
+    FV fv(ref.data(), n);
+    EXPECT_TRUE(fv.num_blocks() == (n + BS - 1) / BS);
+    for (std::size_t b = 0; b < fv.num_blocks(); ++b) {
+        auto first = ref.begin() + static_cast<std::ptrdiff_t>(b * BS);
+        auto last = ref.begin() + static_cast<std::ptrdiff_t>(std::min(n, (b + 1) * BS));
+        U lo = *std::min_element(first, last);
+        U hi = *std::max_element(first, last);
+        unsigned int w = 0;
+        for (U range = static_cast<U>(hi - lo); range != 0;
+                                          range = static_cast<U>(range >> 1))
+            ++w;
+        EXPECT_TRUE(fv.block_base(b) == lo);
+        EXPECT_TRUE(fv.block_bitlen(b) == w);
+    }
+    check_contents(fv, ref);
+
+    FV fv2(std::move(fv));
+    check_contents(fv2, ref);
+}
+
+template <typename U, std::size_t BS>
+void check_sizes()
+{
+    for (std::size_t n : { 0u, 1u, 7u, 8u, 9u, 127u, 128u, 129u, 1000u, 5003u })
+        check_clustered<U, BS>(n);
+}
+
+
+TEST(HurchallaUtilCpp14, FrameOfReferenceUintVector) {
+    check_sizes<uint8_t, 128>();
+    check_sizes<uint16_t, 128>();
+    check_sizes<uint32_t, 128>();
+    check_sizes<uint64_t, 128>();
+    check_sizes<uint32_t, 8>();
+    check_sizes<uint64_t, 64>();
+    check_sizes<uint32_t, 1024>();
+    check_clustered<uint32_t, 128,
+                    hurchalla::BitpackedPageStorage<false>>(10000);
+}
+
+TEST(HurchallaUtilCpp14, FrameOfReferenceUintVectorSortedPrimes) {
+    namespace hc = ::hurchalla;
+    // the primes below 2^22 use 22 bits each in a BitpackedUintVector, but
+    // only about 11-12 bits per block of 128 consecutive primes
+    uint32_t limit = UINT32_C(1) << 22;
+    std::vector<uint8_t> composite(limit);
+    std::vector<uint32_t> primes;
+    for (uint32_t i = 2; i < limit; ++i) {
+        if (!composite[i]) {
+            primes.push_back(i);
+            for (uint64_t j = static_cast<uint64_t>(i) * i; j < limit; j += i)
+                composite[static_cast<std::size_t>(j)] = 1;
+        }
+    }
+    hc::FrameOfReferenceUintVector<uint32_t> fv(primes.data(), primes.size());
+    check_contents(fv, primes);
+    std::size_t dense_bytes =
+         hc::BitpackedUintVector<uint32_t, 22>::dataSizeBytes(primes.size());
+    EXPECT_TRUE(fv.memoryBytes() * 10 < dense_bytes * 7);
+}
+
+
+} // end unnamed namespace
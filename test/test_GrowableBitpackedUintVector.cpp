@@ -0,0 +1,205 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#include "hurchalla/util/GrowableBitpackedUintVector.h"
+#include "hurchalla/util/BitpackedUintVector.h"
+#include "hurchalla/util/BitpackedUintVectorStorage.h"
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+
+
+// true if gbv holds exactly the elements of 'ref', and its serialized bytes
+// are identical to those of a BitpackedUintVector holding the same elements
+template <typename U, unsigned int BITS, class Storage>
+bool matches(const hurchalla::GrowableBitpackedUintVector<U,BITS,Storage>& gbv,
+             const std::vector<U>& ref)
+{
+    namespace hc = ::hurchalla;
+    using size_type =
+         typename hc::GrowableBitpackedUintVector<U,BITS,Storage>::size_type;
+    if (gbv.size() != ref.size() || gbv.capacity() < gbv.size())
+        return false;
+    hc::BitpackedUintVector<U, BITS> buv(static_cast<size_type>(ref.size()));
+    for (std::size_t i = 0; i < ref.size(); ++i) {
+        if (gbv.getAt(static_cast<size_type>(i)) != ref[i])
+            return false;
+        buv.setAt(static_cast<size_type>(i), ref[i]);
+    }
+    return gbv.dataSizeBytes() == buv.dataSizeBytes() &&
+           std::memcmp(gbv.data(), buv.data(), buv.dataSizeBytes()) == 0;
+}
+
+
+template <typename U, unsigned int BITS, class Storage = hurchalla::BitpackedHeapStorage>
+void check_growable()
+{
+    namespace hc = ::hurchalla;
+    using V = hc::GrowableBitpackedUintVector<U, BITS, Storage>;
+    using size_type = typename V::size_type;
+    std::mt19937_64 mt(BITS);
+    auto rand_value = [&mt]() {
+        return static_cast<U>(mt() & V::max_allowed_value());
+    };
+
+    V gbv;
+    std::vector<U> ref;
+    EXPECT_TRUE(gbv.size() == 0);
+    EXPECT_TRUE(matches(gbv, ref));
+
+    // push_back, with the capacity growing geometrically
+    size_type reallocations = 0;
+    size_type last_cap = gbv.capacity();
+    for (int i = 0; i < 5000; ++i) {
+        U x = rand_value();
+        gbv.push_back(x);
+        ref.push_back(x);
+        if (gbv.capacity() != last_cap) {
+            ++reallocations;
+            last_cap = gbv.capacity();
+        }
+    }
+    EXPECT_TRUE(matches(gbv, ref));
+    EXPECT_TRUE(reallocations < 20);
+
+    // append, starting at every offset within a group
+    std::vector<U> in(301);
+    for (int k = 0; k < 9; ++k) {
+        for (auto& x : in)
+            x = rand_value();
+        gbv.append(in.data(), static_cast<size_type>(k * 37));
+        ref.insert(ref.end(), in.begin(), in.begin() + k * 37);
+    }
+    EXPECT_TRUE(matches(gbv, ref));
+
+    // pop_back and shrinking resize() must leave the removed bits zero, so
+    // that the serialized data matches BitpackedUintVector
+    for (int i = 0; i < 13; ++i) {
+        gbv.pop_back();
+        ref.pop_back();
+        EXPECT_TRUE(matches(gbv, ref));
+    }
+    gbv.resize(gbv.size() - 101);
+    ref.resize(ref.size() - 101);
+    EXPECT_TRUE(matches(gbv, ref));
+    gbv.resize(gbv.size() + 77);
+    ref.resize(ref.size() + 77, 0);
+    EXPECT_TRUE(matches(gbv, ref));
+
+    // reserve, shrink_to_fit
+    gbv.reserve(gbv.size() + 10000);
+    EXPECT_TRUE(gbv.capacity() >= gbv.size() + 10000);
+    const unsigned char* p = gbv.data();
+    for (int i = 0; i < 10000; ++i) {
+        U x = rand_value();
+        gbv.push_back(x);
+        ref.push_back(x);
+    }
+    EXPECT_TRUE(gbv.data() == p);   // no reallocation
+    gbv.shrink_to_fit();
+    EXPECT_TRUE(gbv.capacity() == gbv.size());
+    EXPECT_TRUE(matches(gbv, ref));
+    // reserve() grows geometrically, the same as push_back()
+    auto old_cap = gbv.capacity();
+    gbv.reserve(old_cap + 1);
+    EXPECT_TRUE(gbv.capacity() >= 2 * old_cap);
+    EXPECT_TRUE(matches(gbv, ref));
+
+    // setAt, getRange, setRange, iterators
+    gbv.setAt(5, V::max_allowed_value());
+    ref[5] = V::max_allowed_value();
+    std::vector<U> out(ref.size());
+    gbv.getRange(0, gbv.size(), out.data());
+    EXPECT_TRUE(out == ref);
+    for (auto& x : in)
+        x = rand_value();
+    gbv.setRange(3, static_cast<size_type>(in.size()), in.data());
+    std::copy(in.begin(), in.end(), ref.begin() + 3);
+    EXPECT_TRUE(matches(gbv, ref));
+    std::vector<size_type> indices;
+    for (size_type k = 0; k < gbv.size(); k += 3)
+        indices.push_back(gbv.size() - 1 - k);
+    std::vector<U> gathered(indices.size());
+    gbv.gather(indices.data(), indices.size(), gathered.data());
+    for (auto& x : gathered)
+        x = static_cast<U>(V::max_allowed_value() - x);
+    gbv.scatter(indices.data(), indices.size(), gathered.data());
+    for (std::size_t k = 0; k < indices.size(); ++k)
+        ref[indices[k]] = gathered[k];
+    EXPECT_TRUE(matches(gbv, ref));
+    std::size_t i = 0;
+    bool all_ok = true;
+    for (U x : gbv)
+        all_ok = all_ok && (x == ref[i++]);
+    EXPECT_TRUE(all_ok && i == ref.size());
+
+    // serialize, and deserialize as both classes
+    std::unique_ptr<unsigned char[]> data(new unsigned char[gbv.dataSizeBytes()]);
+    std::memcpy(data.get(), gbv.data(), gbv.dataSizeBytes());
+    std::unique_ptr<unsigned char[]> data2(new unsigned char[gbv.dataSizeBytes()]);
+    std::memcpy(data2.get(), gbv.data(), gbv.dataSizeBytes());
+    hc::BitpackedUintVector<U, BITS> buv(std::move(data),
+                                         gbv.dataSizeBytes(), gbv.size());
+    EXPECT_TRUE(buv.getAt(5) == ref[5] && buv.size() == gbv.size());
+    V gbv2(std::move(data2), gbv.dataSizeBytes(), gbv.size());
+    EXPECT_TRUE(matches(gbv2, ref));
+    gbv2.push_back(1);
+    ref.push_back(1);
+    EXPECT_TRUE(matches(gbv2, ref));
+
+    // move, clear
+    V gbv3(std::move(gbv2));
+    EXPECT_TRUE(gbv2.size() == 0);
+    EXPECT_TRUE(matches(gbv3, ref));
+    gbv3.clear();
+    ref.clear();
+    EXPECT_TRUE(matches(gbv3, ref));
+    gbv3.push_back(1);
+    ref.push_back(1);
+    EXPECT_TRUE(matches(gbv3, ref));
+}
+
+
+TEST(HurchallaUtilCpp14, GrowableBitpackedUintVector) {
+    check_growable<uint8_t, 1>();
+    check_growable<uint8_t, 3>();
+    check_growable<uint8_t, 5>();
+    check_growable<uint8_t, 8>();
+    check_growable<uint16_t, 9>();
+    check_growable<uint16_t, 12>();
+    check_growable<uint16_t, 15>();
+    check_growable<uint32_t, 16>();
+    check_growable<uint32_t, 19>();
+    check_growable<uint32_t, 24>();
+    check_growable<uint32_t, 27>();
+    check_growable<uint32_t, 32>();
+    check_growable<uint64_t, 31>();
+    check_growable<uint64_t, 48>();
+    check_growable<uint64_t, 59>();
+    check_growable<uint64_t, 64>();
+    check_growable<uint16_t, 11, hurchalla::BitpackedPageStorage<>>();
+}
+
+TEST(HurchallaUtilCpp14, GrowableBitpackedUintVectorErrors) {
+    namespace hc = ::hurchalla;
+    using V = hc::GrowableBitpackedUintVector<uint16_t, 10>;
+    std::unique_ptr<unsigned char[]> data(new unsigned char[3]());
+    EXPECT_THROW(V(std::move(data), 3, 4), std::length_error);
+    V gbv(4);
+    EXPECT_TRUE(gbv.size() == 4 && gbv.getAt(3) == 0);
+    // a capacity whose data size fits in size_t, but not in an object
+    EXPECT_THROW(gbv.reserve(std::numeric_limits<V::size_type>::max() / 2),
+                 std::length_error);
+    EXPECT_TRUE(gbv.size() == 4 && gbv.getAt(3) == 0);
+}
+
+
+} // end unnamed namespace
@@ -0,0 +1,137 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#include "hurchalla/util/MappedBitpackedUintVector.h"
+#include "hurchalla/util/BitpackedUintVector.h"
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace {
+
+
+// only a writable mapping has setAt()
+template <class T, class = void>
+struct has_setAt : std::false_type {};
+template <class T>
+struct has_setAt<T, decltype(std::declval<T&>().setAt(0, 0), void())>
+    : std::true_type {};
+static_assert(!has_setAt<
+        ::hurchalla::MappedBitpackedUintVector<uint16_t, 13>>::value, "");
+static_assert(has_setAt<
+        ::hurchalla::MappedBitpackedUintVector<uint16_t, 13, true>>::value, "");
+
+
+template <typename U, unsigned int BITS>
+void check_mapped(std::size_t count, const char* path)
+{
+    namespace hc = ::hurchalla;
+
+    std::mt19937_64 mt(count);
+    hc::BitpackedUintVector<U, BITS> buv(count);
+    using size_type = typename decltype(buv)::size_type;
+    std::vector<U> vals;
+    for (size_type i = 0; i < buv.size(); ++i) {
+        U val = static_cast<U>(mt() & buv.max_allowed_value());
+        vals.push_back(val);
+        buv.setAt(i, val);
+    }
+    hc::MappedBitpackedUintVector<U, BITS>::writeFile(path, buv);
+
+    {
+        hc::MappedBitpackedUintVector<U, BITS> mbuv(path);
+        EXPECT_TRUE(mbuv.size() == buv.size());
+        EXPECT_TRUE(mbuv.dataSizeBytes() == buv.dataSizeBytes());
+        EXPECT_FALSE(mbuv.writable());
+        EXPECT_TRUE(mbuv.getFormatID() == buv.getFormatID());
+        for (size_type i = 0; i < mbuv.size(); ++i)
+            EXPECT_TRUE(mbuv.getAt(i) == vals[static_cast<std::size_t>(i)]);
+        // moving keeps the mapping
+        hc::MappedBitpackedUintVector<U, BITS> mbuv2(std::move(mbuv));
+        for (size_type i = 0; i < mbuv2.size(); ++i)
+            EXPECT_TRUE(mbuv2.getAt(i) == vals[static_cast<std::size_t>(i)]);
+    }
+    {
+        // a writable mapping writes through to the file
+        hc::MappedBitpackedUintVector<U, BITS, true> mbuv(path);
+        EXPECT_TRUE(mbuv.writable());
+        for (size_type i = 0; i < mbuv.size(); i += 3) {
+            U val = static_cast<U>(buv.max_allowed_value() -
+                                   vals[static_cast<std::size_t>(i)]);
+            vals[static_cast<std::size_t>(i)] = val;
+            mbuv.setAt(i, val);
+        }
+        // and so does its non-const view
+        auto view = mbuv.view();
+        for (size_type i = 1; i < view.size(); i += 3) {
+            U val = static_cast<U>(vals[static_cast<std::size_t>(i)] / 2);
+            vals[static_cast<std::size_t>(i)] = val;
+            view.setAt(i, val);
+        }
+        for (size_type i = 0; i < mbuv.size(); ++i)
+            EXPECT_TRUE(mbuv.getAt(i) == vals[static_cast<std::size_t>(i)]);
+    }
+    {
+        hc::MappedBitpackedUintVector<U, BITS> mbuv(path);
+        for (size_type i = 0; i < mbuv.size(); ++i)
+            EXPECT_TRUE(mbuv.getAt(i) == vals[static_cast<std::size_t>(i)]);
+    }
+}
+
+
+TEST(HurchallaUtilCpp14, MappedBitpackedUintVector) {
+    const char* path = "test_MappedBitpackedUintVector.tmp";
+    std::size_t counts[] = { 0, 1, 7, 8, 9, 1000 };
+    for (std::size_t count : counts) {
+        check_mapped<uint8_t, 1>(count, path);
+        check_mapped<uint8_t, 3>(count, path);
+        check_mapped<uint16_t, 13>(count, path);
+        check_mapped<uint32_t, 24>(count, path);
+        check_mapped<uint32_t, 29>(count, path);
+        check_mapped<uint64_t, 32>(count, path);
+        check_mapped<uint64_t, 44>(count, path);
+    }
+    std::remove(path);
+}
+
+
+TEST(HurchallaUtilCpp14, MappedBitpackedUintVectorErrors) {
+    namespace hc = ::hurchalla;
+    const char* path = "test_MappedBitpackedUintVectorErrors.tmp";
+
+    EXPECT_THROW((hc::MappedBitpackedUintVector<uint16_t, 13>(
+                          "this_file_does_not_exist.tmp")), std::system_error);
+
+    hc::BitpackedUintVector<uint16_t, 13> buv(100);
+    hc::MappedBitpackedUintVector<uint16_t, 13>::writeFile(path, buv);
+    // a mismatched element_bitlen
+    EXPECT_THROW((hc::MappedBitpackedUintVector<uint16_t, 12>(path)),
+                 std::runtime_error);
+    // a truncated file
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        unsigned char header[64] = {};
+        out.write(reinterpret_cast<const char*>(header), 20);
+    }
+    EXPECT_THROW((hc::MappedBitpackedUintVector<uint16_t, 13>(path)),
+                 std::runtime_error);
+    // a file that isn't a MappedBitpackedUintVector
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        std::vector<char> junk(4096, 'x');
+        out.write(junk.data(), static_cast<std::streamsize>(junk.size()));
+    }
+    EXPECT_THROW((hc::MappedBitpackedUintVector<uint16_t, 13>(path)),
+                 std::runtime_error);
+    std::remove(path);
+}
+
+
+} // end unnamed namespace
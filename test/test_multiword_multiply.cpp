@@ -0,0 +1,252 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+
+// Strictly for testing purposes, we make sure to enable the inline-asm function
+// versions of the multiword multiply kernels.  In their postconditions they
+// will call the corresponding non-inline asm version to check their results,
+// so we won't miss unit testing of the "normal" function versions too, so long
+// as we also enable util's postcondition checking.
+// The asm versions also need BMI2 and ADX; they are tested when this file is
+// compiled for the host CPU (see test/CMakeLists.txt).
+#undef HURCHALLA_ALLOW_INLINE_ASM_MULTIWORD_MULTIPLY
+#define HURCHALLA_ALLOW_INLINE_ASM_MULTIWORD_MULTIPLY
+#undef HURCHALLA_UTIL_ENABLE_ASSERTS
+#define HURCHALLA_UTIL_ENABLE_ASSERTS
+#undef HURCHALLA_UTIL_ASSERT_LEVEL
+#define HURCHALLA_UTIL_ASSERT_LEVEL 3
+
+
+#include "hurchalla/util/multiword_multiply.h"
+#include "hurchalla/util/traits/ut_numeric_limits.h"
+#include "hurchalla/util/compiler_macros.h"
+#include "gtest/gtest.h"
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+namespace {
+
+
+// The reference arithmetic is done on base 256 digits (bytes), so that it's
+// independent of the multiply functions being tested.
+using Digits = std::vector<unsigned int>;
+
+template <typename T>
+void set_digits(Digits& d, std::size_t pos, T x)
+{
+    for (std::size_t k = 0; k < sizeof(T); ++k)
+        d[pos + k] = static_cast<unsigned int>(
+                                     static_cast<std::uint8_t>(x >> (8*k)));
+}
+
+template <typename T>
+Digits to_digits(const T* x, std::size_t n)
+{
+    Digits d(n * sizeof(T));
+    for (std::size_t i = 0; i < n; ++i)
+        set_digits(d, i * sizeof(T), x[i]);
+    return d;
+}
+
+// the digits of the n+1 word number  top || x
+template <typename T>
+Digits to_digits(const T* x, std::size_t n, T top)
+{
+    Digits d(n * sizeof(T) + sizeof(T));
+    for (std::size_t i = 0; i < n; ++i)
+        set_digits(d, i * sizeof(T), x[i]);
+    set_digits(d, n * sizeof(T), top);
+    return d;
+}
+
+// x + y, with the result having as many digits as the longer of the two
+Digits ref_add(const Digits& x, const Digits& y)
+{
+    Digits r(x.size() > y.size() ? x.size() : y.size(), 0);
+    unsigned int carry = 0;
+    for (std::size_t i = 0; i < r.size(); ++i) {
+        unsigned int t = carry;
+        if (i < x.size()) t += x[i];
+        if (i < y.size()) t += y[i];
+        r[i] = t & 0xFF;
+        carry = t >> 8;
+    }
+    EXPECT_TRUE(carry == 0);
+    return r;
+}
+
+Digits ref_mul(const Digits& x, const Digits& y)
+{
+    Digits r(x.size() + y.size(), 0);
+    for (std::size_t i = 0; i < x.size(); ++i) {
+        unsigned int carry = 0;
+        for (std::size_t j = 0; j < y.size(); ++j) {
+            unsigned int t = x[i] * y[j] + r[i+j] + carry;
+            r[i+j] = t & 0xFF;
+            carry = t >> 8;
+        }
+        r[i + y.size()] = carry;
+    }
+    return r;
+}
+
+
+template <typename T>
+T random_value(std::mt19937_64& mt)
+{
+    T x = 0;
+    for (std::size_t i = 0; i < sizeof(T); ++i)
+        x = static_cast<T>(static_cast<T>(x << 8) | (mt() & 0xFF));
+    return x;
+}
+
+// Mostly random words, but sometimes all zero or all max words, which give
+// the longest carry and borrow chains.
+template <typename T, std::size_t N>
+std::array<T, N> random_array(std::mt19937_64& mt, int i)
+{
+    T tmax = hurchalla::ut_numeric_limits<T>::max();
+    std::array<T, N> x;
+    for (auto& w : x) {
+        switch (i % 8) {
+            case 0:  w = tmax; break;
+            case 1:  w = 0; break;
+            default: w = random_value<T>(mt);
+        }
+    }
+    return x;
+}
+
+
+template <typename T, std::size_t N>
+void test_multiword_multiply()
+{
+    namespace hc = ::hurchalla;
+    using A = std::array<T, N>;
+    T tmax = hc::ut_numeric_limits<T>::max();
+    std::mt19937_64 mt(12345);
+
+    // a few exact results
+    {
+        A a, r;
+        a.fill(tmax);
+        r.fill(0);
+        T hi = hc::mul_1(r, a, tmax);
+        // (R^N - 1)*(R - 1) == (R-2)*R^N + (R^N - R) + 1
+        EXPECT_TRUE(hi == static_cast<T>(tmax - 1));
+        EXPECT_TRUE(r[0] == 1);
+        for (std::size_t i = 1; i < N; ++i)
+            EXPECT_TRUE(r[i] == tmax);
+
+        // (R^N - 1) + (R^N - 1)*(R - 1) == (R-1)*R^N + (R^N - R)
+        r.fill(tmax);
+        T carry = hc::addmul_1(r, a, tmax);
+        EXPECT_TRUE(carry == tmax);
+        EXPECT_TRUE(r[0] == 0);
+        for (std::size_t i = 1; i < N; ++i)
+            EXPECT_TRUE(r[i] == tmax);
+
+        // 0 - (R^N - 1)*(R - 1) == -(R-1)*R^N + (R - 1)
+        r.fill(0);
+        T borrow = hc::submul_1(r, a, tmax);
+        EXPECT_TRUE(borrow == tmax);
+        EXPECT_TRUE(r[0] == tmax);
+        for (std::size_t i = 1; i < N; ++i)
+            EXPECT_TRUE(r[i] == 0);
+
+        // multiplying by zero and one
+        A b = random_array<T, N>(mt, 2);
+        EXPECT_TRUE(hc::mul_1(r, b, static_cast<T>(0)) == 0);
+        for (std::size_t i = 0; i < N; ++i)
+            EXPECT_TRUE(r[i] == 0);
+        EXPECT_TRUE(hc::mul_1(r, b, static_cast<T>(1)) == 0);
+        EXPECT_TRUE(r == b);
+        EXPECT_TRUE(hc::submul_1(r, b, static_cast<T>(1)) == 0);
+        for (std::size_t i = 0; i < N; ++i)
+            EXPECT_TRUE(r[i] == 0);
+    }
+
+    bool all_ok = true;
+    for (int i = 0; i < 400; ++i) {
+        A a = random_array<T, N>(mt, i);
+        A r_in = random_array<T, N>(mt, i / 8);
+        T b = (i % 16 == 0) ? tmax : random_value<T>(mt);
+        Digits da = to_digits(a.data(), N);
+        Digits db = to_digits(&b, 1);
+        Digits dab = ref_mul(da, db);           // N+1 words
+
+        // mul_1:  r || hi == a*b
+        A r;
+        T hi = hc::mul_1<N>(r.data(), a.data(), b);
+        all_ok = all_ok && (to_digits(r.data(), N, hi) == dab);
+
+        // addmul_1:  r || carry == r_in + a*b
+        r = r_in;
+        T carry = hc::addmul_1<N>(r.data(), a.data(), b);
+        all_ok = all_ok && (to_digits(r.data(), N, carry) ==
+                            ref_add(to_digits(r_in.data(), N), dab));
+
+        // submul_1:  r || 0 + a*b == r_in || borrow
+        r = r_in;
+        T borrow = hc::submul_1<N>(r.data(), a.data(), b);
+        Digits d = to_digits(r.data(), N, static_cast<T>(0));
+        all_ok = all_ok &&
+                 (ref_add(d, dab) == to_digits(r_in.data(), N, borrow));
+
+        // in-place (r is the same array as a)
+        A x = a;
+        all_ok = all_ok && (hc::mul_1(x, x, b) == hi);
+        A y;
+        hc::mul_1(y, a, b);
+        all_ok = all_ok && (x == y);
+        x = a;
+        y = a;
+        all_ok = all_ok && (hc::addmul_1(x, x, b) == hc::addmul_1(y, a, b));
+        all_ok = all_ok && (x == y);
+        x = a;
+        y = a;
+        all_ok = all_ok && (hc::submul_1(x, x, b) == hc::submul_1(y, a, b));
+        all_ok = all_ok && (x == y);
+
+        // mul_n:  r2 == a*c
+        A c = random_array<T, N>(mt, i + 3);
+        std::array<T, 2*N> r2;
+        hc::mul_n(r2, a, c);
+        all_ok = all_ok && (to_digits(r2.data(), 2*N) ==
+                            ref_mul(da, to_digits(c.data(), N)));
+        std::array<T, 2*N> r3;
+        hc::mul_n<N>(r3.data(), a.data(), c.data());
+        all_ok = all_ok && (r3 == r2);
+    }
+    EXPECT_TRUE(all_ok);
+}
+
+
+template <typename T>
+void test_multiword_multiply_all_n()
+{
+    test_multiword_multiply<T, 1>();
+    test_multiword_multiply<T, 2>();
+    test_multiword_multiply<T, 3>();
+    test_multiword_multiply<T, 4>();
+    test_multiword_multiply<T, 5>();
+    test_multiword_multiply<T, 8>();
+}
+
+
+TEST(HurchallaUtil, multiword_multiply) {
+    test_multiword_multiply_all_n<std::uint8_t>();
+    test_multiword_multiply_all_n<std::uint16_t>();
+    test_multiword_multiply_all_n<std::uint32_t>();
+    test_multiword_multiply_all_n<std::uint64_t>();
+#if HURCHALLA_COMPILER_HAS_UINT128_T()
+    test_multiword_multiply<__uint128_t, 1>();
+    test_multiword_multiply<__uint128_t, 4>();
+#endif
+}
+
+
+} // end unnamed namespace
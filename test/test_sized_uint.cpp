@@ -19,6 +19,8 @@ TEST(HurchallaUtil, sized_uint) {
 #if HURCHALLA_COMPILER_HAS_UINT128_T()
     static_assert(std::is_same<__uint128_t, hc::sized_uint<128>::type>::value, "");
 #endif
+    static_assert(std::is_same<hc::uint_fixed<256>, hc::sized_uint<256>::type>::value, "");
+    static_assert(std::is_same<hc::uint_fixed<512>, hc::sized_uint<512>::type>::value, "");
 
     static_assert(hc::is_valid_sized_uint<8>::value, "");
     static_assert(hc::is_valid_sized_uint<16>::value, "");
@@ -27,6 +29,8 @@ TEST(HurchallaUtil, sized_uint) {
 #if HURCHALLA_COMPILER_HAS_UINT128_T()
     static_assert(hc::is_valid_sized_uint<128>::value, "");
 #endif
+    static_assert(hc::is_valid_sized_uint<256>::value, "");
+    static_assert(hc::is_valid_sized_uint<512>::value, "");
     EXPECT_TRUE(hc::is_valid_sized_uint<8>::value);
     EXPECT_TRUE(hc::is_valid_sized_uint<16>::value);
     EXPECT_TRUE(hc::is_valid_sized_uint<32>::value);
@@ -34,9 +38,12 @@ TEST(HurchallaUtil, sized_uint) {
 #if HURCHALLA_COMPILER_HAS_UINT128_T()
     EXPECT_TRUE(hc::is_valid_sized_uint<128>::value);
 #endif
+    EXPECT_TRUE(hc::is_valid_sized_uint<256>::value);
+    EXPECT_TRUE(hc::is_valid_sized_uint<512>::value);
 
     static_assert(!hc::is_valid_sized_uint<4>::value, "");
     static_assert(!hc::is_valid_sized_uint<9>::value, "");
+    static_assert(!hc::is_valid_sized_uint<192>::value, "");
     EXPECT_FALSE(hc::is_valid_sized_uint<4>::value);
     EXPECT_FALSE(hc::is_valid_sized_uint<9>::value);
 }
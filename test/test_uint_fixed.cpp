@@ -0,0 +1,407 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+
+// Strictly for testing purposes, we make sure to enable the inline-asm versions
+// of uint_fixed's add and sub, and of the multiply-add that its multiplies use.
+// In their postconditions they will call the corresponding non-inline asm
+// version to check their results, so we won't miss unit testing of the
+// "normal" versions too, so long as we also enable util's postcondition
+// checking.
+#undef HURCHALLA_ALLOW_INLINE_ASM_UINT_FIXED
+#define HURCHALLA_ALLOW_INLINE_ASM_UINT_FIXED
+#undef HURCHALLA_ALLOW_INLINE_ASM_MULTIPLY_ADD_TO_HILO
+#define HURCHALLA_ALLOW_INLINE_ASM_MULTIPLY_ADD_TO_HILO
+#undef HURCHALLA_UTIL_ENABLE_ASSERTS
+#define HURCHALLA_UTIL_ENABLE_ASSERTS
+#undef HURCHALLA_UTIL_ASSERT_LEVEL
+#define HURCHALLA_UTIL_ASSERT_LEVEL 3
+
+
+#include "hurchalla/util/uint_fixed.h"
+#include "hurchalla/util/unsigned_multiply_to_hilo_product.h"
+#include "hurchalla/util/unsigned_multiply_to_hi_product.h"
+#include "hurchalla/util/unsigned_square_to_hilo_product.h"
+#include "hurchalla/util/unsigned_multiply_add_to_hilo_product.h"
+#include "hurchalla/util/traits/ut_numeric_limits.h"
+#include "hurchalla/util/traits/extensible_make_unsigned.h"
+#include "hurchalla/util/traits/safely_promote_unsigned.h"
+#include "hurchalla/util/sized_uint.h"
+#include "hurchalla/util/compiler_macros.h"
+// uint_wide relies on C++14 constexpr, to be a literal type
+#if (__cplusplus >= 201402L)
+#  include "uint_wide.h"
+#endif
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <random>
+#include <type_traits>
+
+namespace {
+
+
+namespace hc = ::hurchalla;
+using hc::uint_fixed;
+
+
+template <int BITS>
+uint_fixed<BITS> random_value(std::mt19937_64& mt)
+{
+    typename uint_fixed<BITS>::limb_array w;
+    for (auto& x : w) {
+        // mostly random limbs, but also the extremes, so that carries and
+        // borrows propagate across several limbs
+        switch (mt() % 8) {
+            case 0: x = 0; break;
+            case 1: x = ~static_cast<std::uint64_t>(0); break;
+            default: x = mt(); break;
+        }
+    }
+    return uint_fixed<BITS>(w);
+}
+
+template <int BITS>
+bool less_by_limbs(const uint_fixed<BITS>& a, const uint_fixed<BITS>& b)
+{
+    const auto& wa = a.getLimbs();
+    const auto& wb = b.getLimbs();
+    return std::lexicographical_compare(wa.rbegin(), wa.rend(),
+                                        wb.rbegin(), wb.rend());
+}
+
+
+template <int BITS>
+void test_traits()
+{
+    using T = uint_fixed<BITS>;
+    static_assert(hc::ut_numeric_limits<T>::is_specialized, "");
+    static_assert(hc::ut_numeric_limits<T>::is_integer, "");
+    static_assert(!hc::ut_numeric_limits<T>::is_signed, "");
+    static_assert(hc::ut_numeric_limits<T>::is_modulo, "");
+    static_assert(hc::ut_numeric_limits<T>::digits == BITS, "");
+    static_assert(hc::ut_numeric_limits<const T>::digits == BITS, "");
+    static_assert(std::is_same<typename
+                         hc::extensible_make_unsigned<T>::type, T>::value, "");
+    static_assert(std::is_same<typename
+                         hc::extensible_make_unsigned<const T>::type,
+                         const T>::value, "");
+    static_assert(std::is_same<typename
+                         hc::safely_promote_unsigned<T>::type, T>::value, "");
+    static_assert(sizeof(T) == BITS / 8, "");
+
+    T tmax = hc::ut_numeric_limits<T>::max();
+    for (auto x : tmax.getLimbs())
+        EXPECT_TRUE(x == ~static_cast<std::uint64_t>(0));
+    EXPECT_TRUE(hc::ut_numeric_limits<T>::min() == 0);
+    EXPECT_TRUE(static_cast<T>(tmax + 1) == 0);
+    EXPECT_TRUE(static_cast<T>(T(0) - 1) == tmax);
+}
+
+
+template <int BITS>
+void test_conversions()
+{
+    using T = uint_fixed<BITS>;
+    using std::uint64_t;
+    constexpr T zero;
+    constexpr T seven = 7;
+    static_assert(sizeof(zero) == sizeof(seven), "");
+    EXPECT_TRUE(zero == 0);
+    EXPECT_TRUE(seven == 7u);
+    EXPECT_TRUE(static_cast<uint64_t>(seven) == 7);
+
+    // negative values are sign extended, as in a native conversion
+    EXPECT_TRUE(T(-1) == hc::ut_numeric_limits<T>::max());
+    EXPECT_TRUE(T(static_cast<std::int8_t>(-2)) + 2 == 0);
+    EXPECT_TRUE(T(static_cast<std::int64_t>(-5)) == T(0) - 5);
+
+    // conversion to a native type gives the low bits
+    T x = (T(0x0123456789abcdefULL) << 64) | T(0xfedcba9876543210ULL);
+    EXPECT_TRUE(static_cast<uint64_t>(x) == 0xfedcba9876543210ULL);
+    EXPECT_TRUE(static_cast<std::uint32_t>(x) == 0x76543210u);
+    EXPECT_TRUE(static_cast<std::uint8_t>(x) == 0x10u);
+    EXPECT_TRUE(static_cast<bool>(x));
+    EXPECT_FALSE(static_cast<bool>(zero));
+    EXPECT_TRUE(static_cast<bool>(T(1) << (BITS - 1)));
+#if HURCHALLA_COMPILER_HAS_UINT128_T()
+    __uint128_t x128 = (static_cast<__uint128_t>(0x0123456789abcdefULL) << 64)
+                       | 0xfedcba9876543210ULL;
+    EXPECT_TRUE(static_cast<__uint128_t>(x) == x128);
+    EXPECT_TRUE(T(x128) == x);
+    EXPECT_TRUE(T(static_cast<__int128_t>(-3)) == T(0) - 3);
+#endif
+
+    // conversions between widths truncate or zero extend
+    uint_fixed<BITS + 64> wide(T(0) - 1);
+    EXPECT_TRUE(wide == (uint_fixed<BITS + 64>(1) << BITS) - 1);
+    EXPECT_TRUE(T(wide) == T(0) - 1);
+    EXPECT_TRUE(T(uint_fixed<BITS + 64>(1) << BITS) == 0);
+}
+
+
+template <int BITS>
+void test_basic_arithmetic()
+{
+    using T = uint_fixed<BITS>;
+    T tmax = hc::ut_numeric_limits<T>::max();
+    T x = 5;
+    EXPECT_TRUE(x + 3 == 8);
+    EXPECT_TRUE(x - 3 == 2);
+    EXPECT_TRUE(x * 3 == 15);
+    EXPECT_TRUE(3 * x == 15);
+    EXPECT_TRUE((x & 4) == 4);
+    EXPECT_TRUE((x | 2) == 7);
+    EXPECT_TRUE((x ^ 1) == 4);
+    EXPECT_TRUE(~x == tmax - 5);
+    EXPECT_TRUE(-x == T(0) - 5);
+    EXPECT_TRUE(+x == 5);
+    EXPECT_TRUE(x < 6 && x <= 5 && x > 4 && x >= 5 && x != 4);
+
+    // carries and borrows through every limb
+    EXPECT_TRUE(tmax + 1 == 0);
+    EXPECT_TRUE(T(0) - 1 == tmax);
+    EXPECT_TRUE(tmax * tmax == 1);
+    T top = T(1) << (BITS - 1);
+    EXPECT_TRUE(top + top == 0);
+    EXPECT_TRUE(top - 1 == (tmax >> 1));
+    EXPECT_TRUE(top > tmax >> 1);
+    EXPECT_TRUE(top * 2 == 0);
+
+    T y = 10;
+    y += 5;  EXPECT_TRUE(y == 15);
+    y -= 3;  EXPECT_TRUE(y == 12);
+    y *= 3;  EXPECT_TRUE(y == 36);
+    y &= 7;  EXPECT_TRUE(y == 4);
+    y |= 1;  EXPECT_TRUE(y == 5);
+    y ^= 6;  EXPECT_TRUE(y == 3);
+    y <<= 70;  EXPECT_TRUE(y == T(3) << 70);
+    y >>= 69;  EXPECT_TRUE(y == 6);
+    EXPECT_TRUE(++y == 7);
+    EXPECT_TRUE(y++ == 7);
+    EXPECT_TRUE(y == 8);
+    EXPECT_TRUE(--y == 7);
+    EXPECT_TRUE(y-- == 7);
+    EXPECT_TRUE(y == 6);
+    T z = tmax;
+    EXPECT_TRUE(++z == 0);
+    EXPECT_TRUE(--z == tmax);
+}
+
+
+template <int BITS>
+void test_shifts()
+{
+    using T = uint_fixed<BITS>;
+    T one = 1;
+    for (int s = 0; s < BITS; ++s) {
+        T p = one << s;
+        EXPECT_TRUE((p >> s) == 1);
+        // exactly one bit is set, in limb s/64
+        for (std::size_t i = 0; i < T::N; ++i) {
+            std::uint64_t expected = (i == static_cast<std::size_t>(s / 64)) ?
+                              (static_cast<std::uint64_t>(1) << (s % 64)) : 0;
+            EXPECT_TRUE(p.getLimbs()[i] == expected);
+        }
+    }
+    std::mt19937_64 mt(2);
+    for (int trial = 0; trial < 20; ++trial) {
+        T x = random_value<BITS>(mt);
+        for (int s = 0; s < BITS; ++s) {
+            // shifting by s is shifting by 1, s times
+            if (s == 0) {
+                EXPECT_TRUE((x << s) == x && (x >> s) == x);
+            } else {
+                EXPECT_TRUE((x << s) == ((x << (s - 1)) << 1));
+                EXPECT_TRUE((x >> s) == ((x >> (s - 1)) >> 1));
+            }
+        }
+    }
+    // x << 1 == x + x, and the shifts by 1 are their own check
+    for (int trial = 0; trial < 100; ++trial) {
+        T x = random_value<BITS>(mt);
+        EXPECT_TRUE((x << 1) == x + x);
+        EXPECT_TRUE(((x >> 1) << 1) == (x & ~T(1)));
+    }
+}
+
+
+template <int BITS>
+void test_comparisons()
+{
+    using T = uint_fixed<BITS>;
+    std::mt19937_64 mt(3);
+    for (int trial = 0; trial < 2000; ++trial) {
+        T a = random_value<BITS>(mt);
+        T b = (trial % 4 == 0) ? a : random_value<BITS>(mt);
+        if (trial % 8 == 1) {
+            // differ only in the low limb
+            auto w = a.getLimbs();
+            w[0] = b.getLimbs()[0];
+            b = T(w);
+        }
+        bool lt = less_by_limbs(a, b);
+        bool eq = (a.getLimbs() == b.getLimbs());
+        EXPECT_TRUE((a < b) == lt);
+        EXPECT_TRUE((a > b) == (!lt && !eq));
+        EXPECT_TRUE((a <= b) == (lt || eq));
+        EXPECT_TRUE((a >= b) == !lt);
+        EXPECT_TRUE((a == b) == eq);
+        EXPECT_TRUE((a != b) == !eq);
+        // the borrow of a - b
+        EXPECT_TRUE(((a - b) + b) == a);
+    }
+}
+
+
+#if HURCHALLA_COMPILER_HAS_UINT128_T()
+// uint_fixed<128> must agree with __uint128_t for every operation
+uint_fixed<128> to_fixed(__uint128_t x) { return uint_fixed<128>(x); }
+
+void test_against_uint128()
+{
+    using T = uint_fixed<128>;
+    using U = __uint128_t;
+    std::mt19937_64 mt(4);
+    for (int trial = 0; trial < 5000; ++trial) {
+        T a = random_value<128>(mt);
+        T b = random_value<128>(mt);
+        U ua = static_cast<U>(a);
+        U ub = static_cast<U>(b);
+        EXPECT_TRUE(a + b == to_fixed(static_cast<U>(ua + ub)));
+        EXPECT_TRUE(a - b == to_fixed(static_cast<U>(ua - ub)));
+        EXPECT_TRUE(a * b == to_fixed(static_cast<U>(ua * ub)));
+        EXPECT_TRUE((a & b) == to_fixed(ua & ub));
+        EXPECT_TRUE((a | b) == to_fixed(ua | ub));
+        EXPECT_TRUE((a ^ b) == to_fixed(ua ^ ub));
+        EXPECT_TRUE(~a == to_fixed(static_cast<U>(~ua)));
+        EXPECT_TRUE(-a == to_fixed(static_cast<U>(0 - ua)));
+        EXPECT_TRUE((a < b) == (ua < ub));
+        EXPECT_TRUE((a == b) == (ua == ub));
+        unsigned int s = static_cast<unsigned int>(mt() % 128);
+        EXPECT_TRUE((a << s) == to_fixed(static_cast<U>(ua << s)));
+        EXPECT_TRUE((a >> s) == to_fixed(ua >> s));
+    }
+}
+#endif
+
+
+#if (__cplusplus >= 201402L)
+// uint_wide (see uint_wide.h) is an independent implementation, which
+// computes its products with 32 bit half-limbs.
+template <int BITS>
+uint_wide<BITS> to_wide(const uint_fixed<BITS>& x)
+{
+    uint_wide<BITS> r;
+    for (std::size_t i = 0; i < uint_fixed<BITS>::N; ++i)
+        r.w[i] = x.getLimbs()[i];
+    return r;
+}
+
+template <int BITS>
+uint_wide<2*BITS> widen(const uint_wide<BITS>& x)
+{
+    uint_wide<2*BITS> r;
+    for (std::size_t i = 0; i < uint_wide<BITS>::N; ++i)
+        r.w[i] = x.w[i];
+    return r;
+}
+
+template <int BITS>
+void test_against_uint_wide()
+{
+    using T = uint_fixed<BITS>;
+    using W = uint_wide<BITS>;
+    using W2 = uint_wide<2*BITS>;
+    std::mt19937_64 mt(5);
+    for (int trial = 0; trial < 1000; ++trial) {
+        T a = random_value<BITS>(mt);
+        T b = random_value<BITS>(mt);
+        T c = random_value<BITS>(mt);
+        T d = random_value<BITS>(mt);
+        W wa = to_wide(a), wb = to_wide(b);
+        EXPECT_TRUE(to_wide(a + b) == wa + wb);
+        EXPECT_TRUE(to_wide(a - b) == wa - wb);
+        EXPECT_TRUE(to_wide(a * b) == wa * wb);
+        EXPECT_TRUE(to_wide(a & b) == (wa & wb));
+        EXPECT_TRUE(to_wide(a | b) == (wa | wb));
+        unsigned int s = static_cast<unsigned int>(mt() % BITS);
+        EXPECT_TRUE(to_wide(a << s) == (wa << s));
+        EXPECT_TRUE(to_wide(a >> s) == (wa >> s));
+
+        // the double-width functions of this library, on uint_fixed
+        W2 product = widen(wa) * widen(wb);
+        W phi, plo;
+        for (std::size_t i = 0; i < W::N; ++i) {
+            plo.w[i] = product.w[i];
+            phi.w[i] = product.w[i + W::N];
+        }
+        T lo;
+        T hi = hc::unsigned_multiply_to_hilo_product(lo, a, b);
+        EXPECT_TRUE(to_wide(hi) == phi && to_wide(lo) == plo);
+        EXPECT_TRUE(to_wide(hc::unsigned_multiply_to_hi_product(a, b)) == phi);
+
+        T slo;
+        T shi = hc::unsigned_square_to_hilo_product(slo, a);
+        T slo2;
+        T shi2 = hc::unsigned_multiply_to_hilo_product(slo2, a, a);
+        EXPECT_TRUE(shi == shi2 && slo == slo2);
+
+        // u*v + c + d, from the product and two carries
+        T mlo;
+        T mhi = hc::unsigned_multiply_add_to_hilo_product(mlo, a, b, c, d);
+        T elo = lo + c;
+        T ehi = hi + T(elo < c);
+        T elo2 = elo + d;
+        ehi = ehi + T(elo2 < d);
+        EXPECT_TRUE(mhi == ehi && mlo == elo2);
+    }
+}
+#endif
+
+
+TEST(HurchallaUtil, uint_fixed) {
+    static_assert(std::is_same<hc::sized_uint<256>::type,
+                               uint_fixed<256>>::value, "");
+    static_assert(std::is_same<hc::sized_uint<512>::type,
+                               uint_fixed<512>>::value, "");
+
+    test_traits<128>();
+    test_traits<256>();
+    test_traits<512>();
+    test_traits<192>();
+
+    test_conversions<128>();
+    test_conversions<256>();
+    test_conversions<512>();
+    test_conversions<192>();
+
+    test_basic_arithmetic<128>();
+    test_basic_arithmetic<256>();
+    test_basic_arithmetic<512>();
+    test_basic_arithmetic<192>();
+
+    test_shifts<128>();
+    test_shifts<256>();
+    test_shifts<512>();
+    test_shifts<192>();
+
+    test_comparisons<128>();
+    test_comparisons<256>();
+    test_comparisons<512>();
+    test_comparisons<192>();
+
+#if HURCHALLA_COMPILER_HAS_UINT128_T()
+    test_against_uint128();
+#endif
+#if (__cplusplus >= 201402L)
+    test_against_uint_wide<128>();
+    test_against_uint_wide<256>();
+    test_against_uint_wide<512>();
+    test_against_uint_wide<192>();
+#endif
+}
+
+
+} // end unnamed namespace
@@ -0,0 +1,180 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+
+// Strictly for testing purposes, we make sure to enable the inline-asm function
+// versions of unsigned_multiply_add_to_hilo_product.  In their postconditions
+// they will call the corresponding non-inline asm version to check their
+// results, so we won't miss unit testing of the "normal" function versions too,
+// so long as we also enable util's postcondition checking.
+#undef HURCHALLA_ALLOW_INLINE_ASM_MULTIPLY_ADD_TO_HILO
+#define HURCHALLA_ALLOW_INLINE_ASM_MULTIPLY_ADD_TO_HILO
+#undef HURCHALLA_UTIL_ENABLE_ASSERTS
+#define HURCHALLA_UTIL_ENABLE_ASSERTS
+#undef HURCHALLA_UTIL_ASSERT_LEVEL
+#define HURCHALLA_UTIL_ASSERT_LEVEL 3
+
+
+#include "hurchalla/util/unsigned_multiply_add_to_hilo_product.h"
+#include "hurchalla/util/unsigned_multiply_to_hilo_product.h"
+#include "hurchalla/util/traits/ut_numeric_limits.h"
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <cstddef>
+#include <random>
+
+namespace {
+
+
+template <typename T>
+struct umathp {
+    static T call(T& lowResult, T u, T v, T a)
+    {
+        return hurchalla::unsigned_multiply_add_to_hilo_product(lowResult,
+                                                                u, v, a);
+    }
+    static T call(T& lowResult, T u, T v, T a, T b)
+    {
+        return hurchalla::unsigned_multiply_add_to_hilo_product(lowResult,
+                                                                u, v, a, b);
+    }
+};
+template <typename T>
+struct umathp_slow {
+    static T call(T& lowResult, T u, T v, T a)
+    {
+        return hurchalla::detail::slow_unsigned_multiply_add_to_hilo_product::
+                                                     call(lowResult, u, v, a);
+    }
+    static T call(T& lowResult, T u, T v, T a, T b)
+    {
+        return hurchalla::detail::slow_unsigned_multiply_add_to_hilo_product::
+                                                  call(lowResult, u, v, a, b);
+    }
+};
+
+
+template <typename T>
+T random_value(std::mt19937_64& mt)
+{
+    T x = 0;
+    for (std::size_t i = 0; i < sizeof(T); ++i)
+        x = static_cast<T>(static_cast<T>(x << 8) | (mt() & 0xFF));
+    return x;
+}
+
+template <typename T, template <typename> class F>
+void test_unsigned_multiply_add_to_hilo_product()
+{
+    namespace hc = ::hurchalla;
+    static_assert(hc::ut_numeric_limits<T>::is_integer, "");
+    static_assert(!(hc::ut_numeric_limits<T>::is_signed), "");
+    T tmax = hc::ut_numeric_limits<T>::max();
+    T hi, lo;
+
+    hi = F<T>::call(lo, 5, 6, 7);
+    EXPECT_TRUE(hi == 0 && lo == 37);
+    hi = F<T>::call(lo, 5, 6, 7, 8);
+    EXPECT_TRUE(hi == 0 && lo == 45);
+    hi = F<T>::call(lo, 0, 0, 0);
+    EXPECT_TRUE(hi == 0 && lo == 0);
+    hi = F<T>::call(lo, 0, 0, 0, 0);
+    EXPECT_TRUE(hi == 0 && lo == 0);
+    hi = F<T>::call(lo, 0, tmax, tmax);
+    EXPECT_TRUE(hi == 0 && lo == tmax);
+
+    // the addend carries into the high word
+    hi = F<T>::call(lo, 1, tmax, 1);
+    EXPECT_TRUE(hi == 1 && lo == 0);
+    hi = F<T>::call(lo, 0, 0, tmax, 1);
+    EXPECT_TRUE(hi == 1 && lo == 0);
+    hi = F<T>::call(lo, 0, 0, tmax, tmax);
+    EXPECT_TRUE(hi == 1 && lo == static_cast<T>(tmax - 1));
+    hi = F<T>::call(lo, 2, tmax, 2);
+    EXPECT_TRUE(hi == 2 && lo == 0);
+
+    // the maximum results
+    hi = F<T>::call(lo, tmax, tmax, tmax);
+    EXPECT_TRUE(hi == tmax && lo == 0);
+    hi = F<T>::call(lo, tmax, tmax, tmax, tmax);
+    EXPECT_TRUE(hi == tmax && lo == tmax);
+    hi = F<T>::call(lo, tmax, tmax, tmax, 0);
+    EXPECT_TRUE(hi == tmax && lo == 0);
+    hi = F<T>::call(lo, tmax, tmax, 0, tmax);
+    EXPECT_TRUE(hi == tmax && lo == 0);
+    hi = F<T>::call(lo, tmax, tmax, 1, 1);
+    EXPECT_TRUE(hi == static_cast<T>(tmax - 1) && lo == 3);
+
+    // compare to unsigned_multiply_to_hilo_product plus the additions
+    std::mt19937_64 mt(12345);
+    bool all_ok = true;
+    for (int i = 0; i < 10000; ++i) {
+        T u = random_value<T>(mt);
+        T v = random_value<T>(mt);
+        T a = random_value<T>(mt);
+        T b = random_value<T>(mt);
+        if (i % 4 == 0) { a = tmax; }
+        if (i % 8 == 0) { b = tmax; }
+        T plo;
+        T phi = hc::unsigned_multiply_to_hilo_product(plo, u, v);
+        T lo1 = static_cast<T>(plo + a);
+        T hi1 = static_cast<T>(phi + (lo1 < a ? 1 : 0));
+        T lo2 = static_cast<T>(lo1 + b);
+        T hi2 = static_cast<T>(hi1 + (lo2 < b ? 1 : 0));
+
+        hi = F<T>::call(lo, u, v, a);
+        all_ok = all_ok && (hi == hi1 && lo == lo1);
+        hi = F<T>::call(lo, u, v, a, b);
+        all_ok = all_ok && (hi == hi2 && lo == lo2);
+    }
+    EXPECT_TRUE(all_ok);
+}
+
+
+void test_unsigned_multiply_add_exhaustive_uint8()
+{
+    using std::uint8_t;
+    namespace hc = ::hurchalla;
+    bool all_ok = true;
+    for (int i = 0; i <= 255; i++) {
+        for (int j = 0; j <= 255; j++) {
+            for (int k : { 0, 1, 2, 127, 128, 254, 255 }) {
+                uint8_t lo;
+                uint8_t hi = hc::unsigned_multiply_add_to_hilo_product(lo,
+                       static_cast<uint8_t>(i), static_cast<uint8_t>(j),
+                       static_cast<uint8_t>(k));
+                int ref = i*j + k;
+                all_ok = all_ok && (hi == (ref >> 8) && lo == (ref & 0xFF));
+                hi = hc::unsigned_multiply_add_to_hilo_product(lo,
+                       static_cast<uint8_t>(i), static_cast<uint8_t>(j),
+                       static_cast<uint8_t>(k), static_cast<uint8_t>(255 - k));
+                ref = i*j + 255;
+                all_ok = all_ok && (hi == (ref >> 8) && lo == (ref & 0xFF));
+            }
+        }
+    }
+    EXPECT_TRUE(all_ok);
+}
+
+
+TEST(HurchallaUtil, unsigned_multiply_add_to_hilo_product) {
+    test_unsigned_multiply_add_to_hilo_product<std::uint8_t, umathp>();
+    test_unsigned_multiply_add_to_hilo_product<std::uint16_t, umathp>();
+    test_unsigned_multiply_add_to_hilo_product<std::uint32_t, umathp>();
+    test_unsigned_multiply_add_to_hilo_product<std::uint64_t, umathp>();
+#if HURCHALLA_COMPILER_HAS_UINT128_T()
+    test_unsigned_multiply_add_to_hilo_product<__uint128_t, umathp>();
+#endif
+
+    test_unsigned_multiply_add_exhaustive_uint8();
+}
+
+TEST(HurchallaUtil, slow_unsigned_multiply_add_to_hilo_product) {
+    test_unsigned_multiply_add_to_hilo_product<std::uint64_t, umathp_slow>();
+#if HURCHALLA_COMPILER_HAS_UINT128_T()
+    test_unsigned_multiply_add_to_hilo_product<__uint128_t, umathp_slow>();
+#endif
+}
+
+
+} // end unnamed namespace
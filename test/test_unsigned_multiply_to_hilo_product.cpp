@@ -20,6 +20,11 @@
 #include "hurchalla/util/traits/ut_numeric_limits.h"
 #include "gtest/gtest.h"
 #include <cstdint>
+#include <random>
+// uint_wide relies on C++14 constexpr, to be a literal type (see by_halves)
+#if (__cplusplus >= 201402L)
+#  include "uint_wide.h"
+#endif
 
 namespace {
 
@@ -137,6 +142,52 @@ struct umthp_slow {
     }
 };
 
+template <typename T>
+struct umthp_halves {
+    static T call(T& lowProduct, T u, T v)
+    {
+        return hurchalla::detail::slow_unsigned_multiply_to_hilo_product::by_halves(lowProduct, u, v);
+    }
+};
+template <typename T>
+struct umthp_limbs32 {
+    static T call(T& lowProduct, T u, T v)
+    {
+        return hurchalla::detail::slow_unsigned_multiply_to_hilo_product::by_limbs<T, std::uint32_t>(lowProduct, u, v);
+    }
+};
+
+
+#if (__cplusplus >= 201402L)
+// Checks that the limb decomposition that unsigned_multiply_to_hilo_product
+// uses for wide types agrees with by_halves(), and with 32 bit limbs.  (We
+// skip 32 bit limbs for 512 bits, only because its 256 unrolled multiplies
+// are slow to compile.)
+template <int BITS, template <typename> class F2 = umthp_limbs32>
+void test_wide_random()
+{
+    namespace hc = ::hurchalla;
+    using T = uint_wide<BITS>;
+    std::mt19937_64 mt(BITS);
+    bool all_ok = true;
+    for (int k = 0; k < 1000; ++k) {
+        T u, v;
+        for (std::size_t i = 0; i < T::N; ++i) {
+            u.w[i] = mt();
+            v.w[i] = mt();
+        }
+        if (k % 5 == 0)
+            u = hc::ut_numeric_limits<T>::max();
+        T lo1, lo2, lo3;
+        T hi1 = hc::unsigned_multiply_to_hilo_product(lo1, u, v);
+        T hi2 = umthp_halves<T>::call(lo2, u, v);
+        T hi3 = F2<T>::call(lo3, u, v);
+        all_ok = all_ok && hi1 == hi2 && lo1 == lo2 && hi1 == hi3 && lo1 == lo3;
+    }
+    EXPECT_TRUE(all_ok);
+}
+#endif
+
 
 TEST(HurchallaUtil, unsigned_multiply_to_hilo_product) {
     test_unsigned_multiply_to_hilo_product<std::uint8_t, umthp>();
@@ -152,8 +203,29 @@ TEST(HurchallaUtil, unsigned_multiply_to_hilo_product) {
 
 TEST(HurchallaUtil, slow_unsigned_multiply_to_hilo_product) {
     test_unsigned_multiply_to_hilo_product<std::uint64_t, umthp_slow>();
+    test_unsigned_multiply_to_hilo_product<std::uint64_t, umthp_halves>();
+#if HURCHALLA_COMPILER_HAS_UINT128_T()
+    test_unsigned_multiply_to_hilo_product<__uint128_t, umthp_halves>();
+    test_unsigned_multiply_to_hilo_product<__uint128_t, umthp_limbs32>();
+#endif
 }
 
+#if (__cplusplus >= 201402L)
+TEST(HurchallaUtil, wide_unsigned_multiply_to_hilo_product) {
+    test_unsigned_multiply_to_hilo_product<uint_wide<128>, umthp>();
+    test_unsigned_multiply_to_hilo_product<uint_wide<256>, umthp>();
+    test_unsigned_multiply_to_hilo_product<uint_wide<512>, umthp>();
+    test_unsigned_multiply_to_hilo_product<uint_wide<192>, umthp>();
+    test_unsigned_multiply_to_hilo_product<uint_wide<256>, umthp_halves>();
+    test_unsigned_multiply_to_hilo_product<uint_wide<512>, umthp_halves>();
+    test_unsigned_multiply_to_hilo_product<uint_wide<256>, umthp_limbs32>();
+
+    test_wide_random<128>();
+    test_wide_random<256>();
+    test_wide_random<512, umthp>();
+}
+#endif
+
 
 
 } // end unnamed namespace
@@ -0,0 +1,147 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+
+// Strictly for testing purposes, we make sure to enable the SIMD versions of
+// unsigned_multiply_to_hilo_product_array.  They are compiled only when the
+// target ISA supports them (see the -march=native test target), and we check
+// every kernel against the scalar unsigned_multiply_to_hilo_product.
+#undef HURCHALLA_ALLOW_SIMD_MULTIPLY_TO_HILO
+#define HURCHALLA_ALLOW_SIMD_MULTIPLY_TO_HILO
+#undef HURCHALLA_UTIL_ENABLE_ASSERTS
+#define HURCHALLA_UTIL_ENABLE_ASSERTS
+
+
+#include "hurchalla/util/unsigned_multiply_to_hilo_product_array.h"
+#include "hurchalla/util/unsigned_multiply_to_hilo_product.h"
+#include "hurchalla/util/traits/ut_numeric_limits.h"
+#include "hurchalla/util/compiler_macros.h"
+#include "gtest/gtest.h"
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+namespace {
+
+
+template <typename T>
+T random_value(std::mt19937_64& mt)
+{
+    T x = 0;
+    for (std::size_t i = 0; i < sizeof(T); ++i)
+        x = static_cast<T>(static_cast<T>(x << 8) | (mt() & 0xFF));
+    return x;
+}
+
+// Fills u and v with random values, with some maximum values and zeros mixed
+// in, since those are the edge cases of the 52 bit split in the IFMA kernel
+// and of the lane shuffles in the 32 bit kernels.
+template <typename T>
+void fill(std::vector<T>& u, std::vector<T>& v, std::mt19937_64& mt)
+{
+    namespace hc = ::hurchalla;
+    T tmax = hc::ut_numeric_limits<T>::max();
+    for (std::size_t i = 0; i < u.size(); ++i) {
+        u[i] = random_value<T>(mt);
+        v[i] = random_value<T>(mt);
+        switch (mt() % 8) {
+            case 0: u[i] = tmax; break;
+            case 1: v[i] = tmax; break;
+            case 2: u[i] = tmax; v[i] = tmax; break;
+            case 3: u[i] = 0; break;
+            default: break;
+        }
+    }
+}
+
+template <typename T>
+bool matches_scalar(const std::vector<T>& hi, const std::vector<T>& lo,
+                    const std::vector<T>& u, const std::vector<T>& v)
+{
+    namespace hc = ::hurchalla;
+    for (std::size_t i = 0; i < u.size(); ++i) {
+        T low;
+        T high = hc::unsigned_multiply_to_hilo_product(low, u[i], v[i]);
+        if (high != hi[i] || low != lo[i])
+            return false;
+    }
+    return true;
+}
+
+template <typename T>
+void test_multiply_to_hilo_array()
+{
+    namespace hc = ::hurchalla;
+    std::mt19937_64 mt(sizeof(T));
+
+    // every size up to a few SIMD vectors, so every tail length is covered
+    for (std::size_t n = 0; n <= 40; ++n) {
+        std::vector<T> u(n), v(n), hi(n), lo(n);
+        fill(u, v, mt);
+        hc::unsigned_multiply_to_hilo_product_array(hi.data(), lo.data(),
+                                                    u.data(), v.data(), n);
+        EXPECT_TRUE(matches_scalar(hi, lo, u, v));
+    }
+    {
+        std::size_t n = 10007;
+        std::vector<T> u(n), v(n), hi(n), lo(n);
+        fill(u, v, mt);
+        hc::unsigned_multiply_to_hilo_product_array(hi.data(), lo.data(),
+                                                    u.data(), v.data(), n);
+        EXPECT_TRUE(matches_scalar(hi, lo, u, v));
+
+        // in-place: the products overwrite the inputs
+        std::vector<T> u2 = u, v2 = v;
+        hc::unsigned_multiply_to_hilo_product_array(u2.data(), v2.data(),
+                                                    u2.data(), v2.data(), n);
+        EXPECT_TRUE(u2 == hi && v2 == lo);
+        u2 = u; v2 = v;
+        hc::unsigned_multiply_to_hilo_product_array(v2.data(), u2.data(),
+                                                    u2.data(), v2.data(), n);
+        EXPECT_TRUE(v2 == hi && u2 == lo);
+    }
+    // a misaligned start
+    {
+        std::size_t n = 61;
+        std::vector<T> u(n + 1), v(n + 1), hi(n + 1), lo(n + 1);
+        fill(u, v, mt);
+        hc::unsigned_multiply_to_hilo_product_array(hi.data() + 1,
+                               lo.data() + 1, u.data() + 1, v.data() + 1, n);
+        hi[0] = 0; lo[0] = 0; u[0] = 0; v[0] = 0;
+        EXPECT_TRUE(matches_scalar(hi, lo, u, v));
+    }
+    // the std::array overload
+    {
+        T tmax = hc::ut_numeric_limits<T>::max();
+        std::array<T, 11> u, v, lo;
+        for (std::size_t i = 0; i < u.size(); ++i) {
+            u[i] = static_cast<T>(tmax - i);
+            v[i] = static_cast<T>(tmax - 3*i);
+        }
+        std::array<T, 11> hi =
+                      hc::unsigned_multiply_to_hilo_product_array(lo, u, v);
+        bool all_ok = true;
+        for (std::size_t i = 0; i < u.size(); ++i) {
+            T low;
+            T high = hc::unsigned_multiply_to_hilo_product(low, u[i], v[i]);
+            all_ok = all_ok && (high == hi[i] && low == lo[i]);
+        }
+        EXPECT_TRUE(all_ok);
+    }
+}
+
+
+TEST(HurchallaUtil, unsigned_multiply_to_hilo_product_array) {
+    test_multiply_to_hilo_array<std::uint8_t>();
+    test_multiply_to_hilo_array<std::uint16_t>();
+    test_multiply_to_hilo_array<std::uint32_t>();
+    test_multiply_to_hilo_array<std::uint64_t>();
+#if HURCHALLA_COMPILER_HAS_UINT128_T()
+    test_multiply_to_hilo_array<__uint128_t>();
+#endif
+}
+
+
+} // end unnamed namespace
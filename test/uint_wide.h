@@ -0,0 +1,162 @@
+// --- This file is distributed under the MIT Open Source License, as detailed
+// by the file "LICENSE.TXT" in the root of this repository ---
+
+#ifndef HURCHALLA_UTIL_TEST_UINT_WIDE_H_INCLUDED
+#define HURCHALLA_UTIL_TEST_UINT_WIDE_H_INCLUDED
+
+
+#include "hurchalla/util/traits/ut_numeric_limits.h"
+#include <cstdint>
+#include <cstddef>
+
+
+// helper struct: a BITS wide unsigned integer, stored as 64 bit words, with
+// just enough operators to test and benchmark the slow (generic) versions of
+// the multiply functions for types that are wider than any native type.
+// Everything is constexpr (C++14) so that it is a literal type.
+template <int BITS>
+struct uint_wide {
+    static_assert(BITS % 64 == 0 && BITS >= 128, "");
+    static constexpr std::size_t N = BITS / 64;
+    uint64_t w[N];   // w[0] is the least significant word
+
+    constexpr uint_wide() : w() {}
+    constexpr uint_wide(uint64_t x) : w() { w[0] = x; }
+    constexpr explicit operator uint64_t() const { return w[0]; }
+    constexpr explicit operator uint32_t() const
+    {
+        return static_cast<uint32_t>(w[0]);
+    }
+
+    constexpr bool operator==(const uint_wide& x) const
+    {
+        for (std::size_t i = 0; i < N; ++i) {
+            if (w[i] != x.w[i])
+                return false;
+        }
+        return true;
+    }
+    constexpr bool operator!=(const uint_wide& x) const
+    {
+        return !(*this == x);
+    }
+    constexpr uint_wide operator&(const uint_wide& x) const
+    {
+        uint_wide tmp;
+        for (std::size_t i = 0; i < N; ++i)
+            tmp.w[i] = w[i] & x.w[i];
+        return tmp;
+    }
+    constexpr uint_wide operator|(const uint_wide& x) const
+    {
+        uint_wide tmp;
+        for (std::size_t i = 0; i < N; ++i)
+            tmp.w[i] = w[i] | x.w[i];
+        return tmp;
+    }
+    constexpr uint_wide operator+(const uint_wide& x) const
+    {
+        uint_wide tmp;
+        uint64_t carry = 0;
+        for (std::size_t i = 0; i < N; ++i) {
+            uint64_t s = w[i] + x.w[i];
+            uint64_t c = (s < w[i]);
+            tmp.w[i] = s + carry;
+            carry = c + (tmp.w[i] < s);
+        }
+        return tmp;
+    }
+    constexpr uint_wide operator-(const uint_wide& x) const
+    {
+        uint_wide tmp;
+        uint64_t borrow = 0;
+        for (std::size_t i = 0; i < N; ++i) {
+            uint64_t d = w[i] - x.w[i];
+            uint64_t b = (w[i] < x.w[i]);
+            tmp.w[i] = d - borrow;
+            borrow = b + (d < borrow);
+        }
+        return tmp;
+    }
+    constexpr uint_wide operator<<(unsigned int shift) const
+    {
+        uint_wide tmp;
+        std::size_t words = shift / 64;
+        unsigned int bits = shift % 64;
+        for (std::size_t i = words; i < N; ++i) {
+            tmp.w[i] = w[i - words] << bits;
+            if (bits != 0 && i > words)
+                tmp.w[i] |= w[i - words - 1] >> (64 - bits);
+        }
+        return tmp;
+    }
+    constexpr uint_wide operator>>(unsigned int shift) const
+    {
+        uint_wide tmp;
+        std::size_t words = shift / 64;
+        unsigned int bits = shift % 64;
+        for (std::size_t i = 0; i + words < N; ++i) {
+            tmp.w[i] = w[i + words] >> bits;
+            if (bits != 0 && i + words + 1 < N)
+                tmp.w[i] |= w[i + words + 1] << (64 - bits);
+        }
+        return tmp;
+    }
+    // the low BITS bits of the product, computed with 32 bit half-words so
+    // that it's independent of the multiply functions being tested
+    constexpr uint_wide operator*(const uint_wide& x) const
+    {
+        constexpr std::size_t H = 2 * N;
+        uint32_t a[H] = {}, b[H] = {}, r[H] = {};
+        for (std::size_t i = 0; i < N; ++i) {
+            a[2*i] = static_cast<uint32_t>(w[i]);
+            a[2*i+1] = static_cast<uint32_t>(w[i] >> 32);
+            b[2*i] = static_cast<uint32_t>(x.w[i]);
+            b[2*i+1] = static_cast<uint32_t>(x.w[i] >> 32);
+        }
+        for (std::size_t i = 0; i < H; ++i) {
+            uint64_t carry = 0;
+            for (std::size_t j = 0; i + j < H; ++j) {
+                uint64_t t = static_cast<uint64_t>(a[i]) * b[j] + r[i+j] + carry;
+                r[i+j] = static_cast<uint32_t>(t);
+                carry = t >> 32;
+            }
+        }
+        uint_wide tmp;
+        for (std::size_t i = 0; i < N; ++i)
+            tmp.w[i] = (static_cast<uint64_t>(r[2*i+1]) << 32) | r[2*i];
+        return tmp;
+    }
+};
+
+template<int BITS, typename U>
+struct hurchalla::ut_numeric_limits<uint_wide<BITS>, U> {
+    static constexpr bool is_specialized = true;
+    static constexpr bool is_signed = false;
+    static constexpr bool is_integer = true;
+    static constexpr int digits = BITS;
+    static constexpr uint_wide<BITS> max() noexcept
+    {
+        uint_wide<BITS> tmp;
+        for (std::size_t i = 0; i < uint_wide<BITS>::N; ++i)
+            tmp.w[i] = ~static_cast<uint64_t>(0);
+        return tmp;
+    }
+};
+// This section is only needed prior to C++17, and can cause deprecation
+// warnings if enabled after C++17
+#if __cplusplus < 201703L
+template <int BITS>
+constexpr std::size_t uint_wide<BITS>::N;
+template <int BITS, typename U>
+constexpr bool hurchalla::ut_numeric_limits<uint_wide<BITS>, U>::is_specialized;
+template <int BITS, typename U>
+constexpr bool hurchalla::ut_numeric_limits<uint_wide<BITS>, U>::is_signed;
+template <int BITS, typename U>
+constexpr bool hurchalla::ut_numeric_limits<uint_wide<BITS>, U>::is_integer;
+template <int BITS, typename U>
+constexpr int hurchalla::ut_numeric_limits<uint_wide<BITS>, U>::digits;
+#endif
+
+
+#endif